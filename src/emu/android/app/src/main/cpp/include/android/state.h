@@ -84,7 +84,7 @@ namespace eka2l1::android {
 
         config::state conf;
         window_server *winserv;
-        int present_status;
+        drivers::command_fence present_fence;
 
         std::mutex input_mutex;
 
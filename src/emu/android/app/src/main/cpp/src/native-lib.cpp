@@ -91,15 +91,15 @@ Java_com_github_eka2l1_emu_Emulator_getApps(
 }
 
 static void redraw_screens_immediately() {
-    state->graphics_driver->wait_for(&state->present_status);
+    state->graphics_driver->wait_for(&state->present_fence);
 
     eka2l1::drivers::graphics_command_builder builder;
     state->launcher->draw(builder, state->winserv ? state->winserv->get_screens() : nullptr,
                           state->window->window_fb_size().x,
                           state->window->window_fb_size().y);
 
-    state->present_status = -100;
-    builder.present(&state->present_status);
+    state->present_fence.reset();
+    builder.present(&state->present_fence);
 
     eka2l1::drivers::command_list retrieved = builder.retrieve_command_list();
     state->graphics_driver->submit_command_list(retrieved);
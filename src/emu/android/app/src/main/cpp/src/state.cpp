@@ -56,7 +56,7 @@ namespace eka2l1::android {
         , surface_inited(false)
         , first_time(true)
         , winserv(nullptr)
-        , present_status(0) {
+        , present_fence(true) {
     }
 
     void emulator::register_draw_callback() {
@@ -73,7 +73,7 @@ namespace eka2l1::android {
 
                     // Check if previous presenting is done yet (to prevent input delay because frame
                     // submit request is too fast)
-                    state_ptr->graphics_driver->wait_for(&state_ptr->present_status);
+                    state_ptr->graphics_driver->wait_for(&state_ptr->present_fence);
 
                     drivers::graphics_command_builder builder;
                     state_ptr->launcher->draw(builder, scr, state_ptr->window->window_fb_size().x,
@@ -82,8 +82,8 @@ namespace eka2l1::android {
                     // Submit, present, and wait for the presenting
                     // Don't wait for present to be done, let the game during this time to do
                     // something meaningful. (Callback tied to draw thread)
-                    state_ptr->present_status = -100;
-                    builder.present(&state_ptr->present_status);
+                    state_ptr->present_fence.reset();
+                    builder.present(&state_ptr->present_fence);
 
                     drivers::command_list retrieved = builder.retrieve_command_list();
                     state_ptr->graphics_driver->submit_command_list(retrieved);
@@ -115,6 +115,10 @@ namespace eka2l1::android {
             log::filterings->parse_filter_string(conf.log_filter);
         }
 
+        if (conf.binary_log && !log::start_binary_log("EKA2L1.binlog")) {
+            LOG_WARN(FRONTEND_CMDLINE, "Unable to open the binary log file, falling back to text logging");
+        }
+
         LOG_INFO(FRONTEND_CMDLINE, "EKA2L1 v0.0.1 ({}-{})", GIT_BRANCH, GIT_COMMIT_HASH);
 
         app_settings = std::make_unique<config::app_settings>(&conf);
@@ -26,6 +26,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1::common {
@@ -57,17 +58,87 @@ namespace eka2l1::common {
         }
     };
 
+    struct block_allocator_stats {
+        std::size_t total_size_; ///< Size of the managed space.
+        std::size_t used_size_; ///< Bytes handed out to active blocks.
+        std::size_t free_size_; ///< Bytes in free blocks.
+        std::size_t largest_free_block_; ///< Size of the biggest free block.
+        std::size_t active_block_count_; ///< Number of blocks currently allocated.
+        std::size_t free_block_count_; ///< Number of free blocks. Neighbors are always coalesced.
+        std::uint64_t allocation_count_; ///< Total number of successful allocations.
+        std::uint64_t free_count_; ///< Total number of successful frees.
+        std::uint64_t failed_allocation_count_; ///< Number of allocations that could not be served, even after expanding.
+
+        /**
+         * @brief Get external fragmentation of the free space, from 0 (one free block) to 1.
+         */
+        double fragmentation() const {
+            return free_size_ ? 1.0 - static_cast<double>(largest_free_block_) / static_cast<double>(free_size_) : 0.0;
+        }
+    };
+
+    /**
+     * @brief Two-level segregated fit allocator over a fixed space.
+     *
+     * Free blocks are kept in lists bucketed by size class, with a two-level bitmap to find a list that can
+     * serve a request in constant time. Freed blocks are merged with their free neighbors right away.
+     *
+     * Block bookkeeping lives outside the managed space, so the space can be memory visible to the guest.
+     */
     class block_allocator : public space_based_allocator {
+    public:
+        static constexpr std::size_t ALIGNMENT_LOG2 = 4;
+        static constexpr std::size_t ALIGNMENT = 1 << ALIGNMENT_LOG2;
+
+    private:
+        static constexpr std::uint32_t SL_COUNT_LOG2 = 4;
+        static constexpr std::uint32_t SL_COUNT = 1 << SL_COUNT_LOG2;
+        static constexpr std::uint32_t FL_SHIFT = SL_COUNT_LOG2 + ALIGNMENT_LOG2;
+        static constexpr std::uint32_t FL_COUNT = 64 - FL_SHIFT + 1;
+        static constexpr std::uint32_t INVALID_BLOCK = 0xFFFFFFFF;
+
         struct block_info {
             std::uint64_t offset;
             std::size_t size;
 
+            std::uint32_t prev_phys;
+            std::uint32_t next_phys;
+            std::uint32_t prev_free;
+            std::uint32_t next_free;
+
             bool active{ false };
         };
 
         std::vector<block_info> blocks;
+        std::vector<std::uint32_t> unused_blocks;
+        std::unordered_map<std::uint64_t, std::uint32_t> active_blocks;
+
+        std::uint64_t fl_bitmap;
+        std::uint32_t sl_bitmap[FL_COUNT];
+        std::uint32_t free_heads[FL_COUNT][SL_COUNT];
+
+        std::uint32_t last_block;
+        std::size_t space_size;
+
+        block_allocator_stats stats;
+
         std::mutex lock;
 
+        /**
+         * @brief Get the first and second level list index of a block size.
+         */
+        static void map_block_size(const std::size_t size, std::uint32_t &fl, std::uint32_t &sl);
+        static std::size_t get_search_size(const std::size_t size);
+
+        std::uint32_t new_block(const std::uint64_t offset, const std::size_t size);
+        void remove_block(const std::uint32_t index);
+
+        void insert_free(const std::uint32_t index);
+        void remove_free(const std::uint32_t index);
+
+        std::uint32_t find_free(const std::size_t size);
+        void grow_space(const std::size_t new_size);
+
     public:
         explicit block_allocator(std::uint8_t *sptr, const std::size_t initial_max_size);
 
@@ -77,6 +148,8 @@ namespace eka2l1::common {
         virtual bool expand(std::size_t target) override {
             return false;
         }
+
+        block_allocator_stats get_stats();
     };
 
     struct bitmap_allocator {
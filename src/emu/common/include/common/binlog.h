@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace eka2l1::log {
+    /**
+     * \brief Type tag of an argument stored in a binary log record.
+     */
+    enum binlog_arg_type : std::uint8_t {
+        BINLOG_ARG_SIGNED = 0,
+        BINLOG_ARG_UNSIGNED = 1,
+        BINLOG_ARG_FLOAT = 2,
+        BINLOG_ARG_BOOL = 3,
+        BINLOG_ARG_CHAR = 4,
+        BINLOG_ARG_STRING = 5,
+        BINLOG_ARG_POINTER = 6
+    };
+
+    /**
+     * \brief Header of a record in a thread's log ring.
+     *
+     * Format and file strings are literals, so only their address is stored. The writer thread turns them
+     * into call site definitions in the log file.
+     */
+    struct binlog_record_header {
+        std::uint32_t size_; ///< Size of the record including this header. Zero marks the end of the ring.
+        std::uint16_t class_;
+        std::uint8_t level_;
+        std::uint8_t arg_count_;
+        std::uint32_t line_;
+        std::uint32_t args_size_;
+        std::uint64_t time_us_;
+        const char *file_;
+        const char *format_;
+    };
+
+    /**
+     * \brief A decoded binary log record.
+     */
+    struct binlog_entry {
+        std::uint64_t time_us_;
+        std::uint32_t thread_;
+        std::uint8_t level_;
+        std::string class_name_;
+        std::string file_;
+        std::uint32_t line_;
+        std::string message_;
+    };
+
+    extern std::atomic<bool> binary_logging;
+
+    /**
+     * \brief Start writing log messages to a binary log file.
+     *
+     * Messages are encoded on the logging thread into a per-thread lock-free ring, without formatting.
+     * A background thread drains the rings into the file. Records are dropped, and the drop counted, when
+     * a ring is full, so logging never blocks the emulator.
+     *
+     * \param path Path to the binary log file. It is overwritten.
+     * \returns True on success.
+     */
+    bool start_binary_log(const std::string &path);
+
+    /**
+     * \brief Drain all pending records and close the binary log file.
+     */
+    void stop_binary_log();
+
+    /**
+     * \brief Decode a binary log file.
+     *
+     * \param path      Path to the binary log file.
+     * \param callback  Function called with each record, in the order they were written to the file.
+     * \param dropped   Optional, receives the number of records dropped because a ring was full.
+     *
+     * \returns False if the file is not a binary log.
+     */
+    bool decode_binary_log(const std::string &path, const std::function<void(const binlog_entry &)> &callback,
+        std::uint64_t *dropped = nullptr);
+
+    namespace detail {
+        std::uint8_t *reserve_binlog_record(const std::size_t size);
+        void commit_binlog_record();
+
+        std::uint64_t get_binlog_time_us();
+
+        template <typename T>
+        struct binlog_arg {
+            using value_type = std::decay_t<T>;
+
+            static constexpr bool is_string = std::is_same_v<value_type, const char *> || std::is_same_v<value_type, char *>
+                || std::is_same_v<value_type, std::string> || std::is_same_v<value_type, std::string_view>;
+
+            static constexpr bool is_number = std::is_arithmetic_v<value_type> || (std::is_enum_v<value_type> && std::is_convertible_v<value_type, int>);
+
+            static constexpr bool is_pointer = std::is_pointer_v<value_type> && !is_string;
+
+            static std::string_view as_string(const T &value) {
+                if constexpr (std::is_same_v<value_type, const char *> || std::is_same_v<value_type, char *>) {
+                    return value ? std::string_view(value) : std::string_view("(null)");
+                } else {
+                    return std::string_view(value);
+                }
+            }
+        };
+
+        template <typename T>
+        std::size_t binlog_arg_size(const T &value, std::string *fallback) {
+            using arg = binlog_arg<T>;
+
+            if constexpr (std::is_same_v<typename arg::value_type, bool> || std::is_same_v<typename arg::value_type, char>) {
+                return 2;
+            } else if constexpr (arg::is_number || arg::is_pointer) {
+                return 1 + sizeof(std::uint64_t);
+            } else if constexpr (arg::is_string) {
+                return 1 + sizeof(std::uint32_t) + arg::as_string(value).size();
+            } else {
+                // Types with a custom formatter are formatted here, to not keep references to the caller's objects
+                *fallback = fmt::format("{}", value);
+                return 1 + sizeof(std::uint32_t) + fallback->size();
+            }
+        }
+
+        inline std::uint8_t *write_binlog_string(std::uint8_t *dest, const std::string_view str) {
+            *dest++ = BINLOG_ARG_STRING;
+
+            const std::uint32_t length = static_cast<std::uint32_t>(str.size());
+            std::memcpy(dest, &length, sizeof(std::uint32_t));
+            std::memcpy(dest + sizeof(std::uint32_t), str.data(), str.size());
+
+            return dest + sizeof(std::uint32_t) + str.size();
+        }
+
+        template <typename T>
+        std::uint8_t *write_binlog_arg(std::uint8_t *dest, const T &value, const std::string *fallback) {
+            using arg = binlog_arg<T>;
+            using value_type = typename arg::value_type;
+
+            if constexpr (std::is_same_v<value_type, bool>) {
+                *dest++ = BINLOG_ARG_BOOL;
+                *dest++ = value ? 1 : 0;
+            } else if constexpr (std::is_same_v<value_type, char>) {
+                *dest++ = BINLOG_ARG_CHAR;
+                *dest++ = static_cast<std::uint8_t>(value);
+            } else if constexpr (arg::is_pointer) {
+                const std::uint64_t encoded = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(value));
+                *dest++ = BINLOG_ARG_POINTER;
+                std::memcpy(dest, &encoded, sizeof(std::uint64_t));
+                dest += sizeof(std::uint64_t);
+            } else if constexpr (std::is_floating_point_v<value_type>) {
+                const double encoded = static_cast<double>(value);
+                *dest++ = BINLOG_ARG_FLOAT;
+                std::memcpy(dest, &encoded, sizeof(double));
+                dest += sizeof(double);
+            } else if constexpr (arg::is_number) {
+                using integer_type = std::conditional_t<std::is_enum_v<value_type>, std::underlying_type<value_type>,
+                    std::common_type<value_type>>;
+
+                if constexpr (std::is_signed_v<typename integer_type::type>) {
+                    const std::int64_t encoded = static_cast<std::int64_t>(value);
+                    *dest++ = BINLOG_ARG_SIGNED;
+                    std::memcpy(dest, &encoded, sizeof(std::int64_t));
+                } else {
+                    const std::uint64_t encoded = static_cast<std::uint64_t>(value);
+                    *dest++ = BINLOG_ARG_UNSIGNED;
+                    std::memcpy(dest, &encoded, sizeof(std::uint64_t));
+                }
+
+                dest += sizeof(std::uint64_t);
+            } else if constexpr (arg::is_string) {
+                dest = write_binlog_string(dest, arg::as_string(value));
+            } else {
+                dest = write_binlog_string(dest, *fallback);
+            }
+
+            return dest;
+        }
+    }
+
+    /**
+     * \brief Queue a log message to the binary log. Prefer the LOG_* macros.
+     */
+    template <typename... Args>
+    void write_binary(const int cls, const int level, const char *file, const int line, const char *format,
+        const Args &...args) {
+        static_assert(sizeof...(Args) < 256, "Too many log arguments");
+
+        std::string fallbacks[sizeof...(Args) + 1];
+        std::size_t args_size = 0;
+        std::size_t index = 0;
+
+        ((args_size += detail::binlog_arg_size(args, &fallbacks[index++])), ...);
+
+        // Keep records 8-byte aligned in the ring
+        const std::size_t total_size = (sizeof(binlog_record_header) + args_size + 7) & ~static_cast<std::size_t>(7);
+        std::uint8_t *dest = detail::reserve_binlog_record(total_size);
+
+        if (!dest) {
+            return;
+        }
+
+        binlog_record_header header;
+        header.size_ = static_cast<std::uint32_t>(total_size);
+        header.class_ = static_cast<std::uint16_t>(cls);
+        header.level_ = static_cast<std::uint8_t>(level);
+        header.arg_count_ = static_cast<std::uint8_t>(sizeof...(Args));
+        header.line_ = static_cast<std::uint32_t>(line);
+        header.args_size_ = static_cast<std::uint32_t>(args_size);
+        header.time_us_ = detail::get_binlog_time_us();
+        header.file_ = file;
+        header.format_ = format;
+
+        std::memcpy(dest, &header, sizeof(binlog_record_header));
+        dest += sizeof(binlog_record_header);
+
+        index = 0;
+        ((dest = detail::write_binlog_arg(dest, args, &fallbacks[index++])), ...);
+
+        detail::commit_binlog_record();
+    }
+}
@@ -22,6 +22,7 @@
 #define SPDLOG_FMT_EXTERNAL
 #include <spdlog/spdlog.h>
 
+#include <common/binlog.h>
 #include <common/configure.h>
 
 #include <memory>
@@ -90,43 +91,62 @@ namespace eka2l1 {
 #define LOG_ERROR_IF(class, flag, fmt, ...)
 #define LOG_CRITICAL_IF(class, flag, fmt, ...)
 #else
+#ifndef EKA2L1_LOG_MIN_LEVEL
+#define EKA2L1_LOG_MIN_LEVEL 0
+#endif
+
+// Calls below the minimum level set at configure time are dead code, and get stripped by the compiler
+#define LOG_LEVEL_COMPILED(serv) (static_cast<int>(spdlog::level::serv) >= EKA2L1_LOG_MIN_LEVEL)
+
 #ifdef ENABLE_SCRIPTING
-#define COND_CHECK(class, serv) if (eka2l1::log::spd_logger && eka2l1::log::filterings->is_passed(class, spdlog::level::serv))
+#define COND_CHECK(class, serv) if (LOG_LEVEL_COMPILED(serv) && eka2l1::log::spd_logger && eka2l1::log::filterings->is_passed(class, spdlog::level::serv))
 #define COND_CHECK_AND(class, serv) &&eka2l1::log::spd_logger &&eka2l1::log::filterings->is_passed(class, spdlog::level::serv)
 #else
-#define COND_CHECK(class, serv) if (eka2l1::log::filterings->is_passed(class, spdlog::level::serv))
+#define COND_CHECK(class, serv) if (LOG_LEVEL_COMPILED(serv) && eka2l1::log::filterings->is_passed(class, spdlog::level::serv))
 #define COND_CHECK_AND(class, serv) &&eka2l1::log::filterings->is_passed(class, spdlog::level::serv)
 #endif
 
+// With the binary log on, messages are only queued on the calling thread. Warnings and worse still go
+// to the text sinks too, so that they are seen right away.
+#define LOG_EMIT_ASYNC(class, serv, method, fmt, ...) \
+    (eka2l1::log::binary_logging.load(std::memory_order_relaxed) \
+            ? eka2l1::log::write_binary(class, spdlog::level::serv, __FILE__, __LINE__, fmt, ##__VA_ARGS__) \
+            : eka2l1::log::spd_logger->method("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__))
+#define LOG_EMIT_BOTH(class, serv, method, fmt, ...) \
+    ((eka2l1::log::binary_logging.load(std::memory_order_relaxed) \
+             ? eka2l1::log::write_binary(class, spdlog::level::serv, __FILE__, __LINE__, fmt, ##__VA_ARGS__) \
+             : (void)0), \
+        eka2l1::log::spd_logger->method("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__))
+
 #define LOG_TRACE(class, fmt, ...) COND_CHECK(class, trace) \
-                                   eka2l1::log::spd_logger->trace("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+                                   LOG_EMIT_ASYNC(class, trace, trace, fmt, ##__VA_ARGS__)
 #define LOG_DEBUG(class, fmt, ...) COND_CHECK(class, debug) \
-                                   eka2l1::log::spd_logger->debug("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+                                   LOG_EMIT_ASYNC(class, debug, debug, fmt, ##__VA_ARGS__)
 #define LOG_INFO(class, fmt, ...) COND_CHECK(class, info) \
-                                  eka2l1::log::spd_logger->info("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+                                  LOG_EMIT_ASYNC(class, info, info, fmt, ##__VA_ARGS__)
 #define LOG_WARN(class, fmt, ...) COND_CHECK(class, warn) \
-                                  eka2l1::log::spd_logger->warn("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+                                  LOG_EMIT_BOTH(class, warn, warn, fmt, ##__VA_ARGS__)
 #define LOG_ERROR(class, fmt, ...) COND_CHECK(class, err) \
-                                   eka2l1::log::spd_logger->error("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+                                   LOG_EMIT_BOTH(class, err, error, fmt, ##__VA_ARGS__)
 #define LOG_CRITICAL(class, fmt, ...) COND_CHECK(class, critical) \
-                                      eka2l1::log::spd_logger->critical("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
-
-#define LOG_TRACE_IF(class, flag, fmt, ...) \
-    if (flag COND_CHECK_AND(class, trace))  \
-    eka2l1::log::spd_logger->trace("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
-#define LOG_DEBUG_IF(class, flag, fmt, ...) \
-    if (flag COND_CHECK_AND(class, debug))  \
-    eka2l1::log::spd_logger->debug("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
-#define LOG_INFO_IF(class, flag, fmt, ...) \
-    if (flag COND_CHECK_AND(class, info))  \
-    eka2l1::log::spd_logger->info("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
-#define LOG_WARN_IF(class, flag, fmt, ...) \
-    if (flag COND_CHECK_AND(class, warn))  \
-    eka2l1::log::spd_logger->warn("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
-#define LOG_ERROR_IF(class, flag, fmt, ...) \
-    if (flag COND_CHECK_AND(class, err))    \
-    eka2l1::log::spd_logger->error("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
-#define LOG_CRITICAL_IF(class, flag, fmt, ...) \
-    if (flag COND_CHECK_AND(class, critical))  \
-    eka2l1::log::spd_logger->critical("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+                                      LOG_EMIT_BOTH(class, critical, critical, fmt, ##__VA_ARGS__)
+
+#define LOG_TRACE_IF(class, flag, fmt, ...)                              \
+    if (LOG_LEVEL_COMPILED(trace) && (flag)COND_CHECK_AND(class, trace)) \
+    LOG_EMIT_ASYNC(class, trace, trace, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_IF(class, flag, fmt, ...)                              \
+    if (LOG_LEVEL_COMPILED(debug) && (flag)COND_CHECK_AND(class, debug)) \
+    LOG_EMIT_ASYNC(class, debug, debug, fmt, ##__VA_ARGS__)
+#define LOG_INFO_IF(class, flag, fmt, ...)                             \
+    if (LOG_LEVEL_COMPILED(info) && (flag)COND_CHECK_AND(class, info)) \
+    LOG_EMIT_ASYNC(class, info, info, fmt, ##__VA_ARGS__)
+#define LOG_WARN_IF(class, flag, fmt, ...)                             \
+    if (LOG_LEVEL_COMPILED(warn) && (flag)COND_CHECK_AND(class, warn)) \
+    LOG_EMIT_BOTH(class, warn, warn, fmt, ##__VA_ARGS__)
+#define LOG_ERROR_IF(class, flag, fmt, ...)                          \
+    if (LOG_LEVEL_COMPILED(err) && (flag)COND_CHECK_AND(class, err)) \
+    LOG_EMIT_BOTH(class, err, error, fmt, ##__VA_ARGS__)
+#define LOG_CRITICAL_IF(class, flag, fmt, ...)                                 \
+    if (LOG_LEVEL_COMPILED(critical) && (flag)COND_CHECK_AND(class, critical)) \
+    LOG_EMIT_BOTH(class, critical, critical, fmt, ##__VA_ARGS__)
 #endif
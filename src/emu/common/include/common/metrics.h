@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/container.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace eka2l1::common {
+    enum metric_type {
+        metric_type_counter = 0,
+        metric_type_gauge = 1,
+        metric_type_histogram = 2
+    };
+
+    /**
+     * @brief A value that only goes up, such as time spent in a subsystem.
+     *
+     * Frame snapshots report how much the counter increased during the frame.
+     */
+    class metric_counter {
+        std::atomic<std::uint64_t> value_{ 0 };
+
+    public:
+        void add(const std::uint64_t amount = 1) {
+            value_.fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Mirror a total that the subsystem already keeps by itself.
+         */
+        void set(const std::uint64_t total) {
+            value_.store(total, std::memory_order_relaxed);
+        }
+
+        std::uint64_t value() const {
+            return value_.load(std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * @brief A value that can go up and down, such as memory usage. Frame snapshots report the current value.
+     */
+    class metric_gauge {
+        std::atomic<double> value_{ 0.0 };
+
+    public:
+        void set(const double value) {
+            value_.store(value, std::memory_order_relaxed);
+        }
+
+        double value() const {
+            return value_.load(std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * @brief Distribution of samples, such as the duration of each call to something.
+     *
+     * Samples are counted in power of two buckets, so recording is a few atomic adds. Percentiles in
+     * frame snapshots are interpolated inside the bucket they fall in.
+     */
+    class metric_histogram {
+    public:
+        static constexpr std::size_t BUCKET_COUNT = 40;
+
+    private:
+        friend class metrics_registry;
+
+        std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> buckets_;
+        std::atomic<std::uint64_t> count_;
+        std::atomic<std::uint64_t> sum_;
+        std::atomic<std::uint64_t> frame_max_;
+
+    public:
+        explicit metric_histogram();
+
+        void record(const std::uint64_t value);
+
+        std::uint64_t count() const {
+            return count_.load(std::memory_order_relaxed);
+        }
+
+        std::uint64_t sum() const {
+            return sum_.load(std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * @brief Add the host time spent in a scope, in microseconds, to a counter. Does nothing if the counter is null.
+     */
+    class scoped_metric_timer {
+        metric_counter *counter_;
+        std::chrono::steady_clock::time_point start_;
+
+    public:
+        explicit scoped_metric_timer(metric_counter *counter)
+            : counter_(counter) {
+            if (counter_) {
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~scoped_metric_timer() {
+            if (counter_) {
+                counter_->add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count());
+            }
+        }
+    };
+
+    struct metric_sample {
+        std::string name_;
+        metric_type type_;
+
+        double value_ = 0.0; ///< Counter: increase during the frame. Gauge: current value. Histogram: mean of the frame's samples.
+        std::uint64_t total_ = 0; ///< Counter: value since creation. Histogram: number of samples in the frame.
+
+        double p50_ = 0.0; ///< Histogram only, median of the frame's samples.
+        double p95_ = 0.0; ///< Histogram only, 95th percentile of the frame's samples.
+        std::uint64_t max_ = 0; ///< Histogram only, biggest sample of the frame.
+    };
+
+    /**
+     * @brief Values of every registered metric, taken at the end of a frame.
+     */
+    struct metrics_frame {
+        std::uint64_t index_ = 0;
+        std::uint64_t timestamp_us_ = 0; ///< Host time since the registry was created.
+        std::uint64_t frame_time_us_ = 0; ///< Host time since the end of the previous frame.
+
+        std::vector<metric_sample> samples_; ///< In registration order.
+
+        const metric_sample *find(const std::string &name) const;
+    };
+
+    using metrics_collector = std::function<void()>;
+    using metrics_frame_callback = std::function<void(const metrics_frame &)>;
+
+    /**
+     * @brief Named counters, gauges and histograms that subsystems publish into, snapshotted once per frame.
+     *
+     * Metrics are created on first lookup and live as long as the registry, so the returned pointers should be
+     * cached by the caller and updated from any thread without locking. Subsystems that already keep their own
+     * statistics can register a collector instead, which copies them into metrics right before each snapshot.
+     */
+    class metrics_registry {
+        struct entry {
+            std::string name_;
+            metric_type type_;
+
+            std::unique_ptr<metric_counter> counter_;
+            std::unique_ptr<metric_gauge> gauge_;
+            std::unique_ptr<metric_histogram> histogram_;
+
+            // Values at the end of the previous frame, to compute the frame's share
+            std::uint64_t last_value_ = 0;
+            std::array<std::uint64_t, metric_histogram::BUCKET_COUNT> last_buckets_{};
+            std::uint64_t last_sum_ = 0;
+        };
+
+        mutable std::mutex lock_;
+        std::vector<std::unique_ptr<entry>> entries_;
+
+        std::mutex callback_lock_;
+        identity_container<metrics_collector> collectors_;
+        identity_container<metrics_frame_callback> frame_callbacks_;
+
+        std::chrono::steady_clock::time_point creation_time_;
+        std::uint64_t last_frame_end_us_;
+        std::uint64_t frame_count_;
+
+        metrics_frame last_frame_;
+
+        entry *get_or_create(const std::string &name, const metric_type type);
+        void snapshot_entry(entry &ent, metric_sample &sample);
+
+    public:
+        explicit metrics_registry();
+
+        /**
+         * @brief Get a metric by name, creating it if needed.
+         *
+         * @returns Null if a metric with the same name but of another type exists.
+         */
+        metric_counter *counter(const std::string &name);
+        metric_gauge *gauge(const std::string &name);
+        metric_histogram *histogram(const std::string &name);
+
+        std::size_t add_collector(metrics_collector collector);
+        bool remove_collector(const std::size_t handle);
+
+        /**
+         * @brief Register a function called with each new frame snapshot, on the thread that ended the frame.
+         *
+         * The callback must not add or remove callbacks or collectors.
+         */
+        std::size_t add_frame_callback(metrics_frame_callback callback);
+        bool remove_frame_callback(const std::size_t handle);
+
+        /**
+         * @brief Run the collectors, snapshot every metric and hand the snapshot to the frame callbacks.
+         */
+        void end_frame();
+
+        metrics_frame last_frame() const;
+    };
+
+    /**
+     * @brief Write frame snapshots as CSV rows, one column per metric.
+     *
+     * Frames are queued and turned into rows by a thread of the writer, so the thread ending the frame never
+     * waits on the file. Everything queued is written before the writer is destroyed. The header is written
+     * again each time the set of metrics changes.
+     */
+    class metrics_csv_writer {
+        std::ofstream stream_;
+        std::vector<std::string> columns_;
+
+        std::mutex pending_lock_;
+        std::condition_variable pending_cond_;
+        std::vector<metrics_frame> pending_;
+        bool stopping_;
+
+        std::thread thread_;
+
+        void write_rows(const metrics_frame &frame);
+        void thread_loop();
+
+    public:
+        explicit metrics_csv_writer(const std::string &path);
+        ~metrics_csv_writer();
+
+        bool valid() const {
+            return thread_.joinable();
+        }
+
+        void write(const metrics_frame &frame);
+    };
+}
@@ -20,6 +20,8 @@
 #pragma once
 
 #include <common/vecx.h>
+
+#include <cstdint>
 #include <vector>
 
 namespace eka2l1::common {
@@ -27,9 +29,16 @@ namespace eka2l1::common {
 
     /**
      * \brief Basic interface for pixel plotter.
+     *
+     * Besides the per-pixel functions, the plotter exposes span functions, which work on a run of
+     * pixels on a single row. The default implementations of those fall back to plot_pixel and get_pixel,
+     * so a plotter only has to implement the per-pixel interface. Buffer plotters override the span
+     * functions to write whole rows at once.
      */
     class pixel_plotter {
     public:
+        virtual ~pixel_plotter() = default;
+
         /**
          * \brief Resize the bitmap the plotter handle to targeted size.
          * \param size A vector2 contains the width and height of the new bitmap.
@@ -56,29 +65,80 @@ namespace eka2l1::common {
          * \brief Get size of the bitmap this plotter handle.
          */
         virtual eka2l1::vec2 &get_size() = 0;
+
+        /**
+         * \brief Set a horizontal run of pixels to a color.
+         *
+         * Pixels outside of the bitmap are ignored.
+         *
+         * \param pos   Coordinate of the leftmost pixel of the span.
+         * \param count Number of pixels in the span.
+         * \param color The color to set.
+         */
+        virtual void fill_span(const eka2l1::vec2 &pos, const int count, const eka2l1::vecx<int, 4> &color);
+
+        /**
+         * \brief Blend a color over a horizontal run of pixels.
+         *
+         * The alpha channel of the color is its opacity: 255 is the same as fill_span, 0 leaves the
+         * pixels untouched.
+         *
+         * \param pos   Coordinate of the leftmost pixel of the span.
+         * \param count Number of pixels in the span.
+         * \param color The color to blend, in RGBA.
+         */
+        virtual void blend_span(const eka2l1::vec2 &pos, const int count, const eka2l1::vecx<int, 4> &color);
+
+        /**
+         * \brief Copy pixels to a row of the bitmap.
+         *
+         * \param pos    Coordinate of the destination of the first pixel.
+         * \param pixels Source pixels, each one is a 0xAARRGGBB word.
+         * \param count  Number of pixels to copy.
+         */
+        virtual void copy_row(const eka2l1::vec2 &pos, const std::uint32_t *pixels, const int count);
     };
 
     /**
-     * \brief A basic 24-bit bitmap pixel plotter.
-     * 
-     * This plotter only stores R,G and B channel, and ignore the alpha channel.
-     * This plotter produces 24 bits per pixel bitmap.
+     * \brief Base of plotters that stores pixels in a BMP-compatible buffer.
+     *
+     * Rows are stored top to bottom, each row is aligned to 4 bytes. Channels of a pixel are in BGR(A) order.
      */
-    class buffer_24bmp_pixel_plotter : public pixel_plotter {
+    class buffer_bmp_pixel_plotter : public pixel_plotter {
+    protected:
         eka2l1::vec2 size_;
         std::vector<std::uint8_t> buf_;
 
         int aligned_row_size_in_bytes;
+        int bytes_per_pixel_;
+
+        /**
+         * \brief Clip a span to the bitmap.
+         *
+         * \returns Pointer to the first pixel of the clipped span, or nullptr if nothing is left to draw.
+         */
+        std::uint8_t *clip_span(const eka2l1::vec2 &pos, int &count, int *skipped = nullptr);
 
     public:
+        explicit buffer_bmp_pixel_plotter(const int bytes_per_pixel);
+
         void resize(const eka2l1::vec2 &size) override;
-        void plot_pixel(const eka2l1::vec2 &pos, const eka2l1::vecx<int, 4> &color) override;
-        eka2l1::vecx<int, 4> get_pixel(const eka2l1::vec2 &pos) override;
+
+        void fill_span(const eka2l1::vec2 &pos, const int count, const eka2l1::vecx<int, 4> &color) override;
+        void blend_span(const eka2l1::vec2 &pos, const int count, const eka2l1::vecx<int, 4> &color) override;
 
         eka2l1::vec2 &get_size() override {
             return size_;
         }
 
+        const std::uint8_t *data() const {
+            return buf_.data();
+        }
+
+        int stride() const {
+            return aligned_row_size_in_bytes;
+        }
+
         /**
          * \brief Set the content in the bitmap buffer to a stream.
          * \param stream Write-only stream that will contains BMP file data.
@@ -86,6 +146,37 @@ namespace eka2l1::common {
         void save_to_bmp(wo_stream *stream);
     };
 
+    /**
+     * \brief A basic 24-bit bitmap pixel plotter.
+     * 
+     * This plotter only stores R,G and B channel, and ignore the alpha channel.
+     * This plotter produces 24 bits per pixel bitmap.
+     */
+    class buffer_24bmp_pixel_plotter : public buffer_bmp_pixel_plotter {
+    public:
+        explicit buffer_24bmp_pixel_plotter();
+
+        void plot_pixel(const eka2l1::vec2 &pos, const eka2l1::vecx<int, 4> &color) override;
+        eka2l1::vecx<int, 4> get_pixel(const eka2l1::vec2 &pos) override;
+
+        void copy_row(const eka2l1::vec2 &pos, const std::uint32_t *pixels, const int count) override;
+    };
+
+    /**
+     * \brief A 32-bit bitmap pixel plotter.
+     *
+     * This plotter stores all four channels, and produces 32 bits per pixel bitmap.
+     */
+    class buffer_32bmp_pixel_plotter : public buffer_bmp_pixel_plotter {
+    public:
+        explicit buffer_32bmp_pixel_plotter();
+
+        void plot_pixel(const eka2l1::vec2 &pos, const eka2l1::vecx<int, 4> &color) override;
+        eka2l1::vecx<int, 4> get_pixel(const eka2l1::vec2 &pos) override;
+
+        void copy_row(const eka2l1::vec2 &pos, const std::uint32_t *pixels, const int count) override;
+    };
+
     class painter {
         pixel_plotter *plotter_;
 
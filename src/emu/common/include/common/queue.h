@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <queue>
@@ -227,4 +228,71 @@ namespace eka2l1 {
             abort_ = false;
         }
     };
+
+    /**
+     * \brief A bounded, lock-free ring for one producer thread and one consumer thread.
+     *
+     * The producer only writes the tail, and the consumer only writes the head, so no lock is needed
+     * as long as there is at most one thread on each side. The capacity is rounded up to a power of two.
+     */
+    template <typename T>
+    class spsc_ring {
+        std::unique_ptr<T[]> items_;
+        std::size_t mask_;
+
+        alignas(64) std::atomic<std::size_t> head_;
+        alignas(64) std::atomic<std::size_t> tail_;
+
+    public:
+        explicit spsc_ring(const std::size_t capacity)
+            : head_(0)
+            , tail_(0) {
+            std::size_t rounded = 1;
+
+            while (rounded < capacity) {
+                rounded <<= 1;
+            }
+
+            items_ = std::make_unique<T[]>(rounded);
+            mask_ = rounded - 1;
+        }
+
+        bool try_push(const T &item) {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+            if (tail - head_.load(std::memory_order_acquire) > mask_) {
+                return false;
+            }
+
+            items_[tail & mask_] = item;
+            tail_.store(tail + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        bool try_pop(T &item) {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+
+            if (head == tail_.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            item = std::move(items_[head & mask_]);
+            head_.store(head + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        std::size_t size() const {
+            return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+        }
+
+        std::size_t capacity() const {
+            return mask_ + 1;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+    };
 }
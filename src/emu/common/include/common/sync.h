@@ -21,6 +21,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 
 namespace eka2l1::common {
@@ -72,6 +73,25 @@ namespace eka2l1::common {
         }
     };
 
+    /**
+     * @brief Block the calling thread while the word still holds the expected value.
+     *
+     * This is a futex on Linux and Android. On other platforms, waiters are parked on a condition
+     * variable picked from the word's address. Wakeups can be spurious, so always check the word again.
+     *
+     * @param word          The word to wait on.
+     * @param expected      The value that the word must still hold for the wait to happen.
+     */
+    void futex_wait(std::atomic<std::uint32_t> &word, const std::uint32_t expected);
+
+    /**
+     * @brief Wake threads waiting on a word. Call this after the word is modified.
+     *
+     * @param word          The word that threads wait on.
+     * @param all           True to wake every waiter, false to wake only one.
+     */
+    void futex_wake(std::atomic<std::uint32_t> &word, const bool all = false);
+
     class event_impl;
 
     class event {
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace eka2l1::common {
+    /**
+     * @brief A fixed-size pool of host worker threads.
+     *
+     * Tasks are executed in FIFO order. This is intended for short-lived host jobs (parsing, decompression,
+     * file extraction...) that do not touch guest state. The pool is joined on destruction, after all pending
+     * tasks are run.
+     */
+    class thread_pool {
+        std::vector<std::thread> workers_;
+        std::queue<std::function<void()>> tasks_;
+
+        std::mutex lock_;
+        std::condition_variable cond_;
+
+        std::string name_;
+        bool stopping_;
+
+        void worker_loop(const std::size_t index);
+
+    public:
+        /**
+         * @brief Construct a new thread pool.
+         *
+         * @param name          Name prefix of the worker threads.
+         * @param worker_count  Number of worker. Zero to use the number of host hardware threads.
+         */
+        explicit thread_pool(const std::string &name, const std::size_t worker_count = 0);
+        ~thread_pool();
+
+        thread_pool(const thread_pool &) = delete;
+        thread_pool &operator=(const thread_pool &) = delete;
+
+        void enqueue(std::function<void()> task);
+
+        /**
+         * @brief Queue a task and get a future to its result.
+         */
+        template <typename F>
+        auto submit(F &&func) -> std::future<decltype(func())> {
+            using result_type = decltype(func());
+
+            auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(func));
+            std::future<result_type> result = task->get_future();
+
+            enqueue([task]() {
+                (*task)();
+            });
+
+            return result;
+        }
+
+        std::size_t worker_count() const {
+            return workers_.size();
+        }
+    };
+
+    /**
+     * @brief Run a function over the index range [0, count) on the pool, and wait for all to finish.
+     *
+     * Indexes are handed out in contiguous batches, one per worker, to avoid queue traffic on large ranges.
+     */
+    template <typename F>
+    void parallel_for(thread_pool &pool, const std::size_t count, F func) {
+        if (count == 0) {
+            return;
+        }
+
+        const std::size_t batch_count = std::min<std::size_t>(count, pool.worker_count());
+        const std::size_t batch_size = (count + batch_count - 1) / batch_count;
+
+        std::vector<std::future<void>> waits;
+        waits.reserve(batch_count);
+
+        for (std::size_t start = 0; start < count; start += batch_size) {
+            const std::size_t end = std::min<std::size_t>(count, start + batch_size);
+
+            waits.push_back(pool.submit([start, end, &func]() {
+                for (std::size_t i = start; i < end; i++) {
+                    func(i);
+                }
+            }));
+        }
+
+        for (auto &wait : waits) {
+            wait.get();
+        }
+    }
+}
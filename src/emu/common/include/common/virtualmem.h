@@ -112,4 +112,44 @@ namespace eka2l1::common {
      * \brief Returns true if the platform doesn't allow write and executable memory at the same time.
     */
     bool is_memory_wx_exclusive();
+
+    /**
+     * \brief Create an immutable memory image that can be mapped copy-on-write at several places.
+     *
+     * \param data The content of the image.
+     * \param size Size of the image. Must be aligned to the host page size.
+     *
+     * \returns A handle to the image on success, or -1 if the host does not support it.
+    */
+    std::intptr_t create_cow_template(const void *data, const std::size_t size);
+
+    /**
+     * \brief Release the handle to a copy-on-write image. Existing mappings stay valid.
+    */
+    void destroy_cow_template(const std::intptr_t tmpl);
+
+    /**
+     * \brief Map a copy-on-write image over an already reserved region.
+     *
+     * Pages are shared with the image until they are written to, at which point the host gives the writer
+     * its own copy.
+     *
+     * \param tmpl The image handle.
+     * \param dest Host page aligned address to map the image to.
+     * \param size Size to map. Must be aligned to the host page size.
+     * \param perm The protection of the mapped pages.
+     *
+     * \returns True on success.
+    */
+    bool map_cow_template(const std::intptr_t tmpl, void *dest, const std::size_t size, const prot perm);
+
+    /**
+     * \brief Replace a copy-on-write mapping with fresh reserved memory, which must be committed again to use.
+    */
+    bool unmap_cow_template(void *dest, const std::size_t size);
+
+    /**
+     * \brief Get the number of bytes of a copy-on-write mapping that were written to, and so are no longer shared.
+    */
+    std::size_t get_cow_private_size(void *ptr, const std::size_t size);
 }
@@ -27,8 +27,23 @@
 #include <stdexcept>
 
 namespace eka2l1::common {
+    static int find_most_significant_bit_index(const std::uint64_t v) {
+        const std::uint32_t high = static_cast<std::uint32_t>(v >> 32);
+
+        if (high) {
+            return 63 - common::count_leading_zero(high);
+        }
+
+        return 31 - common::count_leading_zero(static_cast<std::uint32_t>(v));
+    }
+
     block_allocator::block_allocator(std::uint8_t *sptr, const std::size_t initial_max_size)
-        : space_based_allocator(sptr, initial_max_size) {
+        : space_based_allocator(sptr, initial_max_size)
+        , fl_bitmap(0)
+        , sl_bitmap()
+        , last_block(INVALID_BLOCK)
+        , space_size(0)
+        , stats() {
         const auto alignment_needed = (4 - reinterpret_cast<std::uint64_t>(ptr) % 4) % 4;
 
         if (alignment_needed > initial_max_size) {
@@ -38,80 +53,332 @@ namespace eka2l1::common {
         }
 
         ptr += alignment_needed;
+
+        for (std::uint32_t fl = 0; fl < FL_COUNT; fl++) {
+            std::fill(free_heads[fl], free_heads[fl] + SL_COUNT, INVALID_BLOCK);
+        }
+
+        if (initial_max_size > alignment_needed) {
+            grow_space(common::align(initial_max_size - alignment_needed, ALIGNMENT, 0));
+        }
     }
 
-    void *block_allocator::allocate(std::size_t bytes) {
-        std::size_t rounded_size = common::next_power_of_two(bytes);
-        std::uint64_t farthest_end_offset = 0;
+    void block_allocator::map_block_size(const std::size_t size, std::uint32_t &fl, std::uint32_t &sl) {
+        if (size < (static_cast<std::size_t>(1) << FL_SHIFT)) {
+            // Small blocks have a list for each size
+            fl = 0;
+            sl = static_cast<std::uint32_t>(size >> ALIGNMENT_LOG2);
 
-        const std::lock_guard<std::mutex> guard(lock);
+            return;
+        }
+
+        const int msb = find_most_significant_bit_index(size);
+
+        fl = static_cast<std::uint32_t>(msb) - FL_SHIFT + 1;
+        sl = static_cast<std::uint32_t>(size >> (msb - SL_COUNT_LOG2)) ^ SL_COUNT;
+    }
+
+    std::uint32_t block_allocator::new_block(const std::uint64_t offset, const std::size_t size) {
+        std::uint32_t index = 0;
+
+        if (!unused_blocks.empty()) {
+            index = unused_blocks.back();
+            unused_blocks.pop_back();
+        } else {
+            index = static_cast<std::uint32_t>(blocks.size());
+            blocks.emplace_back();
+        }
+
+        block_info &block = blocks[index];
+
+        block.offset = offset;
+        block.size = size;
+        block.prev_phys = INVALID_BLOCK;
+        block.next_phys = INVALID_BLOCK;
+        block.prev_free = INVALID_BLOCK;
+        block.next_free = INVALID_BLOCK;
+        block.active = false;
+
+        return index;
+    }
+
+    void block_allocator::remove_block(const std::uint32_t index) {
+        unused_blocks.push_back(index);
+    }
+
+    void block_allocator::insert_free(const std::uint32_t index) {
+        block_info &block = blocks[index];
+
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
+
+        map_block_size(block.size, fl, sl);
+
+        const std::uint32_t head = free_heads[fl][sl];
+
+        block.prev_free = INVALID_BLOCK;
+        block.next_free = head;
+
+        if (head != INVALID_BLOCK) {
+            blocks[head].prev_free = index;
+        }
 
-        for (auto &block : blocks) {
-            farthest_end_offset = common::max(farthest_end_offset, block.offset + block.size);
+        free_heads[fl][sl] = index;
 
-            if (!block.active && block.size >= rounded_size) {
-                // Gonna use it right away
-                if (block.size == rounded_size) {
-                    block.active = true;
-                    return block.offset + ptr;
+        fl_bitmap |= (1ULL << fl);
+        sl_bitmap[fl] |= (1U << sl);
+
+        stats.free_block_count_++;
+    }
+
+    void block_allocator::remove_free(const std::uint32_t index) {
+        block_info &block = blocks[index];
+
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
+
+        map_block_size(block.size, fl, sl);
+
+        if (block.prev_free != INVALID_BLOCK) {
+            blocks[block.prev_free].next_free = block.next_free;
+        }
+
+        if (block.next_free != INVALID_BLOCK) {
+            blocks[block.next_free].prev_free = block.prev_free;
+        }
+
+        if (free_heads[fl][sl] == index) {
+            free_heads[fl][sl] = block.next_free;
+
+            if (block.next_free == INVALID_BLOCK) {
+                sl_bitmap[fl] &= ~(1U << sl);
+
+                if (sl_bitmap[fl] == 0) {
+                    fl_bitmap &= ~(1ULL << fl);
                 }
+            }
+        }
+
+        block.prev_free = INVALID_BLOCK;
+        block.next_free = INVALID_BLOCK;
+
+        stats.free_block_count_--;
+    }
+
+    std::size_t block_allocator::get_search_size(const std::size_t size) {
+        // Round up to the next size class, so that any block in the found list is big enough
+        if (size >= (static_cast<std::size_t>(1) << FL_SHIFT)) {
+            return size + (static_cast<std::size_t>(1) << (find_most_significant_bit_index(size) - SL_COUNT_LOG2)) - 1;
+        }
+
+        return size;
+    }
+
+    std::uint32_t block_allocator::find_free(const std::size_t size) {
+        const std::size_t search_size = get_search_size(size);
+
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
+
+        map_block_size(search_size, fl, sl);
+
+        if (fl >= FL_COUNT) {
+            return INVALID_BLOCK;
+        }
+
+        std::uint32_t sl_map = sl_bitmap[fl] & (0xFFFFFFFFU << sl);
+
+        if (!sl_map) {
+            const std::uint64_t fl_map = fl_bitmap & (~0ULL << (fl + 1));
+
+            if (!fl_map) {
+                return INVALID_BLOCK;
+            }
 
-                void *ret_ptr = ptr + block.offset;
+            fl = static_cast<std::uint32_t>(common::find_least_significant_bit_one(fl_map));
+            sl_map = sl_bitmap[fl];
+        }
+
+        sl = static_cast<std::uint32_t>(common::find_least_significant_bit_one(sl_map));
+        return free_heads[fl][sl];
+    }
+
+    void block_allocator::grow_space(const std::size_t new_size) {
+        if (new_size <= space_size) {
+            return;
+        }
+
+        const std::size_t extra = new_size - space_size;
 
-                // Divide it to two if we can
-                block_info new_block;
-                new_block.active = true;
-                new_block.offset = block.offset;
-                new_block.size = rounded_size;
+        if ((last_block != INVALID_BLOCK) && !blocks[last_block].active) {
+            remove_free(last_block);
+            blocks[last_block].size += extra;
+            insert_free(last_block);
+        } else {
+            const std::uint32_t index = new_block(space_size, extra);
 
-                // Change our old block
-                block.size -= rounded_size;
-                block.offset += rounded_size;
+            blocks[index].prev_phys = last_block;
 
-                blocks.push_back(std::move(new_block));
-                return ret_ptr;
+            if (last_block != INVALID_BLOCK) {
+                blocks[last_block].next_phys = index;
             }
+
+            last_block = index;
+            insert_free(index);
         }
 
-        if (farthest_end_offset + rounded_size > max_size) {
-            // It's time to expand
-            if (!expand(common::max(max_size * 2, max_size + rounded_size))) {
+        space_size = new_size;
+    }
+
+    void *block_allocator::allocate(std::size_t bytes) {
+        const std::size_t size = common::align(common::max<std::size_t>(bytes, 1), ALIGNMENT);
+        const std::lock_guard<std::mutex> guard(lock);
+
+        std::uint32_t index = find_free(size);
+
+        if (index == INVALID_BLOCK) {
+            // It's time to expand. Double the space, or if that is over the limit, take just what is needed.
+            // The new free block must be big enough to be found by its size class.
+            const std::size_t needed = common::align(get_search_size(size), ALIGNMENT);
+            std::size_t target = common::max(max_size * 2, max_size + needed);
+
+            if (!expand(target)) {
+                target = max_size + needed;
+
+                if (!expand(target)) {
+                    stats.failed_allocation_count_++;
+                    return nullptr;
+                }
+            }
+
+            grow_space(space_size + common::align(target - max_size, ALIGNMENT, 0));
+            max_size = target;
+
+            index = find_free(size);
+
+            if (index == INVALID_BLOCK) {
+                stats.failed_allocation_count_++;
                 return nullptr;
             }
+        }
+
+        remove_free(index);
+
+        if (blocks[index].size - size >= ALIGNMENT) {
+            // Split the rest to a new free block
+            const std::uint32_t rest = new_block(blocks[index].offset + size, blocks[index].size - size);
+            const std::uint32_t next = blocks[index].next_phys;
+
+            blocks[rest].prev_phys = index;
+            blocks[rest].next_phys = next;
 
-            max_size = common::max(max_size * 2, max_size + rounded_size);
+            if (next != INVALID_BLOCK) {
+                blocks[next].prev_phys = rest;
+            } else {
+                last_block = rest;
+            }
+
+            blocks[index].next_phys = rest;
+            blocks[index].size = size;
+
+            insert_free(rest);
         }
 
-        // We try our best, but we can't
-        // We should alloc new block
-        block_info new_block;
-        new_block.active = true;
-        new_block.offset = farthest_end_offset;
-        new_block.size = rounded_size;
+        block_info &block = blocks[index];
+        block.active = true;
 
-        blocks.push_back(std::move(new_block));
+        active_blocks.emplace(block.offset, index);
 
-        return farthest_end_offset + ptr;
+        stats.used_size_ += block.size;
+        stats.allocation_count_++;
+
+        return ptr + block.offset;
     }
 
     bool block_allocator::freep(const void *tptr) {
-        const std::uint64_t to_free_offset = reinterpret_cast<const std::uint8_t *>(tptr) - ptr;
+        if (reinterpret_cast<const std::uint8_t *>(tptr) < ptr) {
+            return false;
+        }
 
+        const std::uint64_t to_free_offset = reinterpret_cast<const std::uint8_t *>(tptr) - ptr;
         const std::lock_guard<std::mutex> guard(lock);
 
-        auto ite = std::find_if(blocks.begin(), blocks.end(),
-            [to_free_offset](const block_info &info) {
-                return info.active && info.offset == to_free_offset;
-            });
+        auto ite = active_blocks.find(to_free_offset);
 
-        if (ite == blocks.end()) {
+        if (ite == active_blocks.end()) {
             return false;
         }
 
-        ite->active = false;
+        std::uint32_t index = ite->second;
+        active_blocks.erase(ite);
+
+        blocks[index].active = false;
+
+        stats.used_size_ -= blocks[index].size;
+        stats.free_count_++;
+
+        // Merge with the free neighbors, so that free space never stays split up
+        const std::uint32_t prev = blocks[index].prev_phys;
+
+        if ((prev != INVALID_BLOCK) && !blocks[prev].active) {
+            remove_free(prev);
+
+            blocks[prev].size += blocks[index].size;
+            blocks[prev].next_phys = blocks[index].next_phys;
+
+            if (blocks[index].next_phys != INVALID_BLOCK) {
+                blocks[blocks[index].next_phys].prev_phys = prev;
+            } else {
+                last_block = prev;
+            }
+
+            remove_block(index);
+            index = prev;
+        }
+
+        const std::uint32_t next = blocks[index].next_phys;
+
+        if ((next != INVALID_BLOCK) && !blocks[next].active) {
+            remove_free(next);
+
+            blocks[index].size += blocks[next].size;
+            blocks[index].next_phys = blocks[next].next_phys;
+
+            if (blocks[next].next_phys != INVALID_BLOCK) {
+                blocks[blocks[next].next_phys].prev_phys = index;
+            } else {
+                last_block = index;
+            }
+
+            remove_block(next);
+        }
+
+        insert_free(index);
         return true;
     }
 
+    block_allocator_stats block_allocator::get_stats() {
+        const std::lock_guard<std::mutex> guard(lock);
+        block_allocator_stats result = stats;
+
+        result.total_size_ = space_size;
+        result.free_size_ = space_size - stats.used_size_;
+        result.active_block_count_ = active_blocks.size();
+        result.largest_free_block_ = 0;
+
+        if (fl_bitmap) {
+            // The biggest block is in the highest non-empty list, but blocks in a list are not sorted
+            const int fl = find_most_significant_bit_index(fl_bitmap);
+            const int sl = find_most_significant_bit_index(sl_bitmap[fl]);
+
+            for (std::uint32_t index = free_heads[fl][sl]; index != INVALID_BLOCK; index = blocks[index].next_free) {
+                result.largest_free_block_ = common::max(result.largest_free_block_, blocks[index].size);
+            }
+        }
+
+        return result;
+    }
+
     bitmap_allocator::bitmap_allocator(const std::size_t total_bits)
         : words_((total_bits >> 5) + ((total_bits % 32 != 0) ? 1 : 0), 0xFFFFFFFF) {
     }
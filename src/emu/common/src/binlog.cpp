@@ -0,0 +1,617 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/binlog.h>
+#include <common/log.h>
+#include <common/thread.h>
+
+#include <fmt/args.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1::log {
+    std::atomic<bool> binary_logging{ false };
+
+    // Records reserved but not yet committed, so that stopping can wait for them
+    static std::atomic<std::uint32_t> binlog_records_in_flight{ 0 };
+
+    static constexpr std::uint32_t BINLOG_MAGIC = 0x4C424B45; // EKBL
+    static constexpr std::uint16_t BINLOG_VERSION = 1;
+
+    static constexpr std::size_t BINLOG_RING_SIZE = 1 << 20;
+    static constexpr std::size_t BINLOG_MAX_RECORD_SIZE = BINLOG_RING_SIZE / 4;
+    static constexpr int BINLOG_DRAIN_INTERVAL_MS = 5;
+
+    enum binlog_entry_kind : std::uint8_t {
+        BINLOG_ENTRY_SITE = 1,
+        BINLOG_ENTRY_RECORD = 2,
+        BINLOG_ENTRY_DROPPED = 3
+    };
+
+    /**
+     * \brief Single-producer single-consumer byte ring owned by one logging thread.
+     */
+    class binlog_ring {
+        std::vector<std::uint8_t> buf_;
+
+        std::atomic<std::uint64_t> head_;
+        std::atomic<std::uint64_t> tail_;
+        std::uint64_t pending_head_;
+
+        std::atomic<std::uint64_t> dropped_;
+        std::uint64_t dropped_reported_;
+
+    public:
+        const std::uint32_t index_;
+        std::atomic<bool> retired_;
+
+        explicit binlog_ring(const std::uint32_t index)
+            : buf_(BINLOG_RING_SIZE)
+            , head_(0)
+            , tail_(0)
+            , pending_head_(0)
+            , dropped_(0)
+            , dropped_reported_(0)
+            , index_(index)
+            , retired_(false) {
+        }
+
+        std::uint8_t *reserve(const std::size_t size) {
+            const std::uint64_t head = head_.load(std::memory_order_relaxed);
+            const std::uint64_t tail = tail_.load(std::memory_order_acquire);
+
+            const std::size_t offset = static_cast<std::size_t>(head & (BINLOG_RING_SIZE - 1));
+            const std::size_t contiguous = BINLOG_RING_SIZE - offset;
+
+            // A record never straddles the end of the ring. Skip to the start when it would.
+            const std::size_t needed = (size > contiguous) ? (contiguous + size) : size;
+
+            if ((size > BINLOG_MAX_RECORD_SIZE) || (BINLOG_RING_SIZE - (head - tail) < needed)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            if (size > contiguous) {
+                const std::uint32_t wrap_marker = 0;
+                std::memcpy(buf_.data() + offset, &wrap_marker, sizeof(std::uint32_t));
+
+                pending_head_ = head + contiguous + size;
+                return buf_.data();
+            }
+
+            pending_head_ = head + size;
+            return buf_.data() + offset;
+        }
+
+        void commit() {
+            head_.store(pending_head_, std::memory_order_release);
+        }
+
+        template <typename F>
+        void drain(F consume) {
+            const std::uint64_t head = head_.load(std::memory_order_acquire);
+            std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+
+            while (tail != head) {
+                const std::size_t offset = static_cast<std::size_t>(tail & (BINLOG_RING_SIZE - 1));
+
+                std::uint32_t size = 0;
+                std::memcpy(&size, buf_.data() + offset, sizeof(std::uint32_t));
+
+                if (size == 0) {
+                    tail += BINLOG_RING_SIZE - offset;
+                    continue;
+                }
+
+                consume(buf_.data() + offset);
+                tail += size;
+            }
+
+            tail_.store(tail, std::memory_order_release);
+        }
+
+        bool empty() const {
+            return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+        }
+
+        std::uint64_t take_new_drops() {
+            const std::uint64_t total = dropped_.load(std::memory_order_relaxed);
+            const std::uint64_t result = total - dropped_reported_;
+
+            dropped_reported_ = total;
+            return result;
+        }
+    };
+
+    struct binlog_site_key {
+        const char *file_;
+        const char *format_;
+        std::uint32_t line_;
+
+        bool operator==(const binlog_site_key &rhs) const {
+            return (file_ == rhs.file_) && (format_ == rhs.format_) && (line_ == rhs.line_);
+        }
+    };
+
+    struct binlog_site_key_hash {
+        std::size_t operator()(const binlog_site_key &key) const {
+            return std::hash<const void *>()(key.format_) ^ (std::hash<const void *>()(key.file_) << 1) ^ key.line_;
+        }
+    };
+
+    /**
+     * \brief Owns the rings of all logging threads, and the thread writing them to the file.
+     */
+    class binlog_writer {
+        std::mutex rings_lock_;
+        std::vector<std::shared_ptr<binlog_ring>> rings_;
+        std::uint32_t next_ring_index_;
+
+        std::mutex state_lock_;
+        std::condition_variable stop_cond_;
+        std::thread thread_;
+        bool stopping_;
+
+        std::FILE *file_;
+        std::unordered_map<binlog_site_key, std::uint32_t, binlog_site_key_hash> sites_;
+
+        template <typename T>
+        void write_value(const T &value) {
+            std::fwrite(&value, sizeof(T), 1, file_);
+        }
+
+        void write_string(const char *str) {
+            const std::uint32_t length = static_cast<std::uint32_t>(std::strlen(str));
+            write_value(length);
+            std::fwrite(str, 1, length, file_);
+        }
+
+        std::uint32_t get_site_id(const binlog_record_header &header) {
+            const binlog_site_key key{ header.file_, header.format_, header.line_ };
+            auto result = sites_.find(key);
+
+            if (result != sites_.end()) {
+                return result->second;
+            }
+
+            const std::uint32_t id = static_cast<std::uint32_t>(sites_.size());
+            sites_.emplace(key, id);
+
+            write_value(BINLOG_ENTRY_SITE);
+            write_value(id);
+            write_value(header.line_);
+            write_string(header.file_);
+            write_string(header.format_);
+
+            return id;
+        }
+
+        void drain_all() {
+            std::vector<std::shared_ptr<binlog_ring>> rings;
+
+            {
+                const std::lock_guard<std::mutex> guard(rings_lock_);
+                rings = rings_;
+            }
+
+            for (auto &ring : rings) {
+                ring->drain([&](const std::uint8_t *record) {
+                    binlog_record_header header;
+                    std::memcpy(&header, record, sizeof(binlog_record_header));
+
+                    const std::uint32_t site_id = get_site_id(header);
+
+                    write_value(BINLOG_ENTRY_RECORD);
+                    write_value(site_id);
+                    write_value(ring->index_);
+                    write_value(header.time_us_);
+                    write_value(header.level_);
+                    write_value(header.class_);
+                    write_value(header.arg_count_);
+                    write_value(header.args_size_);
+
+                    std::fwrite(record + sizeof(binlog_record_header), 1, header.args_size_, file_);
+                });
+
+                const std::uint64_t new_drops = ring->take_new_drops();
+
+                if (new_drops != 0) {
+                    write_value(BINLOG_ENTRY_DROPPED);
+                    write_value(ring->index_);
+                    write_value(new_drops);
+                }
+            }
+
+            std::fflush(file_);
+
+            // Forget rings of threads that exited, once everything they logged is written
+            const std::lock_guard<std::mutex> guard(rings_lock_);
+
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<binlog_ring> &ring) {
+                return ring->retired_.load() && ring->empty();
+            }),
+                rings_.end());
+        }
+
+        void thread_loop() {
+            common::set_thread_name("Binary log writer");
+            std::unique_lock<std::mutex> guard(state_lock_);
+
+            while (!stopping_) {
+                stop_cond_.wait_for(guard, std::chrono::milliseconds(BINLOG_DRAIN_INTERVAL_MS));
+
+                guard.unlock();
+                drain_all();
+                guard.lock();
+            }
+        }
+
+    public:
+        explicit binlog_writer()
+            : next_ring_index_(0)
+            , stopping_(false)
+            , file_(nullptr) {
+        }
+
+        ~binlog_writer() {
+            stop();
+        }
+
+        std::shared_ptr<binlog_ring> new_ring() {
+            const std::lock_guard<std::mutex> guard(rings_lock_);
+
+            auto ring = std::make_shared<binlog_ring>(next_ring_index_++);
+            rings_.push_back(ring);
+
+            return ring;
+        }
+
+        bool start(const std::string &path) {
+            const std::lock_guard<std::mutex> guard(state_lock_);
+
+            if (file_) {
+                return false;
+            }
+
+            file_ = std::fopen(path.c_str(), "wb");
+
+            if (!file_) {
+                return false;
+            }
+
+            write_value(BINLOG_MAGIC);
+            write_value(BINLOG_VERSION);
+
+            const std::uint16_t class_count = LOG_CLASS_COUNT;
+            write_value(class_count);
+
+            for (int i = 0; i < LOG_CLASS_COUNT; i++) {
+                write_string(log_class_to_string(static_cast<log_class>(i)));
+            }
+
+            sites_.clear();
+            stopping_ = false;
+            thread_ = std::thread([this]() { thread_loop(); });
+
+            binary_logging = true;
+            return true;
+        }
+
+        void stop() {
+            {
+                const std::lock_guard<std::mutex> guard(state_lock_);
+
+                if (!file_) {
+                    return;
+                }
+
+                binary_logging = false;
+                stopping_ = true;
+            }
+
+            stop_cond_.notify_one();
+            thread_.join();
+
+            // A thread that saw logging on before it was turned off may still be writing its record
+            while (binlog_records_in_flight.load() != 0) {
+                std::this_thread::yield();
+            }
+
+            // Pick up whatever was logged after the last drain
+            drain_all();
+
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    };
+
+    static binlog_writer &get_binlog_writer() {
+        static binlog_writer writer;
+        return writer;
+    }
+
+    namespace detail {
+        struct binlog_thread_ring {
+            std::shared_ptr<binlog_ring> ring_;
+
+            ~binlog_thread_ring() {
+                if (ring_) {
+                    ring_->retired_ = true;
+                }
+            }
+        };
+
+        static thread_local binlog_thread_ring thread_ring;
+
+        std::uint8_t *reserve_binlog_record(const std::size_t size) {
+            if (!thread_ring.ring_) {
+                thread_ring.ring_ = get_binlog_writer().new_ring();
+            }
+
+            binlog_records_in_flight++;
+
+            if (!binary_logging.load()) {
+                binlog_records_in_flight--;
+                return nullptr;
+            }
+
+            std::uint8_t *dest = thread_ring.ring_->reserve(size);
+
+            if (!dest) {
+                binlog_records_in_flight--;
+            }
+
+            return dest;
+        }
+
+        void commit_binlog_record() {
+            thread_ring.ring_->commit();
+            binlog_records_in_flight--;
+        }
+
+        std::uint64_t get_binlog_time_us() {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+    }
+
+    bool start_binary_log(const std::string &path) {
+        return get_binlog_writer().start(path);
+    }
+
+    void stop_binary_log() {
+        get_binlog_writer().stop();
+    }
+
+    template <typename T>
+    static bool read_binlog_value(std::FILE *file, T &value) {
+        return std::fread(&value, sizeof(T), 1, file) == 1;
+    }
+
+    static bool read_binlog_string(std::FILE *file, std::string &value) {
+        std::uint32_t length = 0;
+
+        if (!read_binlog_value(file, length)) {
+            return false;
+        }
+
+        value.resize(length);
+        return (length == 0) || (std::fread(value.data(), 1, length, file) == length);
+    }
+
+    static std::string format_binlog_message(const std::string &format, const std::uint8_t *args, const std::size_t args_size,
+        const std::uint8_t arg_count) {
+        fmt::dynamic_format_arg_store<fmt::format_context> store;
+        const std::uint8_t *end = args + args_size;
+
+        for (std::uint8_t i = 0; i < arg_count; i++) {
+            if (args >= end) {
+                return format + " <truncated arguments>";
+            }
+
+            const std::uint8_t type = *args++;
+
+            switch (type) {
+            case BINLOG_ARG_SIGNED: {
+                std::int64_t value = 0;
+                std::memcpy(&value, args, sizeof(std::int64_t));
+                store.push_back(value);
+                args += sizeof(std::int64_t);
+                break;
+            }
+
+            case BINLOG_ARG_UNSIGNED: {
+                std::uint64_t value = 0;
+                std::memcpy(&value, args, sizeof(std::uint64_t));
+                store.push_back(value);
+                args += sizeof(std::uint64_t);
+                break;
+            }
+
+            case BINLOG_ARG_FLOAT: {
+                double value = 0;
+                std::memcpy(&value, args, sizeof(double));
+                store.push_back(value);
+                args += sizeof(double);
+                break;
+            }
+
+            case BINLOG_ARG_POINTER: {
+                std::uint64_t value = 0;
+                std::memcpy(&value, args, sizeof(std::uint64_t));
+                store.push_back(reinterpret_cast<const void *>(static_cast<std::uintptr_t>(value)));
+                args += sizeof(std::uint64_t);
+                break;
+            }
+
+            case BINLOG_ARG_BOOL:
+                store.push_back(*args++ != 0);
+                break;
+
+            case BINLOG_ARG_CHAR:
+                store.push_back(static_cast<char>(*args++));
+                break;
+
+            case BINLOG_ARG_STRING: {
+                std::uint32_t length = 0;
+                std::memcpy(&length, args, sizeof(std::uint32_t));
+                args += sizeof(std::uint32_t);
+
+                store.push_back(std::string(reinterpret_cast<const char *>(args), length));
+                args += length;
+                break;
+            }
+
+            default:
+                return format + " <unknown argument type>";
+            }
+        }
+
+        try {
+            return fmt::vformat(format, store);
+        } catch (fmt::format_error &err) {
+            return format + " <format error: " + err.what() + ">";
+        }
+    }
+
+    bool decode_binary_log(const std::string &path, const std::function<void(const binlog_entry &)> &callback,
+        std::uint64_t *dropped) {
+        std::unique_ptr<std::FILE, decltype(&std::fclose)> file(std::fopen(path.c_str(), "rb"), &std::fclose);
+
+        if (!file) {
+            return false;
+        }
+
+        std::uint32_t magic = 0;
+        std::uint16_t version = 0;
+        std::uint16_t class_count = 0;
+
+        if (!read_binlog_value(file.get(), magic) || (magic != BINLOG_MAGIC) || !read_binlog_value(file.get(), version)
+            || (version != BINLOG_VERSION) || !read_binlog_value(file.get(), class_count)) {
+            return false;
+        }
+
+        std::vector<std::string> class_names(class_count);
+
+        for (auto &name : class_names) {
+            if (!read_binlog_string(file.get(), name)) {
+                return false;
+            }
+        }
+
+        struct site_info {
+            std::uint32_t line_;
+            std::string file_;
+            std::string format_;
+        };
+
+        std::vector<site_info> sites;
+        std::vector<std::uint8_t> args;
+
+        if (dropped) {
+            *dropped = 0;
+        }
+
+        std::uint8_t kind = 0;
+
+        // A log cut short by a crash still decodes up to the last complete entry
+        while (read_binlog_value(file.get(), kind)) {
+            switch (kind) {
+            case BINLOG_ENTRY_SITE: {
+                std::uint32_t id = 0;
+                site_info site;
+
+                if (!read_binlog_value(file.get(), id) || !read_binlog_value(file.get(), site.line_) || !read_binlog_string(file.get(), site.file_)
+                    || !read_binlog_string(file.get(), site.format_)) {
+                    return true;
+                }
+
+                if (id >= sites.size()) {
+                    sites.resize(id + 1);
+                }
+
+                sites[id] = std::move(site);
+                break;
+            }
+
+            case BINLOG_ENTRY_RECORD: {
+                std::uint32_t site_id = 0;
+                std::uint8_t arg_count = 0;
+                std::uint16_t cls = 0;
+                std::uint32_t args_size = 0;
+
+                binlog_entry entry;
+
+                if (!read_binlog_value(file.get(), site_id) || !read_binlog_value(file.get(), entry.thread_) || !read_binlog_value(file.get(), entry.time_us_)
+                    || !read_binlog_value(file.get(), entry.level_) || !read_binlog_value(file.get(), cls) || !read_binlog_value(file.get(), arg_count)
+                    || !read_binlog_value(file.get(), args_size)) {
+                    return true;
+                }
+
+                args.resize(args_size);
+
+                if ((args_size != 0) && (std::fread(args.data(), 1, args_size, file.get()) != args_size)) {
+                    return true;
+                }
+
+                if (site_id >= sites.size()) {
+                    return true;
+                }
+
+                const site_info &site = sites[site_id];
+
+                entry.class_name_ = (cls < class_names.size()) ? class_names[cls] : "Unknown";
+                entry.file_ = site.file_;
+                entry.line_ = site.line_;
+                entry.message_ = format_binlog_message(site.format_, args.data(), args.size(), arg_count);
+
+                callback(entry);
+                break;
+            }
+
+            case BINLOG_ENTRY_DROPPED: {
+                std::uint32_t thread = 0;
+                std::uint64_t count = 0;
+
+                if (!read_binlog_value(file.get(), thread) || !read_binlog_value(file.get(), count)) {
+                    return true;
+                }
+
+                if (dropped) {
+                    *dropped += count;
+                }
+
+                break;
+            }
+
+            default:
+                return true;
+            }
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/algorithm.h>
+#include <common/metrics.h>
+#include <common/thread.h>
+
+#include <fmt/format.h>
+
+namespace eka2l1::common {
+    static std::size_t get_histogram_bucket(const std::uint64_t value) {
+        // Bucket N holds values in [2^(N - 1), 2^N), bucket 0 only holds zero
+        std::size_t bucket = 0;
+        std::uint64_t remain = value;
+
+        while (remain != 0) {
+            bucket++;
+            remain >>= 1;
+        }
+
+        return common::min<std::size_t>(bucket, metric_histogram::BUCKET_COUNT - 1);
+    }
+
+    static double get_histogram_percentile(const std::array<std::uint64_t, metric_histogram::BUCKET_COUNT> &buckets,
+        const std::uint64_t count, const double percentile, const std::uint64_t max_value) {
+        if (count == 0) {
+            return 0.0;
+        }
+
+        const double rank = common::max(1.0, percentile * static_cast<double>(count));
+        std::uint64_t before = 0;
+
+        for (std::size_t i = 0; i < buckets.size(); i++) {
+            if (buckets[i] == 0) {
+                continue;
+            }
+
+            if (static_cast<double>(before + buckets[i]) >= rank) {
+                if (i == 0) {
+                    return 0.0;
+                }
+
+                const double low = static_cast<double>(1ULL << (i - 1));
+                const double high = static_cast<double>((1ULL << i) - 1);
+                const double fraction = (rank - static_cast<double>(before)) / static_cast<double>(buckets[i]);
+
+                return common::min(low + (high - low) * fraction, static_cast<double>(max_value));
+            }
+
+            before += buckets[i];
+        }
+
+        return static_cast<double>(max_value);
+    }
+
+    metric_histogram::metric_histogram()
+        : count_(0)
+        , sum_(0)
+        , frame_max_(0) {
+        for (auto &bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void metric_histogram::record(const std::uint64_t value) {
+        buckets_[get_histogram_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+
+        std::uint64_t current_max = frame_max_.load(std::memory_order_relaxed);
+
+        while ((value > current_max) && !frame_max_.compare_exchange_weak(current_max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    const metric_sample *metrics_frame::find(const std::string &name) const {
+        for (const metric_sample &sample : samples_) {
+            if (sample.name_ == name) {
+                return &sample;
+            }
+        }
+
+        return nullptr;
+    }
+
+    metrics_registry::metrics_registry()
+        : creation_time_(std::chrono::steady_clock::now())
+        , last_frame_end_us_(0)
+        , frame_count_(0) {
+    }
+
+    metrics_registry::entry *metrics_registry::get_or_create(const std::string &name, const metric_type type) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        for (auto &ent : entries_) {
+            if (ent->name_ == name) {
+                return (ent->type_ == type) ? ent.get() : nullptr;
+            }
+        }
+
+        auto ent = std::make_unique<entry>();
+        ent->name_ = name;
+        ent->type_ = type;
+
+        switch (type) {
+        case metric_type_counter:
+            ent->counter_ = std::make_unique<metric_counter>();
+            break;
+
+        case metric_type_gauge:
+            ent->gauge_ = std::make_unique<metric_gauge>();
+            break;
+
+        case metric_type_histogram:
+            ent->histogram_ = std::make_unique<metric_histogram>();
+            break;
+
+        default:
+            return nullptr;
+        }
+
+        entries_.push_back(std::move(ent));
+        return entries_.back().get();
+    }
+
+    metric_counter *metrics_registry::counter(const std::string &name) {
+        entry *ent = get_or_create(name, metric_type_counter);
+        return ent ? ent->counter_.get() : nullptr;
+    }
+
+    metric_gauge *metrics_registry::gauge(const std::string &name) {
+        entry *ent = get_or_create(name, metric_type_gauge);
+        return ent ? ent->gauge_.get() : nullptr;
+    }
+
+    metric_histogram *metrics_registry::histogram(const std::string &name) {
+        entry *ent = get_or_create(name, metric_type_histogram);
+        return ent ? ent->histogram_.get() : nullptr;
+    }
+
+    std::size_t metrics_registry::add_collector(metrics_collector collector) {
+        const std::lock_guard<std::mutex> guard(callback_lock_);
+        return collectors_.add(collector);
+    }
+
+    bool metrics_registry::remove_collector(const std::size_t handle) {
+        const std::lock_guard<std::mutex> guard(callback_lock_);
+        return collectors_.remove(handle);
+    }
+
+    std::size_t metrics_registry::add_frame_callback(metrics_frame_callback callback) {
+        const std::lock_guard<std::mutex> guard(callback_lock_);
+        return frame_callbacks_.add(callback);
+    }
+
+    bool metrics_registry::remove_frame_callback(const std::size_t handle) {
+        const std::lock_guard<std::mutex> guard(callback_lock_);
+        return frame_callbacks_.remove(handle);
+    }
+
+    void metrics_registry::snapshot_entry(entry &ent, metric_sample &sample) {
+        sample.name_ = ent.name_;
+        sample.type_ = ent.type_;
+
+        switch (ent.type_) {
+        case metric_type_counter: {
+            const std::uint64_t value = ent.counter_->value();
+
+            // A mirrored total can go back when its source is recreated
+            sample.value_ = static_cast<double>((value >= ent.last_value_) ? (value - ent.last_value_) : value);
+            sample.total_ = value;
+
+            ent.last_value_ = value;
+            break;
+        }
+
+        case metric_type_gauge:
+            sample.value_ = ent.gauge_->value();
+            break;
+
+        case metric_type_histogram: {
+            metric_histogram &hist = *ent.histogram_;
+            std::array<std::uint64_t, metric_histogram::BUCKET_COUNT> frame_buckets;
+
+            std::uint64_t frame_count = 0;
+
+            for (std::size_t i = 0; i < metric_histogram::BUCKET_COUNT; i++) {
+                const std::uint64_t bucket = hist.buckets_[i].load(std::memory_order_relaxed);
+
+                frame_buckets[i] = bucket - ent.last_buckets_[i];
+                frame_count += frame_buckets[i];
+
+                ent.last_buckets_[i] = bucket;
+            }
+
+            const std::uint64_t sum = hist.sum();
+            const std::uint64_t frame_max = hist.frame_max_.exchange(0, std::memory_order_relaxed);
+
+            sample.total_ = frame_count;
+            sample.value_ = frame_count ? static_cast<double>(sum - ent.last_sum_) / static_cast<double>(frame_count) : 0.0;
+            sample.p50_ = get_histogram_percentile(frame_buckets, frame_count, 0.50, frame_max);
+            sample.p95_ = get_histogram_percentile(frame_buckets, frame_count, 0.95, frame_max);
+            sample.max_ = frame_max;
+
+            ent.last_sum_ = sum;
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    void metrics_registry::end_frame() {
+        const std::lock_guard<std::mutex> callback_guard(callback_lock_);
+
+        for (auto &collector : collectors_) {
+            if (collector) {
+                collector();
+            }
+        }
+
+        metrics_frame frame;
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            const std::uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - creation_time_).count();
+
+            frame.index_ = frame_count_++;
+            frame.timestamp_us_ = now_us;
+            frame.frame_time_us_ = now_us - last_frame_end_us_;
+
+            last_frame_end_us_ = now_us;
+
+            frame.samples_.resize(entries_.size());
+
+            for (std::size_t i = 0; i < entries_.size(); i++) {
+                snapshot_entry(*entries_[i], frame.samples_[i]);
+            }
+
+            last_frame_ = frame;
+        }
+
+        for (auto &callback : frame_callbacks_) {
+            if (callback) {
+                callback(frame);
+            }
+        }
+    }
+
+    metrics_frame metrics_registry::last_frame() const {
+        const std::lock_guard<std::mutex> guard(lock_);
+        return last_frame_;
+    }
+
+    metrics_csv_writer::metrics_csv_writer(const std::string &path)
+        : stream_(path, std::ios::out | std::ios::trunc)
+        , stopping_(false) {
+        if (stream_.good()) {
+            thread_ = std::thread([this]() { thread_loop(); });
+        }
+    }
+
+    metrics_csv_writer::~metrics_csv_writer() {
+        if (!thread_.joinable()) {
+            return;
+        }
+
+        {
+            const std::lock_guard<std::mutex> guard(pending_lock_);
+            stopping_ = true;
+        }
+
+        pending_cond_.notify_one();
+        thread_.join();
+    }
+
+    void metrics_csv_writer::write(const metrics_frame &frame) {
+        if (!thread_.joinable()) {
+            return;
+        }
+
+        bool was_empty = false;
+
+        {
+            const std::lock_guard<std::mutex> guard(pending_lock_);
+
+            was_empty = pending_.empty();
+            pending_.push_back(frame);
+        }
+
+        // The writer thread is only waiting when nothing is queued
+        if (was_empty) {
+            pending_cond_.notify_one();
+        }
+    }
+
+    void metrics_csv_writer::thread_loop() {
+        common::set_thread_name("Metrics CSV writer");
+
+        std::vector<metrics_frame> frames;
+        std::unique_lock<std::mutex> guard(pending_lock_);
+
+        while (true) {
+            pending_cond_.wait(guard, [this]() {
+                return stopping_ || !pending_.empty();
+            });
+
+            if (pending_.empty()) {
+                break;
+            }
+
+            frames.swap(pending_);
+            guard.unlock();
+
+            for (const metrics_frame &frame : frames) {
+                write_rows(frame);
+            }
+
+            frames.clear();
+            guard.lock();
+        }
+
+        stream_.flush();
+    }
+
+    void metrics_csv_writer::write_rows(const metrics_frame &frame) {
+        std::vector<std::string> columns;
+        columns.reserve(frame.samples_.size());
+
+        for (const metric_sample &sample : frame.samples_) {
+            columns.push_back(sample.name_);
+        }
+
+        if (columns != columns_) {
+            columns_ = std::move(columns);
+            stream_ << "frame,timestamp_us,frame_time_us";
+
+            for (const metric_sample &sample : frame.samples_) {
+                if (sample.type_ == metric_type_histogram) {
+                    stream_ << fmt::format(",{0}.count,{0}.mean,{0}.p50,{0}.p95,{0}.max", sample.name_);
+                } else {
+                    stream_ << ',' << sample.name_;
+                }
+            }
+
+            stream_ << '\n';
+        }
+
+        stream_ << fmt::format("{},{},{}", frame.index_, frame.timestamp_us_, frame.frame_time_us_);
+
+        for (const metric_sample &sample : frame.samples_) {
+            if (sample.type_ == metric_type_histogram) {
+                stream_ << fmt::format(",{},{:.2f},{:.2f},{:.2f},{}", sample.total_, sample.value_, sample.p50_, sample.p95_, sample.max_);
+            } else if (sample.type_ == metric_type_counter) {
+                stream_ << fmt::format(",{}", static_cast<std::uint64_t>(sample.value_));
+            } else {
+                stream_ << fmt::format(",{:.2f}", sample.value_);
+            }
+        }
+
+        stream_ << '\n';
+    }
+}
@@ -17,15 +17,165 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/algorithm.h>
 #include <common/bitmap.h>
 #include <common/buffer.h>
 #include <common/paint.h>
+#include <common/platform.h>
 
+#include <cmath>
+#include <cstring>
 #include <stack>
 
+#if EKA2L1_ARCH(X64)
+#include <emmintrin.h>
+#elif EKA2L1_ARCH(ARM64)
+#include <arm_neon.h>
+#endif
+
 namespace eka2l1::common {
-    void buffer_24bmp_pixel_plotter::resize(const eka2l1::vec2 &size) {
-        aligned_row_size_in_bytes = size.x * 3;
+    // Least common multiple of 3 and 4 bytes per pixel, times the 16 bytes of a vector register.
+    // A pattern of this length starts and ends on a pixel boundary for both buffer formats.
+    static constexpr int SPAN_PATTERN_SIZE = 48;
+
+    static inline std::uint32_t div_255(const std::uint32_t value) {
+        return (value + 128 + ((value + 128) >> 8)) >> 8;
+    }
+
+    static void make_span_pattern(std::uint8_t *pattern, const int bytes_per_pixel, const eka2l1::vecx<int, 4> &color) {
+        const std::uint8_t pixel[4] = { static_cast<std::uint8_t>(color[2]), static_cast<std::uint8_t>(color[1]),
+            static_cast<std::uint8_t>(color[0]), static_cast<std::uint8_t>(color[3]) };
+
+        for (int i = 0; i < SPAN_PATTERN_SIZE; i++) {
+            pattern[i] = pixel[i % bytes_per_pixel];
+        }
+    }
+
+    /**
+     * \brief Repeat a pattern over a run of bytes.
+     */
+    static void fill_bytes(std::uint8_t *dest, std::size_t count, const std::uint8_t *pattern) {
+#if EKA2L1_ARCH(X64)
+        const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pattern));
+        const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pattern + 16));
+        const __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pattern + 32));
+
+        for (; count >= SPAN_PATTERN_SIZE; count -= SPAN_PATTERN_SIZE, dest += SPAN_PATTERN_SIZE) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), p0);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 16), p1);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 32), p2);
+        }
+#elif EKA2L1_ARCH(ARM64)
+        const uint8x16_t p0 = vld1q_u8(pattern);
+        const uint8x16_t p1 = vld1q_u8(pattern + 16);
+        const uint8x16_t p2 = vld1q_u8(pattern + 32);
+
+        for (; count >= SPAN_PATTERN_SIZE; count -= SPAN_PATTERN_SIZE, dest += SPAN_PATTERN_SIZE) {
+            vst1q_u8(dest, p0);
+            vst1q_u8(dest + 16, p1);
+            vst1q_u8(dest + 32, p2);
+        }
+#else
+        for (; count >= SPAN_PATTERN_SIZE; count -= SPAN_PATTERN_SIZE, dest += SPAN_PATTERN_SIZE) {
+            std::memcpy(dest, pattern, SPAN_PATTERN_SIZE);
+        }
+#endif
+
+        std::memcpy(dest, pattern, count);
+    }
+
+    /**
+     * \brief Blend a pattern over a run of bytes: dest = (dest * inv_alpha + premult) / 255.
+     *
+     * \param premult Pattern color, each channel already multiplied by the source alpha.
+     */
+    static void blend_bytes(std::uint8_t *dest, std::size_t count, const std::uint16_t *premult, const std::uint16_t inv_alpha) {
+#if EKA2L1_ARCH(X64)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i inv = _mm_set1_epi16(static_cast<short>(inv_alpha));
+        const __m128i round = _mm_set1_epi16(128);
+
+        for (; count >= SPAN_PATTERN_SIZE; count -= SPAN_PATTERN_SIZE, dest += SPAN_PATTERN_SIZE) {
+            for (int i = 0; i < SPAN_PATTERN_SIZE; i += 16) {
+                const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dest + i));
+
+                __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv);
+                __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv);
+
+                lo = _mm_add_epi16(_mm_add_epi16(lo, _mm_loadu_si128(reinterpret_cast<const __m128i *>(premult + i))), round);
+                hi = _mm_add_epi16(_mm_add_epi16(hi, _mm_loadu_si128(reinterpret_cast<const __m128i *>(premult + i + 8))), round);
+
+                lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+                hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_packus_epi16(lo, hi));
+            }
+        }
+#elif EKA2L1_ARCH(ARM64)
+        const uint8x8_t inv = vdup_n_u8(static_cast<std::uint8_t>(inv_alpha));
+
+        for (; count >= SPAN_PATTERN_SIZE; count -= SPAN_PATTERN_SIZE, dest += SPAN_PATTERN_SIZE) {
+            for (int i = 0; i < SPAN_PATTERN_SIZE; i += 16) {
+                const uint8x16_t d = vld1q_u8(dest + i);
+
+                const uint16x8_t lo = vmlal_u8(vld1q_u16(premult + i), vget_low_u8(d), inv);
+                const uint16x8_t hi = vmlal_u8(vld1q_u16(premult + i + 8), vget_high_u8(d), inv);
+
+                // Rounding shifts do the +128, same as div_255
+                vst1q_u8(dest + i, vcombine_u8(vrshrn_n_u16(vrsraq_n_u16(lo, lo, 8), 8),
+                                       vrshrn_n_u16(vrsraq_n_u16(hi, hi, 8), 8)));
+            }
+        }
+#endif
+
+        for (std::size_t i = 0; i < count; i++) {
+            dest[i] = static_cast<std::uint8_t>(div_255(dest[i] * inv_alpha + premult[i % SPAN_PATTERN_SIZE]));
+        }
+    }
+
+    void pixel_plotter::fill_span(const eka2l1::vec2 &pos, const int count, const eka2l1::vecx<int, 4> &color) {
+        for (int i = 0; i < count; i++) {
+            plot_pixel({ pos.x + i, pos.y }, color);
+        }
+    }
+
+    void pixel_plotter::blend_span(const eka2l1::vec2 &pos, const int count, const eka2l1::vecx<int, 4> &color) {
+        const eka2l1::vec2 size = get_size();
+
+        for (int i = 0; i < count; i++) {
+            const eka2l1::vec2 pixel_pos{ pos.x + i, pos.y };
+
+            if (pixel_pos.x < 0 || pixel_pos.x >= size.x || pixel_pos.y < 0 || pixel_pos.y >= size.y) {
+                continue;
+            }
+
+            eka2l1::vecx<int, 4> result = get_pixel(pixel_pos);
+
+            for (int j = 0; j < 3; j++) {
+                result[j] = static_cast<int>(div_255(result[j] * (255 - color[3]) + color[j] * color[3]));
+            }
+
+            result[3] = static_cast<int>(div_255(result[3] * (255 - color[3]) + 255 * color[3]));
+            plot_pixel(pixel_pos, result);
+        }
+    }
+
+    void pixel_plotter::copy_row(const eka2l1::vec2 &pos, const std::uint32_t *pixels, const int count) {
+        for (int i = 0; i < count; i++) {
+            const std::uint32_t pixel = pixels[i];
+
+            plot_pixel({ pos.x + i, pos.y }, { static_cast<int>((pixel >> 16) & 0xFF), static_cast<int>((pixel >> 8) & 0xFF),
+                                                 static_cast<int>(pixel & 0xFF), static_cast<int>(pixel >> 24) });
+        }
+    }
+
+    buffer_bmp_pixel_plotter::buffer_bmp_pixel_plotter(const int bytes_per_pixel)
+        : aligned_row_size_in_bytes(0)
+        , bytes_per_pixel_(bytes_per_pixel) {
+    }
+
+    void buffer_bmp_pixel_plotter::resize(const eka2l1::vec2 &size) {
+        aligned_row_size_in_bytes = size.x * bytes_per_pixel_;
 
         // Align row pixel size
         if (aligned_row_size_in_bytes % 4 != 0) {
@@ -36,31 +186,84 @@ namespace eka2l1::common {
         size_ = size;
     }
 
-    void buffer_24bmp_pixel_plotter::plot_pixel(const eka2l1::vec2 &pos, const eka2l1::vecx<int, 4> &color) {
-        if (pos.x < 0 || pos.x >= size_.x || pos.y < 0 || pos.y >= size_.y) {
+    std::uint8_t *buffer_bmp_pixel_plotter::clip_span(const eka2l1::vec2 &pos, int &count, int *skipped) {
+        if (pos.y < 0 || pos.y >= size_.y || pos.x >= size_.x || count <= 0) {
+            return nullptr;
+        }
+
+        int start_x = pos.x;
+
+        if (start_x < 0) {
+            count += start_x;
+            start_x = 0;
+        }
+
+        count = common::min(count, size_.x - start_x);
+
+        if (count <= 0) {
+            return nullptr;
+        }
+
+        if (skipped) {
+            *skipped = start_x - pos.x;
+        }
+
+        return buf_.data() + aligned_row_size_in_bytes * pos.y + start_x * bytes_per_pixel_;
+    }
+
+    void buffer_bmp_pixel_plotter::fill_span(const eka2l1::vec2 &pos, const int count, const eka2l1::vecx<int, 4> &color) {
+        int clipped_count = count;
+        std::uint8_t *dest = clip_span(pos, clipped_count);
+
+        if (!dest) {
             return;
         }
 
-        // Byte byte transparency :(
-        buf_[(aligned_row_size_in_bytes * pos.y) + pos.x * 3] = color[2];
-        buf_[(aligned_row_size_in_bytes * pos.y) + pos.x * 3 + 1] = color[1];
-        buf_[(aligned_row_size_in_bytes * pos.y) + pos.x * 3 + 2] = color[0];
+        std::uint8_t pattern[SPAN_PATTERN_SIZE];
+        make_span_pattern(pattern, bytes_per_pixel_, color);
+
+        fill_bytes(dest, static_cast<std::size_t>(clipped_count) * bytes_per_pixel_, pattern);
     }
 
-    eka2l1::vecx<int, 4> buffer_24bmp_pixel_plotter::get_pixel(const eka2l1::vec2 &pos) {
-        return { buf_[(aligned_row_size_in_bytes * pos.y) + pos.x * 3 + 2],
-            buf_[(aligned_row_size_in_bytes * pos.y) + pos.x * 3 + 1],
-            buf_[(aligned_row_size_in_bytes * pos.y) + pos.x * 3],
-            255 };
+    void buffer_bmp_pixel_plotter::blend_span(const eka2l1::vec2 &pos, const int count, const eka2l1::vecx<int, 4> &color) {
+        if (color[3] <= 0) {
+            return;
+        }
+
+        if (color[3] >= 255) {
+            fill_span(pos, count, color);
+            return;
+        }
+
+        int clipped_count = count;
+        std::uint8_t *dest = clip_span(pos, clipped_count);
+
+        if (!dest) {
+            return;
+        }
+
+        // The alpha byte of 32-bit buffers blends toward full opacity
+        const std::uint16_t premult_pixel[4] = { static_cast<std::uint16_t>(color[2] * color[3]),
+            static_cast<std::uint16_t>(color[1] * color[3]), static_cast<std::uint16_t>(color[0] * color[3]),
+            static_cast<std::uint16_t>(255 * color[3]) };
+
+        std::uint16_t premult[SPAN_PATTERN_SIZE];
+
+        for (int i = 0; i < SPAN_PATTERN_SIZE; i++) {
+            premult[i] = premult_pixel[i % bytes_per_pixel_];
+        }
+
+        blend_bytes(dest, static_cast<std::size_t>(clipped_count) * bytes_per_pixel_, premult,
+            static_cast<std::uint16_t>(255 - color[3]));
     }
 
-    void buffer_24bmp_pixel_plotter::save_to_bmp(wo_stream *stream) {
+    void buffer_bmp_pixel_plotter::save_to_bmp(wo_stream *stream) {
         common::bmp_header header;
         header.file_size = static_cast<std::uint32_t>(sizeof(common::bmp_header) + sizeof(common::dib_header_v1) + buf_.size());
         header.pixel_array_offset = header.file_size - static_cast<std::uint32_t>(buf_.size());
 
         common::dib_header_v1 dib_header;
-        dib_header.bit_per_pixels = 24;
+        dib_header.bit_per_pixels = static_cast<std::uint16_t>(bytes_per_pixel_ * 8);
         dib_header.color_plane_count = 1;
         dib_header.important_color_count = 0;
         dib_header.palette_count = 0;
@@ -76,6 +279,93 @@ namespace eka2l1::common {
         stream->write(&buf_[0], static_cast<std::uint32_t>(buf_.size()));
     }
 
+    buffer_24bmp_pixel_plotter::buffer_24bmp_pixel_plotter()
+        : buffer_bmp_pixel_plotter(3) {
+    }
+
+    void buffer_24bmp_pixel_plotter::plot_pixel(const eka2l1::vec2 &pos, const eka2l1::vecx<int, 4> &color) {
+        if (pos.x < 0 || pos.x >= size_.x || pos.y < 0 || pos.y >= size_.y) {
+            return;
+        }
+
+        // Byte byte transparency :(
+        buf_[(aligned_row_size_in_bytes * pos.y) + pos.x * 3] = color[2];
+        buf_[(aligned_row_size_in_bytes * pos.y) + pos.x * 3 + 1] = color[1];
+        buf_[(aligned_row_size_in_bytes * pos.y) + pos.x * 3 + 2] = color[0];
+    }
+
+    eka2l1::vecx<int, 4> buffer_24bmp_pixel_plotter::get_pixel(const eka2l1::vec2 &pos) {
+        return { buf_[(aligned_row_size_in_bytes * pos.y) + pos.x * 3 + 2],
+            buf_[(aligned_row_size_in_bytes * pos.y) + pos.x * 3 + 1],
+            buf_[(aligned_row_size_in_bytes * pos.y) + pos.x * 3],
+            255 };
+    }
+
+    void buffer_24bmp_pixel_plotter::copy_row(const eka2l1::vec2 &pos, const std::uint32_t *pixels, const int count) {
+        int clipped_count = count;
+        int skipped = 0;
+
+        std::uint8_t *dest = clip_span(pos, clipped_count, &skipped);
+
+        if (!dest) {
+            return;
+        }
+
+        pixels += skipped;
+
+#if EKA2L1_ARCH(ARM64)
+        // Deinterleave BGRA and store back only BGR
+        for (; clipped_count >= 16; clipped_count -= 16, pixels += 16, dest += 48) {
+            const uint8x16x4_t source = vld4q_u8(reinterpret_cast<const std::uint8_t *>(pixels));
+            const uint8x16x3_t result = { { source.val[0], source.val[1], source.val[2] } };
+
+            vst3q_u8(dest, result);
+        }
+#endif
+
+        for (int i = 0; i < clipped_count; i++) {
+            dest[i * 3] = static_cast<std::uint8_t>(pixels[i]);
+            dest[i * 3 + 1] = static_cast<std::uint8_t>(pixels[i] >> 8);
+            dest[i * 3 + 2] = static_cast<std::uint8_t>(pixels[i] >> 16);
+        }
+    }
+
+    buffer_32bmp_pixel_plotter::buffer_32bmp_pixel_plotter()
+        : buffer_bmp_pixel_plotter(4) {
+    }
+
+    void buffer_32bmp_pixel_plotter::plot_pixel(const eka2l1::vec2 &pos, const eka2l1::vecx<int, 4> &color) {
+        if (pos.x < 0 || pos.x >= size_.x || pos.y < 0 || pos.y >= size_.y) {
+            return;
+        }
+
+        std::uint8_t *dest = buf_.data() + (aligned_row_size_in_bytes * pos.y) + pos.x * 4;
+
+        dest[0] = static_cast<std::uint8_t>(color[2]);
+        dest[1] = static_cast<std::uint8_t>(color[1]);
+        dest[2] = static_cast<std::uint8_t>(color[0]);
+        dest[3] = static_cast<std::uint8_t>(color[3]);
+    }
+
+    eka2l1::vecx<int, 4> buffer_32bmp_pixel_plotter::get_pixel(const eka2l1::vec2 &pos) {
+        const std::uint8_t *source = buf_.data() + (aligned_row_size_in_bytes * pos.y) + pos.x * 4;
+        return { source[2], source[1], source[0], source[3] };
+    }
+
+    void buffer_32bmp_pixel_plotter::copy_row(const eka2l1::vec2 &pos, const std::uint32_t *pixels, const int count) {
+        int clipped_count = count;
+        int skipped = 0;
+
+        std::uint8_t *dest = clip_span(pos, clipped_count, &skipped);
+
+        if (!dest) {
+            return;
+        }
+
+        // 0xAARRGGBB words are BGRA in memory on little-endian hosts, which is our layout
+        std::memcpy(dest, pixels + skipped, static_cast<std::size_t>(clipped_count) * 4);
+    }
+
     painter::painter(pixel_plotter *plotter)
         : plotter_(plotter) {
     }
@@ -83,12 +373,9 @@ namespace eka2l1::common {
     void painter::new_art(const eka2l1::vec2 &size) {
         plotter_->resize(size);
 
-        // Clear the bitmap
-        for (int i = 0; i < size.x; i++) {
-            for (int j = 0; j < size.y; j++) {
-                // Plot empty white transparent pixel
-                plotter_->plot_pixel({ i, j }, { 255, 255, 255, 255 });
-            }
+        // Clear the bitmap with empty white transparent pixels
+        for (int j = 0; j < size.y; j++) {
+            plotter_->fill_span({ 0, j }, size.x, { 255, 255, 255, 255 });
         }
     }
 
@@ -108,12 +395,16 @@ namespace eka2l1::common {
 
         const auto psize = plotter_->get_size();
 
+        auto should_fill = [&](eka2l1::vecx<int, 4> pix) {
+            return fill_mode ? (pix != brush_col_) : (pix == old_color);
+        };
+
         while (!floody.empty()) {
             eka2l1::vec2 ant_pos = std::move(floody.top());
             floody.pop();
 
             // Scan for the beginning of our pixels sequence
-            while (ant_pos.x >= 0 && fill_mode ? (plotter_->get_pixel(ant_pos) != brush_col_) : (plotter_->get_pixel(ant_pos) == old_color)) {
+            while (ant_pos.x >= 0 && should_fill(plotter_->get_pixel(ant_pos))) {
                 ant_pos.x--;
             }
 
@@ -123,37 +414,43 @@ namespace eka2l1::common {
                 span_above = false;
                 span_below = false;
 
-                while (ant_pos.x < psize.x && fill_mode ? (plotter_->get_pixel(ant_pos) != brush_col_) : (plotter_->get_pixel(ant_pos) == old_color)) {
-                    // Plot our pixel
-                    plotter_->plot_pixel(ant_pos, brush_col_);
-
-                    auto pix = plotter_->get_pixel(ant_pos + vec2(0, -1));
+                const int span_start = ant_pos.x;
 
+                while (ant_pos.x < psize.x && should_fill(plotter_->get_pixel(ant_pos))) {
                     // Scanning above. Well, is there a sign of a sequence to be fill ?
-                    if (!span_above && ant_pos.y > 0 && (fill_mode ? pix != brush_col_ : pix == old_color)) {
-                        // There is. Enable span above, to check for end of sequence
-                        floody.push(ant_pos + vec2(0, -1));
-                        span_above = true;
-                    } else if (span_above && ant_pos.y > 0 && (fill_mode ? pix == brush_col_ : pix != old_color)) {
-                        // End of sequeuce, disable span above, check for new sequence to push
-                        span_above = false;
+                    if (ant_pos.y > 0) {
+                        const bool fill_above = should_fill(plotter_->get_pixel(ant_pos + vec2(0, -1)));
+
+                        if (!span_above && fill_above) {
+                            // There is. Enable span above, to check for end of sequence
+                            floody.push(ant_pos + vec2(0, -1));
+                            span_above = true;
+                        } else if (span_above && !fill_above) {
+                            // End of sequeuce, disable span above, check for new sequence to push
+                            span_above = false;
+                        }
                     }
 
-                    pix = plotter_->get_pixel(ant_pos + vec2(0, 1));
-
                     // Scanning below. Well, is there a sign of a sequence to be fill ?
-                    if (!span_below && ant_pos.y < psize.y - 1 && (fill_mode ? pix != brush_col_ : pix == old_color)) {
-                        // There is. Enable span below, to check for end of sequence
-                        floody.push(ant_pos + vec2(0, 1));
-                        span_below = true;
-                    } else if (span_below && ant_pos.y < psize.y - 1 && (fill_mode ? pix == brush_col_ : pix != old_color)) {
-                        // End of sequeuce, disable span below, check for new sequence to push
-                        span_below = false;
+                    if (ant_pos.y < psize.y - 1) {
+                        const bool fill_below = should_fill(plotter_->get_pixel(ant_pos + vec2(0, 1)));
+
+                        if (!span_below && fill_below) {
+                            // There is. Enable span below, to check for end of sequence
+                            floody.push(ant_pos + vec2(0, 1));
+                            span_below = true;
+                        } else if (span_below && !fill_below) {
+                            // End of sequeuce, disable span below, check for new sequence to push
+                            span_below = false;
+                        }
                     }
 
                     // Increase the plot horizontal pos
                     ant_pos.x++;
                 }
+
+                // The rows above and below are only read, so the sequence can be plotted in one go
+                plotter_->fill_span({ span_start, ant_pos.y }, ant_pos.x - span_start, brush_col_);
             }
         }
     }
@@ -288,6 +585,31 @@ namespace eka2l1::common {
     }
 
     void painter::line_from_to(const eka2l1::vec2 &start, const eka2l1::vec2 &end) {
+        // Axis-aligned lines cover the same pixels as below: a horizontal line grows its thickness upward,
+        // a vertical line grows it to the left. Draw them as spans.
+        if ((start.y == end.y) && (start.x != end.x)) {
+            const int width = (brush_thick_ + 1) / 2;
+            const int left = common::min(start.x, end.x);
+
+            for (int i = 0; i < common::max(width, 1); i++) {
+                plotter_->fill_span({ left, start.y - i }, std::abs(end.x - start.x) + 1, brush_col_);
+            }
+
+            return;
+        }
+
+        if ((start.x == end.x) && (start.y != end.y)) {
+            const int width = common::max((brush_thick_ + 1) / 2, 1);
+            const int top = common::min(start.y, end.y);
+            const int bottom = common::max(start.y, end.y);
+
+            for (int y = top; y <= bottom; y++) {
+                plotter_->fill_span({ start.x - width + 1, y }, width, brush_col_);
+            }
+
+            return;
+        }
+
         // Bresenham Line-Drawing Algorithm
         const vec2 delta = (end - start).abs();
         const int derr = delta.x - delta.y;
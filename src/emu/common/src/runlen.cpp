@@ -21,8 +21,17 @@
 #include <common/algorithm.h>
 #include <common/buffer.h>
 #include <common/log.h>
+#include <common/platform.h>
 #include <common/runlen.h>
 
+#include <cstring>
+
+#if EKA2L1_ARCH(X64)
+#include <emmintrin.h>
+#elif EKA2L1_ARCH(ARM64)
+#include <arm_neon.h>
+#endif
+
 namespace eka2l1 {
     template <size_t BIT>
     bool compress_rle(common::ro_stream *source, common::wo_stream *dest, std::size_t &dest_size) {
@@ -180,187 +189,235 @@ namespace eka2l1 {
         }
     }
 
-    template <>
-    void decompress_rle_fast_route<8>(const std::uint8_t *source, const std::size_t source_size, std::uint8_t *dest, std::size_t &dest_size) {
-        const std::uint8_t *source_start = source;
-        const std::uint8_t *source_end = source_start + source_size;
-
-        std::uint8_t *dest_start = reinterpret_cast<std::uint8_t*>(dest);
-        std::uint8_t *dest_end = dest_start + dest_size;
+    // Multiple of every pixel size (1 to 4 bytes) and of the vector width, so that stores of the
+    // pattern stay in phase with the pixels.
+    static constexpr std::size_t RLE_FILL_PATTERN_SIZE = 48;
+    static constexpr std::size_t RLE_COPY_CHUNK_SIZE = 16;
 
-        dest_size = 0;
+    template <std::size_t PIXEL_SIZE>
+    static void make_fill_pattern(std::uint8_t *pattern, const std::uint8_t *value) {
+        if (PIXEL_SIZE == 1) {
+            std::memset(pattern, *value, RLE_FILL_PATTERN_SIZE);
+            return;
+        }
 
-        while ((source_start < source_end) && (!dest || (dest_start < dest_end))) {
-            std::int32_t repeat = static_cast<std::int8_t>(*source_start++);
-            if (repeat >= 0) {
-                repeat = common::min<std::int32_t>(repeat, static_cast<std::int32_t>(dest_end - dest_start));
+        std::memcpy(pattern, value, PIXEL_SIZE);
 
-                if (dest_start) {
-                    memset(dest_start, *source_start, repeat + 1);
-                    dest_start += repeat + 1;
-                }
-                
-                dest_size += repeat + 1;
-                source_start++;
-            } else {
-                std::int32_t copy_count = common::min<std::int32_t>(-repeat, static_cast<std::int32_t>(dest_end - dest_start));
-                if (dest_start) {
-                    memcpy(dest_start, source_start, copy_count);
-                    dest_start += copy_count;
-                }
+        // Double the pattern on each copy
+        for (std::size_t filled = PIXEL_SIZE; filled < RLE_FILL_PATTERN_SIZE; filled *= 2) {
+            std::memcpy(pattern + filled, pattern, common::min<std::size_t>(filled, RLE_FILL_PATTERN_SIZE - filled));
+        }
+    }
 
-                source_start += copy_count;
-                dest_size += copy_count;
-            }
+    /**
+     * @brief Store the fill pattern until at least the given size is written.
+     *
+     * Up to RLE_FILL_PATTERN_SIZE - 1 bytes are written past the size. The caller makes sure the destination
+     * has room for them; they are rewritten by the runs that follow.
+     */
+    static void fill_pattern_wild(std::uint8_t *dest, const std::uint8_t *pattern, const std::size_t size) {
+#if EKA2L1_ARCH(X64)
+        const __m128i pattern0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pattern));
+        const __m128i pattern1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pattern + 16));
+        const __m128i pattern2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pattern + 32));
+
+        for (std::size_t written = 0; written < size; written += RLE_FILL_PATTERN_SIZE) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + written), pattern0);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + written + 16), pattern1);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + written + 32), pattern2);
+        }
+#elif EKA2L1_ARCH(ARM64)
+        const uint8x16_t pattern0 = vld1q_u8(pattern);
+        const uint8x16_t pattern1 = vld1q_u8(pattern + 16);
+        const uint8x16_t pattern2 = vld1q_u8(pattern + 32);
+
+        for (std::size_t written = 0; written < size; written += RLE_FILL_PATTERN_SIZE) {
+            vst1q_u8(dest + written, pattern0);
+            vst1q_u8(dest + written + 16, pattern1);
+            vst1q_u8(dest + written + 32, pattern2);
+        }
+#else
+        for (std::size_t written = 0; written < size; written += RLE_FILL_PATTERN_SIZE) {
+            std::memcpy(dest + written, pattern, RLE_FILL_PATTERN_SIZE);
         }
+#endif
     }
 
-    template <>
-    void decompress_rle_fast_route<12>(const std::uint8_t *source, const std::size_t source_size, std::uint8_t *dest, std::size_t &dest_size) {
-        const std::uint16_t *source_start = reinterpret_cast<const std::uint16_t*>(source);
-        const std::uint16_t *source_end = source_start + (source_size + 1) / 2;
+    /**
+     * @brief Copy in chunks until at least the given size is copied.
+     *
+     * Up to RLE_COPY_CHUNK_SIZE - 1 bytes past the size are read from the source and written to the destination.
+     */
+    static void copy_wild(std::uint8_t *dest, const std::uint8_t *source, const std::size_t size) {
+#if EKA2L1_ARCH(X64)
+        for (std::size_t copied = 0; copied < size; copied += RLE_COPY_CHUNK_SIZE) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + copied), _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + copied)));
+        }
+#elif EKA2L1_ARCH(ARM64)
+        for (std::size_t copied = 0; copied < size; copied += RLE_COPY_CHUNK_SIZE) {
+            vst1q_u8(dest + copied, vld1q_u8(source + copied));
+        }
+#else
+        std::memcpy(dest, source, size);
+#endif
+    }
 
-        std::uint16_t *dest_start = reinterpret_cast<std::uint16_t*>(dest);
-        std::uint16_t *dest_end = dest_start + ((dest_size + 1) / 2);
+    /**
+     * @brief Decode a byte-aligned RLE stream, where each run is either a repeated pixel or a copy of pixels.
+     *
+     * Runs are written with whole vector stores while the destination has room for the overshoot, and exactly
+     * near its end. When the destination is NULL, only the decompressed size is calculated.
+     */
+    template <std::size_t PIXEL_SIZE>
+    static void decompress_rle_pixels(const std::uint8_t *source, const std::size_t source_size, std::uint8_t *dest, std::size_t &dest_size) {
+        const std::uint8_t *source_end = source + source_size;
+        const std::uint8_t *dest_end = dest + dest_size;
 
-        std::size_t original_size = dest_size;
         dest_size = 0;
 
-        while ((source_start < source_end) && (!dest || (dest_start < dest_end))) {
-            std::uint16_t val = *source_start++;
+        while (source < source_end) {
+            const std::int32_t repeat = static_cast<std::int8_t>(*source++);
 
-            std::uint32_t repeat_count = common::min<std::uint32_t>(static_cast<std::uint32_t>((val >> 12) & 0xF),
-                static_cast<const std::uint32_t>(dest_end - dest_start));
-            
-            val &= 0x0FFF;
+            if (repeat >= 0) {
+                std::size_t count = static_cast<std::size_t>(repeat) + 1;
 
-            if (dest) {
-                for (std::uint32_t i = 0; i <= repeat_count; i++) {
-                    *dest_start++ = val;
+                if (static_cast<std::size_t>(source_end - source) < PIXEL_SIZE) {
+                    break;
                 }
-            }
 
-            dest_size += 2 * (repeat_count + 1);
-        }
-    }
+                bool dest_full = false;
 
-    template <>
-    void decompress_rle_fast_route<16>(const std::uint8_t *source, const std::size_t source_size, std::uint8_t *dest, std::size_t &dest_size) {
-        const std::uint8_t *source_start = source;
-        const std::uint8_t *source_end = source_start + source_size;
+                if (dest) {
+                    const std::size_t dest_left = dest_end - dest;
+
+                    if (dest_left >= count * PIXEL_SIZE + RLE_FILL_PATTERN_SIZE) {
+                        std::uint8_t pattern[RLE_FILL_PATTERN_SIZE];
+
+                        make_fill_pattern<PIXEL_SIZE>(pattern, source);
+                        fill_pattern_wild(dest, pattern, count * PIXEL_SIZE);
+                    } else {
+                        if (count >= dest_left / PIXEL_SIZE) {
+                            count = dest_left / PIXEL_SIZE;
+                            dest_full = true;
+                        }
+
+                        for (std::size_t i = 0; i < count; i++) {
+                            std::memcpy(dest + i * PIXEL_SIZE, source, PIXEL_SIZE);
+                        }
+                    }
 
-        std::uint8_t *dest_start = reinterpret_cast<std::uint8_t*>(dest);
-        std::uint8_t *dest_end = dest_start + dest_size;
+                    dest += count * PIXEL_SIZE;
+                }
 
-        dest_size = 0;
+                source += PIXEL_SIZE;
+                dest_size += count * PIXEL_SIZE;
 
-        while ((source_start < source_end) && (!dest || (dest_start < dest_end))) {
-            std::int32_t repeat = static_cast<std::int8_t>(*source_start++);
-            if (repeat >= 0) {
-                repeat = common::min<std::int32_t>(repeat, static_cast<std::int32_t>((dest_end - dest_start) / 2));
+                if (dest_full) {
+                    break;
+                }
+            } else {
+                const std::size_t source_left = source_end - source;
+                std::size_t copy_size = common::min<std::size_t>(static_cast<std::size_t>(-repeat) * PIXEL_SIZE, source_left);
+
+                if (dest) {
+                    const std::size_t dest_left = dest_end - dest;
 
-                if (dest_start) {
-                    const std::uint16_t value_fill = *reinterpret_cast<const std::uint16_t*>(source_start);
-                    for (std::int32_t i = 0; i <= repeat; i++) {
-                        *reinterpret_cast<std::uint16_t*>(dest_start) = value_fill;
-                        dest_start += 2;
+                    if ((dest_left >= copy_size + RLE_COPY_CHUNK_SIZE) && (source_left >= copy_size + RLE_COPY_CHUNK_SIZE)) {
+                        copy_wild(dest, source, copy_size);
+                    } else {
+                        copy_size = common::min<std::size_t>(copy_size, dest_left);
+                        std::memcpy(dest, source, copy_size);
                     }
-                }
 
-                source_start += 2;
-                dest_size += (repeat + 1) * 2;
-            } else {
-                std::int32_t copy_count = common::min<std::int32_t>(-repeat * 2, static_cast<std::int32_t>(dest_end - dest_start));
-                if (dest_start) {
-                    memcpy(dest_start, source_start, copy_count);
-                    dest_start += copy_count;
+                    dest += copy_size;
                 }
 
-                source_start += copy_count;
-                dest_size += copy_count;
+                source += copy_size;
+                dest_size += copy_size;
+            }
+
+            if (dest && (dest >= dest_end)) {
+                break;
             }
         }
     }
 
     template <>
-    void decompress_rle_fast_route<24>(const std::uint8_t *source, const std::size_t source_size, std::uint8_t *dest, std::size_t &dest_size) {
-        const std::uint8_t *source_start = source;
-        const std::uint8_t *source_end = source_start + source_size;
+    void decompress_rle_fast_route<8>(const std::uint8_t *source, const std::size_t source_size, std::uint8_t *dest, std::size_t &dest_size) {
+        decompress_rle_pixels<1>(source, source_size, dest, dest_size);
+    }
 
-        std::uint8_t *dest_start = reinterpret_cast<std::uint8_t*>(dest);
-        std::uint8_t *dest_end = dest_start + dest_size;
+    template <>
+    void decompress_rle_fast_route<12>(const std::uint8_t *source, const std::size_t source_size, std::uint8_t *dest, std::size_t &dest_size) {
+        const std::uint8_t *source_end = source + (source_size & ~static_cast<std::size_t>(1));
+        const std::uint8_t *dest_end = dest + (dest_size & ~static_cast<std::size_t>(1));
 
         dest_size = 0;
 
-        while ((source_start < source_end) && (!dest || (dest_start < dest_end))) {
-            std::int32_t repeat = static_cast<std::int8_t>(*source_start++);
-            if (repeat >= 0) {
-                repeat = common::min<std::int32_t>(repeat, static_cast<std::int32_t>((dest_end - dest_start) / 3));
+        // Each word is a 12-bit color plus a repeat count of up to 15, so a run is never longer than 32 bytes
+        static constexpr std::size_t MAX_RUN_SIZE = 32;
+
+        while (source < source_end) {
+            std::uint16_t val = 0;
+            std::memcpy(&val, source, 2);
 
-                if (dest_start) {
-                    std::uint8_t val1 = *source_start++;
-                    std::uint8_t val2 = *source_start++;
-                    std::uint8_t val3 = *source_start++;
+            source += 2;
 
-                    for (std::int32_t i = 0; i <= repeat; i++) {
-                        *dest_start++ = val1;
-                        *dest_start++ = val2;
-                        *dest_start++ = val3;
+            std::size_t count = static_cast<std::size_t>((val >> 12) & 0xF) + 1;
+            val &= 0x0FFF;
+
+            if (dest) {
+                const std::size_t dest_left = dest_end - dest;
+
+                if (dest_left >= MAX_RUN_SIZE) {
+                    // Write the longest run possible. Bytes past this run are rewritten by the next ones.
+#if EKA2L1_ARCH(X64)
+                    const __m128i value = _mm_set1_epi16(static_cast<short>(val));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), value);
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 16), value);
+#elif EKA2L1_ARCH(ARM64)
+                    const uint16x8_t value = vdupq_n_u16(val);
+
+                    vst1q_u16(reinterpret_cast<std::uint16_t *>(dest), value);
+                    vst1q_u16(reinterpret_cast<std::uint16_t *>(dest + 16), value);
+#else
+                    for (std::size_t i = 0; i < count; i++) {
+                        std::memcpy(dest + i * 2, &val, 2);
                     }
+#endif
                 } else {
-                    source_start += 3;
-                }
-                
-                dest_size += (repeat + 1) * 3;
-            } else {
-                std::int32_t copy_count = common::min<std::int32_t>(-repeat * 3, static_cast<std::int32_t>(dest_end - dest_start));
-                if (dest_start) {
-                    memcpy(dest_start, source_start, copy_count);
-                    dest_start += copy_count;
+                    count = common::min<std::size_t>(count, dest_left / 2);
+
+                    for (std::size_t i = 0; i < count; i++) {
+                        std::memcpy(dest + i * 2, &val, 2);
+                    }
                 }
 
-                source_start += copy_count;
-                dest_size += copy_count;
+                dest += count * 2;
+            }
+
+            dest_size += count * 2;
+
+            if (dest && (dest >= dest_end)) {
+                break;
             }
         }
     }
 
     template <>
-    void decompress_rle_fast_route<32>(const std::uint8_t *source, const std::size_t source_size, std::uint8_t *dest, std::size_t &dest_size) {
-        const std::uint8_t *source_start = source;
-        const std::uint8_t *source_end = source_start + source_size;
-
-        std::uint8_t *dest_start = reinterpret_cast<std::uint8_t*>(dest);
-        std::uint8_t *dest_end = dest_start + dest_size;
-
-        dest_size = 0;
-
-        while ((source_start < source_end) && (!dest || (dest_start < dest_end))) {
-            std::int32_t repeat = static_cast<std::int8_t>(*source_start++);
-            if (repeat >= 0) {
-                repeat = common::min<std::int32_t>(repeat, static_cast<std::int32_t>((dest_end - dest_start) / 4));
-
-                if (dest_start) {
-                    const std::uint32_t value_fill = *reinterpret_cast<const std::uint32_t*>(source_start);
-                    for (std::int32_t i = 0; i <= repeat; i++) {
-                        *reinterpret_cast<std::uint32_t*>(dest_start) = value_fill;
-                        dest_start += 4;
-                    }
-                }
+    void decompress_rle_fast_route<16>(const std::uint8_t *source, const std::size_t source_size, std::uint8_t *dest, std::size_t &dest_size) {
+        decompress_rle_pixels<2>(source, source_size, dest, dest_size);
+    }
 
-                source_start += 4;
-                dest_size += (repeat + 1) * 4;
-            } else {
-                std::int32_t copy_count = common::min<std::int32_t>(-repeat * 4, static_cast<std::int32_t>(dest_end - dest_start));
-                if (dest_start) {
-                    memcpy(dest_start, source_start, copy_count);
-                    dest_start += copy_count;
-                }
+    template <>
+    void decompress_rle_fast_route<24>(const std::uint8_t *source, const std::size_t source_size, std::uint8_t *dest, std::size_t &dest_size) {
+        decompress_rle_pixels<3>(source, source_size, dest, dest_size);
+    }
 
-                source_start += copy_count;
-                dest_size += copy_count;
-            }
-        }
+    template <>
+    void decompress_rle_fast_route<32>(const std::uint8_t *source, const std::size_t source_size, std::uint8_t *dest, std::size_t &dest_size) {
+        decompress_rle_pixels<4>(source, source_size, dest, dest_size);
     }
 
     template bool compress_rle<8>(common::ro_stream *source, common::wo_stream *dest, std::size_t &dest_size);
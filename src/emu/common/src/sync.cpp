@@ -25,6 +25,14 @@
 #include <Windows.h>
 #endif
 
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <array>
+
 namespace eka2l1::common {
     semaphore::semaphore(const int initial)
         : count_(initial) {
@@ -64,6 +72,52 @@ namespace eka2l1::common {
         return false;
     }
 
+#if defined(__linux__)
+    void futex_wait(std::atomic<std::uint32_t> &word, const std::uint32_t expected) {
+        static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "Atomic word must be lock-free and unpadded");
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+    }
+
+    void futex_wake(std::atomic<std::uint32_t> &word, const bool all) {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE_PRIVATE, all ? INT32_MAX : 1, nullptr, nullptr, 0);
+    }
+#else
+    struct futex_bucket {
+        std::mutex lock_;
+        std::condition_variable cond_;
+    };
+
+    static constexpr std::size_t FUTEX_BUCKET_COUNT = 64;
+
+    static futex_bucket &get_futex_bucket(const void *address) {
+        static std::array<futex_bucket, FUTEX_BUCKET_COUNT> buckets;
+        return buckets[(reinterpret_cast<std::uintptr_t>(address) >> 4) % FUTEX_BUCKET_COUNT];
+    }
+
+    void futex_wait(std::atomic<std::uint32_t> &word, const std::uint32_t expected) {
+        futex_bucket &bucket = get_futex_bucket(&word);
+        std::unique_lock<std::mutex> ulock(bucket.lock_);
+
+        // The waker takes the bucket lock after modifying the word, so checking it here can not miss a wake
+        if (word.load() != expected) {
+            return;
+        }
+
+        bucket.cond_.wait(ulock);
+    }
+
+    void futex_wake(std::atomic<std::uint32_t> &word, const bool all) {
+        futex_bucket &bucket = get_futex_bucket(&word);
+
+        {
+            const std::lock_guard<std::mutex> guard(bucket.lock_);
+        }
+
+        // Different words may share a bucket, so everyone has to be woken up
+        bucket.cond_.notify_all();
+    }
+#endif
+
 #if EKA2L1_PLATFORM(WIN32)
     class event_impl {
     private:
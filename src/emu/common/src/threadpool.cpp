@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/thread.h>
+#include <common/threadpool.h>
+
+namespace eka2l1::common {
+    thread_pool::thread_pool(const std::string &name, const std::size_t worker_count)
+        : name_(name)
+        , stopping_(false) {
+        std::size_t count = worker_count;
+
+        if (count == 0) {
+            count = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+        }
+
+        workers_.reserve(count);
+
+        for (std::size_t i = 0; i < count; i++) {
+            workers_.emplace_back(&thread_pool::worker_loop, this, i);
+        }
+    }
+
+    thread_pool::~thread_pool() {
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            stopping_ = true;
+        }
+
+        cond_.notify_all();
+
+        for (auto &worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    void thread_pool::enqueue(std::function<void()> task) {
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            tasks_.push(std::move(task));
+        }
+
+        cond_.notify_one();
+    }
+
+    void thread_pool::worker_loop(const std::size_t index) {
+        const std::string thread_name = name_ + " " + std::to_string(index);
+        set_thread_name(thread_name.c_str());
+
+        while (true) {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> ulock(lock_);
+                cond_.wait(ulock, [this]() {
+                    return stopping_ || !tasks_.empty();
+                });
+
+                if (tasks_.empty()) {
+                    // Only reachable when stopping and all work is drained
+                    return;
+                }
+
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+
+            task();
+        }
+    }
+}
@@ -32,6 +32,16 @@
 #include <unistd.h>
 #endif
 
+#if EKA2L1_PLATFORM(UNIX)
+#include <sys/syscall.h>
+#endif
+
+#if EKA2L1_PLATFORM(UNIX) && defined(SYS_memfd_create)
+#define EKA2L1_COW_TEMPLATE_SUPPORTED 1
+#endif
+
+#include <vector>
+
 namespace eka2l1::common {
     void *map_memory(const std::size_t size) {
 #if EKA2L1_PLATFORM(WIN32)
@@ -261,4 +271,106 @@ namespace eka2l1::common {
     void *align_address_to_host_page(void *original) {
         return reinterpret_cast<void *>(reinterpret_cast<std::uint64_t>(original) & ~(get_host_page_size() - 1));
     }
+
+    std::intptr_t create_cow_template(const void *data, const std::size_t size) {
+#if EKA2L1_COW_TEMPLATE_SUPPORTED
+        const int fd = static_cast<int>(syscall(SYS_memfd_create, "eka2l1-cow", 0));
+
+        if (fd == -1) {
+            return -1;
+        }
+
+        if (ftruncate(fd, static_cast<off_t>(size)) == -1) {
+            close(fd);
+            return -1;
+        }
+
+        const std::uint8_t *source = reinterpret_cast<const std::uint8_t *>(data);
+        std::size_t written = 0;
+
+        while (written < size) {
+            const ssize_t result = pwrite(fd, source + written, size - written, static_cast<off_t>(written));
+
+            if (result <= 0) {
+                close(fd);
+                return -1;
+            }
+
+            written += static_cast<std::size_t>(result);
+        }
+
+        return fd;
+#else
+        return -1;
+#endif
+    }
+
+    void destroy_cow_template(const std::intptr_t tmpl) {
+#if EKA2L1_COW_TEMPLATE_SUPPORTED
+        if (tmpl != -1) {
+            close(static_cast<int>(tmpl));
+        }
+#endif
+    }
+
+    bool map_cow_template(const std::intptr_t tmpl, void *dest, const std::size_t size, const prot perm) {
+#if EKA2L1_COW_TEMPLATE_SUPPORTED
+        if (tmpl == -1) {
+            return false;
+        }
+
+        void *result = mmap(dest, size, translate_protection(perm), MAP_PRIVATE | MAP_FIXED, static_cast<int>(tmpl), 0);
+        return (result == dest);
+#else
+        return false;
+#endif
+    }
+
+    bool unmap_cow_template(void *dest, const std::size_t size) {
+#if EKA2L1_COW_TEMPLATE_SUPPORTED
+        void *result = mmap(dest, size, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED, -1, 0);
+        return (result == dest);
+#else
+        return false;
+#endif
+    }
+
+    std::size_t get_cow_private_size(void *ptr, const std::size_t size) {
+#if EKA2L1_COW_TEMPLATE_SUPPORTED
+        static constexpr std::uint64_t PAGEMAP_PRESENT = 1ULL << 63;
+        static constexpr std::uint64_t PAGEMAP_FILE_OR_SHARED = 1ULL << 61;
+
+        const std::size_t page_size = static_cast<std::size_t>(get_host_page_size());
+        const std::size_t page_count = (size + page_size - 1) / page_size;
+
+        const int fd = open("/proc/self/pagemap", O_RDONLY);
+
+        if (fd == -1) {
+            return size;
+        }
+
+        std::vector<std::uint64_t> entries(page_count);
+        const off_t offset = static_cast<off_t>(reinterpret_cast<std::uintptr_t>(ptr) / page_size * sizeof(std::uint64_t));
+        const ssize_t read_size = pread(fd, entries.data(), page_count * sizeof(std::uint64_t), offset);
+
+        close(fd);
+
+        if (read_size != static_cast<ssize_t>(page_count * sizeof(std::uint64_t))) {
+            return size;
+        }
+
+        // A written page of a private file mapping is turned into an anonymous page
+        std::size_t private_pages = 0;
+
+        for (const std::uint64_t entry : entries) {
+            if ((entry & PAGEMAP_PRESENT) && !(entry & PAGEMAP_FILE_OR_SHARED)) {
+                private_pages++;
+            }
+        }
+
+        return private_pages * page_size;
+#else
+        return size;
+#endif
+    }
 }
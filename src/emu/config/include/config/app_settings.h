@@ -41,6 +41,8 @@ namespace eka2l1::config {
         std::uint32_t screen_upscale_method;
         std::string filter_shader_path;
 
+        std::uint32_t jit_code_cache_size_mb; ///< Zero to use the global size.
+
         bool child_inherit_setting;
 
         explicit app_setting();
@@ -28,6 +28,7 @@ SETTING(screen-rotation, screen_rotation, 0)
 SETTING(screen-upscale, screen_upscale, -1.0f)
 SETTING(screen-upscale-method, screen_upscale_method, 0)
 SETTING(filter-shader-path, filter_shader_path, "")
+SETTING(jit-code-cache-size, jit_code_cache_size_mb, 0)
 
 #ifdef SETTING
 #undef SETTING
@@ -88,6 +88,7 @@ namespace eka2l1::config {
         bool log_ipc{ false };
         bool log_passed{ false };
         bool log_exports{ false };
+        bool binary_log{ false };
 
         std::string cpu_backend{ "dynarmic" };
         int device{ 0 };
@@ -95,8 +96,17 @@ namespace eka2l1::config {
         int emulator_language{ -1 };
         int audio_master_volume{ 100 };
 
+        std::string audio_backend{ "cubeb" };
+        int audio_null_sample_rate{ 48000 };
+        int audio_null_period_frames{ 1024 };
+        std::string audio_null_dump_path;
+
+        std::string graphics_backend{ "opengl" };
+        std::string graphics_frame_dump_dir;
+
         bool enable_gdbstub{ false };
         int gdb_port{ 24689 };
+        int jit_code_cache_size_mb{ 0 };
 
         std::string storage = "data"; // Set this to dot, avoid making it absolute
 
@@ -126,6 +136,8 @@ namespace eka2l1::config {
         bool disable_display_content_scale { false };
         bool enable_hw_gles1 { true };
         bool hide_system_apps { true };
+        bool hle_server_threads { false };
+        bool dsa_dirty_page_tracking { false };
 
         keybind_profile keybinds;
 
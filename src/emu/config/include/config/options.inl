@@ -37,6 +37,7 @@ OPTION(log-ipc, log_ipc, false)
 OPTION(log-svc, log_svc, false)
 OPTION(log-passed, log_passed, false)
 OPTION(log-exports, log_exports, false)
+OPTION(binary-log, binary_log, false)
 OPTION(cpu, cpu_backend, "dynarmic")
 OPTION(device, device, 0)
 OPTION(language, language, -1)
@@ -55,6 +56,7 @@ OPTION(hide-mouse-in-screen-space, hide_mouse_in_screen_space, false)
 OPTION(enable-nearest-neighbor-filter, nearest_neighbor_filtering, true)
 OPTION(integer-scaling, integer_scaling, true)
 OPTION(cpu-load-save, cpu_load_save, true)
+OPTION(jit-code-cache-size, jit_code_cache_size_mb, 0)
 OPTION(mime-detection, mime_detection, true)
 OPTION(rtos-level, rtos_level, "mid")
 OPTION(ui-new-style, ui_new_style, true)
@@ -64,6 +66,12 @@ OPTION(mtm-reset-2, mtm_reset_2, false)
 OPTION(imei, imei, DEFAULT_IMI)
 OPTION(mmc-id, mmc_id, DEFAULT_MMC_ID)
 OPTION(audio-master-volume, audio_master_volume, 100)
+OPTION(audio-backend, audio_backend, "cubeb")
+OPTION(audio-null-sample-rate, audio_null_sample_rate, 48000)
+OPTION(audio-null-period-frames, audio_null_period_frames, 1024)
+OPTION(audio-null-dump-path, audio_null_dump_path, "")
+OPTION(graphics-backend, graphics_backend, "opengl")
+OPTION(graphics-frame-dump-dir, graphics_frame_dump_dir, "")
 OPTION(current-keybind-profile, current_keybind_profile, "default")
 OPTION(screen-buffer-sync, screen_buffer_sync_string, "preferred")
 OPTION(report-mmfdev-underflow, report_mmfdev_underflow, false)
@@ -75,6 +83,8 @@ OPTION(sf2-bank-path, sf2_bank_path, "resources/defaultbank.sf2")
 OPTION(enable-hw-gles1, enable_hw_gles1, true)
 OPTION(log-filter, log_filter, DEFAULT_LOG_FILTERING)
 OPTION(hide-system-apps, hide_system_apps, true)
+OPTION(hle-server-threads, hle_server_threads, false)
+OPTION(dsa-dirty-page-tracking, dsa_dirty_page_tracking, false)
 
 #ifdef OPTION
 #undef OPTION
@@ -37,6 +37,7 @@ namespace eka2l1::config {
         , screen_rotation(0)
         , screen_upscale(-1.0f)
         , screen_upscale_method(0)
+        , jit_code_cache_size_mb(0)
         , child_inherit_setting(false) {
     }
 
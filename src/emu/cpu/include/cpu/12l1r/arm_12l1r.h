@@ -84,6 +84,9 @@ namespace eka2l1::arm {
         void clear_instruction_cache() override;
         void imb_range(address addr, std::size_t size) override;
 
+        code_cache_stats get_code_cache_stats() override;
+        void set_code_cache_size(const std::size_t size) override;
+
         bool should_clear_old_memory_map() const {
             return true;
         }
@@ -92,6 +92,19 @@ namespace eka2l1::arm::r12l1 {
         void flush_range(const vaddress range_start, const vaddress range_end);
         void flush_all();
 
+        /**
+         * @brief Invalidate and remove a single block.
+         *
+         * @returns False if no block starts at the given address.
+         */
+        bool flush_block(const vaddress start_addr);
+
+        void for_each_block(std::function<void(translated_block *)> func);
+
+        std::size_t size() const {
+            return blocks_.size();
+        }
+
         void set_on_block_invalidate_callback(on_block_invalidate_callback_type cb) {
             invalidate_callback_ = cb;
         }
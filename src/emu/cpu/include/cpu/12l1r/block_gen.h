@@ -26,8 +26,11 @@
 #include <cpu/arm_interface.h>
 #include <cpu/dyncom/arm_dyncom.h>
 
+#include <array>
 #include <cstdint>
 #include <map>
+#include <unordered_set>
+#include <vector>
 
 namespace eka2l1::arm {
     class r12l1_core;
@@ -51,6 +54,11 @@ namespace eka2l1::arm::r12l1 {
     static constexpr std::uint32_t FAST_DISPATCH_ENTRY_MASK = 0xFFFF;
     static constexpr std::uint32_t FAST_DISPATCH_ENTRY_COUNT = 0x10000;
 
+    // The code space after the control functions is split into generations, filled in order. When the last one
+    // is full, writing wraps to the first and only the blocks of the oldest generation are evicted, instead of
+    // throwing away every hot block at once.
+    static constexpr std::uint32_t CODE_GENERATION_COUNT = 4;
+
     class dashixiong_block : public common::armgen::armx_codeblock {
     private:
         std::multimap<vaddress, translated_block *> link_to_;
@@ -67,6 +75,16 @@ namespace eka2l1::arm::r12l1 {
 
         r12l1_core *parent_;
 
+        std::size_t blocks_area_start_;
+        std::size_t generation_size_;
+        std::uint32_t current_generation_;
+        std::size_t pending_code_space_size_;
+
+        std::array<std::vector<vaddress>, CODE_GENERATION_COUNT> generation_blocks_;
+        std::unordered_set<vaddress> evicted_addrs_;
+
+        code_cache_stats stats_;
+
 #if R12L1_ENABLE_FUZZ
         std::unique_ptr<dyncom_core> interpreter_;
         std::unique_ptr<exclusive_monitor> interpreter_monitor_;
@@ -76,6 +94,11 @@ namespace eka2l1::arm::r12l1 {
         void assemble_control_funcs();
         translated_block *start_new_block(const vaddress addr);
 
+        void mark_evicted(const vaddress addr);
+        void reset_generations();
+        void evict_generation(const std::uint32_t generation);
+        void advance_generation();
+
     public:
         enum {
             FLAG_ENABLE_FUZZ = 1 << 1,
@@ -107,6 +130,19 @@ namespace eka2l1::arm::r12l1 {
         void flush_range(const vaddress start, const vaddress end);
         void flush_all();
 
+        /**
+         * @brief Request a new size for the code space.
+         *
+         * The code space can not be reallocated while running translated code, so the size is only stored here,
+         * and applied on the next call to apply_pending_code_space_size().
+         *
+         * @param size      Size in bytes. Zero to use the default size.
+         */
+        void set_code_space_size(const std::size_t size);
+        void apply_pending_code_space_size();
+
+        code_cache_stats get_code_cache_stats();
+
         bool raise_guest_exception(const exception_type exc, const std::uint32_t usrdata);
         void raise_system_call(const std::uint32_t num);
 
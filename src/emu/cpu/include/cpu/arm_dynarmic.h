@@ -72,6 +72,8 @@ namespace eka2l1 {
 
             bool interpreter_callback_inited;
 
+            code_cache_stats cache_stats;
+
         public:
             explicit dynarmic_core(arm::exclusive_monitor *monitor);
             ~dynarmic_core() override;
@@ -111,6 +113,8 @@ namespace eka2l1 {
 
             void imb_range(address addr, std::size_t size) override;
 
+            code_cache_stats get_code_cache_stats() override;
+
             std::uint32_t get_num_instruction_executed() override;
 
             bool should_clear_old_memory_map() const override {
@@ -64,6 +64,26 @@ namespace eka2l1::arm {
 
     class core;
 
+    /**
+     * @brief Statistics of the translated code cache of a core.
+     *
+     * Backends that do not cache translated code leave everything as zero.
+     */
+    struct code_cache_stats {
+        std::uint64_t capacity_bytes_ = 0; ///< Maximum host memory the cache can grow to.
+        std::uint64_t committed_bytes_ = 0; ///< Host memory currently committed for the cache.
+        std::uint64_t used_bytes_ = 0; ///< Bytes used by translated blocks that are still reachable.
+        std::uint64_t block_count_ = 0; ///< Number of blocks currently cached.
+        std::uint64_t evicted_block_count_ = 0; ///< Number of blocks evicted to make room since creation.
+        std::uint64_t reclaim_count_ = 0; ///< Number of time the cache filled up and space had to be reclaimed.
+        std::uint64_t flush_count_ = 0; ///< Number of time every block was thrown away at once.
+        std::uint64_t compiled_block_count_ = 0; ///< Number of blocks translated since creation.
+        std::uint64_t recompiled_block_count_ = 0; ///< Number of blocks translated again after being evicted or flushed.
+        std::uint64_t flush_time_us_ = 0; ///< Host time spent flushing, invalidating and evicting blocks.
+        std::uint64_t recompile_time_us_ = 0; ///< Host time spent translating blocks that were evicted or flushed before.
+        std::uint64_t compile_time_us_ = 0; ///< Host time spent translating blocks since creation.
+    };
+
     class exclusive_monitor {
     public:
         memory_read_with_core_8bit_func read_8bit;
@@ -201,5 +221,20 @@ namespace eka2l1::arm {
         }
 
         virtual std::uint32_t get_num_instruction_executed() = 0;
+
+        virtual code_cache_stats get_code_cache_stats() {
+            return code_cache_stats{};
+        }
+
+        /**
+         * @brief Set the maximum host memory used to cache translated code.
+         *
+         * The new size is applied on the next run, so this can be called from a callback of the core.
+         * Backends that can not resize their cache ignore this.
+         *
+         * @param size      Size in bytes. Zero to use the backend's default size.
+         */
+        virtual void set_code_cache_size(const std::size_t size) {
+        }
     };
 }
@@ -67,6 +67,9 @@ namespace eka2l1::arm {
 
         void imb_range(address addr, std::size_t size) override;
 
+        ARMul_TranslationCacheStats get_translation_cache_stats() const;
+        arm::code_cache_stats get_code_cache_stats() override;
+
         std::uint32_t get_num_instruction_executed() override;
 
         bool should_clear_old_memory_map() const override {
@@ -20,6 +20,7 @@
 #include <array>
 #include <common/types.h>
 #include <unordered_map>
+#include <vector>
 
 #include <cpu/dyncom/arm_regformat.h>
 
@@ -29,7 +30,24 @@ namespace eka2l1::arm {
     class exclusive_monitor;
 }
 
+// Address space reserved for the translation cache. Only what is used gets committed
 #define TRANS_CACHE_SIZE (64 * 1024 * 2000)
+#define TRANS_CACHE_COMMIT_CHUNK_SIZE (1024 * 1024)
+#define TRANS_CACHE_SEGMENT_COUNT 8
+#define TRANS_CACHE_SEGMENT_SIZE (TRANS_CACHE_SIZE / TRANS_CACHE_SEGMENT_COUNT)
+
+// Space that must be free before translating a block. A block ends at the first instruction that reaches
+// or crosses the end of its 4KB guest page, so it is at most 2048 Thumb instructions. The largest cream,
+// arm_inst plus its operands, is 44 bytes and gets rounded up to 48.
+#define TRANS_CACHE_BLOCK_HEADROOM (2048 * 48)
+
+struct ARMul_TranslationCacheStats {
+    std::size_t committed_bytes; // Host memory committed for translated blocks
+    std::size_t live_bytes; // Bytes used by blocks that are still reachable
+    std::size_t block_count; // Number of blocks currently cached
+    std::uint64_t evicted_block_count; // Number of blocks evicted to make room since creation
+    std::uint64_t wrap_count; // Number of time translation wrapped around the cache
+};
 
 // Signal levels
 enum { LOW = 0,
@@ -151,6 +169,10 @@ enum {
 struct ARMul_State final {
 public:
     explicit ARMul_State(eka2l1::arm::dyncom_core *core, PrivilegeMode initial_mode);
+    ~ARMul_State();
+
+    ARMul_State(const ARMul_State &) = delete;
+    ARMul_State &operator=(const ARMul_State &) = delete;
 
     void ChangePrivilegeMode(std::uint32_t new_mode);
     void Reset();
@@ -238,7 +260,19 @@ public:
     unsigned bigendSig;
     unsigned syscallSig;
 
-    char trans_cache_buf[TRANS_CACHE_SIZE];
+    // Make sure there is room for one more block at the top of the translation cache, committing host memory
+    // or evicting the oldest blocks when needed. Must be called before translating a block.
+    void PrepareTranslation();
+
+    // Record a translated block, starting at the given cache offset and ending at the current cache top.
+    void AddTranslatedBlock(std::uint32_t pc, std::size_t start);
+
+    void ClearTranslationCache();
+    ARMul_TranslationCacheStats GetTranslationCacheStats() const;
+
+    // Translated blocks are laid out in a ring over reserved address space. Once the top reaches the end,
+    // translation wraps around, and blocks are evicted oldest first one segment at a time.
+    char *trans_cache_buf = nullptr;
     size_t trans_cache_buf_top = 0;
 
     // TODO(bunnei): Move this cache to a better place - it should be per codeset (likely per
@@ -246,6 +280,22 @@ public:
     std::unordered_map<std::uint32_t, std::size_t> instruction_cache;
 
 private:
+    struct TranslatedBlock {
+        std::uint32_t pc;
+        std::size_t start;
+    };
+
+    void EvictTranslationSegment(std::size_t segment);
+
+    std::size_t trans_cache_committed = 0;
+    std::size_t trans_cache_reclaimed_end = TRANS_CACHE_SIZE; // End of the free space after the top
+    std::size_t trans_cache_high_water = 0; // Top of the previous pass, before wrapping
+    std::uint64_t trans_cache_evicted_blocks = 0;
+    std::uint64_t trans_cache_wraps = 0;
+
+    // Blocks touching each segment, so eviction does not need to walk the whole instruction cache
+    std::array<std::vector<TranslatedBlock>, TRANS_CACHE_SEGMENT_COUNT> trans_cache_segment_blocks;
+
     void ResetMPCoreCP15Registers();
     eka2l1::arm::dyncom_core *core;
 };
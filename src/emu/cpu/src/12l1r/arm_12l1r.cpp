@@ -44,6 +44,7 @@ namespace eka2l1::arm {
         jit_state_.ticks_left_ = target_ticks_run_;
         jit_state_.should_break_ = false;
 
+        big_block_->apply_pending_code_space_size();
         big_block_->enter_dispatch(&jit_state_);
 
         // Set it again
@@ -174,6 +175,14 @@ namespace eka2l1::arm {
         big_block_->flush_range(addr, static_cast<vaddress>(addr + size));
     }
 
+    code_cache_stats r12l1_core::get_code_cache_stats() {
+        return big_block_->get_code_cache_stats();
+    }
+
+    void r12l1_core::set_code_cache_size(const std::size_t size) {
+        big_block_->set_code_space_size(size);
+    }
+
     std::uint32_t r12l1_core::get_num_instruction_executed() {
         return target_ticks_run_ - jit_state_.ticks_left_;
     }
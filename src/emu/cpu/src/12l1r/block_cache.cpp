@@ -115,4 +115,24 @@ namespace eka2l1::arm::r12l1 {
         // Just clear all of it
         blocks_.clear();
     }
+
+    bool block_cache::flush_block(const vaddress start_addr) {
+        auto bl_res = blocks_.find(start_addr);
+        if (bl_res == blocks_.end()) {
+            return false;
+        }
+
+        if (invalidate_callback_) {
+            invalidate_callback_(bl_res->second.get());
+        }
+
+        blocks_.erase(bl_res);
+        return true;
+    }
+
+    void block_cache::for_each_block(std::function<void(translated_block *)> func) {
+        for (auto &[addr, block] : blocks_) {
+            func(block.get());
+        }
+    }
 }
\ No newline at end of file
@@ -35,8 +35,14 @@
 #include <common/algorithm.h>
 #include <common/log.h>
 
+#include <chrono>
+
 namespace eka2l1::arm::r12l1 {
-    static constexpr std::size_t MAX_CODE_SPACE_BYTES = common::MB(32);
+    static constexpr std::size_t DEFAULT_CODE_SPACE_BYTES = common::MB(32);
+    static constexpr std::size_t MIN_CODE_SPACE_BYTES = common::MB(8);
+
+    // Evicted block addresses are only kept to count recompilations, so the set is capped
+    static constexpr std::size_t MAX_TRACKED_EVICTED_ADDRS = 0x10000;
 
     static translated_block *dashixiong_get_block_proxy(dashixiong_block *self, const vaddress addr) {
         return self->get_block(addr);
@@ -55,15 +61,21 @@ namespace eka2l1::arm::r12l1 {
         : dispatch_func_(nullptr)
         , dispatch_ent_for_block_(nullptr)
         , flags_(0)
-        , parent_(parent) {
+        , parent_(parent)
+        , blocks_area_start_(0)
+        , generation_size_(0)
+        , current_generation_(0)
+        , pending_code_space_size_(0) {
         context_info.detect();
         clear_fast_dispatch();
 
-        alloc_codespace(MAX_CODE_SPACE_BYTES);
+        alloc_codespace(static_cast<int>(DEFAULT_CODE_SPACE_BYTES));
         assemble_control_funcs();
+        reset_generations();
 
         cache_.set_on_block_invalidate_callback([this](translated_block *to_destroy) {
             edit_block_links(to_destroy, true);
+            mark_evicted(to_destroy->start_address());
 
             // Remove this block on fast dispatch table
             const std::uint32_t fast_dispatch_index = (to_destroy->start_address() >> FAST_DISPATCH_ENTRY_ADDR_SHIFT)
@@ -295,10 +307,22 @@ namespace eka2l1::arm::r12l1 {
     }
 
     void dashixiong_block::flush_range(const vaddress start, const vaddress end) {
+        const auto flush_start = std::chrono::steady_clock::now();
         cache_.flush_range(start, end);
+
+        stats_.flush_time_us_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - flush_start).count();
     }
 
     void dashixiong_block::flush_all() {
+        const auto flush_start = std::chrono::steady_clock::now();
+
+        // Addresses evicted before a full flush are too old to be worth tracking
+        evicted_addrs_.clear();
+
+        cache_.for_each_block([this](translated_block *block) {
+            mark_evicted(block->start_address());
+        });
+
         clear_fast_dispatch();
 
         link_to_.clear();
@@ -306,6 +330,112 @@ namespace eka2l1::arm::r12l1 {
 
         clear_codespace(0);
         assemble_control_funcs();
+        reset_generations();
+
+        stats_.flush_count_++;
+        stats_.flush_time_us_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - flush_start).count();
+    }
+
+    void dashixiong_block::mark_evicted(const vaddress addr) {
+        if (evicted_addrs_.size() >= MAX_TRACKED_EVICTED_ADDRS) {
+            evicted_addrs_.clear();
+        }
+
+        evicted_addrs_.insert(addr);
+    }
+
+    void dashixiong_block::reset_generations() {
+        blocks_area_start_ = get_offset(get_code_ptr());
+        generation_size_ = (region_size - blocks_area_start_) / CODE_GENERATION_COUNT;
+        current_generation_ = 0;
+
+        for (auto &generation : generation_blocks_) {
+            generation.clear();
+        }
+    }
+
+    void dashixiong_block::evict_generation(const std::uint32_t generation) {
+        const std::uint8_t *gen_start = get_base_ptr() + blocks_area_start_ + generation * generation_size_;
+        const std::uint8_t *gen_end = gen_start + generation_size_;
+
+        for (const vaddress addr : generation_blocks_[generation]) {
+            translated_block *block = cache_.lookup_block(addr);
+
+            // The block may have been invalidated and compiled again in another generation since
+            if (!block || (block->translated_code_ < gen_start) || (block->translated_code_ >= gen_end)) {
+                continue;
+            }
+
+            cache_.flush_block(addr);
+            stats_.evicted_block_count_++;
+        }
+
+        generation_blocks_[generation].clear();
+    }
+
+    void dashixiong_block::advance_generation() {
+        const auto evict_start = std::chrono::steady_clock::now();
+        const std::uint32_t next_generation = (current_generation_ + 1) % CODE_GENERATION_COUNT;
+
+        if (next_generation == 0) {
+            stats_.reclaim_count_++;
+        }
+
+        evict_generation(next_generation);
+
+        current_generation_ = next_generation;
+        reset_codeptr(static_cast<int>(blocks_area_start_ + current_generation_ * generation_size_));
+
+        stats_.flush_time_us_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - evict_start).count();
+    }
+
+    void dashixiong_block::set_code_space_size(const std::size_t size) {
+        pending_code_space_size_ = (size == 0) ? DEFAULT_CODE_SPACE_BYTES : common::max(size, MIN_CODE_SPACE_BYTES);
+    }
+
+    void dashixiong_block::apply_pending_code_space_size() {
+        if ((pending_code_space_size_ == 0) || (pending_code_space_size_ == region_size)) {
+            pending_code_space_size_ = 0;
+            return;
+        }
+
+        LOG_INFO(CPU_12L1R, "Resizing JIT code space to {} KB", pending_code_space_size_ / 1024);
+
+        // Addresses evicted before a full flush are too old to be worth tracking
+        evicted_addrs_.clear();
+
+        cache_.for_each_block([this](translated_block *block) {
+            mark_evicted(block->start_address());
+        });
+
+        clear_fast_dispatch();
+
+        link_to_.clear();
+        cache_.flush_all();
+
+        free_codespace();
+        alloc_codespace(static_cast<int>(pending_code_space_size_));
+
+        assemble_control_funcs();
+        reset_generations();
+
+        pending_code_space_size_ = 0;
+        stats_.flush_count_++;
+    }
+
+    code_cache_stats dashixiong_block::get_code_cache_stats() {
+        code_cache_stats result = stats_;
+
+        result.capacity_bytes_ = region_size;
+        result.committed_bytes_ = region_size;
+        result.block_count_ = cache_.size();
+        result.used_bytes_ = blocks_area_start_;
+
+        cache_.for_each_block([&result](translated_block *block) {
+            result.used_bytes_ += block->translated_size_;
+        });
+
+        return result;
     }
 
     bool dashixiong_block::raise_guest_exception(const exception_type exc, const std::uint32_t usrdata) {
@@ -689,19 +819,25 @@ namespace eka2l1::arm::r12l1 {
     }
 
     translated_block *dashixiong_block::compile_new_block(core_state *state, const vaddress addr) {
+        const std::size_t generation_end = blocks_area_start_ + (current_generation_ + 1) * generation_size_;
+
 #if R12L1_ENABLE_FUZZ
-        if (get_space_left() <= THRESHOLD_LEFT_TO_RESET_CACHE_FUZZ) {
+        if (get_offset(get_code_ptr()) + THRESHOLD_LEFT_TO_RESET_CACHE_FUZZ >= generation_end) {
 #else
-        if (get_space_left() <= THRESHOLD_LEFT_TO_RESET_CACHE) {
+        if (get_offset(get_code_ptr()) + THRESHOLD_LEFT_TO_RESET_CACHE >= generation_end) {
 #endif
-            flush_all();
+            advance_generation();
         }
 
+        const auto compile_start = std::chrono::steady_clock::now();
+
         translated_block *block = start_new_block(addr);
         if (!block) {
             return nullptr;
         }
 
+        generation_blocks_[current_generation_].push_back(addr);
+
         // When you want to start the fuzz, call fuzz_start(), and end it with fuzz_end()
         //if (addr == 0x70393258)
         //   fuzz_start();
@@ -815,6 +951,16 @@ namespace eka2l1::arm::r12l1 {
         end_write();
         flush_icache();
 
+        const std::uint64_t compile_time_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - compile_start).count();
+
+        stats_.compiled_block_count_++;
+        stats_.compile_time_us_ += compile_time_us;
+
+        if (evicted_addrs_.erase(addr)) {
+            stats_.recompiled_block_count_++;
+            stats_.recompile_time_us_ += compile_time_us;
+        }
+
         return block;
     }
 
@@ -27,6 +27,8 @@
 #include <dynarmic/A32/context.h>
 #include <dynarmic/A32/coprocessor.h>
 
+#include <chrono>
+
 namespace eka2l1::arm {
     class dynarmic_core_cp15 : public Dynarmic::A32::Coprocessor {
         std::uint32_t uprw;
@@ -460,11 +462,23 @@ namespace eka2l1::arm {
     }
 
     void dynarmic_core::clear_instruction_cache() {
+        const auto flush_start = std::chrono::steady_clock::now();
         jit->ClearCache();
+
+        cache_stats.flush_count_++;
+        cache_stats.flush_time_us_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - flush_start).count();
     }
 
     void dynarmic_core::imb_range(address addr, std::size_t size) {
+        const auto flush_start = std::chrono::steady_clock::now();
         jit->InvalidateCacheRange(addr, size);
+
+        cache_stats.flush_time_us_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - flush_start).count();
+    }
+
+    code_cache_stats dynarmic_core::get_code_cache_stats() {
+        // Dynarmic manages its own code cache and does not report its usage
+        return cache_stats;
     }
 
     std::uint32_t dynarmic_core::get_num_instruction_executed() {
@@ -158,14 +158,31 @@ namespace eka2l1::arm {
     }
 
     void dyncom_core::clear_instruction_cache() {
-        state_->instruction_cache.clear();
-        state_->trans_cache_buf_top = 0;
+        state_->ClearTranslationCache();
     }
 
     void dyncom_core::imb_range(address addr, std::size_t size) {
         clear_instruction_cache();
     }
 
+    ARMul_TranslationCacheStats dyncom_core::get_translation_cache_stats() const {
+        return state_->GetTranslationCacheStats();
+    }
+
+    arm::code_cache_stats dyncom_core::get_code_cache_stats() {
+        const ARMul_TranslationCacheStats trans_stats = state_->GetTranslationCacheStats();
+        arm::code_cache_stats stats;
+
+        stats.capacity_bytes_ = TRANS_CACHE_SIZE;
+        stats.committed_bytes_ = trans_stats.committed_bytes;
+        stats.used_bytes_ = trans_stats.live_bytes;
+        stats.block_count_ = trans_stats.block_count;
+        stats.evicted_block_count_ = trans_stats.evicted_block_count;
+        stats.reclaim_count_ = trans_stats.wrap_count;
+
+        return stats;
+    }
+
     std::uint32_t dyncom_core::get_num_instruction_executed() {
         return ticks_executed_;
     }
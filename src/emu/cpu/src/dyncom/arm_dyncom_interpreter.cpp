@@ -837,6 +837,8 @@ static int InterpreterTranslateBlock(ARMul_State *cpu, std::size_t &bb_start, st
     ARM_INST_PTR inst_base = nullptr;
     TransExtData ret = TransExtData::NON_BRANCH;
     int size = 0; // instruction size of basic block
+
+    cpu->PrepareTranslation();
     bb_start = cpu->trans_cache_buf_top;
 
     std::uint32_t phys_addr = addr;
@@ -849,19 +851,22 @@ static int InterpreterTranslateBlock(ARMul_State *cpu, std::size_t &bb_start, st
 
         phys_addr += inst_size;
 
-        if ((phys_addr & 0xfff) == 0) {
+        // A 32-bit Thumb instruction may straddle the page end, so compare pages rather than offsets
+        if ((phys_addr & ~0xfffu) != (addr & ~0xfffu)) {
             inst_base->br = TransExtData::END_OF_PAGE;
         }
         ret = inst_base->br;
     };
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    cpu->AddTranslatedBlock(pc_start, bb_start);
 
     return KEEP_GOING;
 }
 
 static int InterpreterTranslateSingle(ARMul_State *cpu, std::size_t &bb_start, std::uint32_t addr) {
     ARM_INST_PTR inst_base = nullptr;
+
+    cpu->PrepareTranslation();
     bb_start = cpu->trans_cache_buf_top;
 
     std::uint32_t phys_addr = addr;
@@ -873,7 +878,7 @@ static int InterpreterTranslateSingle(ARMul_State *cpu, std::size_t &bb_start, s
         inst_base->br = TransExtData::SINGLE_STEP;
     }
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    cpu->AddTranslatedBlock(pc_start, bb_start);
 
     return KEEP_GOING;
 }
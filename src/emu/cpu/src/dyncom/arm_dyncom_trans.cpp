@@ -10,7 +10,7 @@
 static void *AllocBuffer(ARMul_State *state, std::size_t size) {
     std::size_t start = state->trans_cache_buf_top;
     state->trans_cache_buf_top += ((size + 7) >> 3) << 3;
-    assert(state->trans_cache_buf_top <= TRANS_CACHE_SIZE && "Translation cache is full!");
+    assert(state->trans_cache_buf_top <= TRANS_CACHE_SIZE && "Translated block is larger than TRANS_CACHE_BLOCK_HEADROOM!");
     return static_cast<void *>(&state->trans_cache_buf[start]);
 }
 
@@ -5,16 +5,118 @@
 #include <algorithm>
 #include <common/bytes.h>
 #include <common/log.h>
+#include <common/virtualmem.h>
 #include <cpu/dyncom/arm_dyncom.h>
 #include <cpu/dyncom/armstate.h>
 #include <cpu/dyncom/vfp/vfp.h>
 
 ARMul_State::ARMul_State(eka2l1::arm::dyncom_core *core, PrivilegeMode initial_mode)
     : core(core) {
+    trans_cache_buf = static_cast<char *>(eka2l1::common::map_memory(TRANS_CACHE_SIZE));
+
+    if (!trans_cache_buf) {
+        LOG_CRITICAL(eka2l1::CPU_DYNCOM, "Unable to reserve address space for the translation cache!");
+    }
+
     Reset();
     ChangePrivilegeMode(initial_mode);
 }
 
+ARMul_State::~ARMul_State() {
+    if (trans_cache_buf) {
+        eka2l1::common::unmap_memory(trans_cache_buf, TRANS_CACHE_SIZE);
+    }
+}
+
+void ARMul_State::EvictTranslationSegment(std::size_t segment) {
+    std::vector<TranslatedBlock> &blocks = trans_cache_segment_blocks[segment];
+
+    for (const TranslatedBlock &block : blocks) {
+        auto itr = instruction_cache.find(block.pc);
+
+        // The PC may have been translated again somewhere else since
+        if ((itr != instruction_cache.end()) && (itr->second == block.start)) {
+            instruction_cache.erase(itr);
+            trans_cache_evicted_blocks++;
+        }
+    }
+
+    blocks.clear();
+}
+
+void ARMul_State::PrepareTranslation() {
+    while (trans_cache_buf_top + TRANS_CACHE_BLOCK_HEADROOM > trans_cache_reclaimed_end) {
+        if (trans_cache_reclaimed_end >= TRANS_CACHE_SIZE) {
+            // Wrap around. Blocks of the previous pass stay usable until their segment is reclaimed
+            trans_cache_high_water = trans_cache_buf_top;
+            trans_cache_buf_top = 0;
+            trans_cache_reclaimed_end = 0;
+            trans_cache_wraps++;
+
+            LOG_TRACE(eka2l1::CPU_DYNCOM, "Translation cache is full, evicting oldest blocks");
+        }
+
+        EvictTranslationSegment(trans_cache_reclaimed_end / TRANS_CACHE_SEGMENT_SIZE);
+        trans_cache_reclaimed_end = std::min<std::size_t>(TRANS_CACHE_SIZE, trans_cache_reclaimed_end + TRANS_CACHE_SEGMENT_SIZE);
+    }
+
+    const std::size_t needed = std::min<std::size_t>(TRANS_CACHE_SIZE, trans_cache_buf_top + TRANS_CACHE_BLOCK_HEADROOM);
+
+    if (needed > trans_cache_committed) {
+        const std::size_t new_committed = std::min<std::size_t>(TRANS_CACHE_SIZE,
+            (needed + TRANS_CACHE_COMMIT_CHUNK_SIZE - 1) / TRANS_CACHE_COMMIT_CHUNK_SIZE * TRANS_CACHE_COMMIT_CHUNK_SIZE);
+
+        if (!eka2l1::common::commit(trans_cache_buf + trans_cache_committed, new_committed - trans_cache_committed, prot_read_write)) {
+            LOG_CRITICAL(eka2l1::CPU_DYNCOM, "Unable to commit memory for the translation cache!");
+            return;
+        }
+
+        trans_cache_committed = new_committed;
+    }
+}
+
+void ARMul_State::AddTranslatedBlock(std::uint32_t pc, std::size_t start) {
+    instruction_cache[pc] = start;
+
+    const std::size_t first_segment = start / TRANS_CACHE_SEGMENT_SIZE;
+    const std::size_t last_segment = (std::max<std::size_t>(trans_cache_buf_top, start + 1) - 1) / TRANS_CACHE_SEGMENT_SIZE;
+
+    trans_cache_segment_blocks[first_segment].push_back({ pc, start });
+
+    if (last_segment != first_segment) {
+        trans_cache_segment_blocks[last_segment].push_back({ pc, start });
+    }
+}
+
+void ARMul_State::ClearTranslationCache() {
+    instruction_cache.clear();
+
+    for (auto &blocks : trans_cache_segment_blocks) {
+        blocks.clear();
+    }
+
+    trans_cache_buf_top = 0;
+    trans_cache_reclaimed_end = TRANS_CACHE_SIZE;
+    trans_cache_high_water = 0;
+}
+
+ARMul_TranslationCacheStats ARMul_State::GetTranslationCacheStats() const {
+    ARMul_TranslationCacheStats stats;
+
+    stats.committed_bytes = trans_cache_committed;
+    stats.live_bytes = trans_cache_buf_top;
+
+    if (trans_cache_high_water > trans_cache_reclaimed_end) {
+        stats.live_bytes += trans_cache_high_water - trans_cache_reclaimed_end;
+    }
+
+    stats.block_count = instruction_cache.size();
+    stats.evicted_block_count = trans_cache_evicted_blocks;
+    stats.wrap_count = trans_cache_wraps;
+
+    return stats;
+}
+
 void ARMul_State::ChangePrivilegeMode(std::uint32_t new_mode) {
     if (Mode == new_mode)
         return;
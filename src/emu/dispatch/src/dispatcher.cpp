@@ -114,11 +114,8 @@ namespace eka2l1::dispatch {
         epoc::screen *scr = winserv_->get_screens();
 
         while (scr != nullptr) {
-            eka2l1::rect up_rect;
-            up_rect.top = { 0, 0 };
-            up_rect.size = scr->size();
-
-            dispatch::update_screen(sys, 0, scr->number, 1, &up_rect);
+            // No rectangle updates the whole screen
+            dispatch::update_screen(sys, 0, scr->number, 0, nullptr);
             scr = scr->next;
         }
     }
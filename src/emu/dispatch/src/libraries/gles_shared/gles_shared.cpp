@@ -2161,11 +2161,16 @@ namespace eka2l1::dispatch {
                     ctx->texture_pools_2d_.pop();
                 } else {
                     drivers::graphics_driver *drv = sys->get_graphics_driver();
+                    drivers::command_fence create_status;
                     drivers::handle new_h = drivers::create_texture(drv, dimension, 0, internal_format_driver,
                         internal_format_driver, dtype, data_to_pass, out_size[0], eka2l1::vec3(width, height, 0),
-                        0, ctx->unpack_alignment_);
+                        0, ctx->unpack_alignment_, &create_status);
 
-                    if (!new_h) {
+                    drv->wait_for(&create_status);
+
+                    if (create_status.result_ != 0) {
+                        // The handle stays reserved until it is destroyed
+                        ctx->cmd_builder_.destroy(new_h);
                         controller.push_error(ctx, GL_INVALID_OPERATION);
                         return;
                     }
@@ -2244,11 +2249,16 @@ namespace eka2l1::dispatch {
                     ctx->texture_pools_2d_.pop();
                 } else {
                     drivers::graphics_driver *drv = sys->get_graphics_driver();
+                    drivers::command_fence create_status;
                     drivers::handle new_h = drivers::create_texture(drv, 2, static_cast<std::uint8_t>(level), internal_format_driver,
                         internal_format_driver, drivers::texture_data_type::compressed, data_pixels, image_size, eka2l1::vec3(width, height, 0),
-                        0, ctx->unpack_alignment_);
+                        0, ctx->unpack_alignment_, &create_status);
+
+                    drv->wait_for(&create_status);
 
-                    if (!new_h) {
+                    if (create_status.result_ != 0) {
+                        // The handle stays reserved until it is destroyed
+                        ctx->cmd_builder_.destroy(new_h);
                         controller.push_error(ctx, GL_INVALID_OPERATION);
                         return;
                     }
@@ -2340,6 +2350,8 @@ namespace eka2l1::dispatch {
         drivers::graphics_driver *drv = sys->get_graphics_driver();
         get_data_type_to_upload(internal_format_driver, format_driver, dtype, swizzles, format, data_type, drv->is_stricted());
 
+        const std::size_t needed_size = calculate_possible_upload_size(eka2l1::vec2(width, height), format, data_type);
+
         // TODO: border is ignored!
         if (!tex->handle_value()) {
             need_set_params = true;
@@ -2351,10 +2363,18 @@ namespace eka2l1::dispatch {
                 tex->assign_handle(ctx->texture_pools_2d_.top());
                 ctx->texture_pools_2d_.pop();
             } else {
+                // The error must be reported by this call, so wait for the creation result. Textures taken from
+                // the pool above do not pay for this.
+                drivers::command_fence create_status;
                 drivers::handle new_h = drivers::create_texture(drv, dimension, static_cast<std::uint8_t>(level), internal_format_driver,
-                    format_driver, dtype, data_pixels, 0, eka2l1::vec3(width, height, 0), 0, ctx->unpack_alignment_);
+                    format_driver, dtype, data_pixels, needed_size, eka2l1::vec3(width, height, 0), 0, ctx->unpack_alignment_,
+                    &create_status);
+
+                drv->wait_for(&create_status);
 
-                if (!new_h) {
+                if (create_status.result_ != 0) {
+                    // The handle stays reserved until it is destroyed
+                    ctx->cmd_builder_.destroy(new_h);
                     controller.push_error(ctx, GL_INVALID_OPERATION);
                     return;
                 }
@@ -2365,7 +2385,6 @@ namespace eka2l1::dispatch {
         }
 
         if (need_reinstantiate) {
-            const std::size_t needed_size = calculate_possible_upload_size(eka2l1::vec2(width, height), format, data_type);
             ctx->cmd_builder_.recreate_texture(tex->handle_value(), dimension, static_cast<std::uint8_t>(level), internal_format_driver,
                 format_driver, dtype, data_pixels, needed_size, eka2l1::vec3(width, height, 0), 0, ctx->unpack_alignment_);
         }
@@ -2531,9 +2550,14 @@ namespace eka2l1::dispatch {
                 ctx->buffer_pools_.pop();
             } else {
                 drivers::graphics_driver *drv = sys->get_graphics_driver();
-                drivers::handle new_h = drivers::create_buffer(drv, data, size, upload_hint);
+                drivers::command_fence create_status;
+                drivers::handle new_h = drivers::create_buffer(drv, data, size, upload_hint, &create_status);
+
+                drv->wait_for(&create_status);
 
-                if (!new_h) {
+                if (create_status.result_ != 0) {
+                    // The handle stays reserved until it is destroyed
+                    ctx->cmd_builder_.destroy(new_h);
                     controller.push_error(ctx, GL_INVALID_OPERATION);
                     return;
                 }
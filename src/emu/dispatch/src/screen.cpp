@@ -18,6 +18,7 @@
  */
 
 #include <common/log.h>
+#include <common/region.h>
 #include <config/config.h>
 #include <dispatch/dispatcher.h>
 #include <dispatch/screen.h>
@@ -29,9 +30,50 @@
 #include <services/window/classes/wingroup.h>
 #include <system/epoc.h>
 
+#include <cstring>
 #include <fstream>
 
-namespace eka2l1::dispatch {    
+namespace eka2l1::dispatch {
+    // Past this many rectangles, uploading their bounding rectangle is cheaper than one upload per rectangle
+    static constexpr std::size_t MAX_DSA_UPLOAD_RECTS = 16;
+
+    // Granularity of the screen buffer comparison when the guest does not tell what changed
+    static constexpr std::uint32_t DSA_DIRTY_TRACK_PAGE_SIZE = 0x1000;
+
+    static bool is_whole_screen_update(const common::region &dirty, const eka2l1::rect &screen_rect) {
+        return (dirty.rects_.size() == 1) && (dirty.rects_[0].top == screen_rect.top) && (dirty.rects_[0].size == screen_rect.size);
+    }
+
+    /**
+     * @brief Find the rows of the screen buffer that changed since the last upload, one page worth of rows at a time.
+     *
+     * The shadow copy is refreshed as it is compared.
+     */
+    static void track_dsa_dirty_pages(epoc::screen *scr, const std::uint8_t *buffer, const eka2l1::vec2 &screen_size,
+        const std::uint32_t line_pitch, common::region &dirty) {
+        const std::size_t buffer_size = static_cast<std::size_t>(line_pitch) * screen_size.y;
+
+        if (scr->dsa_shadow_buffer_.size() != buffer_size) {
+            // Nothing to compare to yet, upload everything
+            scr->dsa_shadow_buffer_.assign(buffer, buffer + buffer_size);
+            return;
+        }
+
+        const int rows_per_page = common::max<int>(1, static_cast<int>(DSA_DIRTY_TRACK_PAGE_SIZE / line_pitch));
+        dirty.make_empty();
+
+        for (int y = 0; y < screen_size.y; y += rows_per_page) {
+            const int row_count = common::min<int>(rows_per_page, screen_size.y - y);
+            const std::size_t offset = static_cast<std::size_t>(y) * line_pitch;
+            const std::size_t size = static_cast<std::size_t>(row_count) * line_pitch;
+
+            if (std::memcmp(scr->dsa_shadow_buffer_.data() + offset, buffer + offset, size) != 0) {
+                std::memcpy(scr->dsa_shadow_buffer_.data() + offset, buffer + offset, size);
+                dirty.add_rect(eka2l1::rect(eka2l1::vec2(0, y), eka2l1::vec2(screen_size.x, row_count)));
+            }
+        }
+    }
+
     void screen_post_transferer::construct(ntimer *timing) {
         vsync_notify_event_ = timing->register_event("VSyncNotifyEvent", [this](const std::uint64_t data, const int cycles_late) {
             epoc::notify_info *info = reinterpret_cast<epoc::notify_info*>(data);
@@ -205,7 +247,11 @@ namespace eka2l1::dispatch {
                 const epoc::config::screen_mode &mode_info = scr->current_mode();
 
                 const eka2l1::vec2 screen_size = mode_info.size;
-                const std::size_t buffer_size = mode_info.size.x * mode_info.size.y * 4;
+                const eka2l1::rect screen_rect(eka2l1::vec2(0, 0), screen_size);
+
+                const std::uint32_t bpp = epoc::get_bpp_from_display_mode(scr->disp_mode);
+                const std::uint32_t bytes_per_pixel = (bpp + 7) / 8;
+                const std::uint32_t line_pitch = epoc::get_byte_width(screen_size.x, bpp);
 
                 std::uint64_t next_vsync_us = 0;
                 scr->vsync(sys->get_ntimer(), next_vsync_us);
@@ -215,6 +261,7 @@ namespace eka2l1::dispatch {
                 }
 
                 std::unique_lock<std::mutex> guard(scr->screen_mutex);
+                const bool texture_new = !scr->dsa_texture;
 
                 if (!scr->dsa_texture) {
                     const int max_square_width = common::max<int>(screen_size.x, screen_size.y);
@@ -237,8 +284,52 @@ namespace eka2l1::dispatch {
                 eka2l1::drivers::filter_option filter = (kern->get_config()->nearest_neighbor_filtering ? eka2l1::drivers::filter_option::nearest : eka2l1::drivers::filter_option::linear);
                 drivers::graphics_command_builder builder;
 
-                builder.update_bitmap(scr->dsa_texture, reinterpret_cast<const char *>(scr->screen_buffer_ptr()),
-                    buffer_size, { 0, 0 }, screen_size);
+                common::region dirty;
+
+                if (texture_new || (num_rects == 0) || !rect_list) {
+                    dirty.add_rect(screen_rect);
+                } else {
+                    for (std::uint32_t i = 0; i < num_rects; i++) {
+                        // Guest passes TRect, with the bottom right corner in place of the size
+                        eka2l1::rect guest_rect = rect_list[i];
+                        guest_rect.transform_from_symbian_rectangle();
+
+                        dirty.add_rect(guest_rect);
+                    }
+
+                    dirty.clip(screen_rect);
+                }
+
+                std::uint8_t *buffer = scr->screen_buffer_ptr();
+
+                if (kern->get_config()->dsa_dirty_page_tracking) {
+                    if (!texture_new && is_whole_screen_update(dirty, screen_rect)) {
+                        // Many apps update the whole screen every frame, find out what really changed
+                        track_dsa_dirty_pages(scr, buffer, screen_size, line_pitch, dirty);
+                    } else if (scr->dsa_shadow_buffer_.size() != static_cast<std::size_t>(line_pitch) * screen_size.y) {
+                        // The guest vouches that the rest of the buffer is already on the texture
+                        scr->dsa_shadow_buffer_.assign(buffer, buffer + static_cast<std::size_t>(line_pitch) * screen_size.y);
+                    } else {
+                        // Keep the shadow in sync with what the texture holds
+                        for (const eka2l1::rect &dirty_rect : dirty.rects_) {
+                            for (int y = dirty_rect.top.y; y < dirty_rect.top.y + dirty_rect.size.y; y++) {
+                                const std::size_t offset = static_cast<std::size_t>(y) * line_pitch + dirty_rect.top.x * bytes_per_pixel;
+                                std::memcpy(scr->dsa_shadow_buffer_.data() + offset, buffer + offset, dirty_rect.size.x * bytes_per_pixel);
+                            }
+                        }
+                    }
+                }
+
+                if (dirty.rects_.size() > MAX_DSA_UPLOAD_RECTS) {
+                    const eka2l1::rect bound = dirty.bounding_rect();
+
+                    dirty.make_empty();
+                    dirty.add_rect(bound);
+                }
+
+                for (const eka2l1::rect &dirty_rect : dirty.rects_) {
+                    epoc::upload_screen_rect(builder, scr->dsa_texture, buffer, screen_size, bpp, dirty_rect);
+                }
 
                 // NOTE: This is a hack for some apps that dont fill alpha
                 // TODO: Figure out why or better solution (maybe the display mode is not really correct?)
@@ -27,15 +27,20 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
 
 namespace eka2l1::drivers {
     using master_audio_volume_change_callback = std::function<void(const std::uint32_t old, const std::uint32_t newv)>;
     using bank_change_callback = std::function<void(const midi_bank_type type, const std::string &new_path)>;
 
+    class audio_mixer;
+
     class audio_driver : public driver {
         friend struct audio_output_stream;
+        friend class audio_mixer;
 
     private:
         common::identity_container<master_audio_volume_change_callback> master_volume_change_callbacks_;
@@ -47,15 +52,36 @@ namespace eka2l1::drivers {
 
         std::uint32_t master_volume_ = 100;
         bool suspend_ = false;
+        bool mixer_enabled_ = true;
 
         std::mutex lock_;
+        std::mutex mixer_lock_;
+
+        std::unique_ptr<audio_mixer> mixer_;
 
         std::size_t add_master_volume_change_callback(master_audio_volume_change_callback callback);
         bool remove_master_volume_change_callback(const std::size_t handle);
 
+    protected:
+        /**
+         * \brief Create a signed 16-bit LE stream that directly outputs to the host audio device.
+         *
+         * \see     new_output_stream
+         */
+        virtual std::unique_ptr<audio_output_stream> new_host_output_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback)
+            = 0;
+
+        /**
+         * \brief Destroy the software mixer and its host stream.
+         *
+         * Backends must call this before releasing their host context.
+         */
+        void destroy_mixer();
+
     public:
         explicit audio_driver(const std::uint32_t initial_master_volume = 100, const player_type preferred_midi_backend = player_type_tsf);
-        virtual ~audio_driver() {}
+        virtual ~audio_driver();
 
         void run() override {}
         void abort() override {}
@@ -63,6 +89,9 @@ namespace eka2l1::drivers {
         /**
          * \brief Create a signed 16-bit LE audio output stream.
          * 
+         * When the software mixer is enabled, the stream is mixed with other streams into a single
+         * host stream. Else, a host stream is opened for it.
+         * 
          * \param sample_rate       The target sample rate of output stream.
          * \param channels          The number of channels of the stream.
          * \param callback          The callback that the stream will use to retrive data.
@@ -71,9 +100,20 @@ namespace eka2l1::drivers {
          * 
          * \see     native_sample_rate
          */
-        virtual std::unique_ptr<audio_output_stream> new_output_stream(const std::uint32_t sample_rate,
-            const std::uint8_t channels, data_callback callback)
-            = 0;
+        std::unique_ptr<audio_output_stream> new_output_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback);
+
+        /**
+         * \brief Enable or disable the software mixer.
+         *
+         * Only affects streams created after this call.
+         */
+        void enable_mixer(const bool enable);
+
+        /**
+         * \brief Get the software mixer. Null if the mixer is disabled or has not been used yet.
+         */
+        audio_mixer *get_mixer();
 
         virtual std::uint32_t native_sample_rate() = 0;
 
@@ -106,10 +146,20 @@ namespace eka2l1::drivers {
     };
 
     enum class audio_driver_backend {
-        cubeb
+        cubeb,
+        null ///< No output device. Streams are pulled by a simulated device clock.
+    };
+
+    /**
+     * \brief Options of the null audio backend.
+     */
+    struct null_audio_options {
+        std::uint32_t sample_rate_ = 48000; ///< Sample rate of the simulated device.
+        std::uint32_t period_frames_ = 1024; ///< Number of device frames pulled from streams on each clock tick.
+        std::string dump_path_; ///< If not empty, the device output is written to this WAV file.
     };
 
     using audio_driver_instance = std::unique_ptr<audio_driver>;
     audio_driver_instance make_audio_driver(const audio_driver_backend backend, const std::uint32_t initial_master_vol = 100,
-         const player_type preferred_midi_backend = player_type_tsf);
+         const player_type preferred_midi_backend = player_type_tsf, const null_audio_options &null_options = null_audio_options{});
 }
@@ -28,12 +28,14 @@ namespace eka2l1::drivers {
         cubeb *context_;
         bool init_;
 
+    protected:
+        std::unique_ptr<audio_output_stream> new_host_output_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback) override;
+
     public:
         explicit cubeb_audio_driver(const std::uint32_t initial_master_volume = 100, const player_type preferred_midi_backend = player_type_tsf);
         ~cubeb_audio_driver() override;
 
-        std::unique_ptr<audio_output_stream> new_output_stream(const std::uint32_t sample_rate,
-            const std::uint8_t channels, data_callback callback) override;
         std::uint32_t native_sample_rate() override;
     };
 }
@@ -23,8 +23,12 @@
 #include <drivers/audio/dsp.h>
 
 #include <common/container.h>
+#include <common/sync.h>
 
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 namespace eka2l1::drivers {
@@ -41,19 +45,62 @@ namespace eka2l1::drivers {
         common::ring_buffer<std::uint16_t, RING_BUFFER_MAX_SAMPLE_COUNT> buffer_;
 
         std::mutex callback_lock_;
-        std::size_t avg_frame_count_;
+        std::atomic<std::size_t> avg_frame_count_;
 
         bool virtual_stop;
         bool more_requested;
 
+        // Decode-ahead state. Compressed data is decoded on a worker thread, so that the host audio
+        // callback only ever pops already decoded PCM from the ring buffer.
+        std::unique_ptr<std::thread> decode_thread_;
+        common::semaphore decode_sema_;
+        std::mutex decode_lock_;
+        std::atomic<bool> decode_running_;
+        std::atomic<bool> decode_requested_;
+        std::vector<std::uint8_t> decode_scratch_;
+
     protected:
         virtual bool internal_decode_running_out();
 
+        /**
+         * @brief Get the number of samples that the decode worker tries to keep in the ring buffer.
+         */
+        std::size_t decode_ahead_sample_count() const;
+
+        void decode_worker_loop();
+        void fill_decode_ahead();
+
+        void request_decode();
+        void start_decode_worker();
+
+        /**
+         * @brief Stop and join the decode worker.
+         *
+         * The worker calls into decode_data(), so a backend must call this in its destructor, before
+         * its decoder state is freed.
+         */
+        void stop_decode_worker();
+
     public:
         explicit dsp_output_stream_shared(drivers::audio_driver *aud);
         ~dsp_output_stream_shared() override;
 
+        /**
+         * @brief Decode the next chunk of queued data to signed 16-bit PCM.
+         *
+         * Called from the decode worker with the decode lock held. The destination is reused between calls,
+         * implementations should only resize it.
+         *
+         * @returns False if there is nothing more to decode for now.
+         */
         virtual bool decode_data(std::vector<std::uint8_t> &dest) = 0;
+
+        /**
+         * @brief Queue compressed data written by the guest, for the decode worker to pick up.
+         *
+         * Called from the emulator thread. The decode lock is held by the worker while it decodes a packet,
+         * so implementations should guard their input queue with a lock of their own.
+         */
         virtual void queue_data_decode(const std::uint8_t *original, const std::size_t original_size) = 0;
 
         std::size_t data_callback(std::int16_t *buffer, const std::size_t frame_count);
@@ -26,8 +26,12 @@ extern "C" {
 #include <libavformat/avformat.h>
 }
 
+#include <atomic>
+#include <mutex>
 #include <vector>
 
+struct SwrContext;
+
 namespace eka2l1::drivers {
     struct dsp_output_stream_ffmpeg : public dsp_output_stream_shared {
     protected:
@@ -37,9 +41,27 @@ namespace eka2l1::drivers {
 
         std::uint8_t *custom_io_buffer_;
         std::uint64_t timestamp_in_base_;
+
+        // Data not yet consumed by the demuxer starts at the read offset. The vector is compacted
+        // lazily, so that reading does not shift the whole queue each time. The queue has its own lock,
+        // so that guest writes do not wait for the decode worker.
+        std::mutex queued_data_lock_;
         std::vector<std::uint8_t> queued_data_;
+        std::size_t queued_data_offset_;
+        std::atomic<std::size_t> queued_data_left_;
+
+        // Persistent decode state, reused for every frame
+        AVPacket *packet_;
+        AVFrame *frame_;
+
+        SwrContext *swr_;
+        std::uint64_t swr_in_layout_;
+        int swr_in_format_;
+        int swr_in_rate_;
+        std::uint8_t swr_out_channels_;
+        std::uint32_t swr_out_rate_;
 
-        std::mutex decode_lock_;
+        bool prepare_resampler(const AVFrame *frame);
 
         enum state {
             STATE_NONE,
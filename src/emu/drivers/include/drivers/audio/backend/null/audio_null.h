@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/audio/audio.h>
+
+#include <common/buffer.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eka2l1::drivers {
+    struct null_audio_output_stream;
+
+    /**
+     * @brief Audio driver that does not need an output device.
+     *
+     * A device clock thread pulls every playing stream at real time pace, so guest timing (stream position,
+     * buffer requests) behaves like on real hardware. The device output can optionally be written to a WAV file.
+     *
+     * Only streams matching the device format (which is always the case for the software mixer's stream) are
+     * recorded to the WAV file. Other streams are still pulled, but their data is discarded.
+     */
+    class null_audio_driver : public audio_driver {
+        friend struct null_audio_output_stream;
+
+        null_audio_options options_;
+
+        std::unique_ptr<std::thread> clock_thread_;
+        std::atomic<bool> running_;
+
+        std::mutex streams_lock_;
+        std::vector<null_audio_output_stream *> streams_;
+
+        std::vector<std::int32_t> mix_buffer_;
+        std::vector<std::int16_t> output_buffer_;
+
+        std::unique_ptr<common::wo_std_file_stream> wav_file_;
+        std::uint64_t wav_data_size_;
+
+        void attach(null_audio_output_stream *stream);
+        void detach(null_audio_output_stream *stream);
+
+        void clock_loop();
+        void tick();
+
+        bool open_wav_dump();
+        void close_wav_dump();
+
+    protected:
+        std::unique_ptr<audio_output_stream> new_host_output_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback) override;
+
+    public:
+        explicit null_audio_driver(const null_audio_options &options, const std::uint32_t initial_master_volume = 100,
+            const player_type preferred_midi_backend = player_type_tsf);
+
+        ~null_audio_driver() override;
+
+        std::uint32_t native_sample_rate() override;
+    };
+}
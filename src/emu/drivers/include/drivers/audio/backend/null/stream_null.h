@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/audio/stream.h>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace eka2l1::drivers {
+    class null_audio_driver;
+
+    /**
+     * @brief A stream with no output device behind it.
+     *
+     * Data is pulled by the null driver's device clock, at the stream's own sample rate, so that the position
+     * advances at the same pace as with a real device.
+     */
+    struct null_audio_output_stream : public audio_output_stream {
+    private:
+        friend class null_audio_driver;
+
+        null_audio_driver *null_driver_;
+        data_callback callback_;
+
+        std::atomic<bool> playing_;
+        std::atomic<bool> pausing_;
+        std::atomic<bool> drained_;
+        std::atomic<float> volume_;
+
+        std::atomic<std::uint64_t> frames_played_;
+
+        // Only touched by the device clock thread
+        double frames_owed_;
+        std::vector<std::int16_t> buffer_;
+
+        /**
+         * @brief Pull one device period worth of data from the stream's callback.
+         *
+         * @param device_rate       Sample rate of the simulated device.
+         * @param device_frames     Number of device frames in the period.
+         *
+         * @returns Number of frames pulled. The data is available in the stream's buffer.
+         */
+        std::size_t tick(const std::uint32_t device_rate, const std::size_t device_frames);
+
+    public:
+        explicit null_audio_output_stream(null_audio_driver *driver, const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback);
+
+        ~null_audio_output_stream() override;
+
+        bool start() override;
+        bool stop() override;
+        void pause() override;
+
+        bool is_playing() override;
+        bool is_pausing() override;
+
+        bool set_volume(const float volume) override;
+        float get_volume() const override;
+
+        bool current_frame_position(std::uint64_t *pos) override;
+    };
+}
@@ -86,6 +86,7 @@ namespace eka2l1::drivers {
         bool set_dest_channel_count(const std::uint32_t cn) override;
         bool set_dest_encoding(const std::uint32_t enc) override;
         bool set_volume(const std::uint32_t vol) override;
+        bool set_balance(const std::int32_t balance) override;
         void set_dest_container_format(const std::uint32_t confor) override;
 
         std::uint64_t position() const override;
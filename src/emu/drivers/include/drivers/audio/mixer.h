@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/audio/stream.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eka2l1::drivers {
+    class audio_driver;
+    class audio_mixer;
+
+    struct audio_mixer_stats {
+        std::uint64_t mix_time_us_; ///< Total host time spent in the mix callback.
+        std::uint64_t mixed_frames_; ///< Total frames delivered to the host stream.
+        std::uint64_t mix_calls_; ///< Number of time the host stream asked for data.
+        std::uint64_t underruns_; ///< Number of time a guest stream delivered less frames than asked.
+        std::uint32_t stream_count_; ///< Number of guest streams attached to the mixer.
+        std::uint32_t active_stream_count_; ///< Number of guest streams currently playing.
+    };
+
+    /**
+     * @brief A guest stream that is mixed by the software mixer, instead of owning a host stream.
+     *
+     * The stream pulls data from its callback at its own sample rate and channel count. The mixer converts
+     * it to the host format, and applies stream volume and balance.
+     *
+     * A callback that delivers less frames than asked drains the stream. A drained stream is not mixed and does
+     * not report itself as playing, until it is started again.
+     */
+    struct mixer_output_stream : public audio_output_stream {
+    private:
+        friend class audio_mixer;
+
+        audio_mixer *mixer_;
+        data_callback callback_;
+
+        std::atomic<bool> playing_;
+        std::atomic<bool> pausing_;
+        std::atomic<bool> drained_;
+
+        std::atomic<float> volume_;
+        std::atomic<float> balance_;
+
+        std::atomic<std::uint64_t> frames_consumed_;
+
+        // Resampler state. Only touched by the mixer thread
+        std::vector<std::int16_t> source_;
+        std::size_t source_frame_count_;
+        double source_pos_;
+
+        /**
+         * @brief Resample and mix the stream into the host mix buffer.
+         *
+         * @param dest          Mix buffer, interleaved with the mixer channel count.
+         * @param frames        Number of host frames to mix.
+         * @param dest_rate     Host sample rate.
+         * @param dest_channels Host channel count.
+         *
+         * @returns True if the stream delivered all the frames asked.
+         */
+        bool mix_into(std::int32_t *dest, const std::size_t frames, const std::uint32_t dest_rate,
+            const std::uint8_t dest_channels);
+
+        bool pull_source(const std::size_t frames_wanted);
+
+    public:
+        explicit mixer_output_stream(audio_driver *driver, audio_mixer *mixer, const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback);
+
+        ~mixer_output_stream() override;
+
+        bool start() override;
+        bool stop() override;
+        void pause() override;
+
+        bool is_playing() override;
+        bool is_pausing() override;
+
+        bool set_volume(const float volume) override;
+        float get_volume() const override;
+
+        bool set_balance(const float balance) override;
+        float get_balance() const override;
+
+        bool current_frame_position(std::uint64_t *pos) override;
+    };
+
+    /**
+     * @brief Mix every guest audio stream into a single host output stream.
+     *
+     * Opening a host stream per guest stream is expensive: each one has its own callback thread and latency.
+     * The mixer owns one stereo host stream at the native sample rate, and guest streams are attached to it.
+     */
+    class audio_mixer {
+        friend struct mixer_output_stream;
+
+        audio_driver *driver_;
+        std::unique_ptr<audio_output_stream> host_stream_;
+
+        std::uint32_t sample_rate_;
+        std::uint8_t channels_;
+
+        std::mutex lock_;
+        std::condition_variable mix_done_;
+        std::vector<mixer_output_stream *> streams_;
+
+        // Streams of the current mix pass. Guest callbacks are called without holding the lock, so that
+        // they can stop or detach streams. Only touched by the mixer thread.
+        std::vector<mixer_output_stream *> mixing_streams_;
+        std::vector<std::int32_t> mix_buffer_;
+
+        bool mixing_;
+        std::thread::id mixing_thread_;
+
+        std::atomic<bool> host_started_;
+
+        std::atomic<std::uint64_t> mix_time_us_;
+        std::atomic<std::uint64_t> mixed_frames_;
+        std::atomic<std::uint64_t> mix_calls_;
+        std::atomic<std::uint64_t> underruns_;
+
+        std::size_t mix(std::int16_t *output, const std::size_t frames);
+
+        void attach(mixer_output_stream *stream);
+        void detach(mixer_output_stream *stream);
+
+        void stream_started();
+
+    public:
+        explicit audio_mixer(audio_driver *driver, const std::uint32_t sample_rate);
+        ~audio_mixer();
+
+        /**
+         * @brief Create a new guest stream attached to this mixer.
+         *
+         * @param sample_rate       Sample rate of the data that the stream's callback provides.
+         * @param channels          Channel count of the data that the stream's callback provides.
+         * @param callback          Callback to retrieve signed 16-bit interleaved data.
+         *
+         * @returns The stream, which detaches itself on destruction.
+         */
+        std::unique_ptr<audio_output_stream> new_stream(const std::uint32_t sample_rate, const std::uint8_t channels,
+            data_callback callback);
+
+        audio_mixer_stats get_stats();
+
+        std::uint32_t sample_rate() const {
+            return sample_rate_;
+        }
+
+        std::uint8_t channels() const {
+            return channels_;
+        }
+    };
+}
@@ -48,6 +48,20 @@ namespace eka2l1::drivers {
         virtual bool set_volume(const float volume) = 0;
         virtual float get_volume() const = 0;
 
+        /**
+         * \brief Set the left/right balance of the stream.
+         *
+         * \param balance   Balance in range of [-1, 1]. -1 is full left, 1 is full right.
+         * \returns False if the stream does not support balance, or the value is out of range.
+         */
+        virtual bool set_balance(const float balance) {
+            return false;
+        }
+
+        virtual float get_balance() const {
+            return 0.0f;
+        }
+
         virtual bool current_frame_position(std::uint64_t *pos) = 0;
 
         const std::uint8_t get_channels() {
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/driver.h>
+
+#include <common/queue.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace eka2l1::drivers {
+    struct command_queue_stats {
+        std::uint64_t submitted_lists_; ///< Number of command lists queued to the driver.
+        std::uint64_t max_depth_; ///< Highest number of lists pending at once.
+        std::uint64_t depth_sum_; ///< Sum of the pending list count, sampled at each submission.
+        std::uint64_t producer_stalls_; ///< Number of submissions that found the queue full.
+        std::uint64_t producer_stall_us_; ///< Total time producers spent waiting for a free slot.
+        std::uint64_t consumer_waits_; ///< Number of time the driver thread slept on an empty queue.
+        std::uint64_t consumer_busy_us_; ///< Time the driver thread spent on popped lists, until it asked for the next one.
+
+        double average_depth() const {
+            return submitted_lists_ ? static_cast<double>(depth_sum_) / static_cast<double>(submitted_lists_) : 0.0;
+        }
+    };
+
+    /**
+     * @brief Bounded queue of command lists, from the emulator threads to the driver thread.
+     *
+     * Lists are passed through a lock-free single-consumer ring. Producers are serialized by a mutex,
+     * which is uncontended when only the emulation thread submits. Both sides only sleep when the ring
+     * is full or empty, and are woken up through a futex on the sequence counter of the other side.
+     */
+    class command_list_queue {
+        spsc_ring<command_list> ring_;
+        std::mutex producer_lock_;
+
+        std::atomic<std::uint32_t> push_seq_;
+        std::atomic<std::uint32_t> pop_seq_;
+        std::atomic<std::uint32_t> consumer_waiting_;
+        std::atomic<std::uint32_t> producer_waiting_;
+        std::atomic<bool> aborted_;
+
+        std::atomic<std::uint64_t> submitted_lists_;
+        std::atomic<std::uint64_t> max_depth_;
+        std::atomic<std::uint64_t> depth_sum_;
+        std::atomic<std::uint64_t> producer_stalls_;
+        std::atomic<std::uint64_t> producer_stall_us_;
+        std::atomic<std::uint64_t> consumer_waits_;
+        std::atomic<std::uint64_t> consumer_busy_us_;
+
+        // Only touched by the driver thread
+        std::chrono::steady_clock::time_point last_pop_time_;
+        bool has_popped_;
+
+        void notify_popped();
+        void mark_popped();
+
+    public:
+        explicit command_list_queue(const std::size_t capacity = 128);
+
+        /**
+         * @brief Queue a list, waiting for a free slot if the queue is full.
+         *
+         * @returns False if the queue was aborted. The list is then still owned by the caller.
+         */
+        bool push(const command_list &list);
+
+        /**
+         * @brief Take the oldest list, waiting for one if the queue is empty. Only the driver thread may call this.
+         *
+         * @returns False if the queue was aborted.
+         */
+        bool pop(command_list &list);
+
+        /**
+         * @brief Wake up every waiter and reject further submissions.
+         */
+        void abort();
+
+        /**
+         * @brief Hand every list still pending to a callback. Call after abort, from the driver thread.
+         */
+        void drain(std::function<void(command_list &)> callback);
+
+        std::size_t depth() const {
+            return ring_.size();
+        }
+
+        command_queue_stats get_stats() const;
+    };
+}
@@ -20,22 +20,60 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
-#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 namespace eka2l1 {
     class graphics_driver;
 }
 
 namespace eka2l1::drivers {
+    /**
+     * @brief Completion object of a command, signalled by the driver thread once the command is executed.
+     *
+     * Waiters sleep on the fence word itself, so there is no driver-wide lock and no wakeup of unrelated waiters.
+     */
+    struct command_fence {
+        std::atomic<std::uint32_t> signalled_;
+        int result_;
+
+        explicit command_fence(const bool signalled = false)
+            : signalled_(signalled ? 1 : 0)
+            , result_(0) {
+        }
+
+        command_fence(const command_fence &) = delete;
+        command_fence &operator=(const command_fence &) = delete;
+
+        /**
+         * @brief Arm the fence again, before submitting the command that will signal it.
+         */
+        void reset();
+
+        void signal(const int result);
+
+        /**
+         * @brief Wait for the fence to be signalled.
+         *
+         * @returns The result the driver signalled the fence with.
+         */
+        int wait();
+
+        bool signalled() const {
+            return signalled_.load(std::memory_order_acquire) != 0;
+        }
+    };
+
     /**
      * \brief Represent a command for driver.
      */
     struct command {
         std::uint32_t opcode_;
         std::uint64_t data_[10];
-        int *status_;
+        command_fence *status_;
 
         explicit command()
             : opcode_(0)
@@ -43,24 +81,77 @@ namespace eka2l1::drivers {
             , status_(nullptr) {
         }
 
-        explicit command(const std::uint16_t opcode, int *status = nullptr)
+        explicit command(const std::uint16_t opcode, command_fence *status = nullptr)
             : opcode_(opcode)
             , data_()
             , status_(status) {
         }
     };
 
+    /**
+     * @brief Linear allocator for the payloads of a command list.
+     *
+     * Data that a command must carry to the driver thread (region rects, uniform data, texture uploads...)
+     * is bump-allocated in here instead of having its own heap allocation. Everything is released at once
+     * when the list is recycled, after the driver executes it.
+     */
+    class command_payload_arena {
+        struct block {
+            std::unique_ptr<std::uint8_t[]> data_;
+            std::size_t size_;
+        };
+
+        std::vector<block> blocks_;
+        std::vector<block> absorbed_;
+        std::vector<std::uint8_t *> adopted_;
+
+        std::size_t current_;
+        std::size_t offset_;
+
+        std::size_t bytes_copied_;
+        std::size_t allocation_count_;
+        std::size_t heap_allocation_count_;
+
+        friend class command_list_pool;
+
+    public:
+        explicit command_payload_arena();
+        ~command_payload_arena();
+
+        command_payload_arena(const command_payload_arena &) = delete;
+        command_payload_arena &operator=(const command_payload_arena &) = delete;
+
+        std::uint8_t *allocate(const std::size_t size);
+
+        /**
+         * @brief Take ownership of a buffer allocated with new[], so it is freed together with the arena content.
+         */
+        void adopt(std::uint8_t *buffer);
+
+        /**
+         * @brief Take over every payload of another arena, leaving it empty.
+         */
+        void absorb(command_payload_arena &another);
+
+        /**
+         * @brief Release all payloads. Normal sized blocks are kept for the next use.
+         */
+        void reset();
+    };
+
     /**
      * \brief A linked list of command.
      */
     struct command_list {
         command *base_;
+        command_payload_arena *payload_;
 
         std::size_t size_;
         std::size_t max_cap_;
 
         explicit command_list(std::size_t max_cap = 0)
             : base_(nullptr)
+            , payload_(nullptr)
             , size_(0)
             , max_cap_(max_cap) {
         }
@@ -86,42 +177,88 @@ namespace eka2l1::drivers {
             return res;
         }
 
-        void renew() {
-            if (max_cap_ == 0) {
-                return;
-            }
-            // NOTE: After command all iterated, the base will be deleted.
-            // No memory leak!
-            base_ = new command[max_cap_];
-            size_ = 0;
-        }
+        /**
+         * @brief Get a command buffer and a payload arena from the pool.
+         *
+         * After all commands are executed, the driver must call recycle() to give them back.
+         */
+        void renew();
+
+        /**
+         * @brief Return the command buffer and the payload arena to the pool.
+         */
+        void recycle();
+
+        /**
+         * @brief Drop a list that will never be executed.
+         *
+         * Fences attached to the commands are signalled with -1 so that nobody waits forever, then the list is recycled.
+         */
+        void abandon();
+
+        std::uint8_t *allocate_payload(const std::size_t size);
+        void adopt_payload(std::uint8_t *buffer);
     };
 
-    class driver {
+    struct command_list_stats {
+        std::uint64_t lists_; ///< Number of command lists executed.
+        std::uint64_t commands_; ///< Number of commands executed.
+        std::uint64_t payload_bytes_; ///< Bytes copied into payload arenas.
+        std::uint64_t payload_allocations_; ///< Payloads allocated from arenas.
+        std::uint64_t heap_allocations_; ///< Command buffers and arena blocks that had to be allocated from the heap.
+        std::uint64_t recycled_lists_; ///< Command lists served from the pool.
+    };
+
+    /**
+     * @brief Pool of command buffers and payload arenas, shared by every emulator thread and driver.
+     *
+     * Lists are acquired by the threads building commands and given back by the driver thread after execution.
+     */
+    class command_list_pool {
+        struct entry {
+            command *base_;
+            command_payload_arena *payload_;
+            std::size_t max_cap_;
+        };
+
+        std::mutex lock_;
+        std::vector<entry> free_;
+
+        command_list_stats current_;
+        command_list_stats last_frame_;
+        command_list_stats total_;
+
     public:
-        std::mutex mut_;
-        std::condition_variable cond_;
+        explicit command_list_pool();
+        ~command_list_pool();
+
+        void acquire(command_list &list);
+        void release(command_list &list);
+
+        /**
+         * @brief Mark the end of a frame. Statistics of the frame just passed are made available.
+         */
+        void end_frame();
+
+        command_list_stats last_frame_stats();
+        command_list_stats total_stats();
+    };
+
+    command_list_pool &get_command_list_pool();
 
+    class driver {
+    public:
         virtual ~driver() {}
         virtual void run() = 0;
         virtual void abort() = 0;
 
-        virtual void wait_for(int *status) {
-            std::unique_lock<std::mutex> ulock(mut_);
-
-            if (*status == 0) {
-                return;
-            }
-
-            cond_.wait(ulock, [&]() { return *status != -100; });
+        virtual void wait_for(command_fence *fence) {
+            fence->wait();
         }
 
-        void finish(int *status, const int code) {
-            if (status) {
-                std::unique_lock<std::mutex> ulock(mut_);
-
-                *status = code;
-                cond_.notify_all();
+        void finish(command_fence *fence, const int code) {
+            if (fence) {
+                fence->signal(code);
             }
         }
     };
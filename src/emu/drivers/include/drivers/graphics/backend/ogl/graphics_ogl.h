@@ -26,12 +26,10 @@
 #include <drivers/graphics/backend/ogl/input_desc_ogl.h>
 #include <drivers/graphics/context.h>
 
-#include <common/queue.h>
 #include <common/region.h>
 #include <glad/glad.h>
 
 #include <memory>
-#include <queue>
 
 namespace eka2l1::drivers {
     struct ogl_state {
@@ -63,7 +61,7 @@ namespace eka2l1::drivers {
     };
 
     class ogl_graphics_driver : public shared_graphics_driver {
-        eka2l1::request_queue<command_list> list_queue;
+        command_list_queue list_queue;
 
         std::unique_ptr<ogl_shader_program> sprite_program;
         std::unique_ptr<ogl_shader_program> brush_program;
@@ -203,7 +201,7 @@ namespace eka2l1::drivers {
         void dispatch(command &cmd) override;
         void bind_swapchain_framebuf() override;
         void update_surface(void *new_surface) override;
-        void wait_for(int *status) override;
+        command_queue_stats get_command_queue_stats() override;
         void set_upscale_shader(const std::string &name) override;
         std::string get_active_upscale_shader() const override;
 
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/graphics.h>
+
+#include <common/vecx.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eka2l1::drivers {
+    /**
+     * @brief A plain RGBA8888 pixel surface in host memory.
+     *
+     * Each pixel is stored as bytes R, G, B, A, rows go from top to bottom.
+     */
+    struct software_surface {
+        eka2l1::vec2 size_;
+        int bpp_;
+        std::vector<std::uint32_t> pixels_;
+
+        explicit software_surface(const eka2l1::vec2 &size = eka2l1::vec2(0, 0), const int bpp = 32);
+
+        void resize(const eka2l1::vec2 &new_size, const bool keep_content);
+
+        std::uint32_t *row(const int y) {
+            return pixels_.data() + static_cast<std::size_t>(y) * size_.x;
+        }
+
+        const std::uint32_t *row(const int y) const {
+            return pixels_.data() + static_cast<std::size_t>(y) * size_.x;
+        }
+    };
+
+    struct software_blend_state {
+        bool enabled_ = false;
+
+        blend_equation rgb_equation_ = blend_equation::add;
+        blend_equation a_equation_ = blend_equation::add;
+        blend_factor rgb_frag_out_factor_ = blend_factor::one;
+        blend_factor rgb_current_factor_ = blend_factor::zero;
+        blend_factor a_frag_out_factor_ = blend_factor::one;
+        blend_factor a_current_factor_ = blend_factor::zero;
+
+        std::uint32_t constant_colour_ = 0;
+    };
+
+    struct software_draw_state {
+        software_blend_state blend_;
+
+        bool scissor_enabled_ = false;
+        eka2l1::rect scissor_;
+
+        // Rectangles marked by a multi-rectangle clip region, replacing the stencil on GPU backends
+        bool region_enabled_ = false;
+        std::vector<eka2l1::rect> region_;
+
+        std::uint32_t brush_color_ = 0xFFFFFFFF;
+        std::uint8_t point_size_ = 1;
+        pen_style pen_style_ = pen_style_solid;
+    };
+
+    /**
+     * @brief Graphics driver that rasterizes the 2D command set on the CPU.
+     *
+     * This backend needs no window or GPU context. Bitmaps and the swapchain are plain memory surfaces, and
+     * the presented frame can be read back or written to PNG files, which makes it suitable for headless
+     * regression tests against golden frames.
+     *
+     * Only the immediate 2D opcodes (the ones used by the window server and font atlas) are implemented.
+     * Shader, buffer and texture opcodes used by hardware GLES are acknowledged but ignored.
+     */
+    class software_graphics_driver : public graphics_driver {
+        command_list_queue list_queue_;
+        std::atomic<bool> should_stop_;
+
+        std::vector<std::unique_ptr<software_surface>> bitmaps_;
+        software_surface swapchain_;
+        software_surface *target_;
+
+        software_draw_state state_;
+        software_draw_state backup_state_;
+
+        eka2l1::rect viewport_;
+        std::string upscale_shader_;
+
+        std::mutex frame_lock_;
+        software_surface presented_;
+        std::uint64_t presented_count_;
+        std::string frame_dump_dir_;
+
+        software_surface *get_bitmap(const drivers::handle h);
+        bool pass_clip(const int x, const int y) const;
+        eka2l1::rect clip_bounds(const eka2l1::rect &draw_rect, const bool for_clear) const;
+
+        void fill_rect(const eka2l1::rect &area, const std::uint32_t color);
+        void plot_pen(const int x, const int y, const std::uint32_t color);
+        void rasterize_line(const eka2l1::point &start, const eka2l1::point &end);
+
+        void create_bitmap(command &cmd);
+        void destroy_bitmap(command &cmd);
+        void bind_bitmap(command &cmd);
+        void resize_bitmap(command &cmd);
+        void update_bitmap(command &cmd);
+        void read_bitmap(command &cmd);
+        void clear(command &cmd);
+        void clip_rect(command &cmd);
+        void clip_region(command &cmd);
+        void draw_bitmap(command &cmd);
+        void draw_rectangle(command &cmd);
+        void draw_line(command &cmd);
+        void draw_polygon(command &cmd);
+        void set_brush_color(command &cmd);
+        void set_feature(command &cmd);
+        void blend_formula(command &cmd);
+        void set_blend_colour(command &cmd);
+        void set_swapchain_size(command &cmd);
+        void read_framebuffer(command &cmd);
+        void display(command &cmd);
+        void ignore_unsupported(command &cmd);
+
+        void dispatch(command &cmd);
+
+    public:
+        explicit software_graphics_driver(const window_system_info &info);
+        ~software_graphics_driver() override;
+
+        void run() override;
+        void abort() override;
+        command_queue_stats get_command_queue_stats() override;
+
+        void update_bitmap(drivers::handle h, const std::size_t size, const eka2l1::vec2 &offset,
+            const eka2l1::vec2 &dim, const void *data, const std::size_t pixels_per_line = 0) override;
+
+        void set_viewport(const eka2l1::rect &viewport) override;
+        void update_surface(void *surface) override;
+        void submit_command_list(command_list &cmd_list) override;
+
+        void set_upscale_shader(const std::string &name) override;
+        std::string get_active_upscale_shader() const override;
+
+        bool support_extension(const graphics_driver_extension ext) override;
+        bool query_extension_value(const graphics_driver_extension_query query, void *data_ptr) override;
+
+        /**
+         * @brief Write every presented frame to a PNG file in the given directory.
+         *
+         * Files are named frame_<number>.png, numbered from the first present. Pass an empty path to stop.
+         */
+        void set_frame_dump_directory(const std::string &path);
+
+        /**
+         * @brief Copy the last presented frame.
+         *
+         * @param pixels    Receives the frame in RGBA8888, rows from top to bottom.
+         * @param size      Receives the frame dimension.
+         *
+         * @returns Number of frames presented so far. Zero if nothing has been presented yet.
+         */
+        std::uint64_t get_presented_frame(std::vector<std::uint32_t> &pixels, eka2l1::vec2 &size);
+
+        /**
+         * @brief Write the last presented frame to a PNG file.
+         */
+        bool dump_presented_frame(const std::string &path);
+    };
+
+    /**
+     * @brief Encode an RGBA8888 image to a PNG file.
+     */
+    bool write_rgba_png(const std::string &path, const std::uint32_t *pixels, const eka2l1::vec2 &size);
+}
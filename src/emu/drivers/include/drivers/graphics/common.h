@@ -26,7 +26,8 @@ namespace eka2l1::drivers {
 
     enum class graphic_api {
         opengl,
-        vulkan
+        vulkan,
+        software
     };
 
     class graphics_object {
@@ -22,12 +22,15 @@
 
 #include <common/vecx.h>
 
+#include <drivers/command_queue.h>
 #include <drivers/driver.h>
 #include <drivers/graphics/common.h>
 #include <drivers/itc.h>
 
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace eka2l1::drivers {
     enum graphics_driver_opcode : std::uint16_t {
@@ -118,9 +121,40 @@ namespace eka2l1::drivers {
 
     using display_hook = std::function<void()>;
 
+    #define HANDLE_BITMAP (1ULL << 32)
+
+    /**
+     * @brief Hand out handle numbers for objects that are yet to be created on the driver thread.
+     *
+     * A client reserves the handle of a new object right away, and the creation is queued with the rest
+     * of the commands. The number stays reserved until the client destroys the handle, even if the creation
+     * failed, so that it is never handed out to another object while the client still holds it.
+     */
+    class graphics_handle_allocator {
+        std::mutex lock_;
+        std::vector<std::uint32_t> free_;
+        std::vector<bool> reserved_;
+        std::uint32_t next_;
+
+    public:
+        explicit graphics_handle_allocator();
+
+        std::uint32_t reserve();
+
+        /**
+         * @brief Give a reserved number back.
+         *
+         * @returns False if the number was not reserved. Nothing is done in that case.
+         */
+        bool release(const std::uint32_t num);
+    };
+
     class graphics_driver : public driver {
         graphic_api api_;
 
+        graphics_handle_allocator bitmap_handles_;
+        graphics_handle_allocator object_handles_;
+
     protected:
         display_hook disp_hook_;
 
@@ -128,6 +162,32 @@ namespace eka2l1::drivers {
         explicit graphics_driver(graphic_api api)
             : api_(api) {}
 
+        /**
+         * @brief Reserve a handle for a bitmap that will be created later by a queued command.
+         */
+        drivers::handle new_bitmap_handle();
+
+        /**
+         * @brief Reserve a handle for a graphics object that will be created later by a queued command.
+         */
+        drivers::handle new_object_handle();
+
+        /**
+         * @brief Give back a reserved handle. Called by the driver thread when the client destroys the handle.
+         *
+         * @returns False if the handle was not reserved.
+         */
+        bool free_handle(const drivers::handle h);
+
+        /**
+         * @brief Fail a creation command on the driver thread.
+         *
+         * The command's status is signalled with an error. The handle that the client reserved has no object
+         * behind it, but stays reserved until the client destroys it. Shader handles are given back right away,
+         * since shader creation waits for the driver and returns no handle on failure.
+         */
+        void fail_creation(command &cmd);
+
         virtual ~graphics_driver() {
         }
 
@@ -169,6 +229,13 @@ namespace eka2l1::drivers {
          */
         virtual void submit_command_list(command_list &cmd_list) = 0;
 
+        /**
+         * \brief Get statistics of the queue that carries command lists to the driver thread.
+         */
+        virtual command_queue_stats get_command_queue_stats() {
+            return command_queue_stats{};
+        }
+
         virtual void set_upscale_shader(const std::string &name) = 0;
         virtual std::string get_active_upscale_shader() const = 0;
 
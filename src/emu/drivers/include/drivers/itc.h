@@ -63,6 +63,18 @@ namespace eka2l1::drivers {
 
     using graphics_driver_dialog_callback = std::function<void(const char *)>;
 
+    /**
+     * Resource creation functions (bitmap, texture, buffer, renderbuffer, framebuffer, input descriptors) do not
+     * wait for the driver. The handle is reserved right away and the creation is queued to the driver, before any
+     * command list that the caller submits after. Initial data is copied, so the caller can free it on return.
+     *
+     * If the driver fails to create the object, it signals the optional status fence with a non-zero result. A caller
+     * that must report the failure passes a fence and checks its result. Either way the handle stays reserved, with
+     * no object behind it, and must still be destroyed like any other.
+     *
+     * Shader creation still waits for the driver, since the compile log and metadata are read back.
+     */
+
     /** \brief Create a new bitmap in the server size.
       *
       * A bitmap will be created in the server side when using this function. When you bind
@@ -70,10 +82,12 @@ namespace eka2l1::drivers {
       *
       * \param initial_size       The initial size of the bitmap.
       * \param bpp                Bits per pixel of the bitmap
+      * \param status             Optional fence signalled with the creation result.
       * 
       * \returns ID of the bitmap.
       */
-    drivers::handle create_bitmap(graphics_driver *driver, const eka2l1::vec2 &size, const std::uint32_t bpp);
+    drivers::handle create_bitmap(graphics_driver *driver, const eka2l1::vec2 &size, const std::uint32_t bpp,
+        command_fence *status = nullptr);
 
     /** \brief Create a new shader module.
       *
@@ -114,13 +128,14 @@ namespace eka2l1::drivers {
      * \param data              Pointer to the data to upload.
      * \param size              Dimension size of the texture.
      * \param pixels_per_line   Number of pixels per row. Use 0 for default.
+     * \param status            Optional fence signalled with the creation result.
      *
      * \returns Handle to the texture.
      */
     drivers::handle create_texture(graphics_driver *driver, const std::uint8_t dim, const std::uint8_t mip_levels,
         drivers::texture_format internal_format, drivers::texture_format data_format, drivers::texture_data_type data_type,
         const void *data, const std::size_t total_data_size, const eka2l1::vec3 &size, const std::size_t pixels_per_line = 0,
-        const std::uint32_t unpack_alignment = 4);
+        const std::uint32_t unpack_alignment = 4, command_fence *status = nullptr);
 
     /**
      * @brief Create a new renderbuffer.
@@ -131,10 +146,12 @@ namespace eka2l1::drivers {
      * @param driver                The driver associated with this renderbuffer.
      * @param size                  The dimension of the renderbuffer.
      * @param internal_format       The internal format used to store the surface data.
+     * @param status                Optional fence signalled with the creation result.
      * 
-     * @returns Handle to the renderbuffer. 0 on failure.
+     * @returns Handle to the renderbuffer.
      */
-    drivers::handle create_renderbuffer(graphics_driver *driver, const eka2l1::vec2 &size, const drivers::texture_format internal_format);
+    drivers::handle create_renderbuffer(graphics_driver *driver, const eka2l1::vec2 &size, const drivers::texture_format internal_format,
+        command_fence *status = nullptr);
 
     /**
      * \brief Create a new buffer.
@@ -143,10 +160,12 @@ namespace eka2l1::drivers {
      * \param initial_data     The initial data to supply to the buffer.
      * \param initial_size     The size of the buffer. Later resize won't keep the buffer data.
      * \param upload_hint      Upload frequency and target hint for the buffer.
+     * \param status           Optional fence signalled with the creation result.
      *
      * \returns Handle to the buffer.
      */
-    drivers::handle create_buffer(graphics_driver *driver, const void *initial_data, const std::size_t initial_size, const buffer_upload_hint upload_hint);
+    drivers::handle create_buffer(graphics_driver *driver, const void *initial_data, const std::size_t initial_size, const buffer_upload_hint upload_hint,
+        command_fence *status = nullptr);
 
     /**
      * @brief Create input layout descriptors for input vertex data.
@@ -154,8 +173,10 @@ namespace eka2l1::drivers {
      * @brief driver            The driver associated with the input descriptor.
      * @brief descriptors       The layout infos.
      * @brief count             Number of descriptor provided.
+     * @brief status            Optional fence signalled with the creation result.
      */
-    drivers::handle create_input_descriptors(graphics_driver *driver, input_descriptor *descriptors, const std::uint32_t count);
+    drivers::handle create_input_descriptors(graphics_driver *driver, input_descriptor *descriptors, const std::uint32_t count,
+        command_fence *status = nullptr);
 
     /**
      * @brief Create a framebuffer object.
@@ -170,12 +191,13 @@ namespace eka2l1::drivers {
      * @param depth_face_index       The index of the face in texture to render the depth buffer to.
      * @param stencil_buffer         Handle to the stencil buffer (texture/renderbuffer).
      * @param stencil_face_index       The index of the face in texture to render the depth buffer to.
+     * @param status                 Optional fence signalled with the creation result.
      * 
-     * @return Non-zero handle on success.
+     * @return Handle to the framebuffer.
      */
     drivers::handle create_framebuffer(graphics_driver *driver, const drivers::handle *color_buffers, const int *color_face_indicies,
         const std::uint32_t color_buffer_count, drivers::handle depth_buffer, const int depth_face_index,
-        drivers::handle stencil_buffer, const int stencil_face_index);
+        drivers::handle stencil_buffer, const int stencil_face_index, command_fence *status = nullptr);
 
     /**
      * @brief Read bitmap data from a region into memory buffer.
@@ -232,9 +254,7 @@ namespace eka2l1::drivers {
         }
 
         ~graphics_command_builder() {
-            if (list_.base_) {
-                delete list_.base_;
-            }
+            list_.recycle();
         }
 
         bool is_empty() const {
@@ -246,15 +266,13 @@ namespace eka2l1::drivers {
         }
 
         void reset_list() {
-            delete list_.base_;
-
-            list_.size_ = 0;
-            list_.base_ = nullptr;
+            list_.recycle();
         }
 
         command_list retrieve_command_list() {
             command_list copy = list_;
             list_.base_ = nullptr;
+            list_.payload_ = nullptr;
             list_.size_ = 0;
 
             return copy;
@@ -271,16 +289,29 @@ namespace eka2l1::drivers {
 
             if (list_.base_ == nullptr) {
                 list_ = another;
-            } else {
-                if (another.size_ + list_.size_ > list_.max_cap_) {
-                    return false;
-                }
 
-                std::memcpy(list_.base_ + list_.size_, another.base_, another.size_ * sizeof(command));
-                list_.size_ += another.size_;
+                another.base_ = nullptr;
+                another.payload_ = nullptr;
+                another.size_ = 0;
+
+                return true;
+            }
+
+            if (another.size_ + list_.size_ > list_.max_cap_) {
+                return false;
+            }
+
+            std::memcpy(list_.base_ + list_.size_, another.base_, another.size_ * sizeof(command));
+            list_.size_ += another.size_;
+
+            // Payloads of the merged commands must live until this list is executed
+            if (list_.payload_ && another.payload_) {
+                list_.payload_->absorb(*another.payload_);
             }
 
-            delete[] another.base_;
+            // The commands are now counted with this list
+            another.size_ = 0;
+            another.recycle();
             return true;
         }
 
@@ -333,6 +364,7 @@ namespace eka2l1::drivers {
          * \param offset            The offset of the bitmap (pixels).
          * \param dim               The dimensions of bitmap (pixels).
          * \param pixels_per_line   Number of pixels per row. Use 0 for default.
+         * \param need_copy         False to hand over the data, which must be allocated with new[], instead of copying it.
          * 
          * \returns Handle to the texture.
          */
@@ -477,6 +509,11 @@ namespace eka2l1::drivers {
          */
         void update_buffer_data(drivers::handle h, const std::size_t offset, const int chunk_count, const void **chunk_ptr, const std::uint32_t *chunk_size);
 
+        /**
+         * \brief Update buffer data with a buffer that is handed over to the command list.
+         *
+         * The buffer must be allocated with new[]. It is freed when the list is recycled.
+         */
         void update_buffer_data_no_copy(drivers::handle h, const std::size_t offset, const void *ptr, const std::uint32_t size);
 
         /**
@@ -561,8 +598,10 @@ namespace eka2l1::drivers {
 
         /**
          * \brief Present swapchain to screen.
+         *
+         * \param fence Optional fence to signal once the frame is presented. Reset it before submitting.
          */
-        void present(int *status);
+        void present(command_fence *fence);
 
         /**
          * \brief Destroy an object.
@@ -18,7 +18,9 @@
  */
 
 #include <drivers/audio/audio.h>
+#include <drivers/audio/mixer.h>
 #include <drivers/audio/backend/cubeb/audio_cubeb.h>
+#include <drivers/audio/backend/null/audio_null.h>
 
 #include <common/platform.h>
 
@@ -41,6 +43,46 @@ namespace eka2l1::drivers {
         , preferred_midi_backend_(preferred_midi_backend) {
     }
 
+    audio_driver::~audio_driver() {
+        destroy_mixer();
+    }
+
+    void audio_driver::destroy_mixer() {
+        const std::lock_guard<std::mutex> guard(mixer_lock_);
+        mixer_.reset();
+    }
+
+    void audio_driver::enable_mixer(const bool enable) {
+        const std::lock_guard<std::mutex> guard(mixer_lock_);
+        mixer_enabled_ = enable;
+    }
+
+    audio_mixer *audio_driver::get_mixer() {
+        const std::lock_guard<std::mutex> guard(mixer_lock_);
+        return mixer_.get();
+    }
+
+    std::unique_ptr<audio_output_stream> audio_driver::new_output_stream(const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback) {
+        {
+            const std::lock_guard<std::mutex> guard(mixer_lock_);
+
+            if (mixer_enabled_) {
+                if (!mixer_) {
+                    mixer_ = std::make_unique<audio_mixer>(this, native_sample_rate());
+                }
+
+                if (auto stream = mixer_->new_stream(sample_rate, channels, callback)) {
+                    return stream;
+                }
+
+                // The mixer could not open its host stream, so try to open one directly
+            }
+        }
+
+        return new_host_output_stream(sample_rate, channels, callback);
+    }
+
     std::vector<player_type> audio_driver::get_suitable_player_types(const std::string &url) {
         std::vector<player_type> res;
 
@@ -136,12 +178,16 @@ namespace eka2l1::drivers {
     }
 
     audio_driver_instance make_audio_driver(const audio_driver_backend backend, const std::uint32_t initial_master_vol,
-        const player_type preferred_midi_backend) {
+        const player_type preferred_midi_backend, const null_audio_options &null_options) {
         switch (backend) {
         case audio_driver_backend::cubeb: {
             return std::make_unique<cubeb_audio_driver>(initial_master_vol, preferred_midi_backend);
         }
 
+        case audio_driver_backend::null: {
+            return std::make_unique<null_audio_driver>(null_options, initial_master_vol, preferred_midi_backend);
+        }
+
         default:
             break;
         }
@@ -42,7 +42,8 @@ namespace eka2l1::drivers {
 
     cubeb_audio_driver::~cubeb_audio_driver() {
         BAE_DriverDeactivated(this);
-        
+        destroy_mixer();
+
         if (context_) {
             cubeb_destroy(context_);
         }
@@ -64,7 +65,7 @@ namespace eka2l1::drivers {
         return preferred_rate;
     }
 
-    std::unique_ptr<audio_output_stream> cubeb_audio_driver::new_output_stream(const std::uint32_t sample_rate,
+    std::unique_ptr<audio_output_stream> cubeb_audio_driver::new_host_output_stream(const std::uint32_t sample_rate,
         const std::uint8_t channels, data_callback callback) {
         if (!init_) {
             return nullptr;
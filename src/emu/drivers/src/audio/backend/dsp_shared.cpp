@@ -17,24 +17,113 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/algorithm.h>
 #include <common/log.h>
+#include <common/thread.h>
 #include <drivers/audio/backend/dsp_shared.h>
 
 namespace eka2l1::drivers {
+    // Keep at least this much audio decoded ahead, in milliseconds
+    static constexpr std::size_t DECODE_AHEAD_MIN_MS = 100;
+
+    // Or this much host periods, whichever is bigger
+    static constexpr std::size_t DECODE_AHEAD_PERIOD_COUNT = 8;
+
     dsp_output_stream_shared::dsp_output_stream_shared(drivers::audio_driver *aud)
         : dsp_output_stream()
         , aud_(aud)
+        , avg_frame_count_(0)
         , virtual_stop(true)
         , more_requested(false)
-        , avg_frame_count_(0) {
+        , decode_running_(false)
+        , decode_requested_(false) {
     }
 
     dsp_output_stream_shared::~dsp_output_stream_shared() {
+        stop_decode_worker();
+
         if (stream_) {
             stream_->stop();
         }
     }
 
+    std::size_t dsp_output_stream_shared::decode_ahead_sample_count() const {
+        const std::size_t min_samples = freq_ * channels_ * DECODE_AHEAD_MIN_MS / 1000;
+        const std::size_t period_samples = avg_frame_count_.load() * channels_ * DECODE_AHEAD_PERIOD_COUNT;
+
+        // Leave room for one decoded chunk, which can not be pushed partially
+        return common::min<std::size_t>(common::max(min_samples, period_samples), RING_BUFFER_MAX_SAMPLE_COUNT / 2);
+    }
+
+    void dsp_output_stream_shared::start_decode_worker() {
+        if (decode_thread_) {
+            return;
+        }
+
+        decode_running_ = true;
+        decode_thread_ = std::make_unique<std::thread>([this]() {
+            decode_worker_loop();
+        });
+    }
+
+    void dsp_output_stream_shared::stop_decode_worker() {
+        if (!decode_thread_) {
+            return;
+        }
+
+        decode_running_ = false;
+        decode_sema_.notify();
+
+        decode_thread_->join();
+        decode_thread_.reset();
+    }
+
+    void dsp_output_stream_shared::request_decode() {
+        // Avoid waking the worker again if it has not picked up the last request yet
+        if (!decode_requested_.exchange(true)) {
+            decode_sema_.notify();
+        }
+    }
+
+    void dsp_output_stream_shared::decode_worker_loop() {
+        common::set_thread_name("DSP decode worker");
+
+        while (true) {
+            decode_sema_.wait();
+
+            if (!decode_running_) {
+                break;
+            }
+
+            decode_requested_ = false;
+            fill_decode_ahead();
+        }
+    }
+
+    void dsp_output_stream_shared::fill_decode_ahead() {
+        const std::size_t target = decode_ahead_sample_count();
+
+        // Lock per packet, so that the emulator thread waits for at most one packet to be decoded
+        while (decode_running_) {
+            {
+                const std::lock_guard<std::mutex> guard(decode_lock_);
+
+                if (buffer_.size() >= target) {
+                    break;
+                }
+
+                if (!decode_data(decode_scratch_)) {
+                    break;
+                }
+
+                buffer_.push(decode_scratch_.data(), (decode_scratch_.size() + 1) / 2);
+            }
+
+            // Give a waiting thread the chance to take the lock before the next packet
+            std::this_thread::yield();
+        }
+    }
+
     bool dsp_output_stream_shared::set_properties(const std::uint32_t freq, const std::uint8_t channels) {
         // Doc said: Writing to the stream must have stopped before you call this function.
         if ((channels_ == channels) && (freq_ == freq)) {
@@ -117,6 +206,7 @@ namespace eka2l1::drivers {
         virtual_stop = true;
         more_requested = false;
 
+        const std::lock_guard<std::mutex> guard(decode_lock_);
         buffer_.reset();
 
         return true;
@@ -163,6 +253,9 @@ namespace eka2l1::drivers {
         // Copy buffer to queue
         if (format_ != PCM16_FOUR_CC_CODE) {
             queue_data_decode(data, data_size);
+
+            start_decode_worker();
+            request_decode();
         } else {
             buffer_.push(data, (data_size + 1) / 2);
         }
@@ -188,13 +281,11 @@ namespace eka2l1::drivers {
             avg_frame_count_ = (avg_frame_count_ + frame_count) / 2;
         }
 
-        if (format_ != PCM16_FOUR_CC_CODE) {
-            // Running on low
-            if (buffer_.size() <= (avg_frame_count_ * channels_ * 4)) {
-                std::vector<std::uint8_t> target_buffer;
-                decode_data(target_buffer);
-
-                buffer_.push(target_buffer.data(), (target_buffer.size() + 1) / 2);
+        // Do not decode here, this runs on the host audio thread. Just wake the worker up so that
+        // it refills the ring buffer before we run dry.
+        if ((format_ != PCM16_FOUR_CC_CODE) && decode_running_) {
+            if (buffer_.size() <= decode_ahead_sample_count()) {
+                request_decode();
             }
         }
 
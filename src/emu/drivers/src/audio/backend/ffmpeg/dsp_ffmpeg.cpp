@@ -49,11 +49,36 @@ namespace eka2l1::drivers {
         , io_(nullptr)
         , custom_io_buffer_(nullptr)
         , timestamp_in_base_(0)
+        , queued_data_offset_(0)
+        , queued_data_left_(0)
+        , packet_(nullptr)
+        , frame_(nullptr)
+        , swr_(nullptr)
+        , swr_in_layout_(0)
+        , swr_in_format_(-1)
+        , swr_in_rate_(0)
+        , swr_out_channels_(0)
+        , swr_out_rate_(0)
         , state_(STATE_NONE) {
         format(PCM16_FOUR_CC_CODE);
     }
 
     dsp_output_stream_ffmpeg::~dsp_output_stream_ffmpeg() {
+        // The worker may still be in the middle of decoding
+        stop_decode_worker();
+
+        if (swr_) {
+            swr_free(&swr_);
+        }
+
+        if (packet_) {
+            av_packet_free(&packet_);
+        }
+
+        if (frame_) {
+            av_frame_free(&frame_);
+        }
+
         if (codec_) {
             avcodec_close(codec_);
             avcodec_free_context(&codec_);
@@ -71,19 +96,25 @@ namespace eka2l1::drivers {
     }
 
     int dsp_output_stream_ffmpeg::read_queued_data(std::uint8_t *buffer, int buffer_size) {
-        if (queued_data_.empty()) {
+        const std::lock_guard<std::mutex> guard(queued_data_lock_);
+        const std::size_t left = queued_data_.size() - queued_data_offset_;
+
+        if (left == 0) {
             return AVERROR_EOF;
         }
 
-        int read_size = common::min<int>(buffer_size, static_cast<int>(queued_data_.size()));
-        std::memcpy(buffer, queued_data_.data(), read_size);
+        int read_size = common::min<int>(buffer_size, static_cast<int>(left));
+        std::memcpy(buffer, queued_data_.data() + queued_data_offset_, read_size);
+
+        queued_data_offset_ += read_size;
 
-        if (read_size == queued_data_.size()) {
+        if (queued_data_offset_ == queued_data_.size()) {
+            // Keep the capacity around for the next write
             queued_data_.clear();
-        } else {
-            queued_data_.erase(queued_data_.begin(), queued_data_.begin() + read_size);
+            queued_data_offset_ = 0;
         }
 
+        queued_data_left_ = queued_data_.size() - queued_data_offset_;
         return (read_size <= 0) ? AVERROR_EOF : read_size;
     }
 
@@ -94,6 +125,8 @@ namespace eka2l1::drivers {
     }
 
     bool dsp_output_stream_ffmpeg::format(const four_cc fmt) {
+        const std::lock_guard<std::mutex> guard(decode_lock_);
+
         if ((fmt == PCM16_FOUR_CC_CODE) || (fmt == PCM8_FOUR_CC_CODE)) {
             if (codec_) {
                 avcodec_close(codec_);
@@ -179,23 +212,60 @@ namespace eka2l1::drivers {
     }
 
     void dsp_output_stream_ffmpeg::queue_data_decode(const std::uint8_t *original, const std::size_t original_size) {
-        const std::lock_guard<std::mutex> guard(decode_lock_);
-
         const bool all_zero = std::all_of(original, original + original_size, [](std::uint8_t i) { return i==0; });
         if (all_zero) {
-            // Queue buffer
+            // Queue buffer. The decode worker also pushes to it, so wait for its current packet.
+            const std::lock_guard<std::mutex> guard(decode_lock_);
             buffer_.push(reinterpret_cast<const std::uint16_t*>(original), (original_size + 1) / 2);
             return;
         }
 
-        queued_data_.resize(queued_data_.size() + original_size);
-        std::memcpy(queued_data_.data() + queued_data_.size() - original_size, original, original_size);
+        const std::lock_guard<std::mutex> guard(queued_data_lock_);
+
+        if ((queued_data_offset_ != 0) && (queued_data_offset_ >= queued_data_.size() / 2)) {
+            // Most of the queue has been consumed, drop it now before growing
+            queued_data_.erase(queued_data_.begin(), queued_data_.begin() + queued_data_offset_);
+            queued_data_offset_ = 0;
+        }
+
+        queued_data_.insert(queued_data_.end(), original, original + original_size);
+        queued_data_left_ = queued_data_.size() - queued_data_offset_;
+    }
+
+    bool dsp_output_stream_ffmpeg::prepare_resampler(const AVFrame *frame) {
+        const std::uint64_t in_layout = frame->channel_layout ? frame->channel_layout
+            : static_cast<std::uint64_t>(av_get_default_channel_layout(frame->channels));
+
+        if (swr_ && (swr_in_layout_ == in_layout) && (swr_in_format_ == frame->format) && (swr_in_rate_ == frame->sample_rate)
+            && (swr_out_channels_ == channels_) && (swr_out_rate_ == freq_)) {
+            return true;
+        }
+
+        swr_ = swr_alloc_set_opts(swr_,
+            (channels_ == 1) ? AV_CH_LAYOUT_MONO : AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_S16, freq_,
+            in_layout, static_cast<AVSampleFormat>(frame->format), frame->sample_rate,
+            0, nullptr);
+
+        if (!swr_ || (swr_init(swr_) < 0)) {
+            LOG_ERROR(DRIVER_AUD, "Error initializing SWR context");
+            swr_free(&swr_);
+
+            return false;
+        }
+
+        swr_in_layout_ = in_layout;
+        swr_in_format_ = frame->format;
+        swr_in_rate_ = frame->sample_rate;
+        swr_out_channels_ = channels_;
+        swr_out_rate_ = freq_;
+
+        return true;
     }
 
     bool dsp_output_stream_ffmpeg::decode_data(std::vector<std::uint8_t> &dest) {
         dest.clear();
 
-        if (queued_data_.empty()) {
+        if (queued_data_left_ == 0) {
             // Nothing more to resolve
             return false;
         }
@@ -241,61 +311,67 @@ namespace eka2l1::drivers {
             return false;
         }
 
-        AVPacket *packet = av_packet_alloc();
-        if (av_read_frame(av_format_, packet) < 0) {
-            av_packet_free(&packet);
+        if (!packet_) {
+            packet_ = av_packet_alloc();
+            frame_ = av_frame_alloc();
+
+            if (!packet_ || !frame_) {
+                LOG_ERROR(DRIVER_AUD, "Can't allocate FFMPEG DSP packet or frame!");
+                return false;
+            }
+        }
+
+        if (av_read_frame(av_format_, packet_) < 0) {
             return false;
         }
-        
-        int err = avcodec_send_packet(codec_, packet);
-        av_packet_free(&packet);
 
-        if (err >= 0) {
-            AVFrame *frame = av_frame_alloc();
+        int err = avcodec_send_packet(codec_, packet_);
+        av_packet_unref(packet_);
 
-            if (avcodec_receive_frame(codec_, frame) < 0) {
-                av_frame_free(&frame);
+        if (err >= 0) {
+            if (avcodec_receive_frame(codec_, frame_) < 0) {
                 return false;
             }
 
-            dest.resize(channels_ * frame->nb_samples * sizeof(std::uint16_t));
-            timestamp_in_base_ = frame->best_effort_timestamp;
-
-            if ((channels_ != codec_->channels) || (frame->format != AV_SAMPLE_FMT_S16)) {
-                SwrContext *swr = swr_alloc_set_opts(nullptr,
-                    (channels_ == 1) ? AV_CH_LAYOUT_MONO : AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_S16, freq_,
-                    frame->channel_layout, static_cast<AVSampleFormat>(frame->format), frame->sample_rate,
-                    0, nullptr);
-
-                if (swr_init(swr) < 0) {
-                    LOG_ERROR(DRIVER_AUD, "Error initializing SWR context");
-                    av_frame_free(&frame);
+            timestamp_in_base_ = frame_->best_effort_timestamp;
 
+            if ((channels_ != codec_->channels) || (frame_->format != AV_SAMPLE_FMT_S16) || (frame_->sample_rate != static_cast<int>(freq_))) {
+                if (!prepare_resampler(frame_)) {
+                    av_frame_unref(frame_);
                     return false;
                 }
 
-                std::uint8_t *output = &dest[0];
-                const std::uint8_t **input = const_cast<const std::uint8_t**>(frame->extended_data);
+                // The output sample count differs from the input one when the rate is converted
+                const int max_out_samples = swr_get_out_samples(swr_, frame_->nb_samples);
+                dest.resize(channels_ * max_out_samples * sizeof(std::uint16_t));
 
-                const int result = swr_convert(swr, &output, frame->nb_samples, input, frame->nb_samples);
-                swr_free(&swr);
+                std::uint8_t *output = dest.data();
+                const std::uint8_t **input = const_cast<const std::uint8_t**>(frame_->extended_data);
+
+                const int result = swr_convert(swr_, &output, max_out_samples, input, frame_->nb_samples);
+                av_frame_unref(frame_);
 
                 if (result < 0) {
                     LOG_ERROR(DRIVER_AUD, "Error resample audio data!");
+                    dest.clear();
+
                     return false;
                 }
+
+                dest.resize(channels_ * result * sizeof(std::uint16_t));
             } else {
-                std::memcpy(&dest[0], frame->data[0], dest.size());
-            }
+                dest.resize(channels_ * frame_->nb_samples * sizeof(std::uint16_t));
+                std::memcpy(dest.data(), frame_->data[0], dest.size());
 
-            av_frame_free(&frame);
+                av_frame_unref(frame_);
+            }
         }
 
         return true;
     }
 
     bool dsp_output_stream_ffmpeg::internal_decode_running_out() {
-        return ((format_ != drivers::PCM16_FOUR_CC_CODE) && (queued_data_.size() <= CUSTOM_IO_BUFFER_SIZE * 2)) ||
+        return ((format_ != drivers::PCM16_FOUR_CC_CODE) && (queued_data_left_ <= CUSTOM_IO_BUFFER_SIZE * 2)) ||
             dsp_output_stream_shared::internal_decode_running_out();
     }
 }
\ No newline at end of file
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/audio/backend/baeplat_impl.h>
+#include <drivers/audio/backend/null/audio_null.h>
+#include <drivers/audio/backend/null/stream_null.h>
+
+#include <common/algorithm.h>
+#include <common/log.h>
+#include <common/thread.h>
+
+#include <chrono>
+
+namespace eka2l1::drivers {
+    static constexpr std::uint8_t NULL_DEVICE_CHANNEL_COUNT = 2;
+    static constexpr std::uint32_t NULL_DEVICE_MAX_LATE_PERIODS = 4;
+    static constexpr std::uint32_t WAV_HEADER_SIZE = 44;
+
+    null_audio_driver::null_audio_driver(const null_audio_options &options, const std::uint32_t initial_master_volume,
+        const player_type preferred_midi_backend)
+        : audio_driver(initial_master_volume, preferred_midi_backend)
+        , options_(options)
+        , running_(false)
+        , wav_data_size_(0) {
+        if (options_.sample_rate_ == 0) {
+            options_.sample_rate_ = null_audio_options{}.sample_rate_;
+        }
+
+        if (options_.period_frames_ == 0) {
+            options_.period_frames_ = null_audio_options{}.period_frames_;
+        }
+
+        mix_buffer_.resize(options_.period_frames_ * NULL_DEVICE_CHANNEL_COUNT);
+        output_buffer_.resize(options_.period_frames_ * NULL_DEVICE_CHANNEL_COUNT);
+
+        if (!options_.dump_path_.empty()) {
+            open_wav_dump();
+        }
+
+        LOG_INFO(DRIVER_AUD, "Null audio device running at {} Hz, {} frames per period", options_.sample_rate_,
+            options_.period_frames_);
+
+        running_ = true;
+        clock_thread_ = std::make_unique<std::thread>([this]() {
+            clock_loop();
+        });
+    }
+
+    null_audio_driver::~null_audio_driver() {
+        BAE_DriverDeactivated(this);
+
+        // A tick calls into the mixer, and stopping a stream does not wait for a tick in progress.
+        // Stop the clock before the mixer goes away.
+        running_ = false;
+
+        if (clock_thread_) {
+            clock_thread_->join();
+        }
+
+        destroy_mixer();
+        close_wav_dump();
+    }
+
+    std::uint32_t null_audio_driver::native_sample_rate() {
+        return options_.sample_rate_;
+    }
+
+    std::unique_ptr<audio_output_stream> null_audio_driver::new_host_output_stream(const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback) {
+        if ((sample_rate == 0) || (channels == 0)) {
+            return nullptr;
+        }
+
+        return std::make_unique<null_audio_output_stream>(this, sample_rate, channels, callback);
+    }
+
+    void null_audio_driver::attach(null_audio_output_stream *stream) {
+        const std::lock_guard<std::mutex> guard(streams_lock_);
+        streams_.push_back(stream);
+    }
+
+    void null_audio_driver::detach(null_audio_output_stream *stream) {
+        const std::lock_guard<std::mutex> guard(streams_lock_);
+        streams_.erase(std::remove(streams_.begin(), streams_.end(), stream), streams_.end());
+    }
+
+    void null_audio_driver::clock_loop() {
+        common::set_thread_name("Null audio device clock");
+
+        const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(options_.period_frames_) / options_.sample_rate_));
+
+        auto next_tick = std::chrono::steady_clock::now() + period;
+
+        while (running_) {
+            std::this_thread::sleep_until(next_tick);
+            tick();
+
+            next_tick += period;
+
+            // A real device drops what it could not play in time, instead of catching up in a burst.
+            const auto now = std::chrono::steady_clock::now();
+            if (now - next_tick > period * NULL_DEVICE_MAX_LATE_PERIODS) {
+                next_tick = now + period;
+            }
+        }
+    }
+
+    void null_audio_driver::tick() {
+        const std::size_t device_frames = options_.period_frames_;
+        const float master_gain = static_cast<float>(master_volume()) / 100.0f;
+
+        std::fill(mix_buffer_.begin(), mix_buffer_.end(), 0);
+
+        {
+            const std::lock_guard<std::mutex> guard(streams_lock_);
+
+            for (null_audio_output_stream *stream : streams_) {
+                if (!stream->playing_ || stream->pausing_ || stream->drained_ || suspending()) {
+                    continue;
+                }
+
+                const std::size_t frames = stream->tick(options_.sample_rate_, device_frames);
+
+                if (!wav_file_ || (stream->sample_rate != options_.sample_rate_) || (stream->channels > NULL_DEVICE_CHANNEL_COUNT)) {
+                    continue;
+                }
+
+                const float gain = stream->volume_ * master_gain;
+                const std::int16_t *source = stream->buffer_.data();
+
+                for (std::size_t i = 0; i < common::min(frames, device_frames); i++) {
+                    for (std::uint8_t c = 0; c < NULL_DEVICE_CHANNEL_COUNT; c++) {
+                        const std::int16_t sample = source[i * stream->channels + ((stream->channels == 1) ? 0 : c)];
+                        mix_buffer_[i * NULL_DEVICE_CHANNEL_COUNT + c] += static_cast<std::int32_t>(sample * gain);
+                    }
+                }
+            }
+        }
+
+        if (!wav_file_) {
+            return;
+        }
+
+        for (std::size_t i = 0; i < mix_buffer_.size(); i++) {
+            output_buffer_[i] = static_cast<std::int16_t>(common::clamp<std::int32_t>(-32768, 32767, mix_buffer_[i]));
+        }
+
+        wav_data_size_ += wav_file_->write(output_buffer_.data(), output_buffer_.size() * sizeof(std::int16_t));
+    }
+
+    template <typename T>
+    static void write_wav_value(common::wo_stream &stream, const T value) {
+        stream.write(&value, sizeof(T));
+    }
+
+    static void write_wav_header(common::wo_stream &stream, const std::uint32_t sample_rate, const std::uint8_t channels,
+        const std::uint32_t data_size) {
+        const std::uint16_t block_align = static_cast<std::uint16_t>(channels * sizeof(std::int16_t));
+
+        stream.write("RIFF", 4);
+        write_wav_value<std::uint32_t>(stream, WAV_HEADER_SIZE - 8 + data_size);
+        stream.write("WAVE", 4);
+
+        stream.write("fmt ", 4);
+        write_wav_value<std::uint32_t>(stream, 16);
+        write_wav_value<std::uint16_t>(stream, 1); // PCM
+        write_wav_value<std::uint16_t>(stream, channels);
+        write_wav_value<std::uint32_t>(stream, sample_rate);
+        write_wav_value<std::uint32_t>(stream, sample_rate * block_align);
+        write_wav_value<std::uint16_t>(stream, block_align);
+        write_wav_value<std::uint16_t>(stream, 16);
+
+        stream.write("data", 4);
+        write_wav_value<std::uint32_t>(stream, data_size);
+    }
+
+    bool null_audio_driver::open_wav_dump() {
+        wav_file_ = std::make_unique<common::wo_std_file_stream>(options_.dump_path_, true);
+
+        if (!wav_file_->valid()) {
+            LOG_ERROR(DRIVER_AUD, "Unable to open {} to dump audio output", options_.dump_path_);
+            wav_file_.reset();
+
+            return false;
+        }
+
+        // Sizes are patched when the dump is closed
+        write_wav_header(*wav_file_, options_.sample_rate_, NULL_DEVICE_CHANNEL_COUNT, 0);
+        return true;
+    }
+
+    void null_audio_driver::close_wav_dump() {
+        if (!wav_file_) {
+            return;
+        }
+
+        wav_file_->seek(0, common::beg);
+        write_wav_header(*wav_file_, options_.sample_rate_, NULL_DEVICE_CHANNEL_COUNT,
+            static_cast<std::uint32_t>(common::min<std::uint64_t>(wav_data_size_, 0xFFFFFFFF - WAV_HEADER_SIZE)));
+
+        wav_file_.reset();
+    }
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/audio/backend/null/audio_null.h>
+#include <drivers/audio/backend/null/stream_null.h>
+
+#include <common/algorithm.h>
+
+#include <cstring>
+
+namespace eka2l1::drivers {
+    null_audio_output_stream::null_audio_output_stream(null_audio_driver *driver, const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback)
+        : audio_output_stream(driver, sample_rate, channels)
+        , null_driver_(driver)
+        , callback_(callback)
+        , playing_(false)
+        , pausing_(false)
+        , drained_(false)
+        , volume_(1.0f)
+        , frames_played_(0)
+        , frames_owed_(0.0) {
+        null_driver_->attach(this);
+    }
+
+    null_audio_output_stream::~null_audio_output_stream() {
+        null_driver_->detach(this);
+    }
+
+    std::size_t null_audio_output_stream::tick(const std::uint32_t device_rate, const std::size_t device_frames) {
+        // Streams at a different rate than the device still have to advance at real time pace. Carry the
+        // fractional part over to the next period.
+        frames_owed_ += static_cast<double>(device_frames) * sample_rate / device_rate;
+
+        const std::size_t frames = static_cast<std::size_t>(frames_owed_);
+        frames_owed_ -= static_cast<double>(frames);
+
+        if (frames == 0) {
+            return 0;
+        }
+
+        if (buffer_.size() < frames * channels) {
+            buffer_.resize(frames * channels);
+        }
+
+        const std::size_t frames_got = common::min<std::size_t>(frames, callback_(buffer_.data(), frames));
+
+        if (frames_got < frames) {
+            // Same as a host stream, a short read means the stream is drained
+            std::memset(buffer_.data() + frames_got * channels, 0, (frames - frames_got) * channels * sizeof(std::int16_t));
+            drained_ = true;
+        }
+
+        frames_played_ += frames_got;
+        return frames_got;
+    }
+
+    bool null_audio_output_stream::start() {
+        drained_ = false;
+
+        if (pausing_) {
+            pausing_ = false;
+            return true;
+        }
+
+        playing_ = true;
+        return true;
+    }
+
+    bool null_audio_output_stream::stop() {
+        pausing_ = false;
+        playing_ = false;
+
+        return true;
+    }
+
+    void null_audio_output_stream::pause() {
+        pausing_ = true;
+    }
+
+    bool null_audio_output_stream::is_playing() {
+        return playing_;
+    }
+
+    bool null_audio_output_stream::is_pausing() {
+        return pausing_;
+    }
+
+    bool null_audio_output_stream::set_volume(const float volume) {
+        volume_ = volume;
+        return true;
+    }
+
+    float null_audio_output_stream::get_volume() const {
+        return volume_;
+    }
+
+    bool null_audio_output_stream::current_frame_position(std::uint64_t *pos) {
+        *pos = frames_played_.load();
+        return true;
+    }
+}
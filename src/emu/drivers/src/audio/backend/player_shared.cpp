@@ -121,6 +121,7 @@ namespace eka2l1::drivers {
             }
 
             output_stream_->set_volume(static_cast<float>(volume_) / 10.0f);
+            output_stream_->set_balance(static_cast<float>(balance_) / 100.0f);
         }
 
         return output_stream_->start();
@@ -191,6 +192,20 @@ namespace eka2l1::drivers {
         return res;
     }
 
+    bool player_shared::set_balance(const std::int32_t balance) {
+        if (!player::set_balance(balance)) {
+            return false;
+        }
+
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (output_stream_) {
+            output_stream_->set_balance(static_cast<float>(balance_) / 100.0f);
+        }
+
+        return true;
+    }
+
     std::uint32_t player_shared::get_dest_freq() {
         return freq_;
     }
@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/audio/audio.h>
+#include <drivers/audio/mixer.h>
+
+#include <common/algorithm.h>
+#include <common/log.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace eka2l1::drivers {
+    static constexpr std::uint8_t MIXER_CHANNEL_COUNT = 2;
+    static constexpr std::uint32_t MIXER_FALLBACK_SAMPLE_RATE = 48000;
+
+    mixer_output_stream::mixer_output_stream(audio_driver *driver, audio_mixer *mixer, const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback)
+        : audio_output_stream(driver, sample_rate, channels)
+        , mixer_(mixer)
+        , callback_(callback)
+        , playing_(false)
+        , pausing_(false)
+        , drained_(false)
+        , volume_(1.0f)
+        , balance_(0.0f)
+        , frames_consumed_(0)
+        , source_frame_count_(0)
+        , source_pos_(0.0) {
+        mixer_->attach(this);
+    }
+
+    mixer_output_stream::~mixer_output_stream() {
+        mixer_->detach(this);
+    }
+
+    bool mixer_output_stream::pull_source(const std::size_t frames_wanted) {
+        const std::size_t total_samples = (source_frame_count_ + frames_wanted) * channels;
+
+        // Only grows when the host asks for a bigger period than before
+        if (source_.size() < total_samples) {
+            source_.resize(total_samples);
+        }
+
+        const std::size_t frames_got = common::min<std::size_t>(frames_wanted,
+            callback_(source_.data() + source_frame_count_ * channels, frames_wanted));
+
+        source_frame_count_ += frames_got;
+        frames_consumed_ += frames_got;
+
+        return (frames_got == frames_wanted);
+    }
+
+    bool mixer_output_stream::mix_into(std::int32_t *dest, const std::size_t frames, const std::uint32_t dest_rate,
+        const std::uint8_t dest_channels) {
+        const float volume = volume_.load();
+        const float balance = balance_.load();
+
+        float gains[2] = { volume, volume };
+
+        if (dest_channels == 2) {
+            gains[0] = volume * common::min(1.0f, 1.0f - balance);
+            gains[1] = volume * common::min(1.0f, 1.0f + balance);
+        }
+
+        const double step = static_cast<double>(sample_rate) / static_cast<double>(dest_rate);
+        bool complete = true;
+
+        for (std::size_t i = 0; i < frames; i++) {
+            std::size_t base = static_cast<std::size_t>(source_pos_);
+
+            // Linear interpolation needs the frame after the current one too
+            if (base + 1 >= source_frame_count_) {
+                const std::size_t wanted = static_cast<std::size_t>(std::ceil(static_cast<double>(frames - i) * step)) + 1;
+
+                if (!pull_source(wanted)) {
+                    complete = false;
+                }
+
+                if (base + 1 >= source_frame_count_) {
+                    break;
+                }
+            }
+
+            const float t = static_cast<float>(source_pos_ - static_cast<double>(base));
+            const std::int16_t *current = source_.data() + base * channels;
+            const std::int16_t *next = current + channels;
+
+            for (std::uint8_t c = 0; c < dest_channels; c++) {
+                float sample = 0.0f;
+
+                if (channels == dest_channels) {
+                    sample = current[c] + (next[c] - current[c]) * t;
+                } else if (channels == 1) {
+                    sample = current[0] + (next[0] - current[0]) * t;
+                } else {
+                    // Downmix by averaging every source channel
+                    for (std::uint8_t sc = 0; sc < channels; sc++) {
+                        sample += current[sc] + (next[sc] - current[sc]) * t;
+                    }
+
+                    sample /= static_cast<float>(channels);
+                }
+
+                dest[i * dest_channels + c] += static_cast<std::int32_t>(sample * gains[common::min<std::uint8_t>(c, 1)]);
+            }
+
+            source_pos_ += step;
+        }
+
+        // Discard frames that the resampler has passed
+        const std::size_t consumed = common::min<std::size_t>(static_cast<std::size_t>(source_pos_), source_frame_count_);
+
+        if (consumed != 0) {
+            std::memmove(source_.data(), source_.data() + consumed * channels, (source_frame_count_ - consumed) * channels * sizeof(std::int16_t));
+
+            source_frame_count_ -= consumed;
+            source_pos_ -= static_cast<double>(consumed);
+        }
+
+        return complete;
+    }
+
+    bool mixer_output_stream::start() {
+        drained_ = false;
+
+        if (pausing_) {
+            pausing_ = false;
+            return true;
+        }
+
+        if (playing_) {
+            return true;
+        }
+
+        playing_ = true;
+        mixer_->stream_started();
+
+        return true;
+    }
+
+    bool mixer_output_stream::stop() {
+        pausing_ = false;
+        playing_ = false;
+
+        return true;
+    }
+
+    void mixer_output_stream::pause() {
+        pausing_ = true;
+    }
+
+    bool mixer_output_stream::is_playing() {
+        return playing_ && !drained_;
+    }
+
+    bool mixer_output_stream::is_pausing() {
+        return pausing_;
+    }
+
+    bool mixer_output_stream::set_volume(const float volume) {
+        // Master volume is applied on the host stream
+        volume_ = volume;
+        return true;
+    }
+
+    float mixer_output_stream::get_volume() const {
+        return volume_;
+    }
+
+    bool mixer_output_stream::set_balance(const float balance) {
+        if ((balance < -1.0f) || (balance > 1.0f)) {
+            return false;
+        }
+
+        balance_ = balance;
+        return true;
+    }
+
+    float mixer_output_stream::get_balance() const {
+        return balance_;
+    }
+
+    bool mixer_output_stream::current_frame_position(std::uint64_t *pos) {
+        *pos = frames_consumed_.load();
+        return true;
+    }
+
+    audio_mixer::audio_mixer(audio_driver *driver, const std::uint32_t sample_rate)
+        : driver_(driver)
+        , sample_rate_(sample_rate ? sample_rate : MIXER_FALLBACK_SAMPLE_RATE)
+        , channels_(MIXER_CHANNEL_COUNT)
+        , mixing_(false)
+        , host_started_(false)
+        , mix_time_us_(0)
+        , mixed_frames_(0)
+        , mix_calls_(0)
+        , underruns_(0) {
+        host_stream_ = driver_->new_host_output_stream(sample_rate_, channels_, [this](std::int16_t *buffer, const std::size_t frames) {
+            return mix(buffer, frames);
+        });
+
+        if (!host_stream_) {
+            LOG_ERROR(DRIVER_AUD, "Unable to open host stream for the audio mixer!");
+            return;
+        }
+
+        host_stream_->set_volume(1.0f);
+    }
+
+    audio_mixer::~audio_mixer() {
+        // Destroying the host stream detaches it from the backend, so no mix pass can still be running when
+        // the mix state below goes away.
+        if (host_stream_) {
+            host_stream_->stop();
+            host_stream_.reset();
+        }
+    }
+
+    std::unique_ptr<audio_output_stream> audio_mixer::new_stream(const std::uint32_t sample_rate, const std::uint8_t channels,
+        data_callback callback) {
+        if (!host_stream_ || (sample_rate == 0) || (channels == 0)) {
+            return nullptr;
+        }
+
+        return std::make_unique<mixer_output_stream>(driver_, this, sample_rate, channels, callback);
+    }
+
+    void audio_mixer::attach(mixer_output_stream *stream) {
+        const std::lock_guard<std::mutex> guard(lock_);
+        streams_.push_back(stream);
+    }
+
+    void audio_mixer::detach(mixer_output_stream *stream) {
+        std::unique_lock<std::mutex> guard(lock_);
+        streams_.erase(std::remove(streams_.begin(), streams_.end(), stream), streams_.end());
+
+        if (!mixing_) {
+            return;
+        }
+
+        if (mixing_thread_ == std::this_thread::get_id()) {
+            // Detached from a guest callback during the mix pass. Skip the stream for the rest of the pass.
+            std::replace(mixing_streams_.begin(), mixing_streams_.end(), stream, static_cast<mixer_output_stream *>(nullptr));
+            return;
+        }
+
+        // The stream is about to be destroyed, it must not be in use by the mix pass
+        mix_done_.wait(guard, [this]() { return !mixing_; });
+    }
+
+    void audio_mixer::stream_started() {
+        // The host stream is kept running once started. It outputs silence when nothing plays, which is cheaper
+        // than paying the host stream start latency each time a sound effect plays.
+        bool expected = false;
+
+        if (host_started_.compare_exchange_strong(expected, true)) {
+            if (!host_stream_->start()) {
+                LOG_ERROR(DRIVER_AUD, "Unable to start the audio mixer's host stream!");
+                host_started_ = false;
+            }
+        }
+    }
+
+    std::size_t audio_mixer::mix(std::int16_t *output, const std::size_t frames) {
+        const auto mix_start = std::chrono::steady_clock::now();
+        const std::size_t sample_count = frames * channels_;
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            mixing_streams_.assign(streams_.begin(), streams_.end());
+            mixing_thread_ = std::this_thread::get_id();
+            mixing_ = true;
+        }
+
+        if (mix_buffer_.size() < sample_count) {
+            mix_buffer_.resize(sample_count);
+        }
+
+        std::fill(mix_buffer_.begin(), mix_buffer_.begin() + sample_count, 0);
+
+        for (std::size_t i = 0; i < mixing_streams_.size(); i++) {
+            mixer_output_stream *stream = mixing_streams_[i];
+
+            if (!stream || !stream->playing_ || stream->pausing_ || stream->drained_) {
+                continue;
+            }
+
+            if (!stream->mix_into(mix_buffer_.data(), frames, sample_rate_, channels_)) {
+                // Like a host stream, a short read from the callback means that the stream is drained
+                stream->drained_ = true;
+                underruns_++;
+            }
+        }
+
+        for (std::size_t i = 0; i < sample_count; i++) {
+            output[i] = static_cast<std::int16_t>(common::clamp<std::int32_t>(-32768, 32767, mix_buffer_[i]));
+        }
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            mixing_streams_.clear();
+            mixing_ = false;
+        }
+
+        mix_done_.notify_all();
+
+        mix_calls_++;
+        mixed_frames_ += frames;
+        mix_time_us_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - mix_start).count();
+
+        return frames;
+    }
+
+    audio_mixer_stats audio_mixer::get_stats() {
+        audio_mixer_stats stats;
+
+        stats.mix_time_us_ = mix_time_us_.load();
+        stats.mixed_frames_ = mixed_frames_.load();
+        stats.mix_calls_ = mix_calls_.load();
+        stats.underruns_ = underruns_.load();
+
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        stats.stream_count_ = static_cast<std::uint32_t>(streams_.size());
+        stats.active_stream_count_ = static_cast<std::uint32_t>(std::count_if(streams_.begin(), streams_.end(),
+            [](mixer_output_stream *stream) {
+                return stream->playing_ && !stream->pausing_ && !stream->drained_;
+            }));
+
+        return stats;
+    }
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/command_queue.h>
+
+#include <common/sync.h>
+
+#include <chrono>
+
+namespace eka2l1::drivers {
+    command_list_queue::command_list_queue(const std::size_t capacity)
+        : ring_(capacity)
+        , push_seq_(0)
+        , pop_seq_(0)
+        , consumer_waiting_(0)
+        , producer_waiting_(0)
+        , aborted_(false)
+        , submitted_lists_(0)
+        , max_depth_(0)
+        , depth_sum_(0)
+        , producer_stalls_(0)
+        , producer_stall_us_(0)
+        , consumer_waits_(0)
+        , consumer_busy_us_(0)
+        , has_popped_(false) {
+    }
+
+    bool command_list_queue::push(const command_list &list) {
+        const std::lock_guard<std::mutex> guard(producer_lock_);
+
+        if (aborted_) {
+            return false;
+        }
+
+        if (!ring_.try_push(list)) {
+            const auto stall_start = std::chrono::steady_clock::now();
+            producer_stalls_++;
+
+            while (true) {
+                // Announce the wait before checking the ring again, so that the consumer can not miss us
+                producer_waiting_.store(1);
+                const std::uint32_t seq = pop_seq_.load();
+
+                if (ring_.try_push(list)) {
+                    break;
+                }
+
+                if (aborted_) {
+                    producer_waiting_.store(0);
+                    return false;
+                }
+
+                common::futex_wait(pop_seq_, seq);
+            }
+
+            producer_waiting_.store(0);
+            producer_stall_us_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - stall_start).count();
+        }
+
+        push_seq_.fetch_add(1);
+
+        if (consumer_waiting_.load()) {
+            common::futex_wake(push_seq_);
+        }
+
+        const std::uint64_t depth = ring_.size();
+
+        submitted_lists_++;
+        depth_sum_ += depth;
+
+        if (depth > max_depth_.load(std::memory_order_relaxed)) {
+            max_depth_.store(depth, std::memory_order_relaxed);
+        }
+
+        return true;
+    }
+
+    void command_list_queue::mark_popped() {
+        last_pop_time_ = std::chrono::steady_clock::now();
+        has_popped_ = true;
+    }
+
+    void command_list_queue::notify_popped() {
+        pop_seq_.fetch_add(1);
+
+        if (producer_waiting_.load()) {
+            common::futex_wake(pop_seq_);
+        }
+    }
+
+    bool command_list_queue::pop(command_list &list) {
+        if (has_popped_) {
+            // The driver comes back for a new list once it is done with the previous one
+            consumer_busy_us_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - last_pop_time_).count();
+            has_popped_ = false;
+        }
+
+        while (true) {
+            if (ring_.try_pop(list)) {
+                notify_popped();
+                mark_popped();
+
+                return true;
+            }
+
+            if (aborted_) {
+                return false;
+            }
+
+            consumer_waiting_.store(1);
+            const std::uint32_t seq = push_seq_.load();
+
+            if (ring_.try_pop(list)) {
+                consumer_waiting_.store(0);
+                notify_popped();
+                mark_popped();
+
+                return true;
+            }
+
+            if (aborted_) {
+                consumer_waiting_.store(0);
+                return false;
+            }
+
+            consumer_waits_++;
+            common::futex_wait(push_seq_, seq);
+
+            consumer_waiting_.store(0);
+        }
+    }
+
+    void command_list_queue::abort() {
+        aborted_ = true;
+
+        push_seq_.fetch_add(1);
+        pop_seq_.fetch_add(1);
+
+        common::futex_wake(push_seq_, true);
+        common::futex_wake(pop_seq_, true);
+    }
+
+    void command_list_queue::drain(std::function<void(command_list &)> callback) {
+        // Producers check the abort flag under this lock, so nothing can be queued after this
+        const std::lock_guard<std::mutex> guard(producer_lock_);
+        command_list list;
+
+        while (ring_.try_pop(list)) {
+            callback(list);
+        }
+    }
+
+    command_queue_stats command_list_queue::get_stats() const {
+        command_queue_stats stats;
+
+        stats.submitted_lists_ = submitted_lists_.load();
+        stats.max_depth_ = max_depth_.load();
+        stats.depth_sum_ = depth_sum_.load();
+        stats.producer_stalls_ = producer_stalls_.load();
+        stats.producer_stall_us_ = producer_stall_us_.load();
+        stats.consumer_waits_ = consumer_waits_.load();
+        stats.consumer_busy_us_ = consumer_busy_us_.load();
+
+        return stats;
+    }
+}
@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/driver.h>
+
+#include <common/sync.h>
+
+#include <algorithm>
+
+namespace eka2l1::drivers {
+    void command_fence::reset() {
+        result_ = 0;
+        signalled_.store(0, std::memory_order_relaxed);
+    }
+
+    void command_fence::signal(const int result) {
+        result_ = result;
+        signalled_.store(1, std::memory_order_release);
+
+        common::futex_wake(signalled_, true);
+    }
+
+    int command_fence::wait() {
+        while (signalled_.load(std::memory_order_acquire) == 0) {
+            common::futex_wait(signalled_, 0);
+        }
+
+        return result_;
+    }
+
+    static constexpr std::size_t PAYLOAD_BLOCK_SIZE = 64 * 1024;
+    static constexpr std::size_t PAYLOAD_ALIGNMENT = 16;
+    static constexpr std::size_t PAYLOAD_RETAIN_LIMIT = 1024 * 1024;
+    static constexpr std::size_t MAX_POOLED_LIST_COUNT = 16;
+
+    command_payload_arena::command_payload_arena()
+        : current_(0)
+        , offset_(0)
+        , bytes_copied_(0)
+        , allocation_count_(0)
+        , heap_allocation_count_(0) {
+    }
+
+    command_payload_arena::~command_payload_arena() {
+        reset();
+    }
+
+    std::uint8_t *command_payload_arena::allocate(const std::size_t size) {
+        if (size == 0) {
+            return nullptr;
+        }
+
+        const std::size_t aligned_size = (size + PAYLOAD_ALIGNMENT - 1) & ~(PAYLOAD_ALIGNMENT - 1);
+
+        bytes_copied_ += size;
+        allocation_count_++;
+
+        while (current_ < blocks_.size()) {
+            block &target = blocks_[current_];
+
+            if (offset_ + aligned_size <= target.size_) {
+                std::uint8_t *result = target.data_.get() + offset_;
+                offset_ += aligned_size;
+
+                return result;
+            }
+
+            current_++;
+            offset_ = 0;
+        }
+
+        // Big uploads get a block of their own, which is not kept after reset
+        block new_block;
+        new_block.size_ = std::max<std::size_t>(PAYLOAD_BLOCK_SIZE, aligned_size);
+        new_block.data_ = std::make_unique<std::uint8_t[]>(new_block.size_);
+
+        heap_allocation_count_++;
+
+        blocks_.push_back(std::move(new_block));
+
+        current_ = blocks_.size() - 1;
+        offset_ = aligned_size;
+
+        return blocks_.back().data_.get();
+    }
+
+    void command_payload_arena::adopt(std::uint8_t *buffer) {
+        if (buffer) {
+            adopted_.push_back(buffer);
+        }
+    }
+
+    void command_payload_arena::absorb(command_payload_arena &another) {
+        for (block &another_block : another.blocks_) {
+            absorbed_.push_back(std::move(another_block));
+        }
+
+        for (block &another_block : another.absorbed_) {
+            absorbed_.push_back(std::move(another_block));
+        }
+
+        adopted_.insert(adopted_.end(), another.adopted_.begin(), another.adopted_.end());
+
+        bytes_copied_ += another.bytes_copied_;
+        allocation_count_ += another.allocation_count_;
+        heap_allocation_count_ += another.heap_allocation_count_;
+
+        another.blocks_.clear();
+        another.absorbed_.clear();
+        another.adopted_.clear();
+        another.current_ = 0;
+        another.offset_ = 0;
+        another.bytes_copied_ = 0;
+        another.allocation_count_ = 0;
+        another.heap_allocation_count_ = 0;
+    }
+
+    void command_payload_arena::reset() {
+        for (std::uint8_t *buffer : adopted_) {
+            delete[] buffer;
+        }
+
+        adopted_.clear();
+        absorbed_.clear();
+
+        std::size_t retained_size = 0;
+
+        blocks_.erase(std::remove_if(blocks_.begin(), blocks_.end(), [&](const block &target) {
+            if ((target.size_ != PAYLOAD_BLOCK_SIZE) || (retained_size + target.size_ > PAYLOAD_RETAIN_LIMIT)) {
+                return true;
+            }
+
+            retained_size += target.size_;
+            return false;
+        }), blocks_.end());
+
+        current_ = 0;
+        offset_ = 0;
+        bytes_copied_ = 0;
+        allocation_count_ = 0;
+        heap_allocation_count_ = 0;
+    }
+
+    void command_list::renew() {
+        if (max_cap_ == 0) {
+            return;
+        }
+
+        get_command_list_pool().acquire(*this);
+    }
+
+    void command_list::recycle() {
+        get_command_list_pool().release(*this);
+    }
+
+    void command_list::abandon() {
+        for (std::size_t i = 0; i < size_; i++) {
+            if (base_[i].status_) {
+                base_[i].status_->signal(-1);
+            }
+        }
+
+        recycle();
+    }
+
+    std::uint8_t *command_list::allocate_payload(const std::size_t size) {
+        if (!base_) {
+            renew();
+        }
+
+        return payload_ ? payload_->allocate(size) : nullptr;
+    }
+
+    void command_list::adopt_payload(std::uint8_t *buffer) {
+        if (!base_) {
+            renew();
+        }
+
+        if (payload_) {
+            payload_->adopt(buffer);
+        } else {
+            delete[] buffer;
+        }
+    }
+
+    static void add_stats(command_list_stats &dest, const command_list_stats &source) {
+        dest.lists_ += source.lists_;
+        dest.commands_ += source.commands_;
+        dest.payload_bytes_ += source.payload_bytes_;
+        dest.payload_allocations_ += source.payload_allocations_;
+        dest.heap_allocations_ += source.heap_allocations_;
+        dest.recycled_lists_ += source.recycled_lists_;
+    }
+
+    command_list_pool::command_list_pool()
+        : current_()
+        , last_frame_()
+        , total_() {
+    }
+
+    command_list_pool::~command_list_pool() {
+        for (entry &pooled : free_) {
+            delete[] pooled.base_;
+            delete pooled.payload_;
+        }
+    }
+
+    void command_list_pool::acquire(command_list &list) {
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            for (std::size_t i = free_.size(); i > 0; i--) {
+                if (free_[i - 1].max_cap_ == list.max_cap_) {
+                    list.base_ = free_[i - 1].base_;
+                    list.payload_ = free_[i - 1].payload_;
+                    list.size_ = 0;
+
+                    free_.erase(free_.begin() + (i - 1));
+                    current_.recycled_lists_++;
+
+                    return;
+                }
+            }
+
+            current_.heap_allocations_++;
+        }
+
+        list.base_ = new command[list.max_cap_];
+        list.payload_ = new command_payload_arena;
+        list.size_ = 0;
+    }
+
+    void command_list_pool::release(command_list &list) {
+        if (!list.base_) {
+            return;
+        }
+
+        command_list_stats executed{};
+        executed.lists_ = 1;
+        executed.commands_ = list.size_;
+
+        if (list.payload_) {
+            executed.payload_bytes_ = list.payload_->bytes_copied_;
+            executed.payload_allocations_ = list.payload_->allocation_count_;
+            executed.heap_allocations_ = list.payload_->heap_allocation_count_;
+
+            list.payload_->reset();
+        }
+
+        entry to_free{ list.base_, list.payload_, list.max_cap_ };
+
+        list.base_ = nullptr;
+        list.payload_ = nullptr;
+        list.size_ = 0;
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            add_stats(current_, executed);
+
+            if (to_free.payload_ && (free_.size() < MAX_POOLED_LIST_COUNT)) {
+                free_.push_back(to_free);
+                return;
+            }
+        }
+
+        delete[] to_free.base_;
+        delete to_free.payload_;
+    }
+
+    void command_list_pool::end_frame() {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        last_frame_ = current_;
+        add_stats(total_, current_);
+
+        current_ = command_list_stats{};
+    }
+
+    command_list_stats command_list_pool::last_frame_stats() {
+        const std::lock_guard<std::mutex> guard(lock_);
+        return last_frame_;
+    }
+
+    command_list_stats command_list_pool::total_stats() {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        command_list_stats result = total_;
+        add_stats(result, current_);
+
+        return result;
+    }
+
+    command_list_pool &get_command_list_pool() {
+        static command_list_pool pool;
+        return pool;
+    }
+}
@@ -175,32 +175,41 @@ namespace eka2l1::drivers {
             return nullptr;
         }
 
-        if ((h & ~HANDLE_BITMAP) > bmp_textures.size()) {
+        if (((h & ~HANDLE_BITMAP) == 0) || ((h & ~HANDLE_BITMAP) > bmp_textures.size())) {
             return nullptr;
         }
 
         return bmp_textures[(h & ~HANDLE_BITMAP) - 1].get();
     }
 
-    drivers::handle shared_graphics_driver::append_graphics_object(graphics_object_instance &instance) {
-        auto free_slot = std::find(graphic_objects.begin(), graphic_objects.end(), nullptr);
+    void shared_graphics_driver::attach_graphics_object(const drivers::handle h, graphics_object_instance &instance) {
+        if (h == 0) {
+            return;
+        }
 
-        if (free_slot != graphic_objects.end()) {
-            *free_slot = std::move(instance);
-            return std::distance(graphic_objects.begin(), free_slot) + 1;
+        // Handles are reserved by the clients, so the slot may be past the end
+        if (h > graphic_objects.size()) {
+            graphic_objects.resize(h);
         }
 
-        graphic_objects.push_back(std::move(instance));
-        return graphic_objects.size();
+        graphic_objects[h - 1] = std::move(instance);
     }
 
     bool shared_graphics_driver::delete_graphics_object(const drivers::handle handle) {
-        if (handle > graphic_objects.size() || handle == 0) {
-            return 0;
+        if (handle == 0) {
+            return false;
+        }
+
+        bool existed = false;
+
+        if ((handle <= graphic_objects.size()) && graphic_objects[handle - 1]) {
+            graphic_objects[handle - 1].reset();
+            existed = true;
         }
 
-        graphic_objects[handle - 1].reset();
-        return true;
+        // The handle of an object that failed to be created has no object, but is still reserved
+        free_handle(handle);
+        return existed;
     }
 
     graphics_object *shared_graphics_driver::get_graphics_object(const drivers::handle num) {
@@ -284,8 +293,6 @@ namespace eka2l1::drivers {
         unpack_u64_to_2u32(cmd.data_[4], dim.x, dim.y);
 
         update_bitmap(handle, size, offset, dim, data, pixels_per_line);
-
-        delete[] data;
     }
 
     void shared_graphics_driver::update_texture(command &cmd) {
@@ -310,29 +317,29 @@ namespace eka2l1::drivers {
         }
 
         obj->update_data(this, static_cast<int>(lvl), offset, dim, pixels_per_line, data_format, data_type, data, size, unpack_alignment);
-
-        delete[] data;
     }
 
     void shared_graphics_driver::create_bitmap(command &cmd) {
         eka2l1::vec2 size;
         std::uint32_t bpp = static_cast<std::uint32_t>(cmd.data_[1]);
-        drivers::handle *result = reinterpret_cast<drivers::handle*>(cmd.data_[2]);
+        drivers::handle h = static_cast<drivers::handle>(cmd.data_[2]);
 
         unpack_u64_to_2u32(cmd.data_[0], size.x, size.y);
 
-        // Find free slot
-        auto slot_free = std::find(bmp_textures.begin(), bmp_textures.end(), nullptr);
+        const std::size_t index = static_cast<std::size_t>(h & ~HANDLE_BITMAP);
 
-        if (slot_free != bmp_textures.end()) {
-            *slot_free = std::make_unique<bitmap>(this, size, static_cast<int>(bpp));
-            *result = std::distance(bmp_textures.begin(), slot_free) + 1;
-        } else {
-            bmp_textures.push_back(std::make_unique<bitmap>(this, size, static_cast<int>(bpp)));
-            *result = bmp_textures.size();
+        if (((h & HANDLE_BITMAP) == 0) || (index == 0)) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Invalid reserved bitmap handle {}", h);
+            finish(cmd.status_, -1);
+
+            return;
         }
 
-        *result |= HANDLE_BITMAP;
+        if (index > bmp_textures.size()) {
+            bmp_textures.resize(index);
+        }
+
+        bmp_textures[index - 1] = std::make_unique<bitmap>(this, size, static_cast<int>(bpp));
 
         // Notify
         finish(cmd.status_, 0);
@@ -458,12 +465,14 @@ namespace eka2l1::drivers {
     void shared_graphics_driver::destroy_bitmap(command &cmd) {
         drivers::handle h = cmd.data_[0];
 
-        if ((h & ~HANDLE_BITMAP) > bmp_textures.size()) {
-            LOG_ERROR(DRIVER_GRAPHICS, "Invalid bitmap handle to destroy");
-            return;
+        if (get_bitmap(h)) {
+            bmp_textures[(h & ~HANDLE_BITMAP) - 1].reset();
         }
 
-        bmp_textures[(h & ~HANDLE_BITMAP) - 1].reset();
+        // A bitmap that failed to be created has no object, but its handle is still reserved
+        if (!free_handle(h)) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Invalid bitmap handle to destroy");
+        }
     }
 
     void shared_graphics_driver::resize_bitmap(command &cmd) {
@@ -500,15 +509,12 @@ namespace eka2l1::drivers {
         auto obj = make_shader_module(this);
         if (!obj->create(this, data, data_size, mod_type, compile_log)) {
             LOG_ERROR(DRIVER_GRAPHICS, "Fail to create shader module!");
-            finish(cmd.status_, -1);
+            fail_creation(cmd);
             return;
         }
 
         std::unique_ptr<graphics_object> obj_casted = std::move(obj);
-        drivers::handle res = append_graphics_object(obj_casted);
-
-        drivers::handle *store = reinterpret_cast<drivers::handle*>(cmd.data_[3]);
-        *store = res;
+        attach_graphics_object(static_cast<drivers::handle>(cmd.data_[3]), obj_casted);
 
         finish(cmd.status_, 0);
     }
@@ -526,7 +532,7 @@ namespace eka2l1::drivers {
 
         if (!obj->create(this, vert_module_obj, frag_module_obj, link_log)) {
             LOG_ERROR(DRIVER_GRAPHICS, "Fail to create shader program!");
-            finish(cmd.status_, -1);
+            fail_creation(cmd);
             return;
         }
 
@@ -535,11 +541,8 @@ namespace eka2l1::drivers {
         }
 
         std::unique_ptr<graphics_object> obj_casted = std::move(obj);
-        drivers::handle res = append_graphics_object(obj_casted);
+        attach_graphics_object(static_cast<drivers::handle>(cmd.data_[3]), obj_casted);
 
-        drivers::handle *store = reinterpret_cast<drivers::handle*>(cmd.data_[3]);
-
-        *store = res;
         finish(cmd.status_, 0);
     }
 
@@ -569,6 +572,8 @@ namespace eka2l1::drivers {
             obj = reinterpret_cast<drivers::texture*>(get_graphics_object(h));
             if (!obj) {
                 LOG_ERROR(DRIVER_GRAPHICS, "Texture object with handle {} does not exist!", h);
+                fail_creation(cmd);
+
                 return;
             }
         } else {
@@ -576,20 +581,17 @@ namespace eka2l1::drivers {
             obj = obj_inst.get();
         }
 
-        obj->create(this, static_cast<int>(dim), static_cast<int>(mip_level), eka2l1::vec3(width, height, depth),
-            internal_format, data_format, data_type, data, data_size, pixels_per_line, alignment);
+        if (!obj->create(this, static_cast<int>(dim), static_cast<int>(mip_level), eka2l1::vec3(width, height, depth),
+                internal_format, data_format, data_type, data, data_size, pixels_per_line, alignment)) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Fail to create texture!");
+            fail_creation(cmd);
+
+            return;
+        }
 
         if (obj_inst) {
             std::unique_ptr<graphics_object> obj_casted = std::move(obj_inst);
-            drivers::handle res = append_graphics_object(obj_casted);
-
-            drivers::handle *store = reinterpret_cast<drivers::handle*>(cmd.data_[8]);
-            *store = res;
-        } else {
-            if (data != nullptr) {
-                std::uint8_t *data_org = reinterpret_cast<std::uint8_t*>(data);
-                delete[] data_org;
-            }
+            attach_graphics_object(static_cast<drivers::handle>(cmd.data_[8]), obj_casted);
         }
 
         finish(cmd.status_, 0);
@@ -607,6 +609,7 @@ namespace eka2l1::drivers {
         if (existing_handle != 0) {
             obj = reinterpret_cast<drivers::buffer*>(get_graphics_object(existing_handle));
             if (!obj) {
+                fail_creation(cmd);
                 return;
             }
         } else {    
@@ -614,19 +617,18 @@ namespace eka2l1::drivers {
             obj = obj_inst.get();
         }
 
-        obj->create(this, initial_data, initial_size, upload_hint);
+        if (!obj->create(this, initial_data, initial_size, upload_hint)) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Fail to create buffer!");
+            fail_creation(cmd);
+
+            return;
+        }
 
         if (obj_inst) {
             std::unique_ptr<graphics_object> obj_casted = std::move(obj_inst);
-            drivers::handle res = append_graphics_object(obj_casted);
-
-            drivers::handle *store = reinterpret_cast<drivers::handle*>(cmd.data_[4]);
-            *store = res;
+            attach_graphics_object(static_cast<drivers::handle>(cmd.data_[4]), obj_casted);
 
             finish(cmd.status_, 0);
-        } else if ((initial_data != nullptr) && (existing_handle)) {
-            std::uint8_t *data_casted = reinterpret_cast<std::uint8_t*>(initial_data);
-            delete[] data_casted;
         }
     }
 
@@ -641,6 +643,7 @@ namespace eka2l1::drivers {
         if (existing_handle != 0) {
             obj = reinterpret_cast<drivers::input_descriptors*>(get_graphics_object(existing_handle));
             if (!obj) {
+                fail_creation(cmd);
                 return;
             }
         } else {
@@ -648,19 +651,18 @@ namespace eka2l1::drivers {
             obj = obj_inst.get();
         }
 
-        obj->modify(this, descs, count);
+        if (!obj->modify(this, descs, count)) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Fail to create input descriptors!");
+            fail_creation(cmd);
+
+            return;
+        }
 
         if (obj_inst) {
             std::unique_ptr<graphics_object> obj_casted = std::move(obj_inst);
-            drivers::handle res = append_graphics_object(obj_casted);
-
-            drivers::handle *store = reinterpret_cast<drivers::handle*>(cmd.data_[3]);
-            *store = res;
+            attach_graphics_object(static_cast<drivers::handle>(cmd.data_[3]), obj_casted);
 
             finish(cmd.status_, 0);
-        } else if ((descs != nullptr) && (existing_handle)) {
-            std::uint8_t *data_casted = reinterpret_cast<std::uint8_t*>(descs);
-            delete[] data_casted;
         }
     }
 
@@ -678,6 +680,7 @@ namespace eka2l1::drivers {
         if (existing_handle != 0) {
             obj = reinterpret_cast<drivers::renderbuffer*>(get_graphics_object(existing_handle));
             if (!obj) {
+                fail_creation(cmd);
                 return;
             }
         } else {    
@@ -685,14 +688,16 @@ namespace eka2l1::drivers {
             obj = obj_inst.get();
         }
 
-        obj->create(this, size, internal_format);
+        if (!obj->create(this, size, internal_format)) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Fail to create renderbuffer!");
+            fail_creation(cmd);
+
+            return;
+        }
         
         if (obj_inst) {
             std::unique_ptr<graphics_object> obj_casted = std::move(obj_inst);
-            drivers::handle res = append_graphics_object(obj_casted);
-
-            drivers::handle *store = reinterpret_cast<drivers::handle*>(cmd.data_[3]);
-            *store = res;
+            attach_graphics_object(static_cast<drivers::handle>(cmd.data_[3]), obj_casted);
 
             finish(cmd.status_, 0);
         }
@@ -716,6 +721,7 @@ namespace eka2l1::drivers {
         for (std::uint32_t i = 0; i < color_buffer_count; i++) {
             temp = reinterpret_cast<drawable*>(get_graphics_object(color_buffers[i]));
             if (!temp) {
+                fail_creation(cmd);
                 return;
             }
 
@@ -729,6 +735,7 @@ namespace eka2l1::drivers {
         if (depth_buffer) {
             depth_buffer_obj = reinterpret_cast<drawable*>(get_graphics_object(depth_buffer));
             if (!depth_buffer_obj) {
+                fail_creation(cmd);
                 return;
             }
         }
@@ -736,6 +743,7 @@ namespace eka2l1::drivers {
         if (stencil_buffer) {
             stencil_buffer_obj = reinterpret_cast<drawable*>(get_graphics_object(stencil_buffer));
             if (!stencil_buffer_obj) {
+                fail_creation(cmd);
                 return;
             }
         }
@@ -743,11 +751,13 @@ namespace eka2l1::drivers {
         framebuffer_ptr new_fb = make_framebuffer(this, color_buffer_objs, color_face_indicies_v, depth_buffer_obj,
             depth_face_index, stencil_buffer_obj, stencil_face_index);
 
-        std::unique_ptr<graphics_object> obj_casted = std::move(new_fb);
-        drivers::handle res = append_graphics_object(obj_casted);
+        if (!new_fb) {
+            fail_creation(cmd);
+            return;
+        }
 
-        drivers::handle *store = reinterpret_cast<drivers::handle*>(cmd.data_[6]);
-        *store = res;
+        std::unique_ptr<graphics_object> obj_casted = std::move(new_fb);
+        attach_graphics_object(static_cast<drivers::handle>(cmd.data_[6]), obj_casted);
 
         finish(cmd.status_, 0);
     }
@@ -828,8 +838,6 @@ namespace eka2l1::drivers {
         }
 
         bufobj->update_data(this, data, offset, size);
-
-        delete[] data;
     }
 
     void shared_graphics_driver::destroy_object(command &cmd) {
@@ -92,7 +92,6 @@ namespace eka2l1::drivers {
         }
 
         init_gl_graphics_library(context_->gl_mode());
-        list_queue.max_pending_count_ = 128;
 
         context_->set_swap_interval(1);
 
@@ -737,8 +736,6 @@ namespace eka2l1::drivers {
 
         unpack_to_two_floats(cmd.data_[2], scale, temp);
 
-        delete[] to_clip_rects;
-
         if (to_clip.empty()) {
             glDisable(GL_SCISSOR_TEST);
             glDisable(GL_STENCIL_TEST);
@@ -1307,8 +1304,6 @@ namespace eka2l1::drivers {
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicies.size() * sizeof(int), indicies.data(), GL_STATIC_DRAW);
 
         glDrawElements(GL_LINES, static_cast<GLsizei>(indicies.size()), GL_UNSIGNED_INT, 0);
-
-        delete[] point_list;
     }
 
     void ogl_graphics_driver::set_cull_face(command &cmd) {
@@ -1361,56 +1356,40 @@ namespace eka2l1::drivers {
         switch (var_type) {
         case shader_var_type::integer: {
             glUniform1iv(binding, static_cast<GLsizei>((cmd.data_[2] + 3) / 4), reinterpret_cast<const GLint *>(data));
-            delete[] data;
-
             return;
         }
 
         case shader_var_type::real:
             glUniform1fv(binding, static_cast<GLsizei>((cmd.data_[2] + 3) / 4), reinterpret_cast<const GLfloat*>(data));
-            delete[] data;
-
             return;
 
         case shader_var_type::mat2: {
             glUniformMatrix2fv(binding, static_cast<GLsizei>((cmd.data_[2] + 15) / 16), GL_FALSE, reinterpret_cast<const GLfloat *>(data));
-            delete[] data;
-
             return;
         }
 
         case shader_var_type::mat3: {
             glUniformMatrix2fv(binding, static_cast<GLsizei>((cmd.data_[2] + 35) / 36), GL_FALSE, reinterpret_cast<const GLfloat *>(data));
-            delete[] data;
-
             return;
         }
 
         case shader_var_type::mat4: {
             glUniformMatrix4fv(binding, static_cast<GLsizei>((cmd.data_[2] + 63) / 64), GL_FALSE, reinterpret_cast<const GLfloat *>(data));
-            delete[] data;
-
             return;
         }
 
         case shader_var_type::vec2: {
             glUniform2fv(binding, static_cast<GLsizei>((cmd.data_[2] + 7) / 8), reinterpret_cast<const GLfloat *>(data));
-            delete[] data;
-
             return;
         }
 
         case shader_var_type::vec3: {
             glUniform3fv(binding, static_cast<GLsizei>((cmd.data_[2] + 11) / 12), reinterpret_cast<const GLfloat *>(data));
-            delete[] data;
-
             return;
         }
 
         case shader_var_type::vec4: {
             glUniform4fv(binding, static_cast<GLsizei>((cmd.data_[2] + 15) / 16), reinterpret_cast<const GLfloat *>(data));
-            delete[] data;
-
             return;
         }
 
@@ -1439,7 +1418,6 @@ namespace eka2l1::drivers {
 
         if (starting_slots + count >= GL_BACKEND_MAX_VBO_SLOTS) {
             LOG_ERROR(DRIVER_GRAPHICS, "Slot to bind VBO exceed maximum (startSlot={}, count={})", starting_slots, count);
-            delete[] arr;
 
             return;
         }
@@ -1453,8 +1431,6 @@ namespace eka2l1::drivers {
 
             vbo_slots_[starting_slots + i] = bufobj->buffer_handle();
         }
-
-        delete[] arr;
     }
 
     void ogl_graphics_driver::bind_index_buffer(command &cmd) {
@@ -1680,18 +1656,19 @@ namespace eka2l1::drivers {
     }
 
     void ogl_graphics_driver::submit_command_list(command_list &list) {
-        if ((list.size_ == 0) || !list.base_ || should_stop) {
-            if (list.base_) {
-                delete[] list.base_;
-            }
-
+        if ((list.size_ == 0) || !list.base_) {
+            list.recycle();
             return;
         }
-        list_queue.push(list);
+
+        if (should_stop || !list_queue.push(list)) {
+            list.abandon();
+        }
     }
 
     void ogl_graphics_driver::display(command &cmd) {
         context_->swap_buffers();
+        get_command_list_pool().end_frame();
 
         disp_hook_();
         finish(cmd.status_, 0);
@@ -1867,35 +1844,33 @@ namespace eka2l1::drivers {
     }
 
     void ogl_graphics_driver::run() {
-        while (!should_stop) {
-            std::optional<command_list> list = list_queue.pop();
+        command_list list;
 
-            if (!list) {
-                LOG_ERROR(DRIVER_GRAPHICS, "Corrupted graphics command list! Emulation halt.");
+        while (!should_stop) {
+            if (!list_queue.pop(list)) {
                 break;
             }
 
-            for (std::size_t i = 0; i < list->size_; i++) {
-                dispatch(list->base_[i]);
+            for (std::size_t i = 0; i < list.size_; i++) {
+                dispatch(list.base_[i]);
             }
 
-            delete[] list->base_;
+            list.recycle();
         }
+
+        // Nobody must be left waiting on a list that will never be executed
+        list_queue.drain([](command_list &leftover) {
+            leftover.abandon();
+        });
     }
 
     void ogl_graphics_driver::abort() {
-        list_queue.abort();
         should_stop = true;
-
-        cond_.notify_all();
+        list_queue.abort();
     }
 
-    void ogl_graphics_driver::wait_for(int *status) {
-        if (should_stop) {
-            return;
-        }
-
-        driver::wait_for(status);
+    command_queue_stats ogl_graphics_driver::get_command_queue_stats() {
+        return list_queue.get_stats();
     }
 
     std::string ogl_graphics_driver::get_active_upscale_shader() const {
@@ -0,0 +1,1307 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/graphics/backend/software/graphics_software.h>
+
+#include <common/algorithm.h>
+#include <common/buffer.h>
+#include <common/fileutils.h>
+#include <common/log.h>
+#include <common/path.h>
+#include <common/platform.h>
+
+#include <fmt/format.h>
+#include <miniz.h>
+
+#include <cmath>
+#include <cstring>
+
+#if EKA2L1_ARCH(X64)
+#include <emmintrin.h>
+#elif EKA2L1_ARCH(ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace eka2l1::drivers {
+    static constexpr std::uint32_t SOFTWARE_MAX_PENDING_LIST = 128;
+
+    static inline std::uint32_t make_rgba(const std::uint32_t r, const std::uint32_t g, const std::uint32_t b, const std::uint32_t a) {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    static inline std::uint32_t channel(const std::uint32_t color, const int index) {
+        return (color >> (index * 8)) & 0xFF;
+    }
+
+    static inline std::uint32_t div_255(const std::uint32_t value) {
+        return (value + 128 + ((value + 128) >> 8)) >> 8;
+    }
+
+    static inline std::uint32_t float_to_channel(const float value) {
+        return static_cast<std::uint32_t>(common::clamp(0.0f, 1.0f, value) * 255.0f + 0.5f);
+    }
+
+    /**
+     * @brief Fill a span of pixels with a single color.
+     *
+     * Four pixels are written per store when the host has 128-bit vectors, which covers clears and
+     * opaque rectangles, the bulk of the window server's drawing.
+     */
+    static void fill_span(std::uint32_t *dest, std::size_t count, const std::uint32_t color) {
+#if EKA2L1_ARCH(X64)
+        const __m128i color_vec = _mm_set1_epi32(static_cast<int>(color));
+
+        for (; count >= 8; count -= 8, dest += 8) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), color_vec);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 4), color_vec);
+        }
+
+        for (; count >= 4; count -= 4, dest += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), color_vec);
+        }
+#elif EKA2L1_ARCH(ARM64)
+        const uint32x4_t color_vec = vdupq_n_u32(color);
+
+        for (; count >= 8; count -= 8, dest += 8) {
+            vst1q_u32(dest, color_vec);
+            vst1q_u32(dest + 4, color_vec);
+        }
+
+        for (; count >= 4; count -= 4, dest += 4) {
+            vst1q_u32(dest, color_vec);
+        }
+#endif
+
+        for (; count != 0; count--) {
+            *dest++ = color;
+        }
+    }
+
+    static std::uint32_t blend_factor_value(const blend_factor factor, const int index, const std::uint32_t src,
+        const std::uint32_t dest, const std::uint32_t constant) {
+        switch (factor) {
+        case blend_factor::one:
+            return 255;
+
+        case blend_factor::zero:
+            return 0;
+
+        case blend_factor::frag_out_alpha:
+            return channel(src, 3);
+
+        case blend_factor::one_minus_frag_out_alpha:
+            return 255 - channel(src, 3);
+
+        case blend_factor::current_alpha:
+            return channel(dest, 3);
+
+        case blend_factor::one_minus_current_alpha:
+            return 255 - channel(dest, 3);
+
+        case blend_factor::frag_out_color:
+            return channel(src, index);
+
+        case blend_factor::one_minus_frag_out_color:
+            return 255 - channel(src, index);
+
+        case blend_factor::current_color:
+            return channel(dest, index);
+
+        case blend_factor::one_minus_current_color:
+            return 255 - channel(dest, index);
+
+        case blend_factor::frag_out_alpha_saturate:
+            return (index == 3) ? 255 : common::min<std::uint32_t>(channel(src, 3), 255 - channel(dest, 3));
+
+        case blend_factor::constant_colour:
+            return channel(constant, index);
+
+        case blend_factor::one_minus_constant_colour:
+            return 255 - channel(constant, index);
+
+        case blend_factor::constant_alpha:
+            return channel(constant, 3);
+
+        case blend_factor::one_minus_constant_alpha:
+            return 255 - channel(constant, 3);
+
+        default:
+            break;
+        }
+
+        return 255;
+    }
+
+    static std::uint32_t blend_pixel(const software_blend_state &state, const std::uint32_t src, const std::uint32_t dest) {
+        std::uint32_t result = 0;
+
+        for (int i = 0; i < 4; i++) {
+            const bool is_alpha = (i == 3);
+
+            const std::int32_t src_term = static_cast<std::int32_t>(channel(src, i) * blend_factor_value(is_alpha ? state.a_frag_out_factor_ : state.rgb_frag_out_factor_, i, src, dest, state.constant_colour_));
+            const std::int32_t dest_term = static_cast<std::int32_t>(channel(dest, i) * blend_factor_value(is_alpha ? state.a_current_factor_ : state.rgb_current_factor_, i, src, dest, state.constant_colour_));
+
+            std::int32_t value = 0;
+
+            switch (is_alpha ? state.a_equation_ : state.rgb_equation_) {
+            case blend_equation::sub:
+                value = src_term - dest_term;
+                break;
+
+            case blend_equation::isub:
+                value = dest_term - src_term;
+                break;
+
+            default:
+                value = src_term + dest_term;
+                break;
+            }
+
+            result |= common::min<std::uint32_t>(255, div_255(static_cast<std::uint32_t>(common::max(0, value)))) << (i * 8);
+        }
+
+        return result;
+    }
+
+    static std::uint32_t modulate(const std::uint32_t color, const std::uint32_t factor) {
+        if (factor == 0xFFFFFFFF) {
+            return color;
+        }
+
+        return make_rgba(div_255(channel(color, 0) * channel(factor, 0)), div_255(channel(color, 1) * channel(factor, 1)),
+            div_255(channel(color, 2) * channel(factor, 2)), div_255(channel(color, 3) * channel(factor, 3)));
+    }
+
+    software_surface::software_surface(const eka2l1::vec2 &size, const int bpp)
+        : size_(0, 0)
+        , bpp_(bpp) {
+        resize(size, false);
+    }
+
+    void software_surface::resize(const eka2l1::vec2 &new_size, const bool keep_content) {
+        const eka2l1::vec2 clamped_size(common::max(0, new_size.x), common::max(0, new_size.y));
+
+        if (!keep_content || pixels_.empty() || (clamped_size.x == 0) || (clamped_size.y == 0)) {
+            size_ = clamped_size;
+            pixels_.assign(static_cast<std::size_t>(size_.x) * size_.y, 0);
+
+            return;
+        }
+
+        // Same as a framebuffer blit, the old content is stretched to the new size
+        std::vector<std::uint32_t> new_pixels(static_cast<std::size_t>(clamped_size.x) * clamped_size.y);
+
+        for (int y = 0; y < clamped_size.y; y++) {
+            const std::uint32_t *source_row = row(static_cast<int>(static_cast<std::int64_t>(y) * size_.y / clamped_size.y));
+            std::uint32_t *dest_row = new_pixels.data() + static_cast<std::size_t>(y) * clamped_size.x;
+
+            for (int x = 0; x < clamped_size.x; x++) {
+                dest_row[x] = source_row[static_cast<std::int64_t>(x) * size_.x / clamped_size.x];
+            }
+        }
+
+        size_ = clamped_size;
+        pixels_ = std::move(new_pixels);
+    }
+
+    bool write_rgba_png(const std::string &path, const std::uint32_t *pixels, const eka2l1::vec2 &size) {
+        if (!pixels || (size.x <= 0) || (size.y <= 0)) {
+            return false;
+        }
+
+        std::size_t png_size = 0;
+        void *png_data = tdefl_write_image_to_png_file_in_memory_ex(pixels, size.x, size.y, 4, &png_size,
+            MZ_DEFAULT_LEVEL, MZ_FALSE);
+
+        if (!png_data) {
+            return false;
+        }
+
+        common::wo_std_file_stream stream(path, true);
+        const bool result = stream.valid() && (stream.write(png_data, png_size) == png_size);
+
+        mz_free(png_data);
+        return result;
+    }
+
+    software_graphics_driver::software_graphics_driver(const window_system_info &info)
+        : graphics_driver(graphic_api::software)
+        , list_queue_(SOFTWARE_MAX_PENDING_LIST)
+        , should_stop_(false)
+        , target_(&swapchain_)
+        , presented_count_(0) {
+    }
+
+    software_graphics_driver::~software_graphics_driver() {
+    }
+
+    software_surface *software_graphics_driver::get_bitmap(const drivers::handle h) {
+        if ((h & HANDLE_BITMAP) == 0) {
+            return nullptr;
+        }
+
+        const std::uint64_t index = h & ~HANDLE_BITMAP;
+
+        if ((index == 0) || (index > bitmaps_.size())) {
+            return nullptr;
+        }
+
+        return bitmaps_[index - 1].get();
+    }
+
+    bool software_graphics_driver::pass_clip(const int x, const int y) const {
+        if (!state_.region_enabled_) {
+            return true;
+        }
+
+        for (const eka2l1::rect &clip : state_.region_) {
+            if ((x >= clip.top.x) && (y >= clip.top.y) && (x < clip.top.x + clip.size.x) && (y < clip.top.y + clip.size.y)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    eka2l1::rect software_graphics_driver::clip_bounds(const eka2l1::rect &draw_rect, const bool for_clear) const {
+        eka2l1::rect bounds = draw_rect.intersect(eka2l1::rect({ 0, 0 }, target_->size_));
+
+        if (state_.scissor_enabled_) {
+            bounds = bounds.intersect(state_.scissor_);
+        }
+
+        // Like a stencil, the clip region does not restrict clears
+        if (!for_clear && state_.region_enabled_) {
+            if (state_.region_.empty()) {
+                return eka2l1::rect({ 0, 0 }, { 0, 0 });
+            }
+
+            eka2l1::rect region_bounds = state_.region_[0];
+
+            for (std::size_t i = 1; i < state_.region_.size(); i++) {
+                region_bounds.merge(state_.region_[i]);
+            }
+
+            bounds = bounds.intersect(region_bounds);
+        }
+
+        return bounds;
+    }
+
+    void software_graphics_driver::fill_rect(const eka2l1::rect &area, const std::uint32_t color) {
+        const bool need_blend = state_.blend_.enabled_;
+
+        auto fill_clipped = [&](const eka2l1::rect &bounds, const bool check_region) {
+            for (int y = bounds.top.y; y < bounds.top.y + bounds.size.y; y++) {
+                std::uint32_t *dest = target_->row(y) + bounds.top.x;
+
+                if (!need_blend && !check_region) {
+                    fill_span(dest, bounds.size.x, color);
+                    continue;
+                }
+
+                for (int x = 0; x < bounds.size.x; x++) {
+                    if (check_region && !pass_clip(bounds.top.x + x, y)) {
+                        continue;
+                    }
+
+                    dest[x] = need_blend ? blend_pixel(state_.blend_, color, dest[x]) : color;
+                }
+            }
+        };
+
+        const eka2l1::rect bounds = clip_bounds(area, false);
+
+        if (bounds.size.x <= 0 || bounds.size.y <= 0) {
+            return;
+        }
+
+        if (state_.region_enabled_ && !need_blend) {
+            // Overdraw on overlapping clip rectangles is harmless without blending, keep the fast span fill
+            for (const eka2l1::rect &clip : state_.region_) {
+                const eka2l1::rect sub_bounds = bounds.intersect(clip);
+
+                if (sub_bounds.size.x > 0 && sub_bounds.size.y > 0) {
+                    fill_clipped(sub_bounds, false);
+                }
+            }
+
+            return;
+        }
+
+        fill_clipped(bounds, state_.region_enabled_);
+    }
+
+    void software_graphics_driver::create_bitmap(command &cmd) {
+        eka2l1::vec2 size;
+        std::uint32_t bpp = static_cast<std::uint32_t>(cmd.data_[1]);
+        const drivers::handle h = static_cast<drivers::handle>(cmd.data_[2]);
+        const std::uint64_t index = h & ~HANDLE_BITMAP;
+
+        unpack_u64_to_2u32(cmd.data_[0], size.x, size.y);
+
+        if (((h & HANDLE_BITMAP) == 0) || (index == 0)) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Invalid reserved bitmap handle {}", h);
+            finish(cmd.status_, -1);
+
+            return;
+        }
+
+        if (index > bitmaps_.size()) {
+            bitmaps_.resize(index);
+        }
+
+        bitmaps_[index - 1] = std::make_unique<software_surface>(size, static_cast<int>(bpp));
+        finish(cmd.status_, 0);
+    }
+
+    void software_graphics_driver::destroy_bitmap(command &cmd) {
+        software_surface *bmp = get_bitmap(cmd.data_[0]);
+
+        if (bmp) {
+            if (target_ == bmp) {
+                target_ = &swapchain_;
+            }
+
+            bitmaps_[(cmd.data_[0] & ~HANDLE_BITMAP) - 1].reset();
+        }
+
+        // A bitmap that failed to be created has no object, but its handle is still reserved
+        if (!free_handle(cmd.data_[0])) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Invalid bitmap handle to destroy");
+        }
+    }
+
+    void software_graphics_driver::bind_bitmap(command &cmd) {
+        const drivers::handle h = cmd.data_[0];
+
+        if (h == 0) {
+            target_ = &swapchain_;
+            return;
+        }
+
+        software_surface *bmp = get_bitmap(h);
+
+        if (!bmp) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Bitmap handle invalid to be binded");
+            return;
+        }
+
+        target_ = bmp;
+    }
+
+    void software_graphics_driver::resize_bitmap(command &cmd) {
+        software_surface *bmp = get_bitmap(cmd.data_[0]);
+
+        if (!bmp) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Bitmap handle invalid to be resized");
+            return;
+        }
+
+        eka2l1::vec2 new_size = { 0, 0 };
+        unpack_u64_to_2u32(cmd.data_[1], new_size.x, new_size.y);
+
+        bmp->resize(new_size, true);
+    }
+
+    void software_graphics_driver::update_bitmap(drivers::handle h, const std::size_t size, const eka2l1::vec2 &offset,
+        const eka2l1::vec2 &dim, const void *data, const std::size_t pixels_per_line) {
+        software_surface *bmp = get_bitmap(h);
+
+        if (!bmp || !data) {
+            return;
+        }
+
+        std::size_t bytes_per_pixel = 4;
+
+        switch (bmp->bpp_) {
+        case 8:
+            bytes_per_pixel = 1;
+            break;
+
+        case 12:
+        case 16:
+            bytes_per_pixel = 2;
+            break;
+
+        case 24:
+            bytes_per_pixel = 3;
+            break;
+
+        default:
+            break;
+        }
+
+        // Rows follow the unpack alignment of 4 that GPU backends use
+        const std::size_t row_pixels = pixels_per_line ? pixels_per_line : static_cast<std::size_t>(dim.x);
+        const std::size_t stride = ((row_pixels * bytes_per_pixel) + 3) & ~static_cast<std::size_t>(3);
+
+        int row_count = common::min(dim.y, bmp->size_.y - offset.y);
+        const int column_count = common::min(dim.x, bmp->size_.x - offset.x);
+
+        if ((row_count <= 0) || (column_count <= 0) || (offset.x < 0) || (offset.y < 0)) {
+            return;
+        }
+
+        if (size != 0) {
+            const std::size_t rows_in_data = (size + stride - static_cast<std::size_t>(column_count) * bytes_per_pixel) / stride;
+            row_count = static_cast<int>(common::min<std::size_t>(row_count, rows_in_data));
+        }
+
+        const std::uint8_t *source = reinterpret_cast<const std::uint8_t *>(data);
+
+        for (int y = 0; y < row_count; y++) {
+            const std::uint8_t *source_row = source + y * stride;
+            std::uint32_t *dest = bmp->row(offset.y + y) + offset.x;
+
+            switch (bmp->bpp_) {
+            case 8:
+                // Same as the red swizzle of GPU backends, the gray level goes to every channel
+                for (int x = 0; x < column_count; x++) {
+                    dest[x] = source_row[x] * 0x01010101U;
+                }
+
+                break;
+
+            case 12:
+                for (int x = 0; x < column_count; x++) {
+                    std::uint16_t pixel = 0;
+                    std::memcpy(&pixel, source_row + x * 2, 2);
+
+                    dest[x] = make_rgba(((pixel >> 8) & 0xF) * 17, ((pixel >> 4) & 0xF) * 17, (pixel & 0xF) * 17, 255);
+                }
+
+                break;
+
+            case 16:
+                for (int x = 0; x < column_count; x++) {
+                    std::uint16_t pixel = 0;
+                    std::memcpy(&pixel, source_row + x * 2, 2);
+
+                    const std::uint32_t r = (pixel >> 11) & 0x1F;
+                    const std::uint32_t g = (pixel >> 5) & 0x3F;
+                    const std::uint32_t b = pixel & 0x1F;
+
+                    dest[x] = make_rgba((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255);
+                }
+
+                break;
+
+            case 24:
+                for (int x = 0; x < column_count; x++) {
+                    const std::uint8_t *pixel = source_row + x * 3;
+                    dest[x] = make_rgba(pixel[2], pixel[1], pixel[0], 255);
+                }
+
+                break;
+
+            default:
+                for (int x = 0; x < column_count; x++) {
+                    const std::uint8_t *pixel = source_row + x * 4;
+                    dest[x] = make_rgba(pixel[2], pixel[1], pixel[0], pixel[3]);
+                }
+
+                break;
+            }
+        }
+    }
+
+    void software_graphics_driver::update_bitmap(command &cmd) {
+        std::uint8_t *data = reinterpret_cast<std::uint8_t *>(cmd.data_[1]);
+        eka2l1::vec2 offset;
+        eka2l1::vec2 dim;
+
+        unpack_u64_to_2u32(cmd.data_[3], offset.x, offset.y);
+        unpack_u64_to_2u32(cmd.data_[4], dim.x, dim.y);
+
+        update_bitmap(cmd.data_[0], static_cast<std::size_t>(cmd.data_[2]), offset, dim, data,
+            static_cast<std::size_t>(cmd.data_[5]));
+    }
+
+    void software_graphics_driver::read_bitmap(command &cmd) {
+        software_surface *bmp = get_bitmap(cmd.data_[0]);
+        std::uint8_t *ptr = reinterpret_cast<std::uint8_t *>(cmd.data_[4]);
+
+        if (!bmp || !ptr) {
+            finish(cmd.status_, 0);
+            return;
+        }
+
+        eka2l1::point pos(0, 0);
+        eka2l1::object_size size(0, 0);
+        const std::uint32_t bpp = static_cast<std::uint32_t>(cmd.data_[3]);
+
+        unpack_u64_to_2u32(cmd.data_[1], pos.x, pos.y);
+        unpack_u64_to_2u32(cmd.data_[2], size.x, size.y);
+
+        if ((pos.x < 0) || (pos.y < 0) || (pos.x + size.x > bmp->size_.x) || (pos.y + size.y > bmp->size_.y)) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Bitmap read region is out of bound");
+            finish(cmd.status_, 0);
+
+            return;
+        }
+
+        // Layout matches what GPU backends read back: RGBA bytes, or packed 16-bit pixels
+        // with rows aligned to 4 bytes
+        switch (bpp) {
+        case 8:
+        case 24:
+        case 32:
+            for (int y = 0; y < size.y; y++) {
+                std::memcpy(ptr + static_cast<std::size_t>(y) * size.x * 4, bmp->row(pos.y + y) + pos.x, size.x * 4);
+            }
+
+            break;
+
+        case 12:
+        case 16: {
+            const std::size_t stride = ((size.x * 2) + 3) & ~3;
+
+            for (int y = 0; y < size.y; y++) {
+                const std::uint32_t *source = bmp->row(pos.y + y) + pos.x;
+                std::uint16_t *dest = reinterpret_cast<std::uint16_t *>(ptr + y * stride);
+
+                for (int x = 0; x < size.x; x++) {
+                    const std::uint32_t pixel = source[x];
+
+                    if (bpp == 12) {
+                        dest[x] = static_cast<std::uint16_t>(((channel(pixel, 3) / 17) << 12) | ((channel(pixel, 0) / 17) << 8)
+                            | ((channel(pixel, 1) / 17) << 4) | (channel(pixel, 2) / 17));
+                    } else {
+                        dest[x] = static_cast<std::uint16_t>(((channel(pixel, 0) & 0xF8) << 8) | ((channel(pixel, 1) & 0xFC) << 3)
+                            | ((channel(pixel, 2) & 0xF8) >> 3));
+                    }
+                }
+            }
+
+            break;
+        }
+
+        default:
+            LOG_ERROR(DRIVER_GRAPHICS, "Unsupported BPP type to read format from (value={})", bpp);
+            finish(cmd.status_, 0);
+
+            return;
+        }
+
+        finish(cmd.status_, 1);
+    }
+
+    void software_graphics_driver::clear(command &cmd) {
+        const std::uint8_t clear_bits = static_cast<std::uint8_t>(cmd.data_[3]);
+
+        if ((clear_bits & draw_buffer_bit_color_buffer) == 0) {
+            // There is no depth or stencil buffer
+            return;
+        }
+
+        float color[4];
+
+        unpack_to_two_floats(cmd.data_[0], color[0], color[1]);
+        unpack_to_two_floats(cmd.data_[1], color[2], color[3]);
+
+        const std::uint32_t packed = make_rgba(float_to_channel(color[0]), float_to_channel(color[1]),
+            float_to_channel(color[2]), float_to_channel(color[3]));
+
+        const eka2l1::rect bounds = clip_bounds(eka2l1::rect({ 0, 0 }, target_->size_), true);
+
+        for (int y = bounds.top.y; y < bounds.top.y + bounds.size.y; y++) {
+            fill_span(target_->row(y) + bounds.top.x, bounds.size.x, packed);
+        }
+    }
+
+    void software_graphics_driver::clip_rect(command &cmd) {
+        unpack_u64_to_2u32(cmd.data_[0], state_.scissor_.top.x, state_.scissor_.top.y);
+        unpack_u64_to_2u32(cmd.data_[1], state_.scissor_.size.x, state_.scissor_.size.y);
+    }
+
+    void software_graphics_driver::clip_region(command &cmd) {
+        const std::size_t count = static_cast<std::size_t>(cmd.data_[0]);
+        eka2l1::rect *rects = reinterpret_cast<eka2l1::rect *>(cmd.data_[1]);
+
+        float scale = 0.0f;
+        float temp = 0.0f;
+
+        unpack_to_two_floats(cmd.data_[2], scale, temp);
+
+        state_.region_.clear();
+        state_.region_enabled_ = false;
+        state_.scissor_enabled_ = false;
+
+        if (count == 1) {
+            state_.scissor_enabled_ = true;
+            state_.scissor_ = rects[0];
+            state_.scissor_.scale(scale);
+        } else if (count > 1) {
+            state_.region_enabled_ = true;
+
+            for (std::size_t i = 0; i < count; i++) {
+                if (rects[i].valid()) {
+                    state_.region_.push_back(rects[i]);
+                    state_.region_.back().scale(scale);
+                }
+            }
+        }
+    }
+
+    void software_graphics_driver::draw_rectangle(command &cmd) {
+        eka2l1::rect brush_rect;
+        unpack_u64_to_2u32(cmd.data_[0], brush_rect.top.x, brush_rect.top.y);
+        unpack_u64_to_2u32(cmd.data_[1], brush_rect.size.x, brush_rect.size.y);
+
+        if (brush_rect.size.x == 0) {
+            brush_rect.size.x = target_->size_.x;
+        }
+
+        if (brush_rect.size.y == 0) {
+            brush_rect.size.y = target_->size_.y;
+        }
+
+        fill_rect(brush_rect, state_.brush_color_);
+    }
+
+    void software_graphics_driver::draw_bitmap(command &cmd) {
+        software_surface *source = get_bitmap(cmd.data_[0]);
+
+        if (!source) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Invalid bitmap handle to draw");
+            return;
+        }
+
+        software_surface *mask = nullptr;
+
+        if (cmd.data_[1]) {
+            mask = get_bitmap(cmd.data_[1]);
+
+            if (!mask) {
+                LOG_ERROR(DRIVER_GRAPHICS, "Mask handle was provided but invalid!");
+                return;
+            }
+        }
+
+        const std::uint32_t flags = static_cast<std::uint32_t>(cmd.data_[7] >> 32);
+        const std::uint32_t rotation_bits = static_cast<std::uint32_t>(cmd.data_[7]);
+
+        float rotation = 0.0f;
+        std::memcpy(&rotation, &rotation_bits, sizeof(float));
+
+        eka2l1::rect dest_rect;
+        eka2l1::rect source_rect;
+        eka2l1::vec2 origin;
+
+        unpack_u64_to_2u32(cmd.data_[2], dest_rect.top.x, dest_rect.top.y);
+        unpack_u64_to_2u32(cmd.data_[3], dest_rect.size.x, dest_rect.size.y);
+        unpack_u64_to_2u32(cmd.data_[4], source_rect.top.x, source_rect.top.y);
+        unpack_u64_to_2u32(cmd.data_[5], source_rect.size.x, source_rect.size.y);
+        unpack_u64_to_2u32(cmd.data_[6], origin.x, origin.y);
+
+        if (source_rect.empty()) {
+            source_rect.top = { 0, 0 };
+        }
+
+        if (source_rect.size.x == 0) {
+            source_rect.size.x = source->size_.x;
+        }
+
+        if (source_rect.size.y == 0) {
+            source_rect.size.y = source->size_.y;
+        }
+
+        if (dest_rect.size.x == 0) {
+            dest_rect.size.x = source_rect.size.x;
+        }
+
+        if (dest_rect.size.y == 0) {
+            dest_rect.size.y = source_rect.size.y;
+        }
+
+        if ((dest_rect.size.x <= 0) || (dest_rect.size.y <= 0) || (source->size_.x <= 0) || (source->size_.y <= 0)) {
+            return;
+        }
+
+        const std::uint32_t color = (flags & bitmap_draw_flag_use_brush) ? state_.brush_color_ : 0xFFFFFFFF;
+        const bool flip = (flags & bitmap_draw_flag_flip);
+        const bool invert_mask = (flags & bitmap_draw_flag_invert_mask);
+        const bool flat_blending = (flags & bitmap_draw_flag_flat_blending);
+
+        // Fetch the shaded source pixel. Coordinates are relative to the source rectangle
+        auto shade = [&](int sx, int sy) -> std::uint32_t {
+            if (flip) {
+                sy = source_rect.size.y - 1 - sy;
+            }
+
+            sx = common::clamp(0, source->size_.x - 1, source_rect.top.x + sx);
+            sy = common::clamp(0, source->size_.y - 1, source_rect.top.y + sy);
+
+            std::uint32_t pixel = modulate(source->row(sy)[sx], color);
+
+            if (mask) {
+                // The mask is sampled with the same normalized coordinates as the source
+                const int mx = common::clamp(0, mask->size_.x - 1, static_cast<int>(static_cast<std::int64_t>(sx) * mask->size_.x / source->size_.x));
+                const int my = common::clamp(0, mask->size_.y - 1, static_cast<int>(static_cast<std::int64_t>(sy) * mask->size_.y / source->size_.y));
+
+                std::uint32_t mask_value = channel(mask->row(my)[mx], 0);
+
+                if (invert_mask) {
+                    mask_value = 255 - mask_value;
+                }
+
+                if (flat_blending) {
+                    mask_value = mask_value ? 255 : 0;
+                }
+
+                pixel = (pixel & 0x00FFFFFF) | (mask_value << 24);
+            }
+
+            return pixel;
+        };
+
+        auto put = [&](const int x, const int y, const std::uint32_t pixel) {
+            std::uint32_t &dest = target_->row(y)[x];
+            dest = state_.blend_.enabled_ ? blend_pixel(state_.blend_, pixel, dest) : pixel;
+        };
+
+        if (std::fmod(rotation, 360.0f) != 0.0f) {
+            const float radian = rotation * 3.14159265358979f / 180.0f;
+            const float cos_value = std::cos(radian);
+            const float sin_value = std::sin(radian);
+
+            const float pivot_x = static_cast<float>(dest_rect.top.x + origin.x);
+            const float pivot_y = static_cast<float>(dest_rect.top.y + origin.y);
+
+            // Bounding box of the rotated destination rectangle
+            float min_x = pivot_x, max_x = pivot_x, min_y = pivot_y, max_y = pivot_y;
+
+            for (int i = 0; i < 4; i++) {
+                const float cx = static_cast<float>((i & 1) ? dest_rect.top.x + dest_rect.size.x : dest_rect.top.x) - pivot_x;
+                const float cy = static_cast<float>((i & 2) ? dest_rect.top.y + dest_rect.size.y : dest_rect.top.y) - pivot_y;
+
+                const float rx = pivot_x + cx * cos_value - cy * sin_value;
+                const float ry = pivot_y + cx * sin_value + cy * cos_value;
+
+                min_x = common::min(min_x, rx);
+                max_x = common::max(max_x, rx);
+                min_y = common::min(min_y, ry);
+                max_y = common::max(max_y, ry);
+            }
+
+            const eka2l1::rect rotated_rect(eka2l1::vec2(static_cast<int>(std::floor(min_x)), static_cast<int>(std::floor(min_y))),
+                eka2l1::vec2(static_cast<int>(std::ceil(max_x - std::floor(min_x))), static_cast<int>(std::ceil(max_y - std::floor(min_y)))));
+
+            const eka2l1::rect bounds = clip_bounds(rotated_rect, false);
+
+            for (int y = bounds.top.y; y < bounds.top.y + bounds.size.y; y++) {
+                for (int x = bounds.top.x; x < bounds.top.x + bounds.size.x; x++) {
+                    if (!pass_clip(x, y)) {
+                        continue;
+                    }
+
+                    // Map the pixel center back to the unrotated destination rectangle
+                    const float px = static_cast<float>(x) + 0.5f - pivot_x;
+                    const float py = static_cast<float>(y) + 0.5f - pivot_y;
+
+                    const float ux = pivot_x + px * cos_value + py * sin_value - static_cast<float>(dest_rect.top.x);
+                    const float uy = pivot_y - px * sin_value + py * cos_value - static_cast<float>(dest_rect.top.y);
+
+                    if ((ux < 0.0f) || (uy < 0.0f) || (ux >= dest_rect.size.x) || (uy >= dest_rect.size.y)) {
+                        continue;
+                    }
+
+                    put(x, y, shade(static_cast<int>(ux * source_rect.size.x / dest_rect.size.x),
+                        static_cast<int>(uy * source_rect.size.y / dest_rect.size.y)));
+                }
+            }
+
+            return;
+        }
+
+        const eka2l1::rect bounds = clip_bounds(dest_rect, false);
+
+        if ((bounds.size.x <= 0) || (bounds.size.y <= 0)) {
+            return;
+        }
+
+        const bool straight_copy = !mask && !flip && (color == 0xFFFFFFFF) && !state_.blend_.enabled_ && !state_.region_enabled_
+            && (source_rect.size == dest_rect.size) && (source_rect.top.x >= 0) && (source_rect.top.y >= 0)
+            && (source_rect.top.x + source_rect.size.x <= source->size_.x) && (source_rect.top.y + source_rect.size.y <= source->size_.y);
+
+        if (straight_copy) {
+            for (int y = bounds.top.y; y < bounds.top.y + bounds.size.y; y++) {
+                const std::uint32_t *source_row = source->row(source_rect.top.y + y - dest_rect.top.y) + source_rect.top.x
+                    + (bounds.top.x - dest_rect.top.x);
+
+                std::memcpy(target_->row(y) + bounds.top.x, source_row, bounds.size.x * sizeof(std::uint32_t));
+            }
+
+            return;
+        }
+
+        // Nearest sampling, stepping through the source in 16.16 fixed point
+        const std::int64_t step_x = (static_cast<std::int64_t>(source_rect.size.x) << 16) / dest_rect.size.x;
+        const std::int64_t step_y = (static_cast<std::int64_t>(source_rect.size.y) << 16) / dest_rect.size.y;
+
+        for (int y = bounds.top.y; y < bounds.top.y + bounds.size.y; y++) {
+            const int sy = static_cast<int>(((y - dest_rect.top.y) * step_y + step_y / 2) >> 16);
+            std::int64_t sx_fixed = (bounds.top.x - dest_rect.top.x) * step_x + step_x / 2;
+
+            for (int x = bounds.top.x; x < bounds.top.x + bounds.size.x; x++, sx_fixed += step_x) {
+                if (pass_clip(x, y)) {
+                    put(x, y, shade(static_cast<int>(sx_fixed >> 16), sy));
+                }
+            }
+        }
+    }
+
+    void software_graphics_driver::plot_pen(const int x, const int y, const std::uint32_t color) {
+        const int half = state_.point_size_ / 2;
+        const eka2l1::rect dot(eka2l1::vec2(x - half, y - half), eka2l1::vec2(common::max<int>(1, state_.point_size_),
+            common::max<int>(1, state_.point_size_)));
+
+        fill_rect(dot, color);
+    }
+
+    void software_graphics_driver::rasterize_line(const eka2l1::point &start, const eka2l1::point &end) {
+        std::uint32_t pattern = 0;
+
+        switch (state_.pen_style_) {
+        case pen_style_solid:
+            pattern = 0xFFFF;
+            break;
+
+        case pen_style_dotted:
+            pattern = 0x6666;
+            break;
+
+        case pen_style_dashed:
+            pattern = 0x3F3F;
+            break;
+
+        case pen_style_dashed_dot:
+            pattern = 0xFF18;
+            break;
+
+        case pen_style_dashed_dot_dot:
+            pattern = 0x7E66;
+            break;
+
+        default:
+            LOG_WARN(DRIVER_GRAPHICS, "Unrecognised pen style {}!", static_cast<int>(state_.pen_style_));
+            return;
+        }
+
+        // Bresenham, the pattern advances by one bit each pixel
+        const int dx = common::abs(end.x - start.x);
+        const int dy = -common::abs(end.y - start.y);
+        const int sx = (start.x < end.x) ? 1 : -1;
+        const int sy = (start.y < end.y) ? 1 : -1;
+
+        int error = dx + dy;
+        int x = start.x;
+        int y = start.y;
+        std::uint32_t step = 0;
+
+        while (true) {
+            if ((pattern >> (step++ & 15)) & 1) {
+                plot_pen(x, y, state_.brush_color_);
+            }
+
+            if ((x == end.x) && (y == end.y)) {
+                break;
+            }
+
+            const int error2 = error * 2;
+
+            if (error2 >= dy) {
+                error += dy;
+                x += sx;
+            }
+
+            if (error2 <= dx) {
+                error += dx;
+                y += sy;
+            }
+        }
+    }
+
+    void software_graphics_driver::draw_line(command &cmd) {
+        if (state_.pen_style_ == pen_style_none) {
+            return;
+        }
+
+        eka2l1::point start;
+        eka2l1::point end;
+
+        unpack_u64_to_2u32(cmd.data_[0], start.x, start.y);
+        unpack_u64_to_2u32(cmd.data_[1], end.x, end.y);
+
+        rasterize_line(start, end);
+    }
+
+    void software_graphics_driver::draw_polygon(command &cmd) {
+        const std::size_t point_count = static_cast<std::size_t>(cmd.data_[0]);
+        eka2l1::point *point_list = reinterpret_cast<eka2l1::point *>(cmd.data_[1]);
+
+        if (state_.pen_style_ != pen_style_none) {
+            for (std::size_t i = 0; i + 1 < point_count; i++) {
+                rasterize_line(point_list[i], point_list[i + 1]);
+            }
+        }
+    }
+
+    void software_graphics_driver::set_brush_color(command &cmd) {
+        std::uint32_t r, g, b, a;
+        unpack_u64_to_2u32(cmd.data_[0], r, g);
+        unpack_u64_to_2u32(cmd.data_[1], b, a);
+
+        state_.brush_color_ = make_rgba(common::min<std::uint32_t>(r, 255), common::min<std::uint32_t>(g, 255),
+            common::min<std::uint32_t>(b, 255), common::min<std::uint32_t>(a, 255));
+    }
+
+    void software_graphics_driver::set_feature(command &cmd) {
+        drivers::graphics_feature feature;
+        bool enable = true;
+
+        unpack_u64_to_2u32(cmd.data_[0], feature, enable);
+
+        switch (feature) {
+        case drivers::graphics_feature::blend:
+            state_.blend_.enabled_ = enable;
+            break;
+
+        case drivers::graphics_feature::clipping:
+            state_.scissor_enabled_ = enable;
+            break;
+
+        case drivers::graphics_feature::stencil_test:
+            state_.region_enabled_ = enable && !state_.region_.empty();
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void software_graphics_driver::blend_formula(command &cmd) {
+        unpack_u64_to_2u32(cmd.data_[0], state_.blend_.rgb_equation_, state_.blend_.a_equation_);
+        unpack_u64_to_2u32(cmd.data_[1], state_.blend_.rgb_frag_out_factor_, state_.blend_.rgb_current_factor_);
+        unpack_u64_to_2u32(cmd.data_[2], state_.blend_.a_frag_out_factor_, state_.blend_.a_current_factor_);
+    }
+
+    void software_graphics_driver::set_blend_colour(command &cmd) {
+        float red, green, blue, alpha;
+        unpack_to_two_floats(cmd.data_[0], red, green);
+        unpack_to_two_floats(cmd.data_[1], blue, alpha);
+
+        state_.blend_.constant_colour_ = make_rgba(float_to_channel(red), float_to_channel(green), float_to_channel(blue),
+            float_to_channel(alpha));
+    }
+
+    void software_graphics_driver::set_swapchain_size(command &cmd) {
+        eka2l1::vec2 size;
+        unpack_u64_to_2u32(cmd.data_[0], size.x, size.y);
+
+        if (size != swapchain_.size_) {
+            swapchain_.resize(size, false);
+        }
+    }
+
+    void software_graphics_driver::read_framebuffer(command &cmd) {
+        const drivers::texture_format format = static_cast<drivers::texture_format>(static_cast<std::uint32_t>(cmd.data_[1]));
+        const drivers::texture_data_type data_type = static_cast<drivers::texture_data_type>(static_cast<std::uint32_t>(cmd.data_[1] >> 32));
+        std::uint8_t *dest = reinterpret_cast<std::uint8_t *>(cmd.data_[4]);
+
+        std::int32_t x, y, width, height;
+        unpack_u64_to_2u32(cmd.data_[2], x, y);
+        unpack_u64_to_2u32(cmd.data_[3], width, height);
+
+        if ((cmd.data_[0] != 0) || !dest || (data_type != texture_data_type::ubyte) || ((format != texture_format::rgba) && (format != texture_format::bgra))) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Only RGBA/BGRA read of the swapchain is supported by the software renderer");
+            finish(cmd.status_, -1);
+
+            return;
+        }
+
+        // Rows are returned from the bottom, like a GPU framebuffer read
+        for (std::int32_t row = 0; row < height; row++) {
+            const int source_y = swapchain_.size_.y - 1 - (y + row);
+
+            for (std::int32_t column = 0; column < width; column++) {
+                std::uint8_t *pixel = dest + (static_cast<std::size_t>(row) * width + column) * 4;
+                const int source_x = x + column;
+
+                if ((source_y < 0) || (source_y >= swapchain_.size_.y) || (source_x < 0) || (source_x >= swapchain_.size_.x)) {
+                    std::memset(pixel, 0, 4);
+                    continue;
+                }
+
+                const std::uint32_t value = swapchain_.row(source_y)[source_x];
+
+                pixel[0] = static_cast<std::uint8_t>(channel(value, (format == texture_format::bgra) ? 2 : 0));
+                pixel[1] = static_cast<std::uint8_t>(channel(value, 1));
+                pixel[2] = static_cast<std::uint8_t>(channel(value, (format == texture_format::bgra) ? 0 : 2));
+                pixel[3] = static_cast<std::uint8_t>(channel(value, 3));
+            }
+        }
+
+        finish(cmd.status_, 0);
+    }
+
+    void software_graphics_driver::display(command &cmd) {
+        std::string dump_path;
+
+        {
+            const std::lock_guard<std::mutex> guard(frame_lock_);
+
+            presented_.size_ = swapchain_.size_;
+            presented_.pixels_ = swapchain_.pixels_;
+
+            if (!frame_dump_dir_.empty()) {
+                dump_path = eka2l1::add_path(frame_dump_dir_, fmt::format("frame_{:06}.png", presented_count_));
+            }
+
+            presented_count_++;
+        }
+
+        if (!dump_path.empty() && !write_rgba_png(dump_path, presented_.pixels_.data(), presented_.size_)) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Unable to dump frame to {}", dump_path);
+        }
+
+        get_command_list_pool().end_frame();
+
+        if (disp_hook_) {
+            disp_hook_();
+        }
+
+        finish(cmd.status_, 0);
+    }
+
+    void software_graphics_driver::ignore_unsupported(command &cmd) {
+        // Synchronous requests still have to be answered, or the client waits forever. The handle of an
+        // unsupported creation stays reserved until the client destroys it.
+        fail_creation(cmd);
+    }
+
+    void software_graphics_driver::dispatch(command &cmd) {
+        switch (cmd.opcode_) {
+        case graphics_driver_create_bitmap:
+            create_bitmap(cmd);
+            break;
+
+        case graphics_driver_destroy_bitmap:
+            destroy_bitmap(cmd);
+            break;
+
+        // Only bitmaps are created by this driver, other objects failed creation and only hold a handle
+        case graphics_driver_destroy_object:
+            free_handle(cmd.data_[0]);
+            break;
+
+        case graphics_driver_bind_bitmap:
+            bind_bitmap(cmd);
+            break;
+
+        case graphics_driver_resize_bitmap:
+            resize_bitmap(cmd);
+            break;
+
+        case graphics_driver_update_bitmap:
+            update_bitmap(cmd);
+            break;
+
+        case graphics_driver_read_bitmap:
+            read_bitmap(cmd);
+            break;
+
+        case graphics_driver_clear:
+            clear(cmd);
+            break;
+
+        case graphics_driver_clip_rect:
+        case graphics_driver_clip_bitmap_rect:
+            clip_rect(cmd);
+            break;
+
+        case graphics_driver_clip_region:
+            clip_region(cmd);
+            break;
+
+        case graphics_driver_draw_bitmap:
+            draw_bitmap(cmd);
+            break;
+
+        case graphics_driver_draw_rectangle:
+            draw_rectangle(cmd);
+            break;
+
+        case graphics_driver_draw_line:
+            draw_line(cmd);
+            break;
+
+        case graphics_driver_draw_polygon:
+            draw_polygon(cmd);
+            break;
+
+        case graphics_driver_set_brush_color:
+            set_brush_color(cmd);
+            break;
+
+        case graphics_driver_set_point_size:
+            state_.point_size_ = static_cast<std::uint8_t>(cmd.data_[0]);
+            break;
+
+        case graphics_driver_set_pen_style:
+            state_.pen_style_ = static_cast<pen_style>(cmd.data_[0]);
+            break;
+
+        case graphics_driver_set_feature:
+            set_feature(cmd);
+            break;
+
+        case graphics_driver_blend_formula:
+            blend_formula(cmd);
+            break;
+
+        case graphics_driver_set_blend_colour:
+            set_blend_colour(cmd);
+            break;
+
+        case graphics_driver_set_swapchain_size:
+            set_swapchain_size(cmd);
+            break;
+
+        case graphics_driver_backup_state:
+            backup_state_ = state_;
+            break;
+
+        case graphics_driver_restore_state:
+            state_ = backup_state_;
+            break;
+
+        case graphics_driver_read_framebuffer:
+            read_framebuffer(cmd);
+            break;
+
+        case graphics_driver_display:
+            display(cmd);
+            break;
+
+        // Viewport and projection follow the bound surface's size
+        case graphics_driver_set_viewport:
+        case graphics_driver_set_bitmap_viewport:
+        case graphics_driver_set_ortho_size:
+            break;
+
+        default:
+            ignore_unsupported(cmd);
+            break;
+        }
+    }
+
+    void software_graphics_driver::run() {
+        command_list list;
+
+        while (!should_stop_) {
+            if (!list_queue_.pop(list)) {
+                break;
+            }
+
+            for (std::size_t i = 0; i < list.size_; i++) {
+                dispatch(list.base_[i]);
+            }
+
+            list.recycle();
+        }
+
+        list_queue_.drain([](command_list &leftover) {
+            leftover.abandon();
+        });
+    }
+
+    void software_graphics_driver::abort() {
+        should_stop_ = true;
+        list_queue_.abort();
+    }
+
+    command_queue_stats software_graphics_driver::get_command_queue_stats() {
+        return list_queue_.get_stats();
+    }
+
+    void software_graphics_driver::submit_command_list(command_list &cmd_list) {
+        if ((cmd_list.size_ == 0) || !cmd_list.base_) {
+            cmd_list.recycle();
+            return;
+        }
+
+        if (should_stop_ || !list_queue_.push(cmd_list)) {
+            cmd_list.abandon();
+        }
+    }
+
+    void software_graphics_driver::set_viewport(const eka2l1::rect &viewport) {
+        viewport_ = viewport;
+    }
+
+    void software_graphics_driver::update_surface(void *surface) {
+        // No window surface to present to
+    }
+
+    void software_graphics_driver::set_upscale_shader(const std::string &name) {
+        upscale_shader_ = name;
+    }
+
+    std::string software_graphics_driver::get_active_upscale_shader() const {
+        return upscale_shader_;
+    }
+
+    bool software_graphics_driver::support_extension(const graphics_driver_extension ext) {
+        return false;
+    }
+
+    bool software_graphics_driver::query_extension_value(const graphics_driver_extension_query query, void *data_ptr) {
+        return false;
+    }
+
+    void software_graphics_driver::set_frame_dump_directory(const std::string &path) {
+        if (!path.empty()) {
+            common::create_directories(path);
+        }
+
+        const std::lock_guard<std::mutex> guard(frame_lock_);
+        frame_dump_dir_ = path;
+    }
+
+    std::uint64_t software_graphics_driver::get_presented_frame(std::vector<std::uint32_t> &pixels, eka2l1::vec2 &size) {
+        const std::lock_guard<std::mutex> guard(frame_lock_);
+
+        pixels = presented_.pixels_;
+        size = presented_.size_;
+
+        return presented_count_;
+    }
+
+    bool software_graphics_driver::dump_presented_frame(const std::string &path) {
+        const std::lock_guard<std::mutex> guard(frame_lock_);
+
+        if (presented_count_ == 0) {
+            return false;
+        }
+
+        return write_rgba_png(path, presented_.pixels_.data(), presented_.size_);
+    }
+}
@@ -18,18 +18,92 @@
  */
 
 #include <drivers/graphics/backend/ogl/graphics_ogl.h>
+#include <drivers/graphics/backend/software/graphics_software.h>
 #include <drivers/graphics/graphics.h>
 
 #include <common/log.h>
 #include <common/platform.h>
 
 namespace eka2l1::drivers {
+    graphics_handle_allocator::graphics_handle_allocator()
+        : next_(1) {
+    }
+
+    std::uint32_t graphics_handle_allocator::reserve() {
+        const std::lock_guard<std::mutex> guard(lock_);
+        std::uint32_t num = 0;
+
+        if (!free_.empty()) {
+            num = free_.back();
+            free_.pop_back();
+        } else {
+            num = next_++;
+        }
+
+        if (reserved_.size() <= num) {
+            reserved_.resize(num + 1, false);
+        }
+
+        reserved_[num] = true;
+        return num;
+    }
+
+    bool graphics_handle_allocator::release(const std::uint32_t num) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        // A number released twice would be handed out to two objects
+        if ((num >= reserved_.size()) || !reserved_[num]) {
+            return false;
+        }
+
+        reserved_[num] = false;
+        free_.push_back(num);
+
+        return true;
+    }
+
+    drivers::handle graphics_driver::new_bitmap_handle() {
+        return bitmap_handles_.reserve() | HANDLE_BITMAP;
+    }
+
+    drivers::handle graphics_driver::new_object_handle() {
+        return object_handles_.reserve();
+    }
+
+    bool graphics_driver::free_handle(const drivers::handle h) {
+        if (h & HANDLE_BITMAP) {
+            return bitmap_handles_.release(static_cast<std::uint32_t>(h & ~HANDLE_BITMAP));
+        }
+
+        return object_handles_.release(static_cast<std::uint32_t>(h));
+    }
+
+    void graphics_driver::fail_creation(command &cmd) {
+        // Shaders are created synchronously, and the client gets no handle when that fails. Other objects are
+        // created asynchronously, the client already holds their handle and destroys it later.
+        switch (cmd.opcode_) {
+        case graphics_driver_create_shader_module:
+        case graphics_driver_create_shader_program:
+            free_handle(static_cast<drivers::handle>(cmd.data_[3]));
+            break;
+
+        default:
+            break;
+        }
+
+        finish(cmd.status_, -1);
+    }
+
     graphics_driver_ptr create_graphics_driver(const graphic_api api, const window_system_info &info) {
         switch (api) {
         case graphic_api::opengl: {
             return std::make_unique<ogl_graphics_driver>(info);
         }
 
+        case graphic_api::software: {
+            return std::make_unique<software_graphics_driver>(info);
+        }
+
         default:
             break;
         }
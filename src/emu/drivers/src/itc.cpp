@@ -29,8 +29,8 @@ using namespace std::chrono_literals;
 
 namespace eka2l1::drivers {
     static int send_sync_command(graphics_driver *drv, command cmd) {
-        int status = -100;
-        cmd.status_ = &status;
+        command_fence fence;
+        cmd.status_ = &fence;
 
         command_list cmd_list(1);
         cmd_list.renew();
@@ -38,52 +38,79 @@ namespace eka2l1::drivers {
         cmd_list.size_ = 1;
         *cmd_list.base_ = cmd;
 
-        std::unique_lock<std::mutex> ulock(drv->mut_);
         drv->submit_command_list(cmd_list);
-        drv->cond_.wait(ulock, [&]() { return status != -100; });
+        drv->wait_for(&fence);
 
-        return status;
+        return fence.result_;
     }
 
-    static std::uint64_t make_data_copy(const void *source, const std::size_t size) {
+    /**
+     * @brief Queue a single command to the driver, without waiting for it to be executed.
+     *
+     * Payloads of the command must be allocated from the given list. If a status is given, it is armed
+     * and signalled by the driver with the command's result.
+     */
+    static void send_async_command(graphics_driver *drv, command_list &cmd_list, command cmd, command_fence *status) {
+        if (status) {
+            status->reset();
+        }
+
+        cmd.status_ = status;
+
+        if (!cmd_list.base_) {
+            cmd_list.renew();
+        }
+
+        cmd_list.size_ = 1;
+        *cmd_list.base_ = cmd;
+
+        drv->submit_command_list(cmd_list);
+    }
+
+    static std::uint64_t make_data_copy(command_list &list, const void *source, const std::size_t size) {
         if (!source) {
             return 0;
         }
 
-        std::uint8_t *copy = new std::uint8_t[size];
+        std::uint8_t *copy = list.allocate_payload(size);
+        if (!copy) {
+            return 0;
+        }
+
         std::copy(reinterpret_cast<const std::uint8_t *>(source), reinterpret_cast<const std::uint8_t *>(source) + size, copy);
 
         return reinterpret_cast<std::uint64_t>(copy);
     }
 
-    drivers::handle create_bitmap(graphics_driver *driver, const eka2l1::vec2 &size, const std::uint32_t bpp) {
-        drivers::handle handle_num = 0;
+    drivers::handle create_bitmap(graphics_driver *driver, const eka2l1::vec2 &size, const std::uint32_t bpp, command_fence *status) {
+        const drivers::handle handle_num = driver->new_bitmap_handle();
 
         command cmd;
         cmd.opcode_ = graphics_driver_create_bitmap;
         cmd.data_[0] = PACK_2U32_TO_U64(size.x, size.y);
         cmd.data_[1] = bpp;
-        cmd.data_[2] = reinterpret_cast<std::uint64_t>(&handle_num);
+        cmd.data_[2] = handle_num;
 
-        if (send_sync_command(driver, cmd) != 0) {
-            return 0;
-        }
+        command_list cmd_list(1);
+        send_async_command(driver, cmd_list, cmd, status);
 
         return handle_num;
     }
     
     drivers::handle create_shader_module(graphics_driver *driver, const char *data, const std::size_t size, const shader_module_type mtype, std::string *compile_log) {
-        drivers::handle handle_num = 0;
+        // The compile log is read back, so this one still waits for the driver
+        const drivers::handle handle_num = driver->new_object_handle();
 
         command cmd;
         cmd.opcode_ = graphics_driver_create_shader_module;
         cmd.data_[0] = reinterpret_cast<std::uint64_t>(data);
         cmd.data_[1] = size;
         cmd.data_[2] = static_cast<std::uint64_t>(mtype);
-        cmd.data_[3] = reinterpret_cast<std::uint64_t>(&handle_num);
+        cmd.data_[3] = handle_num;
         cmd.data_[4] = reinterpret_cast<std::uint64_t>(compile_log);
 
         if (send_sync_command(driver, cmd) != 0) {
+            // The driver gave the reserved handle back already
             return 0;
         }
 
@@ -91,7 +118,8 @@ namespace eka2l1::drivers {
     }
 
     drivers::handle create_shader_program(graphics_driver *driver, drivers::handle vert_mod, drivers::handle frag_mod, shader_program_metadata *metadata, std::string *link_log) {
-        drivers::handle handle_num = 0;
+        // The link log and metadata are read back, so this one still waits for the driver
+        const drivers::handle handle_num = driver->new_object_handle();
         std::uint8_t *metadata_ptr = nullptr;
 
         command cmd;
@@ -99,10 +127,11 @@ namespace eka2l1::drivers {
         cmd.data_[0] = vert_mod;
         cmd.data_[1] = frag_mod;
         cmd.data_[2] = reinterpret_cast<std::uint64_t>(&metadata_ptr);
-        cmd.data_[3] = reinterpret_cast<std::uint64_t>(&handle_num);
+        cmd.data_[3] = handle_num;
         cmd.data_[4] = reinterpret_cast<std::uint64_t>(link_log);
 
         if (send_sync_command(driver, cmd) != 0) {
+            // The driver gave the reserved handle back already
             return 0;
         }
 
@@ -112,104 +141,98 @@ namespace eka2l1::drivers {
         return handle_num;
     }
 
-    drivers::handle create_buffer(graphics_driver *driver, const void *initial_data, const std::size_t initial_size, const buffer_upload_hint upload_hint) {
-        drivers::handle handle_num = 0;
+    drivers::handle create_buffer(graphics_driver *driver, const void *initial_data, const std::size_t initial_size, const buffer_upload_hint upload_hint,
+        command_fence *status) {
+        const drivers::handle handle_num = driver->new_object_handle();
+        command_list cmd_list(1);
 
         command cmd;
         cmd.opcode_ = graphics_driver_create_buffer;
-        cmd.data_[0] = reinterpret_cast<std::uint64_t>(initial_data);
+        cmd.data_[0] = make_data_copy(cmd_list, initial_data, initial_size);
         cmd.data_[1] = initial_size;
         cmd.data_[2] = static_cast<std::uint64_t>(upload_hint);
         cmd.data_[3] = 0;
-        cmd.data_[4] = reinterpret_cast<std::uint64_t>(&handle_num);
-
-        if (send_sync_command(driver, cmd) != 0) {
-            return 0;
-        }
+        cmd.data_[4] = handle_num;
 
+        send_async_command(driver, cmd_list, cmd, status);
         return handle_num;
     }
     
-    drivers::handle create_input_descriptors(graphics_driver *driver, input_descriptor *descriptors, const std::uint32_t count) {
-        drivers::handle handle_num = 0;
+    drivers::handle create_input_descriptors(graphics_driver *driver, input_descriptor *descriptors, const std::uint32_t count,
+        command_fence *status) {
+        const drivers::handle handle_num = driver->new_object_handle();
+        command_list cmd_list(1);
 
         command cmd;
         cmd.opcode_ = graphics_driver_create_input_descriptor;
-        cmd.data_[0] = reinterpret_cast<std::uint64_t>(descriptors);
+        cmd.data_[0] = make_data_copy(cmd_list, descriptors, count * sizeof(input_descriptor));
         cmd.data_[1] = count;
         cmd.data_[2] = 0;
-        cmd.data_[3] = reinterpret_cast<std::uint64_t>(&handle_num);
-
-        if (send_sync_command(driver, cmd) != 0) {
-            return 0;
-        }
+        cmd.data_[3] = handle_num;
 
+        send_async_command(driver, cmd_list, cmd, status);
         return handle_num;
     }
 
     drivers::handle create_texture(graphics_driver *driver, const std::uint8_t dim, const std::uint8_t mip_levels,
         drivers::texture_format internal_format, drivers::texture_format data_format, drivers::texture_data_type data_type,
         const void *data, const std::size_t data_size, const eka2l1::vec3 &size, const std::size_t pixels_per_line,
-        const std::uint32_t unpack_alignment) {
-        drivers::handle handle_num = 0;
+        const std::uint32_t unpack_alignment, command_fence *status) {
+        const drivers::handle handle_num = driver->new_object_handle();
+        command_list cmd_list(1);
 
         command cmd;
 
         cmd.opcode_ = graphics_driver_create_texture;
         cmd.data_[0] = dim | (static_cast<std::uint64_t>(mip_levels) << 8) | (static_cast<std::uint64_t>(internal_format) << 16)
             | (static_cast<std::uint64_t>(data_format) << 32) | (static_cast<std::uint64_t>(data_type) << 48);
-        cmd.data_[1] = reinterpret_cast<std::uint64_t>(data);
+        cmd.data_[1] = make_data_copy(cmd_list, data, data_size);
         cmd.data_[2] = data_size;
         cmd.data_[3] = pixels_per_line;
         cmd.data_[4] = static_cast<std::uint64_t>(unpack_alignment);
         cmd.data_[5] = PACK_2U32_TO_U64(size.x, size.y);
         cmd.data_[6] = PACK_2U32_TO_U64(size.z, 0);
         cmd.data_[7] = 0;
-        cmd.data_[8] = reinterpret_cast<std::uint64_t>(&handle_num);
-
-        if (send_sync_command(driver, cmd) != 0) {
-            return 0;
-        }
+        cmd.data_[8] = handle_num;
 
+        send_async_command(driver, cmd_list, cmd, status);
         return handle_num;
     }
     
-    drivers::handle create_renderbuffer(graphics_driver *driver, const eka2l1::vec2 &size, const drivers::texture_format internal_format) {
-        drivers::handle handle_num = 0;
+    drivers::handle create_renderbuffer(graphics_driver *driver, const eka2l1::vec2 &size, const drivers::texture_format internal_format,
+        command_fence *status) {
+        const drivers::handle handle_num = driver->new_object_handle();
         command cmd;
 
         cmd.opcode_ = graphics_driver_create_renderbuffer;
         cmd.data_[0] = PACK_2U32_TO_U64(size.x, size.y);
         cmd.data_[1] = static_cast<std::uint64_t>(internal_format);
         cmd.data_[2] = 0;
-        cmd.data_[3] = reinterpret_cast<std::uint64_t>(&handle_num);
+        cmd.data_[3] = handle_num;
 
-        if (send_sync_command(driver, cmd) != 0) {
-            return 0;
-        }
+        command_list cmd_list(1);
+        send_async_command(driver, cmd_list, cmd, status);
 
         return handle_num;
     }
     
     drivers::handle create_framebuffer(graphics_driver *driver, const drivers::handle *color_buffers, const int *color_face_indicies,
         const std::uint32_t color_buffer_count, drivers::handle depth_buffer, const int depth_face_index,
-        drivers::handle stencil_buffer, const int stencil_face_index) {
-        drivers::handle handle_num = 0;
+        drivers::handle stencil_buffer, const int stencil_face_index, command_fence *status) {
+        const drivers::handle handle_num = driver->new_object_handle();
+        command_list cmd_list(1);
         command cmd;
 
         cmd.opcode_ = graphcis_driver_create_framebuffer;
-        cmd.data_[0] = reinterpret_cast<std::uint64_t>(color_buffers);
-        cmd.data_[1] = reinterpret_cast<std::uint64_t>(color_face_indicies);
+        cmd.data_[0] = make_data_copy(cmd_list, color_buffers, color_buffer_count * sizeof(drivers::handle));
+        cmd.data_[1] = make_data_copy(cmd_list, color_face_indicies, color_buffer_count * sizeof(int));
         cmd.data_[2] = static_cast<std::uint64_t>(color_buffer_count);
         cmd.data_[3] = depth_buffer;
         cmd.data_[4] = stencil_buffer;
         cmd.data_[5] = PACK_2U32_TO_U64(depth_face_index, stencil_face_index);
-        cmd.data_[6] = reinterpret_cast<std::uint64_t>(&handle_num);
-
-        if (send_sync_command(driver, cmd) != 0) {
-            return 0;
-        }
+        cmd.data_[6] = handle_num;
 
+        send_async_command(driver, cmd_list, cmd, status);
         return handle_num;
     }
     
@@ -285,7 +308,7 @@ namespace eka2l1::drivers {
 
             cmd->opcode_ = graphics_driver_clip_region;
             cmd->data_[0] = static_cast<std::uint64_t>(region.rects_.size());
-            cmd->data_[1] = make_data_copy(region.rects_.data(), region.rects_.size() * sizeof(eka2l1::rect));
+            cmd->data_[1] = make_data_copy(list_, region.rects_.data(), region.rects_.size() * sizeof(eka2l1::rect));
             cmd->data_[2] = pack_from_two_floats(scale_factor, 0.0f);
         }
     }
@@ -316,11 +339,16 @@ namespace eka2l1::drivers {
         cmd->opcode_ = graphics_driver_update_bitmap;
 
         cmd->data_[0] = h;
-        cmd->data_[1] = (need_copy ? make_data_copy(data, size) : reinterpret_cast<std::uint64_t>(data));
+        cmd->data_[1] = (need_copy ? make_data_copy(list_, data, size) : reinterpret_cast<std::uint64_t>(data));
         cmd->data_[2] = size;
         cmd->data_[3] = PACK_2U32_TO_U64(offset.x, offset.y);
         cmd->data_[4] = PACK_2U32_TO_U64(dim.x, dim.y);
         cmd->data_[5] = pixels_per_line;
+
+        if (!need_copy) {
+            // The buffer is handed over to us, free it together with the list's payloads
+            list_.adopt_payload(reinterpret_cast<std::uint8_t *>(const_cast<char *>(data)));
+        }
     }
 
     void graphics_command_builder::update_texture(drivers::handle h, const char *data, const std::size_t size, const std::uint8_t lvl,
@@ -331,7 +359,7 @@ namespace eka2l1::drivers {
         cmd->opcode_ = graphics_driver_update_texture;
 
         cmd->data_[0] = h;
-        cmd->data_[1] = make_data_copy(data, size);
+        cmd->data_[1] = make_data_copy(list_, data, size);
         cmd->data_[2] = size;
         cmd->data_[3] = lvl | (static_cast<std::uint64_t>(data_format) << 8) | (static_cast<std::uint64_t>(data_type) << 24); 
         cmd->data_[4] = PACK_2U32_TO_U64(offset.x, offset.y);
@@ -400,7 +428,7 @@ namespace eka2l1::drivers {
         cmd->opcode_ = graphics_driver_set_uniform;
 
         cmd->data_[0] = PACK_2U32_TO_U64(binding, var_type);
-        cmd->data_[1] = make_data_copy(data, data_size);
+        cmd->data_[1] = make_data_copy(list_, data, data_size);
         cmd->data_[2] = data_size;
     }
 
@@ -433,7 +461,7 @@ namespace eka2l1::drivers {
         command *cmd = list_.retrieve_next();
         cmd->opcode_ = graphics_driver_bind_vertex_buffers;
 
-        cmd->data_[0] = make_data_copy(h, sizeof(drivers::handle) * count);
+        cmd->data_[0] = make_data_copy(list_, h, sizeof(drivers::handle) * count);
         cmd->data_[1] = PACK_2U32_TO_U64(starting_slot, count);
     }
 
@@ -451,7 +479,7 @@ namespace eka2l1::drivers {
             total_chunk_size += chunk_size[i];
         }
 
-        std::uint8_t *data = new std::uint8_t[total_chunk_size];
+        std::uint8_t *data = list_.allocate_payload(total_chunk_size);
 
         for (int i = 0; i < chunk_count; i++) {
             std::copy(reinterpret_cast<const std::uint8_t *>(chunk_ptr[i]), reinterpret_cast<const std::uint8_t *>(chunk_ptr[i]) + chunk_size[i], data + cursor);
@@ -473,6 +501,8 @@ namespace eka2l1::drivers {
         cmd->data_[1] = reinterpret_cast<std::uint64_t>(ptr);
         cmd->data_[2] = offset;
         cmd->data_[3] = size;
+
+        list_.adopt_payload(reinterpret_cast<std::uint8_t *>(const_cast<void *>(ptr)));
     }
 
     void graphics_command_builder::set_viewport(const eka2l1::rect &viewport_rect) {
@@ -542,10 +572,10 @@ namespace eka2l1::drivers {
         cmd->opcode_ = graphics_driver_restore_state;
     }
 
-    void graphics_command_builder::present(int *status) {
+    void graphics_command_builder::present(command_fence *fence) {
         command *cmd = list_.retrieve_next();
         cmd->opcode_ = graphics_driver_display;
-        cmd->status_ = status;
+        cmd->status_ = fence;
     }
 
     void graphics_command_builder::destroy(drivers::handle h) {
@@ -627,8 +657,10 @@ namespace eka2l1::drivers {
     }
 
     void graphics_command_builder::draw_polygons(const eka2l1::point *point_list, const std::size_t point_count) {
-        eka2l1::point *point_list_copied = new eka2l1::point[point_count];
-        memcpy(point_list_copied, point_list, point_count * sizeof(eka2l1::point));
+        eka2l1::point *point_list_copied = reinterpret_cast<eka2l1::point *>(list_.allocate_payload(point_count * sizeof(eka2l1::point)));
+        if (point_list_copied) {
+            memcpy(point_list_copied, point_list, point_count * sizeof(eka2l1::point));
+        }
 
         command *cmd = list_.retrieve_next();
 
@@ -670,7 +702,7 @@ namespace eka2l1::drivers {
         cmd->opcode_ = graphics_driver_create_texture;
         cmd->data_[0] = dim | (static_cast<std::uint64_t>(mip_levels) << 8) | (static_cast<std::uint64_t>(internal_format) << 16)
             | (static_cast<std::uint64_t>(data_format) << 32) | (static_cast<std::uint64_t>(data_type) << 48);
-        cmd->data_[1] = make_data_copy(data, data_size);
+        cmd->data_[1] = make_data_copy(list_, data, data_size);
         cmd->data_[2] = data_size;
         cmd->data_[3] = pixels_per_line;
         cmd->data_[4] = static_cast<std::uint64_t>(unpack_alignment);
@@ -682,11 +714,11 @@ namespace eka2l1::drivers {
     void graphics_command_builder::recreate_buffer(drivers::handle h, const void *initial_data, const std::size_t initial_size, const buffer_upload_hint upload_hint) {
         command *cmd = list_.retrieve_next();
         cmd->opcode_ = graphics_driver_create_buffer;
-        cmd->data_[0] = make_data_copy(initial_data, initial_size);
+        cmd->data_[0] = make_data_copy(list_, initial_data, initial_size);
         cmd->data_[1] = initial_size;
         cmd->data_[2] = static_cast<std::uint64_t>(upload_hint);
         cmd->data_[3] = h;
-        cmd->data_[4] = reinterpret_cast<std::uint64_t>(&h);
+        cmd->data_[4] = 0;
     }
 
     void graphics_command_builder::set_color_mask(const std::uint8_t mask) {
@@ -707,10 +739,10 @@ namespace eka2l1::drivers {
         command *cmd = list_.retrieve_next();
         cmd->opcode_ = graphics_driver_create_input_descriptor;
     
-        cmd->data_[0] = make_data_copy(descriptors, count * sizeof(input_descriptor));
+        cmd->data_[0] = make_data_copy(list_, descriptors, count * sizeof(input_descriptor));
         cmd->data_[1] = count;
         cmd->data_[2] = h;
-        cmd->data_[3] = reinterpret_cast<std::uint64_t>(&h);
+        cmd->data_[3] = 0;
     }
 
     void graphics_command_builder::bind_input_descriptors(drivers::handle h) {
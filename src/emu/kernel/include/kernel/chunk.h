@@ -129,6 +129,14 @@ namespace eka2l1 {
             /*! \brief Destroy the chunk */
             int destroy() override;
 
+            /**
+             * \brief Serialize the chunk geometry and the content of every committed page.
+             *
+             * When reading, the chunk must have the same maximum size. Pages are committed and decommitted
+             * to match the saved chunk before their content is copied in.
+             */
+            void do_state(common::chunkyseri &seri) override;
+
             void open_to(process *own) override;
 
             /*! \brief Get the base of the chunk. */
@@ -110,8 +110,12 @@ namespace eka2l1::kernel {
 
             std::uint32_t flags = 0;
 
+            std::uint8_t *data_host_ptr = nullptr; ///< Host pointer to the static data of this attach.
+            std::uint32_t data_host_size = 0; ///< Size of the static data, aligned to page size.
+
             enum {
-                FLAG_EP_QUERIED = 1 << 0
+                FLAG_EP_QUERIED = 1 << 0,
+                FLAG_DATA_SHARED = 1 << 1 ///< Static data is mapped copy-on-write from the codeseg's data template.
             };
 
             explicit attached_info(kernel::codeseg *parentseg, kernel::process *pr, chunk_ptr dtc, chunk_ptr cc)
@@ -166,8 +170,17 @@ namespace eka2l1::kernel {
         bool ep_disabled_{ false };
         bool hash_inited_{ false };
 
+        // Relocated static data, shared copy-on-write by every attach that runs at the same addresses.
+        // Released by the destructor only.
+        std::intptr_t data_template_{ -1 };
+        address data_template_code_run_{ 0 };
+        address data_template_data_run_{ 0 };
+        bool data_template_tried_{ false };
+
         void calculate_hash();
 
+        bool can_share_static_data(const std::uint8_t *data_base_ptr, const std::uint32_t data_size_align);
+
     public:
         /*! \brief Create a new codeseg
          *
@@ -181,7 +194,7 @@ namespace eka2l1::kernel {
         explicit codeseg(kernel_system *kern, const std::string &name,
             codeseg_create_info &info);
 
-        virtual ~codeseg() {}
+        ~codeseg() override;
         int destroy() override;
 
         void queries_call_list(kernel::process *pr, std::vector<std::uint32_t> &call_list, const bool for_init = true);
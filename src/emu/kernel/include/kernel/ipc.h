@@ -29,6 +29,8 @@
 #include <memory>
 
 namespace eka2l1 {
+    class kernel_system;
+
     namespace kernel {
         class thread;
     }
@@ -99,6 +101,15 @@ namespace eka2l1 {
         ipc_message_type_wild
     };
 
+    // A message handle holds the message's slot number in the kernel pool, and a generation that changes each time
+    // the message is released. A handle kept past the release then no longer resolves, instead of reaching whoever
+    // holds the message next.
+    enum : std::uint32_t {
+        ipc_msg_handle_slot_bits = 16,
+        ipc_msg_handle_slot_mask = (1 << ipc_msg_handle_slot_bits) - 1,
+        ipc_msg_handle_generation_mask = 0x7FFF ///< Handles are passed to the guest as positive integers.
+    };
+
     /* An IPC msg (ver 2) contains the IPC context. */
     /* Function: The IPC function ordinal */
     /* Arg: IPC args. Max args = 4 */
@@ -123,12 +134,25 @@ namespace eka2l1 {
         common::double_linked_queue_element session_msg_link;
         common::double_linked_queue_element delivered_msg_link;
 
-        explicit ipc_msg(kernel::thread *own);
+        kernel_system *kern;
+
+        // Link in the kernel's free message list. Only valid when the message is on it.
+        ipc_msg *next_free;
+        bool on_free_list;
+
+        explicit ipc_msg(kernel_system *kern, kernel::thread *own);
         ~ipc_msg();
 
         void ref();
         void unref();
 
+        /**
+         * @brief Move the message's handle to the next generation, keeping its slot.
+         *
+         * Called when the message is released, or when it is reused without going through a pool.
+         */
+        void renew_id();
+
         bool is_free() {
             return (type == ipc_message_type_wild) && (ref_count <= 0);
         }
@@ -253,6 +253,15 @@ namespace eka2l1 {
      */
     using uid_of_process_change_callback = std::function<void(kernel::process *, kernel::process_uid_type)>;
 
+    struct ipc_msg_pool_stats {
+        std::uint32_t capacity_; ///< Maximum number of messages the kernel can hold.
+        std::uint32_t allocated_; ///< Number of message slots constructed so far. Slots are never released.
+        std::uint32_t in_use_; ///< Number of messages currently handed out, including session pool messages.
+        std::uint32_t high_water_mark_; ///< Highest number of messages handed out at once.
+        std::uint64_t total_allocs_; ///< Number of successful message allocations since boot.
+        std::uint64_t failed_allocs_; ///< Number of allocations that failed because the pool was exhausted.
+    };
+
     struct kernel_global_data {
         kernel::char_set char_set_;
 
@@ -267,6 +276,9 @@ namespace eka2l1 {
         friend class kernel::process;
 
         std::array<std::unique_ptr<ipc_msg>, 0x1000> msgs_;
+        std::uint32_t msg_count_;
+        ipc_msg *free_msg_head_;
+        ipc_msg_pool_stats msg_stats_;
         std::mutex kern_lock_;
 
         std::vector<kernel_obj_unq_ptr> threads_;
@@ -274,6 +286,7 @@ namespace eka2l1 {
         std::vector<kernel_obj_unq_ptr> servers_;
         std::vector<kernel_obj_unq_ptr> sessions_;
         std::vector<kernel_obj_unq_ptr> props_;
+        std::unordered_map<std::uint64_t, property_ptr> prop_lookup_; ///< Properties keyed by category and key.
         std::vector<kernel_obj_unq_ptr> prop_refs_;
         std::vector<kernel_obj_unq_ptr> chunks_;
         std::vector<kernel_obj_unq_ptr> mutexes_;
@@ -305,6 +318,7 @@ namespace eka2l1 {
         //! Handles for some globally shared processes
         kernel::object_ix kernel_handles_;
         int realtime_ipc_signal_evt_;
+        int hle_worker_done_evt_;
 
         mutable std::atomic<kernel::uid> uid_counter_;
         void *rom_map_;
@@ -419,13 +433,25 @@ namespace eka2l1 {
         void unschedule_wakeup();
         void prepare_reschedule();
 
+        /**
+         * @brief Take a message from the kernel pool.
+         *
+         * Freed messages are kept on a free list, and a new slot is only constructed when the list is empty,
+         * so this is constant time. The ID of a message is its slot index plus one, and never changes.
+         *
+         * @returns Nullptr if the pool is exhausted.
+         */
         ipc_msg_ptr create_msg(kernel::owner_type owner);
         ipc_msg_ptr get_msg(int handle);
 
+        /**
+         * @brief Give a message back to the kernel pool. Freeing a message already free is a no-op.
+         */
         void free_msg(ipc_msg_ptr msg);
 
-        /*! \brief Completely destroy a message. */
-        void destroy_msg(ipc_msg_ptr msg);
+        ipc_msg_pool_stats get_msg_pool_stats() const {
+            return msg_stats_;
+        }
 
         /* Fast duplication, unsafe */
         kernel::handle mirror(kernel::thread *own_thread, kernel::handle handle, kernel::owner_type owner);
@@ -454,8 +480,21 @@ namespace eka2l1 {
         bool subscribe_prop(prop_ident_pair ident, int *request_sts);
         bool unsubscribe_prop(prop_ident_pair ident);
 
+        /**
+         * @brief Create a property and make it findable by its category and key.
+         *
+         * @returns The existing property if one with the same category and key is already created.
+         */
+        property_ptr create_prop(const int category, const int key);
+
         property_ptr get_prop(int category, int key); // Get property by category and key
-        property_ptr delete_prop(int category, int key);
+
+        /**
+         * @brief Destroy a property, found by its category and key.
+         *
+         * @returns False if no such property exists.
+         */
+        bool delete_prop(int category, int key);
 
         void complete_undertakers(kernel::thread *literally_dies);
 
@@ -467,7 +506,16 @@ namespace eka2l1 {
             const std::uint32_t stack_size = 0);
 
         bool should_terminate();
-        void do_state(common::chunkyseri &seri);
+
+        /**
+         * \brief Serialize chunk memory and thread contexts.
+         *
+         * Reading is an in-place rewind: it only succeeds if the live chunks and threads are the same
+         * objects as the saved ones (compared by unique ID). Nothing is changed on mismatch.
+         *
+         * \returns False if the saved state does not match the live kernel objects.
+         */
+        bool do_state(common::chunkyseri &seri);
 
         codeseg_ptr pull_codeseg_by_uids(const kernel::uid uid0, const kernel::uid uid1,
             const kernel::uid uid2);
@@ -513,6 +561,10 @@ namespace eka2l1 {
             return realtime_ipc_signal_evt_;
         }
 
+        int get_hle_worker_done_event() const {
+            return hle_worker_done_evt_;
+        }
+
         ntimer *get_ntimer() {
             return timing_;
         }
@@ -124,6 +124,11 @@ namespace eka2l1::kernel {
         chunk_ptr make_bss_section_accordingly(const address addr);
     };
 
+    struct static_data_usage {
+        std::size_t private_bytes_; ///< Static data that only this process holds.
+        std::size_t shared_bytes_; ///< Static data still shared with other processes through the DLL's data template.
+    };
+
     class process : public kernel_obj {
         friend class eka2l1::kernel_system;
         friend class thread_scheduler;
@@ -329,6 +334,11 @@ namespace eka2l1::kernel {
             return process_handles.total_open();
         }
 
+        /**
+         * @brief Report how much of the static data of attached codesegs is private to this process.
+         */
+        static_data_usage get_static_data_usage();
+
         /**
          * \brief Check if the process's security satisfy the given security policy.
          * 
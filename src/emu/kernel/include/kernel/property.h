@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <common/linked.h>
 #include <common/queue.h>
 
 #include <kernel/kernel_obj.h>
@@ -27,7 +28,11 @@
 #include <utils/reqsts.h>
 
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 
 namespace eka2l1 {
@@ -44,6 +49,14 @@ namespace eka2l1 {
             unk
         };
 
+        struct property_reference;
+
+        struct property_stats {
+            std::uint64_t set_count_; ///< Number of time the value was set.
+            std::uint64_t get_count_; ///< Number of time the value was read.
+            std::uint64_t notify_count_; ///< Number of subscription requests completed because of a change.
+        };
+
         /*! \brief Property is a kind of environment data. 
 		 *
 		 * Property is defined by cagetory and key. Each property contains either
@@ -63,7 +76,14 @@ namespace eka2l1 {
 
             service::property_type data_type;
 
-            threadsafe_cn_queue<epoc::notify_info *> subscription_queue;
+            // Only references with a pending subscription are linked here, so a change never walks
+            // references that are not waiting for it.
+            common::roundabout subscribers_;
+            std::mutex subscribers_lock_;
+
+            std::atomic<std::uint64_t> set_count_;
+            std::atomic<std::uint64_t> get_count_;
+            std::atomic<std::uint64_t> notify_count_;
 
             using data_change_callback = std::pair<void *, data_change_callback_handler>;
             std::vector<data_change_callback> data_change_callbacks;
@@ -129,17 +149,21 @@ namespace eka2l1 {
                 return ret;
             }
 
-            void subscribe(epoc::notify_info &info);
-            bool cancel(const epoc::notify_info &info);
+            void subscribe(property_reference *ref);
+            bool cancel(property_reference *ref);
 
             /*! \brief Notify the request that there is data change */
             void notify_request(const std::int32_t err);
+
+            property_stats get_stats() const;
         };
 
         struct property_reference : public kernel::kernel_obj {
             property *prop_;
             epoc::notify_info nof_;
 
+            common::double_linked_queue_element subscribe_link_;
+
         public:
             explicit property_reference(kernel_system *kern, property *prop);
             ~property_reference() override;
@@ -25,7 +25,9 @@
 
 #include <utils/reqsts.h>
 
+#include <atomic>
 #include <functional>
+#include <mutex>
 #include <queue>
 #include <string>
 #include <unordered_map>
@@ -38,6 +40,12 @@
 
 namespace eka2l1 {
     class system;
+    class kernel_system;
+
+    namespace common {
+        class thread_pool;
+        class metric_counter;
+    }
 
     using session_ptr = service::session *;
 
@@ -92,6 +100,12 @@ namespace eka2l1 {
             /** All the sessions connected to this server */
             std::vector<session *> sessions;
             common::roundabout delivered_msgs;
+            std::mutex delivered_lock_;
+
+            std::unique_ptr<common::thread_pool> worker_;
+
+            std::mutex worker_results_lock_;
+            std::vector<std::function<void()>> worker_results_; ///< Work handed back by the worker, run on the kernel side.
 
             /** The thread own this server */
             //thread_ptr owning_thread;
@@ -100,6 +114,19 @@ namespace eka2l1 {
         protected:
             std::unordered_map<int, ipc_func> ipc_funcs;
 
+            /**
+             * Set by servers whose handlers only touch their own state and guest memory. When enabled in the config,
+             * messages of such server are processed on a host worker thread instead of the emulation thread.
+             */
+            bool thread_safe_ = false;
+
+            std::atomic<common::metric_counter *> hle_time_metric_{ nullptr };
+
+            /**
+             * Get the counter of host time spent processing HLE messages, shared by all servers.
+             */
+            common::metric_counter *hle_time_metric();
+
         private:
             eka2l1::ptr<epoc::request_status> request_status = 0;
             eka2l1::ptr<message2> request_data;
@@ -151,6 +178,45 @@ namespace eka2l1 {
 
             virtual void process_accepted_msg();
 
+            /**
+             * @brief Process the message that was just delivered to this HLE server.
+             *
+             * If the server runs on a worker, the message is handed off to it and this returns immediately. The client
+             * keeps waiting on its request status, which the worker hands back to be completed on the kernel side.
+             */
+            void dispatch_accepted_msg();
+
+            /**
+             * @brief Wait for the worker to process every pending message, and run what it handed back.
+             *
+             * Called on the kernel side. The worker never takes the kernel lock, so this may be called with it held.
+             */
+            void flush_worker();
+
+            /**
+             * @brief Run the request completions and message releases that the worker handed back.
+             *
+             * Called on the kernel side, with the kernel lock held.
+             */
+            void finish_worker_msgs();
+
+            /**
+             * @brief Hand work that touches kernel state, such as a request completion, back to the kernel side.
+             *
+             * Called on the worker. The work runs on the timing thread under the kernel lock, or earlier if the
+             * kernel side flushes the worker first.
+             */
+            void post_to_kernel(std::function<void()> work);
+
+            bool has_worker() const {
+                return worker_ != nullptr;
+            }
+
+            /**
+             * @brief Get the server whose worker is running on this thread, or nullptr on any other thread.
+             */
+            static server *current_worker();
+
             virtual service::uid get_owner_secure_uid() const {
                 return 0xDEADC11E;
             }
@@ -52,7 +52,8 @@ namespace eka2l1 {
 
             server_ptr svr;
 
-            std::vector<std::pair<bool, ipc_msg_ptr>> msgs_pool;
+            std::vector<ipc_msg_ptr> msgs_pool;
+            std::vector<ipc_msg_ptr> free_msgs_; ///< Stack of pool messages not in flight.
             ipc_msg_ptr disconnect_msg_;
 
             common::roundabout in_progress_msgs_;
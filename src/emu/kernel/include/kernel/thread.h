@@ -321,6 +321,13 @@ namespace eka2l1 {
             void do_cleanup();
             int destroy() override;
 
+            /**
+             * \brief Serialize the CPU context of the thread.
+             *
+             * Scheduling and wait state are not included, they are owned by the kernel objects the thread waits on.
+             */
+            void do_state(common::chunkyseri &seri) override;
+
             chunk_ptr get_stack_chunk();
 
             std::optional<tls_slot> get_tls_slot_no_uid(const std::uint32_t handle);
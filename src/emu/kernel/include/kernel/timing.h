@@ -161,6 +161,14 @@ namespace eka2l1 {
         realtime_level get_realtime_level() const {
             return acc_level_;
         }
+
+        /**
+         * @brief Serialize the guest time and the pending events, with their event type names.
+         *
+         * The host clock can not go backwards, so nothing is applied when reading. The data is kept for
+         * inspection of a saved state.
+         */
+        void do_state(common::chunkyseri &seri);
     };
 
     realtime_level get_realtime_level_from_string(const char *c);
@@ -243,5 +243,74 @@ namespace eka2l1 {
         void *chunk::host_base() {
             return mmc_impl_->host_base();
         }
+
+        void chunk::do_state(common::chunkyseri &seri) {
+            kernel_obj::do_state(seri);
+
+            auto s = seri.section("Chunk", 1);
+
+            if (!s) {
+                return;
+            }
+
+            const std::uint32_t page_size = static_cast<std::uint32_t>(mem->get_page_size());
+
+            std::uint32_t bottom = bottom_offset();
+            std::uint32_t top = top_offset();
+            std::uint64_t max = max_size();
+
+            seri.absorb(bottom);
+            seri.absorb(top);
+            seri.absorb(max);
+
+            const bool reading = (seri.get_seri_mode() == common::SERI_MODE_READ);
+            const bool geometry_match = !reading || (max == max_size());
+
+            if (!geometry_match) {
+                LOG_ERROR(KERNEL, "Saved state of chunk {} has a different size, ignored", obj_name);
+            }
+
+            const std::uint32_t page_count = static_cast<std::uint32_t>((max + page_size - 1) / page_size);
+
+            // One byte per page, telling if the page is committed
+            std::vector<std::uint8_t> page_committed(page_count, 0);
+
+            if (!reading) {
+                for (std::uint32_t i = 0; i < page_count; i++) {
+                    page_committed[i] = mmc_impl_->is_page_committed(i) ? 1 : 0;
+                }
+            }
+
+            seri.absorb_container(page_committed);
+
+            if (page_committed.size() != page_count) {
+                return;
+            }
+
+            if (reading && geometry_match) {
+                if (type == chunk_type::disconnected) {
+                    for (std::uint32_t i = 0; i < page_count; i++) {
+                        const bool committed_now = mmc_impl_->is_page_committed(i);
+
+                        if (page_committed[i] && !committed_now) {
+                            commit(i * page_size, page_size);
+                        } else if (!page_committed[i] && committed_now) {
+                            decommit(i * page_size, page_size);
+                        }
+                    }
+                } else {
+                    mmc_impl_->adjust((type == chunk_type::double_ended) ? bottom : 0xFFFFFFFF, top);
+                }
+            }
+
+            // Page data of a mismatched chunk is skipped
+            std::uint8_t *base_ptr = geometry_match ? reinterpret_cast<std::uint8_t *>(mmc_impl_->host_base()) : nullptr;
+
+            for (std::uint32_t i = 0; i < page_count; i++) {
+                if (page_committed[i]) {
+                    seri.absorb_impl(base_ptr ? base_ptr + i * page_size : nullptr, page_size);
+                }
+            }
+        }
     }
 }
@@ -20,6 +20,7 @@
 
 #include <common/algorithm.h>
 #include <common/log.h>
+#include <common/virtualmem.h>
 #include <kernel/codeseg.h>
 #include <kernel/kernel.h>
 #include <loader/common.h>
@@ -70,6 +71,10 @@ namespace eka2l1::kernel {
         relocation_list = info.relocation_list;
     }
 
+    codeseg::~codeseg() {
+        common::destroy_cow_template(data_template_);
+    }
+
     int codeseg::destroy() {
         if (code_chunk_shared) {
             kern->destroy(code_chunk_shared);
@@ -78,6 +83,14 @@ namespace eka2l1::kernel {
         return 0;
     }
 
+    bool codeseg::can_share_static_data(const std::uint8_t *data_base_ptr, const std::uint32_t data_size_align) {
+        // The host maps with its own page granularity, which must line up with the guest's
+        const std::size_t host_page_size = static_cast<std::size_t>(common::get_host_page_size());
+
+        return (data_size_align != 0) && ((reinterpret_cast<std::uintptr_t>(data_base_ptr) % host_page_size) == 0)
+            && ((data_size_align % host_page_size) == 0);
+    }
+
     bool codeseg::eligible_for_codeseg_reuse() {
         mark = true;
 
@@ -141,6 +154,7 @@ namespace eka2l1::kernel {
 
         bool code_chunk_for_reuse = eligible_for_codeseg_reuse();
         bool need_patch_and_reloc = true;
+        bool data_shared = false;
 
         unmark();
 
@@ -208,11 +222,20 @@ namespace eka2l1::kernel {
             data_base_ptr = reinterpret_cast<std::uint8_t *>(dt_chunk->host_base()) + add_offset;
             the_addr_of_data_run = dt_chunk->base(new_foe).ptr_address() + add_offset;
 
-            // Confirmed that if data is in ROM, only BSS is reserved
-            std::copy(constant_data.get(), constant_data.get() + data_size, data_base_ptr); // .data
+            // Relocated data only depends on where code and data run, so an attach at the same addresses
+            // can map the image made by the first one instead of copying and relocating again
+            if ((data_template_ != -1) && new_foe && (the_addr_of_code_run == data_template_code_run_)
+                && (the_addr_of_data_run == data_template_data_run_) && can_share_static_data(data_base_ptr, data_size_align)) {
+                data_shared = common::map_cow_template(data_template_, data_base_ptr, data_size_align, prot_read_write);
+            }
+
+            if (!data_shared) {
+                // Confirmed that if data is in ROM, only BSS is reserved
+                std::copy(constant_data.get(), constant_data.get() + data_size, data_base_ptr); // .data
 
-            const std::uint32_t bss_off = data_size;
-            std::fill(data_base_ptr + bss_off, data_base_ptr + bss_off + bss_size, 0); // .bss
+                const std::uint32_t bss_off = data_size;
+                std::fill(data_base_ptr + bss_off, data_base_ptr + bss_off + bss_size, 0); // .bss
+            }
         } else {
             the_addr_of_data_run = data_addr;
             data_base_ptr = reinterpret_cast<std::uint8_t *>(kern->get_memory_system()->get_real_pointer(data_addr));
@@ -223,6 +246,13 @@ namespace eka2l1::kernel {
 
         attaches.emplace_back(std::make_unique<attached_info>(this, new_foe, dt_chunk, code_chunk));
 
+        attached_info *new_attach = attaches.back().get();
+
+        if (dt_chunk) {
+            new_attach->data_host_ptr = data_base_ptr;
+            new_attach->data_host_size = static_cast<std::uint32_t>(data_size_align);
+        }
+
         // Attach all of its dependencies
         for (auto &dependency : dependencies) {
             dependency.dep_->attach(new_foe);
@@ -274,6 +304,11 @@ namespace eka2l1::kernel {
                         break;
                     }
 
+                    if (data_shared && (sect_type == loader::relocate_section_data)) {
+                        // Already relocated in the template
+                        continue;
+                    }
+
                     std::uint32_t *to_relocate_ptr = reinterpret_cast<std::uint32_t *>(&base_ptr[offset_to_relocate]);
 
                     switch (rel_type) {
@@ -313,8 +348,25 @@ namespace eka2l1::kernel {
             }
         }
 
+        if (dt_chunk && new_foe && !data_shared && !data_template_tried_ && can_share_static_data(data_base_ptr, data_size_align)) {
+            // First attach, make the image from what was just relocated and share it too
+            data_template_tried_ = true;
+            data_template_ = common::create_cow_template(data_base_ptr, data_size_align);
+
+            if (data_template_ != -1) {
+                data_template_code_run_ = the_addr_of_code_run;
+                data_template_data_run_ = the_addr_of_data_run;
+
+                data_shared = common::map_cow_template(data_template_, data_base_ptr, data_size_align, prot_read_write);
+            }
+        }
+
+        if (data_shared) {
+            new_attach->flags |= attached_info::FLAG_DATA_SHARED;
+        }
+
         if (new_foe)
-            new_foe->codeseg_list.push(&attaches.back()->process_link);
+            new_foe->codeseg_list.push(&new_attach->process_link);
 
         kern->run_codeseg_loaded_callback(obj_name, new_foe, this);
 
@@ -343,6 +395,11 @@ namespace eka2l1::kernel {
                     const std::uint32_t offset = data_base - attach_info->data_chunk->base(de_foe).ptr_address();
                     const auto data_size_align = common::align(data_size + bss_size, mem->get_page_size());
 
+                    if (attach_info->flags & attached_info::FLAG_DATA_SHARED) {
+                        // Pages committed here later must not show the template through
+                        common::unmap_cow_template(attach_info->data_host_ptr, attach_info->data_host_size);
+                    }
+
                     attach_info->data_chunk->decommit(offset, data_size_align);
                 }
             }
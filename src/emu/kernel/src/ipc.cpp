@@ -19,6 +19,7 @@
  */
 
 #include <kernel/ipc.h>
+#include <kernel/kernel.h>
 #include <kernel/session.h>
 
 namespace eka2l1 {
@@ -54,7 +55,7 @@ namespace eka2l1 {
         return static_cast<ipc_arg_type>((flag >> (slot * 3)) & 7);
     }
 
-    ipc_msg::ipc_msg(kernel::thread *own)
+    ipc_msg::ipc_msg(kernel_system *kern, kernel::thread *own)
         : own_thr(own)
         , function(0)
         , msg_session(nullptr)
@@ -64,10 +65,16 @@ namespace eka2l1 {
         , id(0)
         , thread_handle_low(0)
         , ref_count(0)
-        , type(ipc_message_type_wild) {
+        , type(ipc_message_type_wild)
+        , kern(kern)
+        , next_free(nullptr)
+        , on_free_list(false) {
     }
 
     ipc_msg::~ipc_msg() {
+        // The pool is being torn down, nothing to give the message back to
+        kern = nullptr;
+
         if (ref_count != 0) {
             ref_count = 1;
             unref();
@@ -84,6 +91,11 @@ namespace eka2l1 {
         ref_count++;
     }
 
+    void ipc_msg::renew_id() {
+        const std::uint32_t generation = ((id >> ipc_msg_handle_slot_bits) + 1) & ipc_msg_handle_generation_mask;
+        id = (generation << ipc_msg_handle_slot_bits) | (id & ipc_msg_handle_slot_mask);
+    }
+
     void ipc_msg::unref() {
         if (--ref_count == 0) {
             if (msg_session) {
@@ -110,6 +122,10 @@ namespace eka2l1 {
             }
 
             msg_session = nullptr;
+
+            if (kern && (type == ipc_message_type_wild)) {
+                kern->free_msg(this);
+            }
         }
     }
 }
\ No newline at end of file
@@ -63,7 +63,10 @@ namespace eka2l1 {
 
     kernel_system::kernel_system(system *esys, ntimer *timing, io_system *io_sys,
         config::state *old_conf, config::app_settings *settings, loader::rom *rom_info, arm::core *cpu, disasm *disassembler)
-        : btrace_inst_(nullptr)
+        : msg_count_(0)
+        , free_msg_head_(nullptr)
+        , msg_stats_()
+        , btrace_inst_(nullptr)
         , lib_mngr_(nullptr)
         , thr_sch_(nullptr)
         , timing_(timing)
@@ -76,6 +79,7 @@ namespace eka2l1 {
         , rom_info_(rom_info)
         , kernel_handles_(this, kernel::handle_array_owner::kernel)
         , realtime_ipc_signal_evt_(0)
+        , hle_worker_done_evt_(0)
         , uid_counter_(0)
         , rom_map_(nullptr)
         , kern_ver_(epocver::epoc94)
@@ -89,6 +93,7 @@ namespace eka2l1 {
         , nanokern_pr_(nullptr)
         , custom_code_chunk(nullptr)
         , wiping_(false) {
+        msg_stats_.capacity_ = static_cast<std::uint32_t>(msgs_.size());
         reset();
     }
 
@@ -99,6 +104,7 @@ namespace eka2l1 {
     void kernel_system::wipeout() {
         wiping_ = true;
         timing_->remove_event(realtime_ipc_signal_evt_);
+        timing_->remove_event(hle_worker_done_evt_);
 
         if (rom_map_) {
             common::unmap_file(rom_map_);
@@ -123,6 +129,7 @@ namespace eka2l1 {
         OBJECT_CONTAINER_CLEANUP(undertakers_);
         OBJECT_CONTAINER_CLEANUP(prop_refs_);
         OBJECT_CONTAINER_CLEANUP(props_);
+        prop_lookup_.clear();
         OBJECT_CONTAINER_CLEANUP(chunks_);
         OBJECT_CONTAINER_CLEANUP(threads_);
         OBJECT_CONTAINER_CLEANUP(processes_);
@@ -157,6 +164,22 @@ namespace eka2l1 {
             unlock();
         });
 
+        // Run what an HLE server worker handed back to the kernel side
+        hle_worker_done_evt_ = timing_->register_event("HleWorkerDone", [this](std::uint64_t userdata, std::uint64_t cycles_late) {
+            const kernel::uid server_uid = static_cast<kernel::uid>(userdata);
+
+            lock();
+
+            service::server *svr = get_by_id<service::server>(server_uid);
+
+            // The server may have been destroyed since, and its results already run
+            if (svr && (svr->unique_id() == server_uid)) {
+                svr->finish_worker_msgs();
+            }
+
+            unlock();
+        });
+
         // Get base time
         base_time_ = common::get_current_utc_time_in_microseconds_since_0ad();
         utc_offset_ = common::get_current_utc_offset();
@@ -705,30 +728,60 @@ namespace eka2l1 {
     }
 
     ipc_msg_ptr kernel_system::create_msg(kernel::owner_type owner) {
-        auto slot_free = std::find_if(msgs_.begin(), msgs_.end(),
-            [](auto &slot) { return !slot || slot->is_free(); });
+        static_assert(std::tuple_size<decltype(msgs_)>::value <= ipc_msg_handle_slot_mask,
+            "Message slots must fit in the handle");
+
+        ipc_msg_ptr msg = free_msg_head_;
 
-        if (slot_free != msgs_.end()) {
-            if (!*slot_free) {
-                std::unique_ptr<ipc_msg> msg = std::make_unique<ipc_msg>(crr_thread());
-                *slot_free = std::move(msg);
+        if (msg) {
+            free_msg_head_ = msg->next_free;
+
+            msg->next_free = nullptr;
+            msg->on_free_list = false;
+        } else {
+            if (msg_count_ >= msgs_.size()) {
+                msg_stats_.failed_allocs_++;
+                LOG_ERROR(KERNEL, "IPC message pool exhausted ({} messages in use)", msg_stats_.in_use_);
+
+                return nullptr;
             }
 
-            slot_free->get()->own_thr = crr_thread();
-            slot_free->get()->id = static_cast<std::uint32_t>(slot_free - msgs_.begin()) + 1;
+            msgs_[msg_count_] = std::make_unique<ipc_msg>(this, crr_thread());
 
-            return slot_free->get();
+            msg = msgs_[msg_count_].get();
+            msg->id = ++msg_count_;
+
+            msg_stats_.allocated_ = msg_count_;
         }
 
-        return nullptr;
+        msg->own_thr = crr_thread();
+
+        msg_stats_.total_allocs_++;
+        msg_stats_.in_use_++;
+        msg_stats_.high_water_mark_ = common::max(msg_stats_.high_water_mark_, msg_stats_.in_use_);
+
+        return msg;
     }
 
     ipc_msg_ptr kernel_system::get_msg(int handle) {
-        if ((msgs_.size() < handle) || (handle <= 0)) {
+        const std::uint32_t slot = static_cast<std::uint32_t>(handle) & ipc_msg_handle_slot_mask;
+
+        if ((handle <= 0) || (slot == 0) || (slot > msg_count_)) {
+            return nullptr;
+        }
+
+        ipc_msg_ptr msg = msgs_[slot - 1].get();
+
+        // The handle is from an earlier use of the message
+        if ((msg->id != static_cast<std::uint32_t>(handle)) || msg->on_free_list) {
             return nullptr;
         }
 
-        return msgs_[handle - 1].get();
+        return msg;
+    }
+
+    static std::uint64_t make_prop_lookup_key(const int category, const int key) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(category)) << 32) | static_cast<std::uint32_t>(key);
     }
 
     bool kernel_system::destroy(kernel_obj_ptr obj) {
@@ -736,6 +789,16 @@ namespace eka2l1 {
             return true;
         }
 
+        if (obj->get_object_type() == kernel::object_type::prop) {
+            // The lookup must not keep pointing to a property that is about to be freed
+            property_ptr prop = reinterpret_cast<property_ptr>(obj);
+            auto lookup_res = prop_lookup_.find(make_prop_lookup_key(prop->first, prop->second));
+
+            if ((lookup_res != prop_lookup_.end()) && (lookup_res->second == prop)) {
+                prop_lookup_.erase(lookup_res);
+            }
+        }
+
         switch (obj->get_object_type()) {
 #define OBJECT_SEARCH(obj_type, obj_map)                                                                         \
     case kernel::object_type::obj_type: {                                                                        \
@@ -943,50 +1006,68 @@ namespace eka2l1 {
     void kernel_system::free_msg(ipc_msg_ptr msg) {
         msg->type = ipc_message_type_wild;
         msg->ref_count = 0;
+
+        if (msg->on_free_list) {
+            return;
+        }
+
+        msg->next_free = free_msg_head_;
+        msg->on_free_list = true;
+        msg->renew_id();
+
+        free_msg_head_ = msg;
+        msg_stats_.in_use_--;
     }
 
-    /*! \brief Completely destroy a message. */
-    void kernel_system::destroy_msg(ipc_msg_ptr msg) {
-        (msgs_.begin() + msg->id - 1)->reset();
+    property_ptr kernel_system::create_prop(const int category, const int key) {
+        const std::uint64_t lookup_key = make_prop_lookup_key(category, key);
+        auto prop_res = prop_lookup_.find(lookup_key);
+
+        if (prop_res != prop_lookup_.end()) {
+            return prop_res->second;
+        }
+
+        property_ptr prop = create<service::property>();
+
+        if (!prop) {
+            return nullptr;
+        }
+
+        prop->first = category;
+        prop->second = key;
+
+        prop_lookup_.emplace(lookup_key, prop);
+        return prop;
     }
 
     property_ptr kernel_system::get_prop(int category, int key) {
-        auto prop_res = std::find_if(props_.begin(), props_.end(),
-            [=](const auto &prop_obj) {
-                property_ptr prop = reinterpret_cast<property_ptr>(prop_obj.get());
-                if (prop->first == category && prop->second == key) {
-                    return true;
-                }
-
-                return false;
-            });
+        auto prop_res = prop_lookup_.find(make_prop_lookup_key(category, key));
 
-        if (prop_res == props_.end()) {
+        if (prop_res == prop_lookup_.end()) {
             return property_ptr(nullptr);
         }
 
-        return reinterpret_cast<property_ptr>(prop_res->get());
+        return prop_res->second;
     }
 
-    property_ptr kernel_system::delete_prop(int category, int key) {
-        auto prop_res = std::find_if(props_.begin(), props_.end(),
-            [=](const auto &prop_obj) {
-                property_ptr prop = reinterpret_cast<property_ptr>(prop_obj.get());
-                if (prop->first == category && prop->second == key) {
-                    return true;
-                }
+    bool kernel_system::delete_prop(int category, int key) {
+        auto lookup_res = prop_lookup_.find(make_prop_lookup_key(category, key));
 
-                return false;
-            });
-
-        if (prop_res == props_.end()) {
-            return property_ptr(nullptr);
+        if (lookup_res == prop_lookup_.end()) {
+            return false;
         }
 
-        property_ptr prop_ptr = reinterpret_cast<property_ptr>(prop_res->get());
-        props_.erase(prop_res);
+        property_ptr prop = lookup_res->second;
+        prop_lookup_.erase(lookup_res);
+
+        auto prop_res = std::find_if(props_.begin(), props_.end(),
+            [=](const auto &prop_obj) { return prop_obj.get() == prop; });
+
+        if (prop_res != props_.end()) {
+            props_.erase(prop_res);
+        }
 
-        return prop_ptr;
+        return true;
     }
 
     kernel::handle kernel_system::mirror(kernel::thread *own_thread, kernel::handle handle, kernel::owner_type owner) {
@@ -1334,12 +1415,56 @@ namespace eka2l1 {
         kernel_info() {}
     };
 
-    void kernel_system::do_state(common::chunkyseri &seri) {
+    static std::vector<kernel::uid> get_object_uids(std::vector<kernel_obj_unq_ptr> &objects) {
+        std::vector<kernel::uid> uids;
+        uids.reserve(objects.size());
+
+        for (auto &obj : objects) {
+            uids.push_back(obj->unique_id());
+        }
+
+        return uids;
+    }
+
+    bool kernel_system::do_state(common::chunkyseri &seri) {
         auto s = seri.section("Kernel", 1);
 
         if (!s) {
-            return;
+            return false;
+        }
+
+        const bool reading = (seri.get_seri_mode() == common::SERI_MODE_READ);
+        kernel::thread *running = crr_thread();
+
+        if (!reading && running) {
+            // Context of the running thread is only up-to-date in the CPU
+            cpu_->save_context(running->get_thread_context());
         }
+
+        std::vector<kernel::uid> chunk_uids = get_object_uids(chunks_);
+        std::vector<kernel::uid> thread_uids = get_object_uids(threads_);
+
+        seri.absorb_container(chunk_uids);
+        seri.absorb_container(thread_uids);
+
+        if (reading && ((chunk_uids != get_object_uids(chunks_)) || (thread_uids != get_object_uids(threads_)))) {
+            LOG_ERROR(KERNEL, "Saved state has different chunks or threads than the running kernel, can't restore");
+            return false;
+        }
+
+        for (auto &chunk : chunks_) {
+            chunk->do_state(seri);
+        }
+
+        for (auto &thr : threads_) {
+            thr->do_state(seri);
+        }
+
+        if (reading && running) {
+            cpu_->load_context(running->get_thread_context());
+        }
+
+        return true;
     }
 
     std::uint64_t kernel_system::universal_time() {
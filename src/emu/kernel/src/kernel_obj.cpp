@@ -50,11 +50,24 @@ namespace eka2l1 {
                 return;
             }
 
-            seri.absorb(obj_name);
-            seri.absorb(uid);
-            seri.absorb(obj_type);
-            seri.absorb(access);
-            seri.absorb(access_count);
+            // The layout is kept for every object type, but on load only the identity is checked. The access
+            // type and count belong to the handle tables that reference this object, which are live and not
+            // part of the saved state, so they are read and dropped.
+            std::string saved_name = obj_name;
+            kernel::uid saved_uid = uid;
+            object_type saved_type = obj_type;
+            kernel::access_type saved_access = access;
+            int saved_access_count = access_count;
+
+            seri.absorb(saved_name);
+            seri.absorb(saved_uid);
+            seri.absorb(saved_type);
+            seri.absorb(saved_access);
+            seri.absorb(saved_access_count);
+
+            if ((seri.get_seri_mode() == common::SERI_MODE_READ) && ((saved_uid != uid) || (saved_type != obj_type))) {
+                LOG_ERROR(KERNEL, "Saved state of object {} belongs to another object (uid {})", obj_name, saved_uid);
+            }
         }
 
         void kernel_obj::full_name(std::string &name_will_full) {
@@ -18,10 +18,12 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/algorithm.h>
 #include <common/chunkyseri.h>
 #include <common/cvt.h>
 #include <common/log.h>
 #include <common/path.h>
+#include <common/virtualmem.h>
 #include <config/app_settings.h>
 
 #include <kernel/kernel.h>
@@ -470,6 +472,38 @@ namespace eka2l1::kernel {
         decrease_access_count();
     }
 
+    static_data_usage process::get_static_data_usage() {
+        static_data_usage usage{ 0, 0 };
+
+        common::double_linked_queue_element *elem = codeseg_list.first();
+        common::double_linked_queue_element *end = codeseg_list.end();
+
+        do {
+            if (!elem) {
+                break;
+            }
+
+            kernel::codeseg::attached_info *info = E_LOFF(elem, kernel::codeseg::attached_info, process_link);
+
+            if (info->data_host_ptr) {
+                std::size_t private_size = info->data_host_size;
+
+                if (info->flags & kernel::codeseg::attached_info::FLAG_DATA_SHARED) {
+                    // Only pages the process wrote to got their own copy
+                    private_size = common::min<std::size_t>(info->data_host_size,
+                        common::get_cow_private_size(info->data_host_ptr, info->data_host_size));
+                }
+
+                usage.private_bytes_ += private_size;
+                usage.shared_bytes_ += info->data_host_size - private_size;
+            }
+
+            elem = elem->next;
+        } while (elem != end);
+
+        return usage;
+    }
+
     void *process::get_ptr_on_addr_space(address addr) {
         return mem->get_control()->get_host_pointer(mm_impl_->address_space_id(), addr);
     }
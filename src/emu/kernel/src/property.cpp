@@ -30,7 +30,10 @@ namespace eka2l1 {
         property::property(kernel_system *kern)
             : kernel::kernel_obj(kern, "", nullptr, kernel::access_type::global_access)
             , data_len(0)
-            , data_type(service::property_type::unk) {
+            , data_type(service::property_type::unk)
+            , set_count_(0)
+            , get_count_(0)
+            , notify_count_(0) {
             obj_type = kernel::object_type::prop;
             bindata.reserve(512);
 
@@ -66,6 +69,8 @@ namespace eka2l1 {
         bool property::set_int(int val) {
             if (data_type == service::property_type::int_data) {
                 ndata = val;
+                set_count_++;
+
                 notify_request(epoc::error_none);
 
                 fire_data_change_callbacks();
@@ -83,6 +88,7 @@ namespace eka2l1 {
 
             memcpy(bindata.data(), bdata, arr_length);
             data_len = arr_length;
+            set_count_++;
 
             notify_request(epoc::error_none);
             fire_data_change_callbacks();
@@ -95,43 +101,60 @@ namespace eka2l1 {
                 return -1;
             }
 
+            get_count_++;
             return ndata;
         }
 
         std::vector<uint8_t> property::get_bin() {
             std::vector<uint8_t> local;
             local.resize(data_len);
+            get_count_++;
 
             memcpy(local.data(), bindata.data(), data_len);
 
             return local;
         }
 
-        void property::subscribe(epoc::notify_info &info) {
-            subscription_queue.push(&info);
+        void property::subscribe(property_reference *ref) {
+            const std::lock_guard<std::mutex> guard(subscribers_lock_);
+            subscribers_.push(&ref->subscribe_link_);
         }
 
-        bool property::cancel(const epoc::notify_info &info) {
-            // Find the subscription
-            auto subscription_iterator = std::find(subscription_queue.begin(), subscription_queue.end(),
-                &info);
+        bool property::cancel(property_reference *ref) {
+            const std::lock_guard<std::mutex> guard(subscribers_lock_);
 
-            if (subscription_iterator == subscription_queue.end()) {
+            // Not linked means there is no pending subscription
+            if (!ref->subscribe_link_.next) {
                 return false;
             }
 
-            (*subscription_iterator)->complete(epoc::error_cancel);
-            subscription_queue.erase(subscription_iterator);
+            ref->subscribe_link_.deque();
+            ref->nof_.complete(epoc::error_cancel);
 
             return true;
         }
 
         void property::notify_request(const std::int32_t err) {
-            while (auto subscription = subscription_queue.pop()) {
-                subscription.value()->complete(err);
+            const std::lock_guard<std::mutex> guard(subscribers_lock_);
+
+            while (!subscribers_.empty()) {
+                property_reference *ref = E_LOFF(subscribers_.first()->deque(), property_reference, subscribe_link_);
+                ref->nof_.complete(err);
+
+                notify_count_++;
             }
         }
 
+        property_stats property::get_stats() const {
+            property_stats stats;
+
+            stats.set_count_ = set_count_.load();
+            stats.get_count_ = get_count_.load();
+            stats.notify_count_ = notify_count_.load();
+
+            return stats;
+        }
+
         property_reference::property_reference(kernel_system *kern, property *prop)
             : kernel::kernel_obj(kern, "", prop)
             , prop_(prop) {
@@ -148,13 +171,13 @@ namespace eka2l1 {
             }
 
             nof_ = info;
-            prop_->subscribe(nof_);
+            prop_->subscribe(this);
 
             return true;
         }
 
         bool property_reference::cancel() {
-            return prop_->cancel(nof_);
+            return prop_->cancel(this);
         }
     }
 }
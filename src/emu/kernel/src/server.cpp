@@ -19,6 +19,7 @@
  */
 
 #include <common/log.h>
+#include <common/threadpool.h>
 #include <utils/err.h>
 
 #include <kernel/kernel.h>
@@ -28,6 +29,8 @@
 #include <config/config.h>
 
 namespace eka2l1::service {
+    static thread_local server *current_worker_server = nullptr;
+
     server::~server() {
     }
 
@@ -51,6 +54,8 @@ namespace eka2l1::service {
     void server::receive(ipc_msg_ptr &msg) {
         msg = nullptr;
 
+        const std::lock_guard<std::mutex> guard(delivered_lock_);
+
         if (!delivered_msgs.empty()) {
             common::double_linked_queue_element *deliver_first = delivered_msgs.first();
             msg = E_LOFF(deliver_first, ipc_msg, delivered_msg_link);
@@ -68,6 +73,8 @@ namespace eka2l1::service {
         if (ready()) {
             accept(msg, true);
         } else {
+            const std::lock_guard<std::mutex> guard(delivered_lock_);
+
             msg->msg_status = ipc_message_status::delivered;
             delivered_msgs.push(&msg->delivered_msg_link);
         }
@@ -86,7 +93,75 @@ namespace eka2l1::service {
         }
     }
 
+    server *server::current_worker() {
+        return current_worker_server;
+    }
+
+    void server::dispatch_accepted_msg() {
+        if (!worker_ && thread_safe_ && kern->get_config()->hle_server_threads) {
+            worker_ = std::make_unique<common::thread_pool>(obj_name, 1);
+        }
+
+        if (!worker_) {
+            process_accepted_msg();
+            return;
+        }
+
+        // One message was delivered, one is processed. A single worker keeps them in order.
+        worker_->enqueue([this]() {
+            current_worker_server = this;
+            process_accepted_msg();
+            current_worker_server = nullptr;
+        });
+    }
+
+    void server::flush_worker() {
+        if (worker_) {
+            worker_->submit([]() {}).wait();
+        }
+
+        finish_worker_msgs();
+    }
+
+    void server::post_to_kernel(std::function<void()> work) {
+        bool first_result = false;
+
+        {
+            const std::lock_guard<std::mutex> guard(worker_results_lock_);
+
+            first_result = worker_results_.empty();
+            worker_results_.push_back(std::move(work));
+        }
+
+        // One wake-up runs every result queued until then
+        if (first_result) {
+            kern->get_ntimer()->schedule_event(0, kern->get_hle_worker_done_event(), unique_id());
+        }
+    }
+
+    void server::finish_worker_msgs() {
+        std::vector<std::function<void()>> results;
+
+        {
+            const std::lock_guard<std::mutex> guard(worker_results_lock_);
+
+            if (worker_results_.empty()) {
+                return;
+            }
+
+            results.swap(worker_results_);
+        }
+
+        for (auto &result : results) {
+            result();
+        }
+    }
+
     int server::destroy() {
+        // Let pending messages finish while the server is still whole
+        worker_.reset();
+        finish_worker_msgs();
+
         if (owner_thread)
             owner_thread->decrease_access_count();
 
@@ -39,10 +39,13 @@ namespace eka2l1 {
 
             if (async_slot_count > 0) {
                 msgs_pool.resize(async_slot_count);
+                free_msgs_.reserve(async_slot_count);
 
                 for (auto &msg : msgs_pool) {
-                    msg = std::make_pair(true, kern->create_msg(kernel::owner_type::process));
-                    msg.second->type = ipc_message_type_session;
+                    msg = kern->create_msg(kernel::owner_type::process);
+                    msg->type = ipc_message_type_session;
+
+                    free_msgs_.push_back(msg);
                 }
             }
 
@@ -88,24 +91,20 @@ namespace eka2l1 {
                 return kern->create_msg(kernel::owner_type::process);
             }
 
-            auto free_msg_in_pool = std::find_if(msgs_pool.begin(), msgs_pool.end(),
-                [](const auto &msg) { return msg.first; });
-
-            if (free_msg_in_pool != msgs_pool.end()) {
-                free_msg_in_pool->first = false;
-                return free_msg_in_pool->second;
+            if (free_msgs_.empty()) {
+                return ipc_msg_ptr(nullptr);
             }
 
-            return ipc_msg_ptr(nullptr);
+            ipc_msg_ptr msg = free_msgs_.back();
+            free_msgs_.pop_back();
+
+            return msg;
         }
 
         void session::set_slot_free(ipc_msg *msg) {
-            auto wrap_msg = std::find_if(msgs_pool.begin(), msgs_pool.end(),
-                [&](const auto &wrap_msg) { return wrap_msg.second == msg; });
-
-            if (wrap_msg != msgs_pool.end()) {
-                wrap_msg->first = true;
-            }
+            // Only called by the last unref of a message from our pool, so it can't already be on the stack
+            msg->renew_id();
+            free_msgs_.push_back(msg);
         }
 
         bool session::eligible_to_send(kernel::thread *thr) {
@@ -134,6 +133,9 @@ namespace eka2l1 {
                 return -1;
             }
 
+            // The thread's sync message is never released, the previous request is over by now
+            msg->renew_id();
+
             msg->function = function;
             msg->args = args;
             msg->own_thr = kern->crr_thread();
@@ -210,6 +212,11 @@ namespace eka2l1 {
 
             // Try to send a disconnect message. Headless session and use sync message.
             if (svr) {
+                if (svr->is_hle()) {
+                    // Pending messages of this session may still be on the server's worker
+                    svr->flush_worker();
+                }
+
                 if (svr->is_hle() || kern->crr_thread())
                     send_destruct();
 
@@ -220,9 +227,11 @@ namespace eka2l1 {
 
             // Free the message pool anyway
             for (const auto &msg : msgs_pool) {
-                kern->free_msg(msg.second);
+                kern->free_msg(msg);
             }
 
+            free_msgs_.clear();
+
             if (svr) {
                 svr->detach(this);
 
@@ -1250,11 +1250,18 @@ namespace eka2l1::epoc {
         const std::string server_name = ss->get_server()->name();
         kern->call_ipc_send_callbacks(server_name, ord, arg, status.ptr_address(), kern->crr_thread());
 
+        service::server *svr = ss->get_server();
+
+        if (svr->is_hle()) {
+            // Complete and give back the messages that the server's worker has finished with
+            svr->finish_worker_msgs();
+        }
+
         const int result = sync ? ss->send_receive_sync(ord, arg, status) : ss->send_receive(ord, arg, status);
 
-        if (ss->get_server()->is_hle()) {
-            // Process it right away.
-            ss->get_server()->process_accepted_msg();
+        if (svr->is_hle()) {
+            // Process it right away, or hand it to the server's worker.
+            svr->dispatch_accepted_msg();
         }
 
         return result;
@@ -2458,14 +2465,11 @@ namespace eka2l1::epoc {
         if (!prop) {
             LOG_WARN(KERNEL, "Property (0x{:x}, 0x{:x}) has not been defined before, undefined behavior may rise", cage, val);
 
-            prop = kern->create<service::property>();
+            prop = kern->create_prop(cage, val);
 
             if (!prop) {
                 return epoc::error_general;
             }
-
-            prop->first = cage;
-            prop->second = val;
         }
 
         auto property_ref_handle_and_obj = kern->create_and_add<service::property_reference>(
@@ -2507,14 +2511,11 @@ namespace eka2l1::epoc {
         property_ptr prop = kern->get_prop(cage, key);
 
         if (!prop) {
-            prop = kern->create<service::property>();
+            prop = kern->create_prop(cage, key);
 
             if (!prop) {
                 return epoc::error_general;
             }
-
-            prop->first = cage;
-            prop->second = key;
         }
 
         prop->define(prop_type, info->size);
@@ -2523,12 +2524,13 @@ namespace eka2l1::epoc {
     }
 
     BRIDGE_FUNC(std::int32_t, property_delete, std::int32_t cage, std::int32_t key) {
-        property_ptr prop = kern->delete_prop(cage, key);
+        property_ptr prop = kern->get_prop(cage, key);
 
         if (!prop || !prop->is_defined()) {
             return epoc::error_not_found;
         }
 
+        kern->delete_prop(cage, key);
         return epoc::error_none;
     }
 
@@ -4431,15 +4433,12 @@ namespace eka2l1::epoc {
 
         property_ptr prop = kern->get_prop(create_info->arg0_, create_info->arg1_);
         if (!prop) {
-            prop = kern->create<service::property>();
+            prop = kern->create_prop(create_info->arg0_, create_info->arg1_);
 
             if (!prop) {
                 finish_status_request_eka1(target_thread, finish_signal, epoc::error_general);
                 return epoc::error_general;
             }
-
-            prop->first = create_info->arg0_;
-            prop->second = create_info->arg1_;
         }
 
         prop->define(static_cast<service::property_type>(create_info->arg2_), create_info->arg3_);
@@ -4458,15 +4457,12 @@ namespace eka2l1::epoc {
             LOG_WARN(KERNEL, "Property (0x{:x}, 0x{:x}) has not been defined before, undefined behavior may rise", create_info->arg1_,
                 create_info->arg2_);
 
-            prop = kern->create<service::property>();
+            prop = kern->create_prop(create_info->arg1_, create_info->arg2_);
 
             if (!prop) {
                 finish_status_request_eka1(target_thread, finish_signal, epoc::error_general);
                 return epoc::error_general;
             }
-
-            prop->first = create_info->arg1_;
-            prop->second = create_info->arg2_;
         }
 
         auto property_ref_handle_and_obj = kern->create_and_add<service::property_reference>(
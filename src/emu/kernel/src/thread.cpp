@@ -19,6 +19,7 @@
  */
 
 #include <common/algorithm.h>
+#include <common/chunkyseri.h>
 #include <common/cvt.h>
 #include <common/log.h>
 #include <common/random.h>
@@ -28,6 +29,7 @@
 #include <kernel/ipc.h>
 #include <kernel/kernel.h>
 #include <kernel/mutex.h>
+#include <kernel/server.h>
 #include <kernel/sema.h>
 #include <kernel/thread.h>
 #include <mem/mem.h>
@@ -383,6 +385,29 @@ namespace eka2l1 {
             return 0;
         }
 
+        void thread::do_state(common::chunkyseri &seri) {
+            kernel_obj::do_state(seri);
+
+            auto s = seri.section("Thread", 1);
+
+            if (!s) {
+                return;
+            }
+
+            for (auto &reg : ctx.cpu_registers) {
+                seri.absorb(reg);
+            }
+
+            seri.absorb(ctx.cpsr);
+
+            for (auto &reg : ctx.fpu_registers) {
+                seri.absorb(reg);
+            }
+
+            seri.absorb(ctx.fpscr);
+            seri.absorb(ctx.uprw);
+        }
+
         void thread::do_cleanup() {
             // Close all thread handles
             if (!kern->wipeout_in_progress())
@@ -1040,6 +1065,25 @@ namespace eka2l1 {
 
             kernel_system *kern = requester->get_kernel_object_owner();
 
+            if (service::server *worker_svr = service::server::current_worker()) {
+                // Kernel state is only touched on the kernel side. The requester may be gone by then.
+                const eka2l1::ptr<epoc::request_status> sts_to_complete = sts;
+                const kernel::uid requester_uid = requester->unique_id();
+
+                sts = 0;
+
+                worker_svr->post_to_kernel([kern, sts_to_complete, requester_uid, err_code]() {
+                    kernel::thread *requester = kern->get_by_id<kernel::thread>(requester_uid);
+
+                    if (requester && (requester->unique_id() == requester_uid)) {
+                        eka2l1::ptr<epoc::request_status> sts_copy = sts_to_complete;
+                        notify_info(sts_copy, requester).complete(err_code);
+                    }
+                });
+
+                return;
+            }
+
             epoc::request_status *sts_real = sts.get(requester->owning_process());
             if (sts_real)
                 sts_real->set(err_code, kern->is_eka1());
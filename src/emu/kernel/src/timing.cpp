@@ -208,6 +208,35 @@ namespace eka2l1 {
         return false;
     }
 
+    void ntimer::do_state(common::chunkyseri &seri) {
+        auto s = seri.section("Timing", 1);
+
+        if (!s) {
+            return;
+        }
+
+        std::uint64_t current_us = microseconds();
+        std::uint32_t cpu_hz = CPU_HZ_;
+
+        seri.absorb(current_us);
+        seri.absorb(cpu_hz);
+
+        const std::lock_guard<std::mutex> guard(lock_);
+        std::vector<event> events_copy = events_;
+
+        seri.absorb_container(events_copy, [this](common::chunkyseri &seri, event &evt) {
+            std::string type_name;
+
+            if ((evt.event_type >= 0) && (evt.event_type < static_cast<int>(event_types_.size()))) {
+                type_name = event_types_[evt.event_type].name;
+            }
+
+            seri.absorb(type_name);
+            seri.absorb(evt.event_time);
+            seri.absorb(evt.event_user_data);
+        });
+    }
+
     bool ntimer::set_clock_frequency_mhz(const std::uint32_t cpu_mhz) {
         if (teletimer_->set_target_frequency(cpu_mhz * 10000000)) {
             CPU_HZ_ = cpu_mhz * 10000000;
@@ -43,6 +43,20 @@ namespace eka2l1::loader {
         bool internalize(common::ro_stream &stream);
     };
 
+    /**
+     * \brief Decompress bitmap data that is already in memory.
+     *
+     * \param header       Header of the bitmap, which gives the compression type.
+     * \param source       Pointer to the bitmap data, as stored in the MBM.
+     * \param source_size  Size of the bitmap data.
+     * \param dest         Destination buffer. Can be null to only calculate the decompressed size.
+     * \param dest_size    Size of the destination buffer. On success, contains the number of bytes written.
+     *
+     * \returns False if the compression type is not supported.
+     */
+    bool decompress_bitmap_data(const sbm_header &header, const std::uint8_t *source, const std::size_t source_size,
+        std::uint8_t *dest, std::size_t &dest_size);
+
     struct mbm_trailer {
         std::uint32_t count;
         std::vector<std::uint32_t> sbm_offsets;
@@ -71,6 +85,9 @@ namespace eka2l1::loader {
         // What index you want to load, throw hear before calling do_read_headers.
         std::vector<std::size_t> index_to_loads;
 
+        // Compressed data is read here before being decompressed. Kept to reuse between reads.
+        std::vector<std::uint8_t> compressed_buffer;
+
         bool do_read_headers();
         bool valid();
 
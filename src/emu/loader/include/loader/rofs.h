@@ -78,5 +78,51 @@ namespace eka2l1::loader {
         bool read(common::ro_stream &stream, const int version);
     };
 
+    /**
+     * @brief A file to extract from a ROFS image, resolved from the directory tree.
+     */
+    struct rofs_extract_file {
+        std::string dest_path_;
+        std::uint64_t image_offset_; ///< Offset of the file data from the start of the image stream.
+        std::uint32_t size_;
+    };
+
+    struct rofs_dump_stats {
+        std::uint64_t index_time_us_ = 0; ///< Time spent walking the directory tree.
+        std::uint64_t extract_time_us_ = 0; ///< Time spent writing out the files.
+        std::size_t file_count_ = 0;
+        std::uint64_t total_size_ = 0;
+    };
+
+    /**
+     * @brief Walk the directory tree of a ROFS image and list all its files.
+     *
+     * Host directories for the whole tree are created under the given path as a side effect.
+     *
+     * @param stream     Stream of the ROFS image, positioned at its header.
+     * @param path       Host path to extract the image to.
+     * @param files      On success, contains every file in the image.
+     *
+     * @returns True on success.
+     */
+    bool index_rofs_system(common::ro_stream &stream, const std::string &path, std::vector<rofs_extract_file> &files);
+
     bool dump_rofs_system(common::ro_stream &stream, const std::string &path, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb);
+
+    /**
+     * @brief Extract a ROFS image stored on the host, writing files from a pool of host workers.
+     *
+     * The directory tree is only decoded once. Each worker then reads the image through its own file handle,
+     * so files are written concurrently. Progress is reported in bytes written.
+     *
+     * @param image_path     Host path to the ROFS image.
+     * @param path           Host path to extract the image to.
+     * @param progress_cb    Progress callback. Calls are serialized, but may come from any worker.
+     * @param cancel_cb      Cancel callback. May be called from any worker.
+     * @param stats          Optional pointer to receive timing of each extraction stage.
+     *
+     * @returns True on success.
+     */
+    bool dump_rofs_system(const std::string &image_path, const std::string &path, progress_changed_callback progress_cb,
+        cancel_requested_callback cancel_cb, rofs_dump_stats *stats = nullptr);
 }
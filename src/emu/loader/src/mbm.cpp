@@ -26,6 +26,8 @@
 
 #include <loader/mbm.h>
 
+#include <cstring>
+
 namespace eka2l1::loader {
     bool sbm_header::internalize(common::ro_stream &stream) {
         std::uint64_t total_read = 0;
@@ -43,6 +45,43 @@ namespace eka2l1::loader {
         return (total_read == sizeof(sbm_header));
     }
 
+    bool decompress_bitmap_data(const sbm_header &header, const std::uint8_t *source, const std::size_t source_size,
+        std::uint8_t *dest, std::size_t &dest_size) {
+        switch (header.compression) {
+        case 0: {
+            dest_size = dest ? common::min<std::size_t>(dest_size, source_size) : source_size;
+
+            if (dest) {
+                std::memcpy(dest, source, dest_size);
+            }
+
+            break;
+        }
+
+        case 1:
+            eka2l1::decompress_rle_fast_route<8>(source, source_size, dest, dest_size);
+            break;
+
+        case 2:
+            eka2l1::decompress_rle_fast_route<12>(source, source_size, dest, dest_size);
+            break;
+
+        case 3:
+            eka2l1::decompress_rle_fast_route<16>(source, source_size, dest, dest_size);
+            break;
+
+        case 4:
+            eka2l1::decompress_rle_fast_route<24>(source, source_size, dest, dest_size);
+            break;
+
+        default:
+            LOG_ERROR(LOADER, "Unsupport RLE compression type {}", header.compression);
+            return false;
+        }
+
+        return true;
+    }
+
     bool mbm_file::valid() {
         return header.uids.uid1 == 0x10000041
 			|| (header.uids.uid1 == 0x10000037 && header.uids.uid2 == 0x10000042);
@@ -183,37 +222,16 @@ namespace eka2l1::loader {
             }
         } else {
             if (compressed_size < common::MB(5)) {
-                std::vector<std::uint8_t> source_data(compressed_size);
-                stream->read(source_data.data(), source_data.size());
-
-                switch (single_bm_header.compression) {
-                case 1: {
-                    eka2l1::decompress_rle_fast_route<8>(source_data.data(), source_data.size(), dest, dest_max);
-                    break;
-                }
-
-                case 2: {
-                    eka2l1::decompress_rle_fast_route<12>(source_data.data(), source_data.size(), dest, dest_max);
-                    break;
-                }
-
-                case 3: {
-                    eka2l1::decompress_rle_fast_route<16>(source_data.data(), source_data.size(), dest, dest_max);
-                    break;
+                if (compressed_buffer.size() < compressed_size) {
+                    compressed_buffer.resize(compressed_size);
                 }
 
-                case 4: {
-                    eka2l1::decompress_rle_fast_route<24>(source_data.data(), source_data.size(), dest, dest_max);
-                    break;
-                }
+                compressed_size = stream->read(compressed_buffer.data(), compressed_size);
 
-                default: {
-                    LOG_ERROR(LOADER, "Unsupport RLE compression type {}", single_bm_header.compression);
+                if (!decompress_bitmap_data(single_bm_header, compressed_buffer.data(), compressed_size, dest, dest_max)) {
                     stream->seek(crr_pos, common::beg);
-
                     return false;
                 }
-                }
             } else {
                 common::wo_buf_stream dest_stream(dest, dest_max ? dest_max : 0xFFFFFFFF);
 
@@ -21,10 +21,15 @@
 #include <common/fileutils.h>
 #include <common/log.h>
 #include <common/path.h>
+#include <common/threadpool.h>
 #include <loader/rofs.h>
 
+#include <common/algorithm.h>
 #include <common/cvt.h>
 
+#include <chrono>
+#include <mutex>
+
 namespace eka2l1::loader {
     bool rofs_entry::read(common::ro_stream &stream, const int version) {
         const std::uint64_t start_pos = stream.tell();
@@ -118,54 +123,41 @@ namespace eka2l1::loader {
         return true;
     }
 
-    static bool extract_file(common::ro_stream &stream, rofs_entry &entry, const std::string &base,
-        const int file_offset, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb, std::size_t &max_pos) {
-        std::string fname = common::ucs2_to_utf8(entry.filename_);
-        if (common::is_platform_case_sensitive()) {
-            fname = common::lowercase_string(fname);
-        }
-
-        fname = add_path(base, fname);
-        std::ofstream extract_stream(fname, std::ios_base::binary);
+    static constexpr std::uint32_t EXTRACT_CHUNK_SIZE = 0x100000;
 
-        const std::uint64_t org_pos = stream.tell();
-        stream.seek(entry.file_addr_ - file_offset, common::seek_where::beg);
+    static bool extract_file(common::ro_stream &stream, const rofs_extract_file &file, std::vector<char> &buf,
+        cancel_requested_callback &cancel_cb, const std::function<void(const std::uint32_t)> &written_cb) {
+        common::wo_std_file_stream extract_stream(file.dest_path_, true);
+        stream.seek(file.image_offset_, common::seek_where::beg);
 
-        static constexpr std::uint32_t CHUNK_SIZE = 0x10000;
-        std::vector<char> buf;
+        std::int64_t size_left = static_cast<std::int64_t>(file.size_);
 
-        std::int64_t size_left = static_cast<std::int64_t>(entry.file_size_);
         while (size_left > 0) {
             if (cancel_cb && cancel_cb()) {
                 return false;
             }
 
             const std::uint32_t size_to_take = common::min<std::uint32_t>(static_cast<std::uint32_t>(size_left),
-                CHUNK_SIZE);
-
-            buf.resize(size_to_take);
+                EXTRACT_CHUNK_SIZE);
 
             const std::uint64_t amount_read = stream.read(buf.data(), size_to_take);
             if (amount_read < size_to_take) {
                 LOG_WARN(LOADER, "Can't read {} bytes, skipping", size_to_take - amount_read);
             }
 
-            if (progress_cb) {
-                max_pos = common::max(max_pos, static_cast<std::size_t>(stream.tell()));
-                progress_cb(max_pos, stream.size());
-            }
-
             extract_stream.write(buf.data(), size_to_take);
             size_left -= size_to_take;
+
+            if (written_cb) {
+                written_cb(size_to_take);
+            }
         }
 
-        stream.seek(org_pos, common::seek_where::beg);
         return true;
     }
 
-    static bool extract_directory(common::ro_stream &stream, const std::string &base,
-        const int version, const int file_offset, const std::uint32_t offset,
-        progress_changed_callback progress_cb, cancel_requested_callback cancel_cb, std::size_t &max_pos) {
+    static bool index_directory(common::ro_stream &stream, const std::string &base, const int version, const int file_offset,
+        const std::uint32_t offset, std::vector<rofs_extract_file> &files) {
         common::create_directories(base);
         stream.seek(offset - file_offset, common::seek_where::beg);
 
@@ -179,18 +171,22 @@ namespace eka2l1::loader {
         if (dir_var.file_block_addr_ - file_offset) {
             stream.seek(dir_var.file_block_addr_ - file_offset, common::seek_where::beg);
             while (stream.tell() - (dir_var.file_block_addr_ - file_offset) < dir_var.file_block_size_) {
-                if (cancel_cb && cancel_cb()) {
-                    return false;
-                }
-
                 rofs_entry file_entry;
                 if (!file_entry.read(stream, version)) {
                     return false;
                 }
 
-                if (!extract_file(stream, file_entry, base, file_offset, progress_cb, cancel_cb, max_pos)) {
-                    LOG_ERROR(LOADER, "Fail to extract file with name: {}", common::ucs2_to_utf8(file_entry.filename_));
+                std::string fname = common::ucs2_to_utf8(file_entry.filename_);
+                if (common::is_platform_case_sensitive()) {
+                    fname = common::lowercase_string(fname);
                 }
+
+                rofs_extract_file file;
+                file.dest_path_ = add_path(base, fname);
+                file.image_offset_ = file_entry.file_addr_ - file_offset;
+                file.size_ = file_entry.file_size_;
+
+                files.push_back(std::move(file));
             }
         }
 
@@ -200,8 +196,8 @@ namespace eka2l1::loader {
                 subdir_name = common::lowercase_string(subdir_name);
             }
 
-            if (!extract_directory(stream, eka2l1::add_path(base, subdir_name + eka2l1::get_separator()),
-                    version, file_offset, subdir_ent.file_addr_, progress_cb, cancel_cb, max_pos)) {
+            if (!index_directory(stream, eka2l1::add_path(base, subdir_name + eka2l1::get_separator()),
+                    version, file_offset, subdir_ent.file_addr_, files)) {
                 return false;
             }
         }
@@ -219,7 +215,7 @@ namespace eka2l1::loader {
         return false;
     }
 
-    bool dump_rofs_system(common::ro_stream &stream, const std::string &path, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb) {
+    bool index_rofs_system(common::ro_stream &stream, const std::string &path, std::vector<rofs_extract_file> &files) {
         rofs_header rheader;
         if (stream.read(&rheader, sizeof(rofs_header)) != sizeof(rofs_header)) {
             return false;
@@ -234,13 +230,120 @@ namespace eka2l1::loader {
         }
 
         // lets hope that ROFS isn't affected
-        int file_offset = rheader.dir_tree_offset_ - rheader.header_size_;
+        const int file_offset = rheader.dir_tree_offset_ - rheader.header_size_;
+        return index_directory(stream, path, rheader.rofs_format_version_, file_offset, rheader.dir_tree_offset_, files);
+    }
+
+    bool dump_rofs_system(common::ro_stream &stream, const std::string &path, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb) {
+        std::vector<rofs_extract_file> files;
+
+        if (!index_rofs_system(stream, path, files)) {
+            return false;
+        }
+
+        std::vector<char> buf(EXTRACT_CHUNK_SIZE);
         std::size_t max_pos = 0;
 
-        const bool result = extract_directory(stream, path, rheader.rofs_format_version_, file_offset, rheader.dir_tree_offset_,
-            progress_cb, cancel_cb, max_pos);
+        const auto written_cb = [&](const std::uint32_t) {
+            if (progress_cb) {
+                max_pos = common::max(max_pos, static_cast<std::size_t>(stream.tell()));
+                progress_cb(max_pos, stream.size());
+            }
+        };
+
+        for (const rofs_extract_file &file : files) {
+            if (!extract_file(stream, file, buf, cancel_cb, written_cb)) {
+                return false;
+            }
+        }
+
+        if (progress_cb) {
+            progress_cb(1, 1);
+        }
+
+        return true;
+    }
+
+    bool dump_rofs_system(const std::string &image_path, const std::string &path, progress_changed_callback progress_cb,
+        cancel_requested_callback cancel_cb, rofs_dump_stats *stats) {
+        std::vector<rofs_extract_file> files;
+
+        const auto index_start = std::chrono::steady_clock::now();
+
+        {
+            common::ro_std_file_stream index_stream(image_path, true);
+
+            if (!index_stream.valid() || !index_rofs_system(index_stream, path, files)) {
+                return false;
+            }
+        }
+
+        const auto extract_start = std::chrono::steady_clock::now();
+
+        std::uint64_t total_size = 0;
+        for (const rofs_extract_file &file : files) {
+            total_size += file.size_;
+        }
+
+        std::atomic<std::size_t> next_file(0);
+        std::atomic<bool> failed(false);
+
+        std::mutex progress_lock;
+        std::uint64_t written_size = 0;
+
+        const auto written_cb = [&](const std::uint32_t size) {
+            if (progress_cb) {
+                const std::lock_guard<std::mutex> guard(progress_lock);
+
+                written_size += size;
+                progress_cb(static_cast<std::size_t>(written_size), static_cast<std::size_t>(common::max<std::uint64_t>(total_size, 1)));
+            }
+        };
+
+        {
+            common::thread_pool pool("ROFS extract", common::min<std::size_t>(files.size(), std::thread::hardware_concurrency()));
+            std::vector<std::future<void>> waits;
+
+            // Files are claimed one at a time rather than in batches, since their sizes vary a lot
+            for (std::size_t i = 0; i < pool.worker_count(); i++) {
+                waits.push_back(pool.submit([&]() {
+                    common::ro_std_file_stream stream(image_path, true);
+                    std::vector<char> buf(EXTRACT_CHUNK_SIZE);
+
+                    if (!stream.valid()) {
+                        failed = true;
+                        return;
+                    }
+
+                    while (!failed) {
+                        const std::size_t index = next_file++;
+
+                        if (index >= files.size()) {
+                            break;
+                        }
+
+                        if (!extract_file(stream, files[index], buf, cancel_cb, written_cb)) {
+                            failed = true;
+                        }
+                    }
+                }));
+            }
+
+            for (auto &wait : waits) {
+                wait.get();
+            }
+        }
+
+        if (stats) {
+            const auto extract_end = std::chrono::steady_clock::now();
+
+            stats->index_time_us_ = std::chrono::duration_cast<std::chrono::microseconds>(extract_start - index_start).count();
+            stats->extract_time_us_ = std::chrono::duration_cast<std::chrono::microseconds>(extract_end - extract_start).count();
+            stats->file_count_ = files.size();
+            stats->total_size_ = total_size;
+        }
 
-        if (!result) {
+        if (failed) {
             return false;
         }
 
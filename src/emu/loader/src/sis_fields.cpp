@@ -292,6 +292,9 @@ namespace eka2l1 {
                     inflate(&stream, Z_NO_FLUSH);
                     inflateEnd(&stream);
 
+                    // Only the inflated data is read from now on
+                    std::vector<unsigned char>().swap(compressed.compressed_data);
+
                     LOG_INFO(LOADER, "Inflating chunk, size: {}", us);
                 }
             }
@@ -49,6 +49,8 @@ namespace eka2l1::mem {
         void manipulate_cpu_map(common::bitmap_allocator *allocator, mem_model_process *process,
             mmu_base *mmu, const bool map);
 
+        bool is_page_committed_in(common::bitmap_allocator *allocator, const std::uint32_t page_index) const;
+
     public:
         explicit mem_model_chunk(control_base *control, const asid id)
             : control_(control)
@@ -84,6 +86,13 @@ namespace eka2l1::mem {
 
         virtual void *host_base() = 0;
 
+        /**
+         * \brief Check if a page of the chunk has memory committed.
+         *
+         * \param page_index Index of the page, counting from the chunk base.
+         */
+        virtual bool is_page_committed(const std::uint32_t page_index) const = 0;
+
         /**
          * \brief Unmap the committed chunk region from the CPU.
          * 
@@ -69,6 +69,10 @@ namespace eka2l1::mem::flexible {
 
         std::int32_t allocate(const std::size_t size) override;
 
+        bool is_page_committed(const std::uint32_t page_index) const override {
+            return is_page_committed_in(page_bma_.get(), page_index);
+        }
+
         void unmap_from_cpu(mem_model_process *pr, mmu_base *mmu) override;
         void map_to_cpu(mem_model_process *pr, mmu_base *mmu) override;
     };
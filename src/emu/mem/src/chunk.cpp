@@ -73,6 +73,18 @@ namespace eka2l1::mem {
         return true;
     }
 
+    bool mem_model_chunk::is_page_committed_in(common::bitmap_allocator *allocator, const std::uint32_t page_index) const {
+        if (!allocator) {
+            // Contigious types. Everything between the bottom and the top is committed
+            return (page_index >= bottom_) && (page_index < top_);
+        }
+
+        const std::uint32_t word = allocator->get_word(page_index >> 5);
+
+        // Committed pages have their bit cleared
+        return ((word >> (31 - (page_index & 31))) & 1) == 0;
+    }
+
     void mem_model_chunk::manipulate_cpu_map(common::bitmap_allocator *allocator, mem_model_process *process,
         mmu_base *mmu, const bool map) {
         // Get the base address for this process
@@ -27,6 +27,7 @@
 #include <fstream>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -34,6 +35,10 @@
 namespace eka2l1 {
     class io_system;
 
+    namespace common {
+        class thread_pool;
+    }
+
     namespace loader {
         struct sis_controller;
         struct sis_registry_tree;
@@ -74,6 +79,10 @@ namespace eka2l1 {
             io_system *sys;
             config::state *conf;
 
+            std::unique_ptr<common::thread_pool> extract_pool_;
+
+            common::thread_pool *get_extract_pool();
+
         protected:
             void traverse_tree_and_add_packages(loader::sis_registry_tree &tree);
             void install_sis_stubs();
@@ -86,6 +95,8 @@ namespace eka2l1 {
             loader::var_value_resolver_func var_resolver;
 
             explicit packages(io_system *sys, config::state *conf, const drive_number residing = drive_c);
+            ~packages();
+
             bool installed(const uid pkg_uid);
 
             void migrate_legacy_registries();
@@ -117,6 +128,17 @@ namespace eka2l1 {
 
             package::installation_result install_package(const std::u16string &path, const drive_number drive, progress_changed_callback progress_cb = nullptr,
                 cancel_requested_callback cancel_cb = nullptr, const bool silent = false);
+
+            /**
+             * \brief Install a list of packages, one after another, reusing this manager and its extraction workers.
+             *
+             * A failed package does not stop the batch. Once cancelled, the remaining packages are reported as aborted.
+             * Progress is reported over the whole batch.
+             *
+             * \returns The result of each package, in the same order as the given paths.
+             */
+            std::vector<package::installation_result> install_packages(const std::vector<std::u16string> &paths, const drive_number drive,
+                progress_changed_callback progress_cb = nullptr, cancel_requested_callback cancel_cb = nullptr, const bool silent = true);
         };
     }
 }
@@ -24,6 +24,8 @@
 
 #include <atomic>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <stack>
 #include <string>
 #include <vector>
@@ -46,9 +48,12 @@ namespace eka2l1 {
 
     namespace common {
         class ro_stream;
+        class thread_pool;
     }
 
     namespace loader {
+        using data_stream_opener = std::function<std::unique_ptr<common::ro_stream>()>;
+
         struct sis_registry_tree {
             package::object package_info;
             manager::controller_info controller_binary;
@@ -77,6 +82,10 @@ namespace eka2l1 {
 
             progress_changed_callback progress_changed_cb;
             cancel_requested_callback cancel_cb;
+            std::mutex progress_lock;
+
+            common::thread_pool *extract_pool;
+            data_stream_opener open_data_stream;
 
             drive_number install_drive;
             common::ro_stream *data_stream;
@@ -120,15 +129,23 @@ namespace eka2l1 {
             std::vector<uint8_t> get_small_file_buf(uint32_t data_idx, uint16_t crr_blck_idx);
 
             /**
-             * \brief Get the data in the index of a buffer block in the SIS, write it to a physical file.
-             * 
-             * Usually uses for extracting large app data.
-             * 
-             * \param path          UTF-8 path to the physical file.
-             * \param data_idx      The index of the source buffer in block buffer.
-             * \param crr_block_idx The block index..
+             * \brief Stream a data unit into a physical file, using the given stream and scratch buffers.
+             *
+             * Usually uses for extracting large app data. Safe to call concurrently with different streams and buffers.
+             *
+             * \param stream        Stream of the SIS file.
+             * \param target        The file to extract.
+             * \param in_buf        Scratch buffer for compressed data.
+             * \param out_buf       Scratch buffer for inflated data.
+             * \param abort         Set by other workers when the extraction has failed.
+             *
+             * \returns False on failure or cancellation. The partially written file is removed.
              */
-            bool extract_file(const std::string &path, const uint32_t idx, uint16_t crr_blck_idx);
+            bool extract_file(common::ro_stream &stream, const extract_target_info &target, std::vector<std::uint8_t> &in_buf,
+                std::vector<std::uint8_t> &out_buf, const std::atomic<bool> &abort);
+
+            void report_extract_progress(const std::size_t decomped_size);
+            bool extract_targets_parallel();
 
         public:
             show_text_func show_text; ///< Hook function to display texts.
@@ -140,6 +157,17 @@ namespace eka2l1 {
 
             std::unique_ptr<sis_registry_tree> interpret(progress_changed_callback cb = nullptr, cancel_requested_callback cancel_cb = nullptr);
 
+            /**
+             * \brief Extract the package's files concurrently on a host thread pool.
+             *
+             * Every worker reads the SIS through its own stream, since file data units are independent.
+             * Without this, files are extracted one by one through the interpreter's stream.
+             *
+             * \param pool      The pool to run extraction on.
+             * \param opener    Function opening a new stream of the same SIS file.
+             */
+            void set_parallel_extract(common::thread_pool *pool, data_stream_opener opener);
+
             const std::vector<std::u16string> &extra_sis_files() const {
                 return gathered_sis_paths;
             }
@@ -18,11 +18,13 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/buffer.h>
 #include <common/chunkyseri.h>
 #include <common/cvt.h>
 #include <common/fileutils.h>
 #include <common/log.h>
 #include <common/path.h>
+#include <common/threadpool.h>
 
 #include <loader/e32img.h>
 #include <loader/sis.h>
@@ -51,6 +53,17 @@ namespace eka2l1 {
             , conf(conf) {
         }
 
+        packages::~packages() {
+        }
+
+        common::thread_pool *packages::get_extract_pool() {
+            if (!extract_pool_) {
+                extract_pool_ = std::make_unique<common::thread_pool>("Package extract");
+            }
+
+            return extract_pool_.get();
+        }
+
         static std::string get_bucket_stream_path(config::state *state, const uid package_uid) {
             return add_path(state->storage, add_path(PACKAGE_FOLDER_PATH, common::to_string(package_uid, std::hex) + ".txt"));
         }
@@ -544,6 +557,11 @@ namespace eka2l1 {
                 // Interpret the file
                 loader::ss_interpreter interpreter(reinterpret_cast<common::ro_stream *>(&stream), sys, this, &res.controller, &res.data, drive);
 
+                // File data units are independent, let every extraction worker read the SIS on its own
+                interpreter.set_parallel_extract(get_extract_pool(), [path]() -> std::unique_ptr<common::ro_stream> {
+                    return std::make_unique<common::ro_std_file_stream>(common::ucs2_to_utf8(path), true);
+                });
+
                 // Set up hooks
                 if (show_text && !silent) {
                     interpreter.show_text = show_text;
@@ -583,5 +601,38 @@ namespace eka2l1 {
             LOG_TRACE(PACKAGE, "Installation done!");
             return package::installation_result_success;
         }
+
+        std::vector<package::installation_result> packages::install_packages(const std::vector<std::u16string> &paths, const drive_number drive,
+            progress_changed_callback progress_cb, cancel_requested_callback cancel_cb, const bool silent) {
+            std::vector<package::installation_result> results(paths.size(), package::installation_result_aborted);
+
+            for (std::size_t i = 0; i < paths.size(); i++) {
+                if (cancel_cb && cancel_cb()) {
+                    break;
+                }
+
+                progress_changed_callback package_progress_cb = nullptr;
+
+                if (progress_cb) {
+                    const std::size_t total = paths.size() * 100;
+
+                    package_progress_cb = [progress_cb, i, total](const std::size_t taken, const std::size_t max) {
+                        progress_cb(i * 100 + ((max == 0) ? 100 : (taken * 100 / max)), total);
+                    };
+                }
+
+                results[i] = install_package(paths[i], drive, package_progress_cb, cancel_cb, silent);
+
+                if (results[i] != package::installation_result_success) {
+                    LOG_ERROR(PACKAGE, "Batch install of {} failed with result {}", common::ucs2_to_utf8(paths[i]), static_cast<int>(results[i]));
+                }
+            }
+
+            if (progress_cb) {
+                progress_cb(1, 1);
+            }
+
+            return results;
+        }
     }
 }
@@ -28,6 +28,7 @@
 #include <common/time.h>
 #include <common/types.h>
 #include <common/platform.h>
+#include <common/threadpool.h>
 
 #include <config/config.h>
 #include <vfs/vfs.h>
@@ -40,6 +41,8 @@
 
 #include <miniz.h>
 
+#include <cstring>
+
 namespace eka2l1 {
     namespace loader {
         std::string get_install_path(const std::u16string &pseudo_path, drive_number drv) {
@@ -76,6 +79,7 @@ namespace eka2l1 {
             , extract_target_accumulated_size(0)
             , extract_target_decomped_size(0)
             , progress_changed_cb(nullptr)
+            , extract_pool(nullptr)
             , install_drive(inst_drv)
             , data_stream(stream)
             , io(io)
@@ -85,35 +89,26 @@ namespace eka2l1 {
         std::vector<uint8_t> ss_interpreter::get_small_file_buf(uint32_t data_idx, uint16_t crr_blck_idx) {
             sis_file_data *data = reinterpret_cast<sis_file_data *>(
                 reinterpret_cast<sis_data_unit *>(install_data->data_units.fields[crr_blck_idx].get())->data_unit.fields[data_idx].get());
-            sis_compressed compressed = data->raw_data;
+            const sis_compressed &compressed = data->raw_data;
 
             std::uint64_t us = ((compressed.len_low) | (static_cast<uint64_t>(compressed.len_high) << 32)) - 12;
-
-            compressed.compressed_data.resize(us);
+            std::vector<std::uint8_t> compressed_data(us);
 
             data_stream->seek(compressed.offset, common::seek_where::beg);
-            data_stream->read(&compressed.compressed_data[0], us);
+            data_stream->read(compressed_data.data(), us);
 
             if (compressed.algorithm == sis_compressed_algorithm::none) {
-                return compressed.compressed_data;
+                return compressed_data;
             }
 
-            compressed.uncompressed_data.resize(compressed.uncompressed_size);
-            mz_stream stream;
-
-            stream.zalloc = nullptr;
-            stream.zfree = nullptr;
+            std::vector<std::uint8_t> uncompressed_data(compressed.uncompressed_size);
+            mz_ulong uncompressed_size = static_cast<mz_ulong>(uncompressed_data.size());
 
-            if (inflateInit(&stream) != MZ_OK) {
-                LOG_ERROR(PACKAGE, "Can not intialize inflate stream");
+            if (mz_uncompress(uncompressed_data.data(), &uncompressed_size, compressed_data.data(), static_cast<mz_ulong>(us)) != MZ_OK) {
+                LOG_ERROR(PACKAGE, "Unable to inflate small file data");
             }
 
-            flate::inflate_data(&stream, compressed.compressed_data.data(),
-                compressed.uncompressed_data.data(), static_cast<std::uint32_t>(us));
-
-            inflateEnd(&stream);
-
-            return compressed.uncompressed_data;
+            return uncompressed_data;
         }
 
         // Assuming this file is small since it's stored in std::vector
@@ -128,7 +123,32 @@ namespace eka2l1 {
             stream.write(data.data(), data.size());
         }
 
-        bool ss_interpreter::extract_file(const std::string &path, const uint32_t idx, uint16_t crr_blck_idx) {
+        static constexpr std::uint32_t EXTRACT_READ_CHUNK_SIZE = 0x40000;
+
+        void ss_interpreter::set_parallel_extract(common::thread_pool *pool, data_stream_opener opener) {
+            extract_pool = pool;
+            open_data_stream = opener;
+        }
+
+        void ss_interpreter::report_extract_progress(const std::size_t decomped_size) {
+            const std::lock_guard<std::mutex> guard(progress_lock);
+            extract_target_decomped_size += decomped_size;
+
+            if (progress_changed_cb) {
+                if (extract_target_accumulated_size != 0) {
+                    progress_changed_cb(extract_target_decomped_size, extract_target_accumulated_size);
+                } else {
+                    progress_changed_cb(100, 100);
+                }
+            }
+        }
+
+        bool ss_interpreter::extract_file(common::ro_stream &stream, const extract_target_info &target, std::vector<std::uint8_t> &in_buf,
+            std::vector<std::uint8_t> &out_buf, const std::atomic<bool> &abort) {
+            const std::string &path = target.file_path_;
+            const std::uint32_t idx = target.data_unit_block_index_;
+            const std::uint16_t crr_blck_idx = static_cast<std::uint16_t>(target.data_unit_index_);
+
             std::string rp = eka2l1::file_directory(path);
             common::create_directories(rp);
 
@@ -147,93 +167,106 @@ namespace eka2l1 {
             }
 
             sis_file_data *data = reinterpret_cast<sis_file_data *>(data_unit->data_unit.fields[idx].get());
-
-            sis_compressed compressed = data->raw_data;
+            const sis_compressed &compressed = data->raw_data;
 
             std::uint64_t left = ((compressed.len_low) | (static_cast<std::uint64_t>(compressed.len_high) << 32)) - 12;
-            data_stream->seek(compressed.offset, common::seek_where::beg);
-
-            std::vector<unsigned char> temp_chunk;
-            temp_chunk.resize(CHUNK_SIZE);
+            stream.seek(compressed.offset, common::seek_where::beg);
 
-            std::vector<unsigned char> temp_inflated_chunk;
-            temp_inflated_chunk.resize(CHUNK_MAX_INFLATED_SIZE);
+            const bool deflated = (compressed.algorithm == sis_compressed_algorithm::deflated);
 
-            mz_stream stream;
+            mz_stream inflate_stream;
+            std::memset(&inflate_stream, 0, sizeof(mz_stream));
 
-            stream.zalloc = nullptr;
-            stream.zfree = nullptr;
-
-            if (compressed.algorithm == sis_compressed_algorithm::deflated) {
-                if (inflateInit(&stream) != MZ_OK) {
-                    LOG_ERROR(PACKAGE, "Can not intialize inflate stream");
-                }
+            if (deflated && (inflateInit(&inflate_stream) != MZ_OK)) {
+                LOG_ERROR(PACKAGE, "Can not intialize inflate stream");
+                return false;
             }
 
-            std::uint32_t total_inflated_size = 0;
-            bool cancel_requested = false;
+            std::uint64_t total_inflated_size = 0;
+            bool success = true;
 
             {
                 common::wo_std_file_stream std_fstream(path, true);
 
+                // Reserve the final size up front, so the file is not grown on every write
+                const std::uint64_t final_size = deflated ? compressed.uncompressed_size : left;
+
+                if (final_size != 0) {
+                    const std::uint8_t last_byte = 0;
+
+                    std_fstream.seek(static_cast<std::int64_t>(final_size - 1), common::seek_where::beg);
+                    std_fstream.write(&last_byte, 1);
+                    std_fstream.seek(0, common::seek_where::beg);
+                }
+
                 while (left > 0) {
-                    if (cancel_cb && cancel_cb()) {
-                        cancel_requested = true;
+                    if (abort || (cancel_cb && cancel_cb())) {
+                        success = false;
                         break;
                     }
 
-                    std::fill(temp_chunk.begin(), temp_chunk.end(), 0);
-                    int grab = static_cast<int>(left < CHUNK_SIZE ? left : CHUNK_SIZE);
-
-                    data_stream->read(&temp_chunk[0], grab);
+                    const std::uint32_t grab = static_cast<std::uint32_t>(common::min<std::uint64_t>(left, in_buf.size()));
 
-                    if (!data_stream->valid()) {
+                    if ((stream.read(in_buf.data(), grab) != grab) || !stream.valid()) {
                         LOG_ERROR(PACKAGE, "Stream fail, skipping this file, should report to developers.");
-                        return false;
+                        success = false;
+                        break;
                     }
 
-                    if (compressed.algorithm == sis_compressed_algorithm::deflated) {
-                        uint32_t inflated_size = 0;
+                    left -= grab;
 
-                        auto res = flate::inflate_data(&stream, temp_chunk.data(), temp_inflated_chunk.data(), grab, &inflated_size);
+                    if (!deflated) {
+                        std_fstream.write(in_buf.data(), grab);
+                        report_extract_progress(grab);
 
-                        if (!res) {
-                            LOG_ERROR(PACKAGE, "Decompress failed! Report to developers");
-                            return false;
-                        }
+                        continue;
+                    }
 
-                        std_fstream.write(temp_inflated_chunk.data(), inflated_size);
+                    inflate_stream.next_in = in_buf.data();
+                    inflate_stream.avail_in = grab;
 
-                        total_inflated_size += inflated_size;
-                        extract_target_decomped_size += inflated_size;
-                    } else {
-                        std_fstream.write(temp_chunk.data(), grab);
-                        extract_target_decomped_size += grab;
-                    }
+                    std::size_t inflated_this_round = 0;
+                    int res = MZ_OK;
 
-                    left -= grab;
+                    // Drain all the input, the output buffer may fill up more than once per input chunk
+                    do {
+                        inflate_stream.next_out = out_buf.data();
+                        inflate_stream.avail_out = static_cast<unsigned int>(out_buf.size());
+
+                        res = inflate(&inflate_stream, MZ_NO_FLUSH);
 
-                    if (progress_changed_cb) {
-                        if (extract_target_accumulated_size != 0) {
-                            progress_changed_cb(extract_target_decomped_size, extract_target_accumulated_size);
-                        } else {
-                            progress_changed_cb(100, 100);
+                        if ((res != MZ_OK) && (res != MZ_STREAM_END) && (res != MZ_BUF_ERROR)) {
+                            LOG_ERROR(PACKAGE, "Decompress failed ({})! Report to developers", mz_error(res));
+                            success = false;
+                            break;
                         }
-                    }
-                }
 
-                if (compressed.algorithm == sis_compressed_algorithm::deflated) {
-                    if (!cancel_requested && (total_inflated_size != compressed.uncompressed_size)) {
-                        LOG_ERROR(PACKAGE, "Sanity check failed: Total inflated size not equal to specified uncompress size "
-                                           "in SISCompressed ({} vs {})!",
-                            total_inflated_size, compressed.uncompressed_size);
+                        const std::size_t inflated_size = out_buf.size() - inflate_stream.avail_out;
+                        std_fstream.write(out_buf.data(), inflated_size);
+
+                        inflated_this_round += inflated_size;
+                    } while ((res == MZ_OK) && ((inflate_stream.avail_in != 0) || (inflate_stream.avail_out == 0)));
+
+                    total_inflated_size += inflated_this_round;
+                    report_extract_progress(inflated_this_round);
+
+                    if (!success || (res == MZ_STREAM_END)) {
+                        break;
                     }
+                }
+            }
 
-                    inflateEnd(&stream);
+            if (deflated) {
+                if (success && (total_inflated_size != compressed.uncompressed_size)) {
+                    LOG_ERROR(PACKAGE, "Sanity check failed: Total inflated size not equal to specified uncompress size "
+                                       "in SISCompressed ({} vs {})!",
+                        total_inflated_size, compressed.uncompressed_size);
                 }
+
+                inflateEnd(&inflate_stream);
             }
 
-            if (cancel_requested) {
+            if (!success) {
                 common::remove(path);
                 return false;
             }
@@ -241,6 +274,51 @@ namespace eka2l1 {
             return true;
         }
 
+        bool ss_interpreter::extract_targets_parallel() {
+            std::atomic<std::size_t> next_target(0);
+            std::atomic<bool> failed(false);
+
+            const std::size_t worker_count = common::min<std::size_t>(extract_pool->worker_count(), extract_targets.size());
+
+            std::vector<std::future<void>> waits;
+            waits.reserve(worker_count);
+
+            // Targets are claimed one by one, file sizes in a package vary a lot
+            for (std::size_t i = 0; i < worker_count; i++) {
+                waits.push_back(extract_pool->submit([&]() {
+                    std::unique_ptr<common::ro_stream> stream = open_data_stream();
+
+                    if (!stream || !stream->valid()) {
+                        LOG_ERROR(PACKAGE, "Unable to open SIS data stream for extraction worker");
+                        failed = true;
+
+                        return;
+                    }
+
+                    std::vector<std::uint8_t> in_buf(EXTRACT_READ_CHUNK_SIZE);
+                    std::vector<std::uint8_t> out_buf(CHUNK_MAX_INFLATED_SIZE);
+
+                    while (!failed) {
+                        const std::size_t index = next_target++;
+
+                        if (index >= extract_targets.size()) {
+                            break;
+                        }
+
+                        if (!extract_file(*stream, extract_targets[index], in_buf, out_buf, failed)) {
+                            failed = true;
+                        }
+                    }
+                }));
+            }
+
+            for (auto &wait : waits) {
+                wait.get();
+            }
+
+            return !failed;
+        }
+
         int ss_interpreter::gasp_true_form_of_integral_expression(const sis_expression &expr) {
             switch (expr.op) {
             case ss_expr_op::EPrimTypeVariable: {
@@ -711,20 +789,27 @@ namespace eka2l1 {
                 if (cb)
                     cb(1, 1);
             } else {
-                std::size_t n = 0;
-                bool cancel_requested = false;
+                bool extracted = true;
 
-                for (; n < extract_targets.size(); n++) {
-                    extract_target_info &target = extract_targets[n];
-                    if (!extract_file(target.file_path_, target.data_unit_block_index_, target.data_unit_index_)) {
-                        cancel_requested = true;
-                        break;
+                if (extract_pool && open_data_stream && (extract_targets.size() > 1)) {
+                    extracted = extract_targets_parallel();
+                } else {
+                    std::vector<std::uint8_t> in_buf(EXTRACT_READ_CHUNK_SIZE);
+                    std::vector<std::uint8_t> out_buf(CHUNK_MAX_INFLATED_SIZE);
+
+                    const std::atomic<bool> abort(false);
+
+                    for (const extract_target_info &target : extract_targets) {
+                        if (!extract_file(*data_stream, target, in_buf, out_buf, abort)) {
+                            extracted = false;
+                            break;
+                        }
                     }
                 }
 
-                if (cancel_requested) {
-                    for (std::size_t i = 0; i < n; i++) {
-                        common::remove(extract_targets[i].file_path_);
+                if (!extracted) {
+                    for (const extract_target_info &target : extract_targets) {
+                        common::remove(target.file_path_);
                     }
 
                     return nullptr;
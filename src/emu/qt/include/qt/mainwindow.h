@@ -44,6 +44,10 @@ namespace eka2l1 {
     class system;
     class window_server;
 
+    namespace common {
+        struct metrics_frame;
+    }
+
     namespace config {
         struct app_setting;
     }
@@ -58,6 +62,20 @@ namespace eka2l1 {
     }
 }
 
+/**
+ * \brief Metrics summed over the frames since the performance overlay was last refreshed.
+ */
+struct performance_overlay_stats {
+    std::uint64_t frame_count_ = 0;
+    std::uint64_t frame_time_us_ = 0;
+    std::uint64_t cpu_time_us_ = 0;
+    std::uint64_t jit_time_us_ = 0;
+    std::uint64_t hle_time_us_ = 0;
+    std::uint64_t gpu_time_us_ = 0;
+    std::uint64_t audio_underruns_ = 0;
+    std::uint64_t last_refresh_us_ = 0;
+};
+
 class applist_widget;
 class applist_widget_item;
 class display_widget;
@@ -84,6 +102,10 @@ private:
 
     QLabel *current_device_label_;
     QLabel *screen_status_label_;
+    QLabel *performance_overlay_;
+
+    std::size_t performance_overlay_callback_;
+    performance_overlay_stats performance_overlay_stats_; ///< Only touched by the emulator thread.
 
     QPointer<settings_dialog> settings_dialog_;
     QActionGroup *rotate_group_;
@@ -115,6 +137,9 @@ private:
     void save_ui_layouts();
     void restore_ui_layouts();
 
+    void accumulate_performance_overlay(const eka2l1::common::metrics_frame &frame);
+    void place_performance_overlay();
+
 private slots:
     void on_about_triggered();
     void on_settings_triggered();
@@ -137,6 +162,8 @@ private slots:
     void on_app_setting_changed();
     void on_another_rotation_triggered(QAction *action);
     void on_pause_toggled(bool checked);
+    void on_quick_save_state_triggered();
+    void on_quick_load_state_triggered();
     void on_package_uninstalled();
     void on_refresh_app_list_requested();
 
@@ -152,6 +179,8 @@ private slots:
     void on_input_dialog_open_request();
     void on_input_dialog_close_request();
     void on_hide_system_apps_changed();
+    void on_performance_overlay_toggled(bool checked);
+    void on_performance_overlay_update(const QString &text);
 
 signals:
     void progress_dialog_change(const std::size_t now, const std::size_t total);
@@ -164,6 +193,7 @@ signals:
     void screen_focus_group_changed();
     void input_dialog_open_request();
     void input_dialog_close_request();
+    void performance_overlay_update(const QString &text);
 
 public:
     main_window(QApplication &app, QWidget *parent, eka2l1::desktop::emulator &emulator_state);
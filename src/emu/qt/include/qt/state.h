@@ -85,7 +85,7 @@ namespace eka2l1::desktop {
         std::size_t sys_reset_cbh;
 
         main_window *ui_main;
-        int present_status;
+        drivers::command_fence present_fence;
 
         explicit emulator();
 
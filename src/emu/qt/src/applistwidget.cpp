@@ -28,6 +28,7 @@
 #include <common/pystr.h>
 #include <qt/applistwidget.h>
 #include <services/applist/applist.h>
+#include <services/applist/iconcache.h>
 #include <services/fbs/fbs.h>
 #include <utils/apacmd.h>
 
@@ -167,6 +168,12 @@ void applist_widget::reload_whole_list() {
             }
         }
     }
+
+    if (eka2l1::apa_icon_cache *icon_cache = lister_->get_icon_cache()) {
+        const eka2l1::apa_icon_cache_stats stats = icon_cache->get_stats();
+        LOG_TRACE(eka2l1::FRONTEND_UI, "App icon cache: {} hits ({} loaded from disk), {} misses, {} entries", stats.hits_,
+            stats.disk_hits_, stats.misses_, stats.entry_count_);
+    }
 }
 eka2l1::apa_app_registry *applist_widget::get_registry_from_widget_item(applist_widget_item *item) {
     if (!item) {
@@ -202,7 +209,40 @@ void applist_widget::add_registeration_item(eka2l1::apa_app_registry &reg, const
 
     const std::u16string path_ext = eka2l1::common::lowercase_ucs2_string(eka2l1::path_extension(reg.icon_file_path));
 
-    if (path_ext == u".mif") {
+    eka2l1::apa_icon_cache *icon_cache = lister_->get_icon_cache();
+    eka2l1::apa_icon_cache_key icon_key;
+
+    bool icon_cacheable = false;
+    bool icon_from_cache = false;
+
+    if (icon_cache && ((path_ext == u".mif") || (path_ext == u".mbm"))) {
+        eka2l1::symfile cache_file_route = io_->open_file(reg.icon_file_path, READ_MODE | BIN_MODE);
+
+        if (cache_file_route) {
+            eka2l1::ro_file_stream cache_file_stream(cache_file_route.get());
+            icon_key.source_hash_ = eka2l1::apa_icon_cache::hash_source(reinterpret_cast<eka2l1::common::ro_stream *>(&cache_file_stream));
+
+            // SVG icons are rasterized at the grid size, bitmap icons keep their own size
+            if (path_ext == u".mif") {
+                icon_key.size_ = eka2l1::vec2(ICON_GRID_SIZE.width(), ICON_GRID_SIZE.height());
+            }
+
+            icon_cacheable = true;
+
+            if (std::shared_ptr<const eka2l1::apa_rendered_icon> cached = icon_cache->get(icon_key)) {
+                QImage cached_image(cached->pixels_.data(), cached->size_.x, cached->size_.y, cached->stride_,
+                    QImage::Format_RGBA8888);
+
+                final_pixmap = QPixmap::fromImage(cached_image);
+                icon_pair_rendered = true;
+                icon_from_cache = true;
+            }
+        }
+    }
+
+    if (icon_from_cache) {
+        // Nothing to decode or rasterize
+    } else if (path_ext == u".mif") {
         eka2l1::symfile file_route = io_->open_file(reg.icon_file_path, READ_MODE | BIN_MODE);
         eka2l1::common::create_directories("cache");
 
@@ -324,6 +364,17 @@ void applist_widget::add_registeration_item(eka2l1::apa_app_registry &reg, const
         }
     }
 
+    if (icon_pair_rendered && icon_cacheable && !icon_from_cache) {
+        const QImage rendered_image = final_pixmap.toImage().convertToFormat(QImage::Format_RGBA8888);
+
+        eka2l1::apa_rendered_icon rendered_icon;
+        rendered_icon.size_ = eka2l1::vec2(rendered_image.width(), rendered_image.height());
+        rendered_icon.stride_ = static_cast<std::uint32_t>(rendered_image.bytesPerLine());
+        rendered_icon.pixels_.assign(rendered_image.constBits(), rendered_image.constBits() + rendered_image.bytesPerLine() * rendered_image.height());
+
+        icon_cache->put(icon_key, std::move(rendered_icon));
+    }
+
     QIcon final_icon;
 
     if (!icon_pair_rendered) {
@@ -19,6 +19,7 @@
 
 #include <common/arghandler.h>
 #include <common/cvt.h>
+#include <common/metrics.h>
 #include <common/path.h>
 #include <common/pystr.h>
 #include <qt/cmdhandler.h>
@@ -372,6 +373,30 @@ bool keybind_profile_option_handler(eka2l1::common::arg_parser *parser, void *us
     return true;
 }
 
+bool metrics_csv_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err) {
+    desktop::emulator *emu = reinterpret_cast<desktop::emulator *>(userdata);
+    const char *path = parser->next_token();
+
+    if (!path) {
+        *err = "No CSV file path specified";
+        return false;
+    }
+
+    auto writer = std::make_shared<common::metrics_csv_writer>(path);
+
+    if (!writer->valid()) {
+        *err = fmt::format("Unable to open {} to write metrics", path);
+        return false;
+    }
+
+    // The writer is owned by the callback, and closed with the registry
+    emu->symsys->get_metrics()->add_frame_callback([writer](const common::metrics_frame &frame) {
+        writer->write(frame);
+    });
+
+    return true;
+}
+
 #if ENABLE_PYTHON_SCRIPTING
 bool python_docgen_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err) {
     try {
@@ -36,6 +36,7 @@
 #include <common/algorithm.h>
 #include <common/fileutils.h>
 #include <common/language.h>
+#include <common/metrics.h>
 #include <common/path.h>
 #include <common/platform.h>
 #include <common/rgb.h>
@@ -69,6 +70,10 @@ static constexpr const char *LAST_PACKAGE_FOLDER_SETTING = "lastPackageFolder";
 static constexpr const char *LAST_MOUNT_FOLDER_SETTING = "lastMountFolder";
 static constexpr const char *NO_DEVICE_INSTALL_DISABLE_NOF_SETTING = "disableNoDeviceInstallNotify";
 static constexpr const char *NO_TOUCHSCREEN_DISABLE_WARN_SETTING = "disableNoTouchscreenWarn";
+static constexpr const char *PERFORMANCE_OVERLAY_SETTING = "performanceOverlay";
+
+static constexpr std::uint64_t PERFORMANCE_OVERLAY_REFRESH_US = 500000;
+static constexpr int PERFORMANCE_OVERLAY_MARGIN = 8;
 
 static void mode_change_screen(void *userdata, eka2l1::epoc::screen *scr, const int old_mode) {
     eka2l1::desktop::emulator *state_ptr = reinterpret_cast<eka2l1::desktop::emulator *>(userdata);
@@ -99,7 +104,7 @@ static void draw_emulator_screen(void *userdata, eka2l1::epoc::screen *scr, cons
     }
     
     if (need_wait)
-        state_ptr->graphics_driver->wait_for(&state_ptr->present_status);
+        state_ptr->graphics_driver->wait_for(&state_ptr->present_fence);
 
     eka2l1::desktop::emulator &state = *state_ptr;
     eka2l1::drivers::graphics_command_builder builder;
@@ -173,10 +178,10 @@ static void draw_emulator_screen(void *userdata, eka2l1::epoc::screen *scr, cons
 
     builder.load_backup_state();
 
-    state_ptr->present_status = -100;
+    state_ptr->present_fence.reset();
 
     // Submit, present, and wait for the presenting
-    builder.present(&state_ptr->present_status);
+    builder.present(&state_ptr->present_fence);
 
     eka2l1::drivers::command_list retrieved = builder.retrieve_command_list();
     state.graphics_driver->submit_command_list(retrieved);
@@ -190,6 +195,8 @@ main_window::main_window(QApplication &application, QWidget *parent, eka2l1::des
     , active_screen_number_(0)
     , active_screen_draw_callback_(0)
     , active_screen_mode_change_callback_(0)
+    , performance_overlay_(nullptr)
+    , performance_overlay_callback_(0)
     , settings_dialog_(nullptr)
     , input_complete_callback_(nullptr)
     , input_text_max_len_(0x7FFFFFFF)
@@ -245,10 +252,21 @@ main_window::main_window(QApplication &application, QWidget *parent, eka2l1::des
     ui_->status_bar->addPermanentWidget(current_device_label_, 1);
     ui_->status_bar->addPermanentWidget(screen_status_label_, 1);
 
+    // The display is a native surface, so the overlay needs its own native window to stay on top of it
+    performance_overlay_ = new QLabel(ui_->centralwidget);
+    performance_overlay_->setAttribute(Qt::WA_NativeWindow);
+    performance_overlay_->setAttribute(Qt::WA_TransparentForMouseEvents);
+    performance_overlay_->setStyleSheet("QLabel { background-color: rgba(0, 0, 0, 170); color: white; padding: 4px; font-family: monospace; }");
+    performance_overlay_->setVisible(false);
+
     ui_->action_pause->setEnabled(false);
     ui_->action_restart->setEnabled(false);
+    ui_->action_quick_save_state->setEnabled(false);
+    ui_->action_quick_load_state->setEnabled(false);
 
     addAction(ui_->action_fullscreen);
+    addAction(ui_->action_quick_save_state);
+    addAction(ui_->action_quick_load_state);
 
     refresh_current_device_label();
     make_default_binding_profile();
@@ -306,8 +324,11 @@ main_window::main_window(QApplication &application, QWidget *parent, eka2l1::des
     connect(ui_->action_fullscreen, &QAction::toggled, this, &main_window::on_fullscreen_toogled);
     connect(ui_->action_pause, &QAction::toggled, this, &main_window::on_pause_toggled);
     connect(ui_->action_restart, &QAction::triggered, this, &main_window::on_restart_requested);
+    connect(ui_->action_quick_save_state, &QAction::triggered, this, &main_window::on_quick_save_state_triggered);
+    connect(ui_->action_quick_load_state, &QAction::triggered, this, &main_window::on_quick_load_state_triggered);
     connect(ui_->action_package_manager, &QAction::triggered, this, &main_window::on_package_manager_triggered);
     connect(ui_->action_refresh_app_list, &QAction::triggered, this, &main_window::on_refresh_app_list_requested);
+    connect(ui_->action_performance_overlay, &QAction::toggled, this, &main_window::on_performance_overlay_toggled);
 
     connect(rotate_group_, &QActionGroup::triggered, this, &main_window::on_another_rotation_triggered);
 
@@ -318,6 +339,9 @@ main_window::main_window(QApplication &application, QWidget *parent, eka2l1::des
     connect(this, &main_window::screen_focus_group_changed, this, &main_window::on_screen_current_group_change_callback, Qt::QueuedConnection);
     connect(this, &main_window::input_dialog_open_request, this, &main_window::on_input_dialog_open_request);
     connect(this, &main_window::input_dialog_close_request, this, &main_window::on_input_dialog_close_request);
+    connect(this, &main_window::performance_overlay_update, this, &main_window::on_performance_overlay_update, Qt::QueuedConnection);
+
+    ui_->action_performance_overlay->setChecked(settings.value(PERFORMANCE_OVERLAY_SETTING, false).toBool());
 
     setAcceptDrops(true);
 }
@@ -386,6 +410,11 @@ eka2l1::config::app_setting *main_window::get_active_app_setting() {
 }
 
 main_window::~main_window() {
+    // The system is gone if the emulator thread already exited
+    if (performance_overlay_callback_ && emulator_state_.symsys) {
+        emulator_state_.symsys->get_metrics()->remove_frame_callback(performance_overlay_callback_);
+    }
+
     if (applist_) {
         delete applist_;
     }
@@ -407,6 +436,7 @@ main_window::~main_window() {
 
     delete current_device_label_;
     delete screen_status_label_;
+    delete performance_overlay_;
 
     delete rotate_group_;
     delete ui_;
@@ -518,6 +548,8 @@ void main_window::on_device_set_requested(const int index) {
     ui_->action_pause->setEnabled(false);
     ui_->action_restart->setEnabled(false);
     ui_->action_pause->setChecked(false);
+    ui_->action_quick_save_state->setEnabled(false);
+    ui_->action_quick_load_state->setEnabled(false);
 }
 
 void main_window::on_restart_requested() {
@@ -534,6 +566,50 @@ void main_window::on_pause_toggled(bool checked) {
     }
 }
 
+static std::string get_quick_state_path(eka2l1::desktop::emulator &state) {
+    return eka2l1::add_path(state.conf.storage, "states/quick.state");
+}
+
+void main_window::on_quick_save_state_triggered() {
+    const eka2l1::snapshot_result result = emulator_state_.symsys->save_snapshot(get_quick_state_path(emulator_state_));
+
+    if (result != eka2l1::snapshot_result_ok) {
+        ui_->status_bar->showMessage(tr("Failed to save the state (error %1)").arg(static_cast<int>(result)), 3000);
+        return;
+    }
+
+    // States only rewind the boot they were saved in, there is nothing to load before the first save
+    ui_->action_quick_load_state->setEnabled(true);
+
+    ui_->status_bar->showMessage(tr("State saved"), 3000);
+}
+
+void main_window::on_quick_load_state_triggered() {
+    const eka2l1::snapshot_result result = emulator_state_.symsys->load_snapshot(get_quick_state_path(emulator_state_));
+
+    switch (result) {
+    case eka2l1::snapshot_result_ok:
+        ui_->status_bar->showMessage(tr("State loaded"), 3000);
+        break;
+
+    case eka2l1::snapshot_result_io_error:
+        ui_->status_bar->showMessage(tr("No saved state to load"), 3000);
+        break;
+
+    case eka2l1::snapshot_result_session_mismatch:
+        ui_->status_bar->showMessage(tr("The saved state was taken before the emulator last booted and can't be loaded"), 3000);
+        break;
+
+    case eka2l1::snapshot_result_state_mismatch:
+        ui_->status_bar->showMessage(tr("Threads or chunks changed since the state was saved, it can't be loaded"), 3000);
+        break;
+
+    default:
+        ui_->status_bar->showMessage(tr("Failed to load the state (error %1)").arg(static_cast<int>(result)), 3000);
+        break;
+    }
+}
+
 void main_window::on_relaunch_request() {
     QString program = QApplication::applicationFilePath();
     QStringList arguments = QApplication::arguments();
@@ -560,6 +636,99 @@ void main_window::on_status_bar_update(const std::uint64_t fps) {
     screen_status_label_->setText(QString("%1 FPS").arg(fps));
 }
 
+static std::uint64_t get_frame_counter_increase(const eka2l1::common::metrics_frame &frame, const char *name) {
+    const eka2l1::common::metric_sample *sample = frame.find(name);
+    return sample ? static_cast<std::uint64_t>(sample->value_) : 0;
+}
+
+void main_window::accumulate_performance_overlay(const eka2l1::common::metrics_frame &frame) {
+    performance_overlay_stats &stats = performance_overlay_stats_;
+
+    if (stats.last_refresh_us_ == 0) {
+        // First frame since the overlay was enabled, only use it as a starting point
+        stats.last_refresh_us_ = frame.timestamp_us_;
+        return;
+    }
+
+    stats.frame_count_++;
+    stats.frame_time_us_ += frame.frame_time_us_;
+    stats.cpu_time_us_ += get_frame_counter_increase(frame, "cpu.run_time_us");
+    stats.jit_time_us_ += get_frame_counter_increase(frame, "jit.compile_time_us");
+    stats.hle_time_us_ += get_frame_counter_increase(frame, "hle.server_time_us");
+    stats.gpu_time_us_ += get_frame_counter_increase(frame, "gpu.busy_time_us");
+    stats.audio_underruns_ += get_frame_counter_increase(frame, "audio.underruns");
+
+    if (frame.timestamp_us_ - stats.last_refresh_us_ < PERFORMANCE_OVERLAY_REFRESH_US) {
+        return;
+    }
+
+    // Show the average of the frames since the last refresh, single frames are too noisy to read
+    const double count = static_cast<double>(stats.frame_count_);
+    const double elapsed_secs = static_cast<double>(frame.timestamp_us_ - stats.last_refresh_us_) / 1000000.0;
+
+    const QString text = QString("%1 FPS, %2 ms/frame\n"
+                                 "CPU %3 ms  JIT %4 ms\n"
+                                 "HLE %5 ms  GPU %6 ms\n"
+                                 "Audio underruns %7")
+                             .arg(count / elapsed_secs, 0, 'f', 1)
+                             .arg(stats.frame_time_us_ / count / 1000.0, 0, 'f', 2)
+                             .arg(stats.cpu_time_us_ / count / 1000.0, 0, 'f', 2)
+                             .arg(stats.jit_time_us_ / count / 1000.0, 0, 'f', 2)
+                             .arg(stats.hle_time_us_ / count / 1000.0, 0, 'f', 2)
+                             .arg(stats.gpu_time_us_ / count / 1000.0, 0, 'f', 2)
+                             .arg(stats.audio_underruns_);
+
+    stats = performance_overlay_stats{};
+    stats.last_refresh_us_ = frame.timestamp_us_;
+
+    emit performance_overlay_update(text);
+}
+
+void main_window::place_performance_overlay() {
+    const QPoint display_pos = displayer_->mapTo(ui_->centralwidget, QPoint(0, 0));
+
+    performance_overlay_->adjustSize();
+    performance_overlay_->move(display_pos + QPoint(PERFORMANCE_OVERLAY_MARGIN, PERFORMANCE_OVERLAY_MARGIN));
+    performance_overlay_->raise();
+}
+
+void main_window::on_performance_overlay_toggled(bool checked) {
+    QSettings settings;
+    settings.setValue(PERFORMANCE_OVERLAY_SETTING, checked);
+
+    eka2l1::common::metrics_registry *metrics = emulator_state_.symsys->get_metrics();
+
+    if (checked) {
+        if (!performance_overlay_callback_) {
+            performance_overlay_callback_ = metrics->add_frame_callback([this](const eka2l1::common::metrics_frame &frame) {
+                accumulate_performance_overlay(frame);
+            });
+        }
+    } else {
+        if (performance_overlay_callback_) {
+            // Waits for a snapshot in progress, so the stats are not touched after this
+            metrics->remove_frame_callback(performance_overlay_callback_);
+
+            performance_overlay_callback_ = 0;
+            performance_overlay_stats_ = performance_overlay_stats{};
+        }
+
+        performance_overlay_->setVisible(false);
+    }
+}
+
+void main_window::on_performance_overlay_update(const QString &text) {
+    if (!ui_->action_performance_overlay->isChecked() || !displayer_->isVisible()) {
+        performance_overlay_->setVisible(false);
+        return;
+    }
+
+    performance_overlay_->setText(text);
+    performance_overlay_->setVisible(true);
+
+    place_performance_overlay();
+}
+
 void main_window::on_new_device_added() {
     if (!applist_) {
         ui_->label_al_not_available->setVisible(false);
@@ -827,6 +996,7 @@ void main_window::switch_to_game_display_mode() {
 
     ui_->action_pause->setEnabled(true);
     ui_->action_restart->setEnabled(true);
+    ui_->action_quick_save_state->setEnabled(true);
     ui_->action_rotate_drop_menu->setEnabled(true);
 
     before_margins_ = ui_->layout_centralwidget->contentsMargins();
@@ -976,6 +1146,10 @@ void main_window::resizeEvent(QResizeEvent *event) {
 
     save_ui_layouts();
 
+    if (performance_overlay_->isVisible()) {
+        place_performance_overlay();
+    }
+
     eka2l1::system *system = emulator_state_.symsys.get();
     if (system) {
         eka2l1::epoc::screen *scr = get_current_active_screen();
@@ -56,7 +56,7 @@ namespace eka2l1::desktop {
         , init_app_launched(false)
         , winserv(nullptr)
         , sys_reset_cbh(0)
-        , present_status(0) {
+        , present_fence(true) {
     }
 
     void emulator::stage_one() {
@@ -77,6 +77,10 @@ namespace eka2l1::desktop {
             log::filterings->parse_filter_string(conf.log_filter);
         }
 
+        if (conf.binary_log && !log::start_binary_log("EKA2L1.binlog")) {
+            LOG_WARN(FRONTEND_CMDLINE, "Unable to open the binary log file, falling back to text logging");
+        }
+
         LOG_INFO(FRONTEND_CMDLINE, "EKA2L1 v0.0.1 ({}-{})", GIT_BRANCH, GIT_COMMIT_HASH);
         app_settings = std::make_unique<config::app_settings>(&conf);
 
@@ -148,9 +152,19 @@ namespace eka2l1::desktop {
                 break;
             }
 
-            // Create audio driver
-            audio_driver = drivers::make_audio_driver(drivers::audio_driver_backend::cubeb, conf.audio_master_volume,
-                player_be);
+            // Create audio driver. The null backend is for machines without an output device (CI, benchmarking)
+            drivers::audio_driver_backend audio_be = drivers::audio_driver_backend::cubeb;
+            drivers::null_audio_options null_audio_opts;
+
+            if (common::lowercase_string(conf.audio_backend) == "null") {
+                audio_be = drivers::audio_driver_backend::null;
+
+                null_audio_opts.sample_rate_ = static_cast<std::uint32_t>(common::max(0, conf.audio_null_sample_rate));
+                null_audio_opts.period_frames_ = static_cast<std::uint32_t>(common::max(0, conf.audio_null_period_frames));
+                null_audio_opts.dump_path_ = conf.audio_null_dump_path;
+            }
+
+            audio_driver = drivers::make_audio_driver(audio_be, conf.audio_master_volume, player_be, null_audio_opts);
 
             if (audio_driver) {
                 audio_driver->set_bank_path(drivers::MIDI_BANK_TYPE_HSB, conf.hsb_bank_path);
@@ -21,6 +21,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/algorithm.h>
 #include <common/arghandler.h>
 #include <common/configure.h>
 #include <common/cvt.h>
@@ -36,6 +37,7 @@
 #include <qt/thread.h>
 #include <qt/utils.h>
 
+#include <drivers/graphics/backend/software/graphics_software.h>
 #include <drivers/graphics/emu_window.h>
 #include <drivers/graphics/graphics.h>
 #include <drivers/input/common.h>
@@ -147,8 +149,20 @@ namespace eka2l1::desktop {
         state.window->set_userdata(&state);
 
         // We got window and context ready (OpenGL, let makes stuff now)
-        // TODO: Configurable
-        state.graphics_driver = drivers::create_graphics_driver(drivers::graphic_api::opengl, state.window->get_window_system_info());
+        drivers::graphic_api graphics_api = drivers::graphic_api::opengl;
+
+        if (common::lowercase_string(state.conf.graphics_backend) == "software") {
+            // Rasterize on the CPU. Nothing is shown on the window, frames can be dumped instead
+            graphics_api = drivers::graphic_api::software;
+        }
+
+        state.graphics_driver = drivers::create_graphics_driver(graphics_api, state.window->get_window_system_info());
+
+        if ((graphics_api == drivers::graphic_api::software) && !state.conf.graphics_frame_dump_dir.empty()) {
+            static_cast<drivers::software_graphics_driver *>(state.graphics_driver.get())->set_frame_dump_directory(
+                state.conf.graphics_frame_dump_dir);
+        }
+
         state.symsys->set_graphics_driver(state.graphics_driver.get());
 
         drivers::emu_window *window = state.window;
@@ -341,6 +355,9 @@ namespace eka2l1::desktop {
         parser.add("--keybindprofile, -kbp", "Set a keybind profile to associate with the emulator launch. Don't include any file extension here.\n"
                                               "\t Example: eka2l1 --kbp controller_for_octopus",
             keybind_profile_option_handler);
+        parser.add("--metrics-csv", "Write the performance metrics of every frame to a CSV file.\n"
+                                    "\t\t\t  Example: eka2l1 --run Bounce --metrics-csv bounce.csv",
+            metrics_csv_option_handler);
 
 #if ENABLE_PYTHON_SCRIPTING
         parser.add("--gendocs", "Generate Python documentation", python_docgen_option_handler);
@@ -55,6 +55,7 @@ ffi.cdef([[
     thread *eka2l1_process_first_thread(process *pr);
     const char *eka2l1_process_executable_path(process *pr);
     const char *eka2l1_process_name(process *pr);
+    void eka2l1_process_static_data_usage(process *pr, uint64_t *private_bytes, uint64_t *shared_bytes);
 
     thread *eka2l1_get_current_thread();
     thread *eka2l1_next_thread_in_process(thread *thr);
@@ -326,6 +327,18 @@ function kernel.process:executablePath()
     return ret
 end
 
+--- Get the host memory used by the static data of the DLLs that this process loaded.
+---
+--- Static data is shared with other processes until it is written to.
+--- @return The number of private bytes, and the number of bytes still shared.
+function kernel.process:staticDataUsage()
+    local privateBytes = ffi.new('uint64_t[1]')
+    local sharedBytes = ffi.new('uint64_t[1]')
+
+    ffi.C.eka2l1_process_static_data_usage(self.impl, privateBytes, sharedBytes)
+    return tonumber(privateBytes[0]), tonumber(sharedBytes[0])
+end
+
 --- Read a certain amount of data from the process's memory.
 ---
 --- @param addr The address to read data from.
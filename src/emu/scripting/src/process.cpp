@@ -198,4 +198,16 @@ EKA2L1_EXPORT const char *eka2l1_process_executable_path(eka2l1::scripting::proc
 EKA2L1_EXPORT eka2l1::scripting::thread *eka2l1_process_first_thread(eka2l1::scripting::process *pr) {
     return new eka2l1::scripting::thread(reinterpret_cast<std::uint64_t>(pr->get_process_handle()->get_primary_thread()));
 }
+
+EKA2L1_EXPORT void eka2l1_process_static_data_usage(eka2l1::scripting::process *pr, std::uint64_t *private_bytes, std::uint64_t *shared_bytes) {
+    const eka2l1::kernel::static_data_usage usage = pr->get_process_handle()->get_static_data_usage();
+
+    if (private_bytes) {
+        *private_bytes = usage.private_bytes_;
+    }
+
+    if (shared_bytes) {
+        *shared_bytes = usage.shared_bytes_;
+    }
+}
 }
\ No newline at end of file
@@ -26,6 +26,7 @@
 #include <utils/des.h>
 #include <vfs/vfs.h>
 
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -33,6 +34,8 @@ namespace eka2l1 {
     class io_system;
     class fbs_server;
     class fs_server;
+    class apa_registry_snapshot;
+    class apa_icon_cache;
 
     struct fbsbitmap;
 
@@ -196,6 +199,9 @@ namespace eka2l1 {
         fbs_server *fbsserv;
         fs_server *fsserv;
 
+        std::unique_ptr<apa_registry_snapshot> snapshot_;
+        std::unique_ptr<apa_icon_cache> icon_cache_;
+
         enum {
             AL_INITED = 0x1
         };
@@ -205,9 +211,6 @@ namespace eka2l1 {
 
         bool delete_registry(const std::u16string &rsc_path);
 
-        bool load_registry(eka2l1::io_system *io, const std::u16string &path, drive_number land_drive,
-            const language ideal_lang = language::en);
-
         bool load_registry_oldarch(eka2l1::io_system *io, const std::u16string &path, drive_number land_drive,
             const language ideal_lang = language::en);
 
@@ -217,7 +220,23 @@ namespace eka2l1 {
 
         bool rescan_registries_on_drive_oldarch(eka2l1::io_system *io, const drive_number num);
         bool rescan_registries_on_drive_newarch(eka2l1::io_system *io, const drive_number num);
-        bool rescan_registries_on_drive_newarch_with_path(eka2l1::io_system *io, const drive_number num, const std::u16string &path);
+
+        /**
+         * \brief Rescan EKA2 registrations on all drives specified in the mask.
+         *
+         * Registrations whose files did not change since the last snapshot are taken from the snapshot.
+         * The rest are parsed concurrently on host worker threads, then merged into the list.
+         *
+         * \param io          The IO system.
+         * \param drive_mask  Bit N set means drive A + N is scanned.
+         *
+         * \returns True if the registration list was modified.
+         */
+        bool rescan_registries_newarch(eka2l1::io_system *io, const std::uint32_t drive_mask);
+
+        std::string get_snapshot_path();
+        std::string get_icon_cache_path();
+        void save_snapshot_if_dirty();
 
         /*! \brief Get the number of screen shared for an app. 
          * 
@@ -300,6 +319,15 @@ namespace eka2l1 {
         bool launch_app(apa_app_registry &registry, epoc::apa::command_line &parameter, kernel::uid *thread_id);
         std::optional<apa_app_masked_icon_bitmap> get_icon(apa_app_registry &registry, const std::int8_t index);
 
+        /**
+         * \brief Get the cache of app icons rendered by the frontends.
+         *
+         * \returns Nullptr if the server is not initialized yet.
+         */
+        apa_icon_cache *get_icon_cache() {
+            return icon_cache_.get();
+        }
+
         std::mutex list_access_mut_;
 
         bool rescan_registries(eka2l1::io_system *io);
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/vecx.h>
+#include <services/window/common.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1 {
+    namespace common {
+        class ro_stream;
+    }
+
+    /**
+     * @brief Identity of a rendered icon.
+     *
+     * The source is identified by the hash of its content rather than its path, so that a reinstalled
+     * or patched app never gets a stale icon.
+     */
+    struct apa_icon_cache_key {
+        std::uint64_t source_hash_{ 0 }; ///< Hash of the icon file content.
+        std::int32_t index_{ 0 }; ///< Index of the icon in the source file.
+        eka2l1::vec2 size_{ 0, 0 }; ///< Size that the icon was rendered at. Zero for the native size.
+        epoc::display_mode mode_{ epoc::display_mode::color16ma }; ///< Display mode of the rendered pixels.
+
+        bool operator==(const apa_icon_cache_key &rhs) const {
+            return (source_hash_ == rhs.source_hash_) && (index_ == rhs.index_) && (size_ == rhs.size_) && (mode_ == rhs.mode_);
+        }
+
+        std::uint64_t digest() const;
+    };
+
+    /**
+     * @brief An icon rendered to raw pixels.
+     */
+    struct apa_rendered_icon {
+        eka2l1::vec2 size_{ 0, 0 };
+        std::uint32_t stride_{ 0 };
+        std::vector<std::uint8_t> pixels_;
+    };
+
+    struct apa_icon_cache_stats {
+        std::uint64_t hits_; ///< Lookups served from memory or disk.
+        std::uint64_t disk_hits_; ///< Lookups that had to load the entry from disk.
+        std::uint64_t misses_; ///< Lookups that found nothing, so the icon had to be rendered.
+        std::uint64_t stores_; ///< Number of rendered icons added to the cache.
+        std::uint32_t entry_count_; ///< Number of entries currently in memory.
+    };
+
+    /**
+     * @brief Persistent cache of rendered app icons.
+     *
+     * Decoding MBM icons and rasterizing SVG icons is done again on every boot for every app. Rendered
+     * results are kept in memory and written to one file per entry in the cache directory, so lookups
+     * on the next boot only read the pixels back.
+     *
+     * The cache is thread-safe.
+     */
+    class apa_icon_cache {
+        std::string root_;
+
+        std::mutex lock_;
+        std::unordered_map<std::uint64_t, std::shared_ptr<const apa_rendered_icon>> entries_;
+
+        std::atomic<std::uint64_t> hits_;
+        std::atomic<std::uint64_t> disk_hits_;
+        std::atomic<std::uint64_t> misses_;
+        std::atomic<std::uint64_t> stores_;
+
+        std::string get_entry_path(const apa_icon_cache_key &key) const;
+
+        std::shared_ptr<const apa_rendered_icon> load_entry(const apa_icon_cache_key &key);
+        bool save_entry(const apa_icon_cache_key &key, const apa_rendered_icon &icon);
+
+    public:
+        /**
+         * @brief Construct the cache.
+         *
+         * @param root Host directory where entries are persisted. Empty to keep entries in memory only.
+         */
+        explicit apa_icon_cache(const std::string &root);
+
+        /**
+         * @brief Hash the whole content of an icon source file, for use in a key.
+         */
+        static std::uint64_t hash_source(common::ro_stream *stream);
+        static std::uint64_t hash_source(const std::uint8_t *data, const std::size_t size);
+
+        /**
+         * @brief Look up a rendered icon.
+         *
+         * @returns The icon, or nullptr if it has not been rendered yet.
+         */
+        std::shared_ptr<const apa_rendered_icon> get(const apa_icon_cache_key &key);
+
+        /**
+         * @brief Add a rendered icon, and persist it.
+         */
+        std::shared_ptr<const apa_rendered_icon> put(const apa_icon_cache_key &key, apa_rendered_icon &&icon);
+
+        apa_icon_cache_stats get_stats();
+    };
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <services/applist/applist.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace eka2l1 {
+    namespace common {
+        class chunkyseri;
+    }
+
+    /**
+     * @brief Identity of a file on the VFS at the time it was parsed.
+     *
+     * An empty stamp (zero size and modify time) describes a file that did not exist.
+     */
+    struct apa_file_stamp {
+        std::uint64_t size_{ 0 };
+        std::uint64_t last_modified_{ 0 };
+
+        bool operator==(const apa_file_stamp &rhs) const {
+            return (size_ == rhs.size_) && (last_modified_ == rhs.last_modified_);
+        }
+
+        bool operator!=(const apa_file_stamp &rhs) const {
+            return !(*this == rhs);
+        }
+    };
+
+    apa_file_stamp get_apa_file_stamp(io_system *io, const std::u16string &path);
+
+    /**
+     * @brief A parsed registration, plus the stamps of every file it was built from.
+     */
+    struct apa_registry_snapshot_entry {
+        apa_file_stamp rsc_stamp_;
+
+        std::u16string localised_path_;
+        apa_file_stamp localised_stamp_;
+
+        apa_app_registry reg_;
+
+        /**
+         * @brief Check if this entry is still valid, given the current stamp of the registration file.
+         */
+        bool up_to_date(io_system *io, const apa_file_stamp &current_rsc_stamp) const;
+    };
+
+    /**
+     * @brief Persisted cache of parsed EKA2 app registrations.
+     *
+     * Entries are keyed by the lowercased path of the registration file, so that on the next boot only
+     * registrations whose registration or localisable file changed need to be parsed again.
+     */
+    class apa_registry_snapshot {
+        std::unordered_map<std::u16string, apa_registry_snapshot_entry> entries_;
+        bool dirty_{ false };
+
+        bool do_state(common::chunkyseri &seri);
+
+    public:
+        apa_registry_snapshot_entry *get(const std::u16string &rsc_path);
+
+        void set(const std::u16string &rsc_path, apa_registry_snapshot_entry &&entry);
+        bool remove(const std::u16string &rsc_path);
+
+        bool load(const std::string &host_path);
+        bool save(const std::string &host_path);
+
+        bool dirty() const {
+            return dirty_;
+        }
+
+        std::size_t size() const {
+            return entries_.size();
+        }
+    };
+}
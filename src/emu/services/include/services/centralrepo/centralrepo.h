@@ -24,6 +24,7 @@
 
 #include <atomic>
 #include <map>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -76,7 +77,7 @@ namespace eka2l1 {
 
         // These drives must be internal, aka not removeable
         std::vector<drive_number> avail_drives;
-        std::mutex serv_lock;
+        std::recursive_mutex serv_lock;
 
         bool first_repo = true;
 
@@ -40,6 +40,8 @@ namespace eka2l1 {
     }
 
     namespace service {
+        class server;
+
         /**
          * \brief Context struct, wrapping around IPC message object.
          * 
@@ -55,6 +57,7 @@ namespace eka2l1 {
 
             eka2l1::system *sys; ///< The system instance pointer.
             ipc_msg_ptr msg; ///< The IPC message that this struct wrapped.
+            server *svr = nullptr; ///< The HLE server processing the message.
 
             bool signaled = false; ///< A safe-check if a request status is set. This allow setting multiple
                 ///< time with only one time it signaled the client.
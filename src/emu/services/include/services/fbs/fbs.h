@@ -30,6 +30,7 @@
 #include <services/fbs/font.h>
 #include <services/fbs/font_atlas.h>
 #include <services/fbs/font_store.h>
+#include <services/fbs/mbm_cache.h>
 #include <services/framework.h>
 #include <services/window/common.h>
 
@@ -361,6 +362,8 @@ namespace eka2l1 {
         std::unique_ptr<compress_queue> compressor;
         std::unique_ptr<std::thread> compressor_thread;
 
+        mbm_decode_cache decode_cache;
+
         epoc::open_font_session_cache_list *session_cache_list;
         epoc::open_font_session_cache_link *session_cache_link;
 
@@ -482,10 +485,17 @@ namespace eka2l1 {
          * \param idx_          Index of the bitmap in MBM. Index base is 0.
          * \param size_         Reference variable to assign the new size in case the data is decompressed.
          * \param err_code      Pointer to integer which will holds error code. Must not be null.
+         * \param decode_cache_path Path of the MBM file if it is read-only, so that all its bitmaps are decoded
+         *                          at once and kept for later loads. Empty to only decode this bitmap.
          * 
          * \return Pointer to the data.
          */
-        void *load_data_to_rom(loader::mbm_file &mbmf_, const std::size_t idx_, std::size_t &size_decomp, int *err_code);
+        void *load_data_to_rom(loader::mbm_file &mbmf_, const std::size_t idx_, std::size_t &size_decomp, int *err_code,
+            const std::u16string &decode_cache_path = u"");
+
+        mbm_decode_cache &get_decode_cache() {
+            return decode_cache;
+        }
 
         /*! \brief Use to Allocate structure from server side.
          *
@@ -513,6 +523,12 @@ namespace eka2l1 {
          */
         bool free_large_data(const void *ptr);
 
+        /**
+         * \brief   Get usage and fragmentation statistics of the shared and large chunk allocators.
+         * \returns False if the server has not been initialized yet.
+         */
+        bool get_chunk_allocator_stats(common::block_allocator_stats &shared_stats, common::block_allocator_stats &large_stats);
+
         /*! \brief Use to Allocate structure from server side.
          *
          * Symbian usually avoids sendings struct that usually changes its structure
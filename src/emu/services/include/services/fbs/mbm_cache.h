@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1 {
+    namespace common {
+        class ro_stream;
+        class thread_pool;
+    }
+
+    struct mbm_decode_cache_stats {
+        std::uint64_t hits_; ///< Number of bitmap loads served from decoded data.
+        std::uint64_t files_decoded_; ///< Number of MBM files decoded as a whole.
+        std::uint64_t bitmaps_decoded_; ///< Number of bitmaps decoded on the worker threads.
+        std::size_t total_size_; ///< Size of decoded data currently held, in bytes.
+    };
+
+    /**
+     * @brief Decoded bitmaps of read-only MBM files.
+     *
+     * Apps usually load bitmaps from the same MBM one by one, and each load seeks through the file and
+     * decompresses again. Files on the ROM drive never change, so on the first load from such file, every
+     * bitmap in it is decompressed at once on host worker threads. Later loads only copy the decoded data.
+     *
+     * Files too large compared to the cache budget are left alone, and least recently used files are evicted
+     * when the budget is exceeded.
+     */
+    class mbm_decode_cache {
+        struct decoded_file {
+            std::vector<std::vector<std::uint8_t>> bitmaps_; ///< Empty for bitmaps that failed to decode.
+            std::size_t total_size_ = 0;
+            std::uint64_t last_use_ = 0;
+            bool cacheable_ = false;
+        };
+
+        std::unordered_map<std::u16string, decoded_file> files_;
+        std::unique_ptr<common::thread_pool> pool_;
+
+        std::size_t max_size_;
+        std::uint64_t use_counter_;
+
+        mbm_decode_cache_stats stats_;
+
+        bool decode_file(common::ro_stream *stream, decoded_file &file);
+        void evict_until_fit(const std::size_t new_size);
+
+    public:
+        explicit mbm_decode_cache(const std::size_t max_size);
+        ~mbm_decode_cache();
+
+        /**
+         * @brief Get the decoded data of a bitmap, decoding the whole file on first use.
+         *
+         * @param path      Path of the MBM file. The file must be read-only.
+         * @param stream    Stream of the MBM file, used to read the whole file when it is not decoded yet.
+         * @param index     Index of the bitmap in the file.
+         *
+         * @returns Decoded data of the bitmap, or null if the file is not cached. The pointer is valid until
+         *          the next call.
+         */
+        const std::vector<std::uint8_t> *get(const std::u16string &path, common::ro_stream *stream, const std::size_t index);
+
+        mbm_decode_cache_stats get_stats() const {
+            return stats_;
+        }
+    };
+}
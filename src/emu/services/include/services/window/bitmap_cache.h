@@ -30,6 +30,7 @@
 #include <services/fbs/bitmap.h>
 
 #include <array>
+#include <vector>
 
 namespace eka2l1 {
     class kernel_system;
@@ -62,6 +63,9 @@ namespace eka2l1::epoc {
 
         std::int64_t last_free{ 0 };
 
+        // Holds decompressed data that still needs conversion before upload. Only grows.
+        std::vector<std::uint8_t> decode_scratch_;
+
     protected:
         std::uint64_t hash_bitwise_bitmap(epoc::bitwise_bitmap *bw_bmp);
 
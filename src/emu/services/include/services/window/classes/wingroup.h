@@ -78,6 +78,13 @@ namespace eka2l1::epoc {
         void lost_focus();
         void gain_focus();
 
+        /**
+         * @brief Size the JIT code cache for the app that owns this group.
+         *
+         * Called when the group becomes the focus. The group of a process that inherits settings uses its parent app's.
+         */
+        void apply_code_cache_setting();
+
         void queue_message_data(const std::uint8_t *data, const std::size_t data_size);
         void get_message_data(std::uint8_t *data, std::size_t &dest_size);
     };
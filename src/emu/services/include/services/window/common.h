@@ -34,6 +34,7 @@
 #include <common/vecx.h>
 #include <common/types.h>
 
+#include <drivers/graphics/common.h>
 #include <drivers/graphics/emu_window.h>
 #include <services/window/keys.h>
 
@@ -46,6 +47,10 @@ enum {
     remote_slot = 2
 };
 
+namespace eka2l1::drivers {
+    class graphics_command_builder;
+}
+
 namespace eka2l1::epoc {
     enum {
         base_handle = 0x40000000
@@ -87,6 +92,21 @@ namespace eka2l1::epoc {
     bool is_display_mode_alpha(const display_mode disp_mode);
     int get_bpp_from_display_mode(const epoc::display_mode bpp);
     int get_byte_width(const std::uint32_t pixels_width, const std::uint8_t bits_per_pixel);
+
+    /**
+     * @brief Queue the upload of a rectangle of a guest screen buffer to a driver bitmap.
+     *
+     * Rows of the buffer are read with the pitch returned by get_byte_width for the screen width.
+     *
+     * @param builder       The builder to queue the upload to.
+     * @param h             Handle to the bitmap, with the screen's bits per pixel.
+     * @param buffer        Start of the screen buffer.
+     * @param screen_size   Size of the screen buffer, in pixels.
+     * @param bpp           Bits per pixel of the screen buffer. Must be 8 or more.
+     * @param area          The rectangle to upload. Must be inside the screen.
+     */
+    void upload_screen_rect(drivers::graphics_command_builder &builder, const drivers::handle h, const std::uint8_t *buffer,
+        const eka2l1::vec2 &screen_size, const int bpp, const eka2l1::rect &area);
     epoc::display_mode string_to_display_mode(const std::string &disp_str);
     std::string display_mode_to_string(const epoc::display_mode disp_mode);
     epoc::display_mode get_display_mode_from_bpp(const int bpp, const bool has_color);
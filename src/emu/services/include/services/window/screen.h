@@ -20,6 +20,7 @@
 #pragma once
 
 #include <common/container.h>
+#include <common/region.h>
 #include <common/vecx.h>
 
 #include <drivers/graphics/common.h>
@@ -44,6 +45,10 @@ namespace eka2l1 {
 
     class window_server;
     class ntimer;
+
+    namespace common {
+        class metrics_registry;
+    }
 }
 
 namespace eka2l1::drivers {
@@ -114,6 +119,11 @@ namespace eka2l1::epoc {
 
         bool sync_screen_buffer = false;
 
+        std::vector<std::uint8_t> dsa_shadow_buffer_; ///< Screen buffer content last uploaded to the DSA texture.
+        std::vector<std::uint8_t> readback_buffer_; ///< Scratch for reading back parts of the screen texture.
+
+        common::metrics_registry *metrics_ = nullptr; ///< Frame snapshots are taken when the first screen is presented.
+
         enum {
             FLAG_NEED_RECALC_VISIBLE = 1 << 0,
             FLAG_ORIENTATION_LOCK = 1 << 1,
@@ -186,7 +196,13 @@ namespace eka2l1::epoc {
 
         const void get_max_num_colors(int &colors, int &greys) const;
 
-        void sync_screen_buffer_data(drivers::graphics_driver *driver);
+        /**
+         * \brief Read the screen texture back to the screen buffer.
+         *
+         * \param driver   The graphics driver associated with the screen.
+         * \param dirty    Region of the screen that changed since the last sync. Null to read back everything.
+         */
+        void sync_screen_buffer_data(drivers::graphics_driver *driver, const common::region *dirty = nullptr);
 
         /**
          * \brief Set screen mode.
@@ -218,7 +234,7 @@ namespace eka2l1::epoc {
         void resize(drivers::graphics_driver *driver, const eka2l1::vec2 &new_size);
 
         void deinit(drivers::graphics_driver *driver);
-        bool redraw(drivers::graphics_command_builder &builder, const bool need_bind);
+        bool redraw(drivers::graphics_command_builder &builder, const bool need_bind, common::region *drawn_region = nullptr);
 
         /**
          * \brief Redraw the screen.
@@ -28,7 +28,12 @@ namespace eka2l1::epoc {
     }
 
     bool chunk_allocator::expand(std::size_t target) {
-        return target_chunk->adjust(common::min<std::size_t>(target_chunk->max_size(), target));
+        // The allocator assumes the whole target is committed on success, never clamp it
+        if (target > target_chunk->max_size()) {
+            return false;
+        }
+
+        return target_chunk->adjust(target);
     }
 
     address chunk_allocator::to_address(const void *addr, kernel::process *pr) {
@@ -20,6 +20,8 @@
 
 #include <services/applist/applist.h>
 #include <services/applist/op.h>
+#include <services/applist/iconcache.h>
+#include <services/applist/snapshot.h>
 #include <services/fs/fs.h>
 #include <services/context.h>
 #include <services/fbs/fbs.h>
@@ -29,11 +31,13 @@
 #include <common/log.h>
 #include <common/path.h>
 #include <common/pystr.h>
+#include <common/threadpool.h>
 #include <common/types.h>
 
 #include <common/common.h>
 #include <kernel/kernel.h>
 #include <loader/rsc.h>
+#include <system/devices.h>
 #include <system/epoc.h>
 #include <utils/apacmd.h>
 #include <utils/bafl.h>
@@ -41,6 +45,8 @@
 #include <vfs/vfs.h>
 
 #include <functional>
+#include <set>
+#include <unordered_map>
 #include <utils/err.h>
 
 #include <config/config.h>
@@ -69,7 +75,8 @@ namespace eka2l1 {
         : service::typical_server(sys, get_app_list_server_name_by_epocver(sys->get_symbian_version_use()))
         , drive_change_handle_(0)
         , fbsserv(nullptr)
-        , fsserv(nullptr) {
+        , fsserv(nullptr)
+        , snapshot_(std::make_unique<apa_registry_snapshot>()) {
     }
 
     applist_server::~applist_server() {
@@ -163,35 +170,20 @@ namespace eka2l1 {
         return true;
     }
 
-    bool applist_server::load_registry(eka2l1::io_system *io, const std::u16string &path, drive_number land_drive,
-        const language ideal_lang) {
+    static bool parse_registry(eka2l1::io_system *io, const std::u16string &path, drive_number land_drive,
+        const language ideal_lang, apa_registry_snapshot_entry &entry) {
         // common::benchmarker marker(__FUNCTION__);
-        const std::u16string nearest_path = utils::get_nearest_lang_file(io, path, ideal_lang, land_drive);
-        symfile f = io->open_file(nearest_path, READ_MODE | BIN_MODE);
+        symfile f = io->open_file(path, READ_MODE | BIN_MODE);
 
         if (!f) {
             return false;
         }
 
-        auto find_result = std::find_if(regs.begin(), regs.end(), [=](const apa_app_registry &reg) {
-            return (common::compare_ignore_case(reg.rsc_path, nearest_path) == 0);
-        });
-
-        std::uint64_t last_modified = f->last_modify_since_0ad();
-
-        if (find_result != regs.end()) {
-            if (find_result->last_rsc_modified != last_modified) {
-                regs.erase(find_result);
-            } else {
-                return false;
-            }
-        }
-
-        apa_app_registry reg;
+        apa_app_registry &reg = entry.reg_;
 
         reg.land_drive = land_drive;
-        reg.rsc_path = nearest_path;
-        reg.last_rsc_modified = last_modified;
+        reg.rsc_path = path;
+        reg.last_rsc_modified = f->last_modify_since_0ad();
 
         auto read_rsc_from_file = [](symfile &f, const int id, const bool confirm_sig, std::uint32_t *uid3) -> std::vector<std::uint8_t> {
             eka2l1::ro_file_stream std_rsc_raw(f.get());
@@ -250,20 +242,29 @@ namespace eka2l1 {
             ideal_lang, land_drive);
 
         if (localised_path.empty()) {
-            return true;
+            return false;
         }
 
-        f = io->open_file(localised_path, READ_MODE | BIN_MODE);
+        entry.localised_path_ = localised_path;
+        entry.localised_stamp_ = get_apa_file_stamp(io, localised_path);
 
-        dat = read_rsc_from_file(f, reg.localised_info_rsc_id, true, nullptr);
+        f = io->open_file(localised_path, READ_MODE | BIN_MODE);
 
-        common::ro_buf_stream localised_app_info_resource_stream(&dat[0], dat.size());
+        if (f) {
+            dat = read_rsc_from_file(f, reg.localised_info_rsc_id, true, nullptr);
+        } else {
+            dat.clear();
+        }
 
         // Read localised info
         // Ignore result
-        if (localised_app_info_resource_stream.valid()) {
-            read_localised_registration_info(reinterpret_cast<common::ro_stream *>(&localised_app_info_resource_stream),
-                reg, land_drive);
+        if (!dat.empty()) {
+            common::ro_buf_stream localised_app_info_resource_stream(&dat[0], dat.size());
+
+            if (localised_app_info_resource_stream.valid()) {
+                read_localised_registration_info(reinterpret_cast<common::ro_stream *>(&localised_app_info_resource_stream),
+                    reg, land_drive);
+            }
         }
 
         LOG_INFO(SERVICE_APPLIST, "Found app: {}, uid: 0x{:X}",
@@ -289,7 +290,6 @@ namespace eka2l1 {
             }
         }
 
-        regs.push_back(std::move(reg));
         return true;
     }
 
@@ -333,6 +333,7 @@ namespace eka2l1 {
                 modified = rescan_registries_on_drive_oldarch(io, drv);
             } else {
                 modified = rescan_registries_on_drive_newarch(io, drv);
+                save_snapshot_if_dirty();
             }
 
             break;
@@ -375,39 +376,205 @@ namespace eka2l1 {
     }
 
     bool applist_server::rescan_registries_on_drive_newarch(eka2l1::io_system *io, const drive_number drv) {
-        const std::u16string import_rsc_path = std::u16string(1, drive_to_char16(drv)) + u":\\Private\\10003a3f\\import\\apps\\" + NEWARCH_REG_FILE_SEARCH_WILDCARD16;
-        const std::u16string rom_rscs_path = std::u16string(1, drive_to_char16(drv)) + u":\\Private\\10003a3f\\apps\\" + NEWARCH_REG_FILE_SEARCH_WILDCARD16;
+        return rescan_registries_newarch(io, 1 << (drv - drive_a));
+    }
+
+    struct apa_registry_candidate {
+        std::u16string path_;
+        drive_number land_drive_;
+        apa_file_stamp stamp_;
+    };
+
+    static void collect_registry_candidates(eka2l1::io_system *io, const drive_number drv, const std::u16string &path,
+        const language ideal_lang, std::vector<apa_registry_candidate> &candidates, std::set<std::u16string> &seen) {
+        auto reg_dir = io->open_dir(path, {}, io_attrib_include_file);
+
+        if (!reg_dir) {
+            return;
+        }
+
+        while (auto ent = reg_dir->get_next_entry()) {
+            if (ent->type != io_component_type::file) {
+                continue;
+            }
+
+            const std::u16string listed_path = common::utf8_to_ucs2(ent->full_path);
+            const std::u16string nearest_path = utils::get_nearest_lang_file(io, listed_path, ideal_lang, drv);
+
+            // Every language variant of a registration resolves to the same nearest file
+            if (!seen.insert(common::lowercase_ucs2_string(nearest_path)).second) {
+                continue;
+            }
+
+            apa_registry_candidate candidate;
+            candidate.path_ = nearest_path;
+            candidate.land_drive_ = drv;
+
+            if (common::compare_ignore_case(nearest_path, listed_path) == 0) {
+                candidate.stamp_.size_ = ent->size;
+                candidate.stamp_.last_modified_ = ent->last_write;
+            } else {
+                candidate.stamp_ = get_apa_file_stamp(io, nearest_path);
+            }
+
+            candidates.push_back(std::move(candidate));
+        }
+    }
+
+    bool applist_server::rescan_registries_newarch(eka2l1::io_system *io, const std::uint32_t drive_mask) {
+        const language ideal_lang = kern->get_current_language();
+
+        std::vector<apa_registry_candidate> candidates;
+        std::set<std::u16string> seen;
+
+        for (std::uint8_t i = 0; i < drive_count; i++) {
+            if (drive_mask & (1 << i)) {
+                const drive_number drv = static_cast<drive_number>(static_cast<int>(drive_a) + i);
+                const std::u16string drive_prefix = std::u16string(1, drive_to_char16(drv)) + u":\\Private\\10003a3f\\";
+
+                // Supposedly to only scan in ROM, but it's not really that strict on the emulator ;)
+                collect_registry_candidates(io, drv, drive_prefix + u"apps\\" + NEWARCH_REG_FILE_SEARCH_WILDCARD16,
+                    ideal_lang, candidates, seen);
+                collect_registry_candidates(io, drv, drive_prefix + u"import\\apps\\" + NEWARCH_REG_FILE_SEARCH_WILDCARD16,
+                    ideal_lang, candidates, seen);
+            }
+        }
 
         bool modded = false;
 
-        // Supposedly to only scan in ROM, but it's not really that strict on the emulator ;)
-        if (rescan_registries_on_drive_newarch_with_path(io, drv, rom_rscs_path)) {
+        // Delete entries on the scanned drives that no longer exist...
+        const std::size_t prev = regs.size();
+
+        common::erase_elements(regs, [&](const apa_app_registry &reg) {
+            if (!(drive_mask & (1 << (reg.land_drive - drive_a)))) {
+                return false;
+            }
+
+            if (seen.find(common::lowercase_ucs2_string(reg.rsc_path)) != seen.end()) {
+                return false;
+            }
+
+            snapshot_->remove(reg.rsc_path);
+            return true;
+        });
+
+        if (prev != regs.size()) {
             modded = true;
         }
 
-        if (rescan_registries_on_drive_newarch_with_path(io, drv, import_rsc_path)) {
-            modded = true;
+        std::unordered_map<std::u16string, std::size_t> existing;
+        for (std::size_t i = 0; i < regs.size(); i++) {
+            existing.emplace(common::lowercase_ucs2_string(regs[i].rsc_path), i);
         }
 
-        return modded;
-    }
+        std::vector<const apa_registry_candidate *> to_parse;
 
-    bool applist_server::rescan_registries_on_drive_newarch_with_path(eka2l1::io_system *io, const drive_number drv, const std::u16string &path) {
-        auto reg_dir = io->open_dir(path, {}, io_attrib_include_file);
-        bool modded = false;
+        for (const apa_registry_candidate &candidate : candidates) {
+            apa_registry_snapshot_entry *entry = snapshot_->get(candidate.path_);
 
-        if (reg_dir) {
-            while (auto ent = reg_dir->get_next_entry()) {
-                if (ent->type == io_component_type::file) {
-                    if (load_registry(io, common::utf8_to_ucs2(ent->full_path), drv, kern->get_current_language()))
-                        modded = true;
+            if (entry && entry->up_to_date(io, candidate.stamp_)) {
+                if (existing.find(common::lowercase_ucs2_string(candidate.path_)) == existing.end()) {
+                    regs.push_back(entry->reg_);
+                    modded = true;
+                }
+
+                continue;
+            }
+
+            to_parse.push_back(&candidate);
+        }
+
+        if (to_parse.empty()) {
+            return modded;
+        }
+
+        std::vector<apa_registry_snapshot_entry> results(to_parse.size());
+        std::vector<std::uint8_t> parse_success(to_parse.size(), 0);
+
+        auto parse_one = [&](const std::size_t index) {
+            results[index].rsc_stamp_ = to_parse[index]->stamp_;
+            parse_success[index] = parse_registry(io, to_parse[index]->path_, to_parse[index]->land_drive_,
+                ideal_lang, results[index]);
+        };
+
+        if (to_parse.size() == 1) {
+            parse_one(0);
+        } else {
+            common::thread_pool parse_pool("Registry parser");
+            common::parallel_for(parse_pool, to_parse.size(), parse_one);
+        }
+
+        LOG_TRACE(SERVICE_APPLIST, "{} registrations reused from snapshot, {} parsed", candidates.size() - to_parse.size(),
+            to_parse.size());
+
+        std::vector<std::u16string> to_delete;
+
+        for (std::size_t i = 0; i < to_parse.size(); i++) {
+            auto existing_result = existing.find(common::lowercase_ucs2_string(to_parse[i]->path_));
+
+            if (!parse_success[i]) {
+                if (existing_result != existing.end()) {
+                    to_delete.push_back(to_parse[i]->path_);
                 }
+
+                snapshot_->remove(to_parse[i]->path_);
+                continue;
+            }
+
+            if (existing_result != existing.end()) {
+                regs[existing_result->second] = results[i].reg_;
+            } else {
+                regs.push_back(results[i].reg_);
+            }
+
+            snapshot_->set(to_parse[i]->path_, std::move(results[i]));
+            modded = true;
+        }
+
+        for (const std::u16string &path : to_delete) {
+            if (delete_registry(path)) {
+                modded = true;
             }
         }
 
         return modded;
     }
 
+    std::string applist_server::get_snapshot_path() {
+        config::state *conf = kern->get_config();
+        device_manager *mngr = sys->get_device_manager();
+
+        if (!conf || !mngr || !mngr->get_current()) {
+            return "";
+        }
+
+        return eka2l1::add_path(conf->storage, eka2l1::add_path("cache/applist/",
+            common::lowercase_string(mngr->get_current()->firmware_code) + ".bin"));
+    }
+
+    std::string applist_server::get_icon_cache_path() {
+        config::state *conf = kern->get_config();
+
+        if (!conf) {
+            return "";
+        }
+
+        // Entries are keyed by the icon file content, so they can be shared between devices
+        return eka2l1::add_path(conf->storage, "cache/applist/icons/");
+    }
+
+    void applist_server::save_snapshot_if_dirty() {
+        if (!snapshot_->dirty()) {
+            return;
+        }
+
+        const std::string path = get_snapshot_path();
+
+        if (!path.empty()) {
+            snapshot_->save(path);
+        }
+    }
+
     bool applist_server::rescan_registries(eka2l1::io_system *io) {
         LOG_INFO(SERVICE_APPLIST, "Loading app registries");
 
@@ -421,32 +588,31 @@ namespace eka2l1 {
             }
         }
 
-        // Delete entries that no longer exist...
-        std::size_t prev = regs.size();
+        if (kern->is_eka1()) {
+            // Delete entries that no longer exist...
+            std::size_t prev = regs.size();
 
-        common::erase_elements(regs, [io](const apa_app_registry &reg) {
-            return !io->exist(reg.rsc_path);
-        });
+            common::erase_elements(regs, [io](const apa_app_registry &reg) {
+                return !io->exist(reg.rsc_path);
+            });
 
-        if (prev != regs.size()) {
-            global_modified = true;
-        }
+            if (prev != regs.size()) {
+                global_modified = true;
+            }
 
-        for (std::uint8_t i = 0; i < drive_count; i++) {
-            if (avail_drives_ & (1 << i)) {
-                drive_number drv = static_cast<drive_number>(static_cast<int>(drive_a) + i);
-                bool drv_modified = false;
+            for (std::uint8_t i = 0; i < drive_count; i++) {
+                if (avail_drives_ & (1 << i)) {
+                    drive_number drv = static_cast<drive_number>(static_cast<int>(drive_a) + i);
 
-                if (kern->is_eka1()) {
-                    drv_modified = rescan_registries_on_drive_oldarch(io, drv);
-                } else {
-                    drv_modified = rescan_registries_on_drive_newarch(io, drv);
-                }
-
-                if (drv_modified) {
-                    global_modified = true;
+                    if (rescan_registries_on_drive_oldarch(io, drv)) {
+                        global_modified = true;
+                    }
                 }
             }
+        } else {
+            // Stale entries are dropped by the scan itself, no need to query each of them
+            global_modified = rescan_registries_newarch(io, avail_drives_);
+            save_snapshot_if_dirty();
         }
 
         if (global_modified) {
@@ -488,6 +654,15 @@ namespace eka2l1 {
         fsserv = kern->get_by_name<eka2l1::fs_server>(epoc::fs::get_server_name_through_epocver(
             kern->get_epoc_version()));
 
+        if (!kern->is_eka1()) {
+            const std::string snapshot_path = get_snapshot_path();
+
+            if (!snapshot_path.empty() && snapshot_->load(snapshot_path)) {
+                LOG_TRACE(SERVICE_APPLIST, "Loaded {} app registrations from snapshot", snapshot_->size());
+            }
+        }
+
+        icon_cache_ = std::make_unique<apa_icon_cache>(get_icon_cache_path());
         rescan_registries(sys->get_io_system());
 
         flags |= AL_INITED;
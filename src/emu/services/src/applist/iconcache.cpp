@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/applist/iconcache.h>
+
+#include <common/buffer.h>
+#include <common/chunkyseri.h>
+#include <common/fileutils.h>
+#include <common/log.h>
+#include <common/path.h>
+
+#include <fmt/format.h>
+#include <xxhash.h>
+
+namespace eka2l1 {
+    static constexpr std::uint32_t APA_ICON_CACHE_MAGIC = 0x4E434941; // AICN
+    static constexpr std::int16_t APA_ICON_CACHE_VERSION = 1;
+    static constexpr std::size_t APA_ICON_HASH_CHUNK_SIZE = 0x10000;
+
+    std::uint64_t apa_icon_cache_key::digest() const {
+        XXH64_state_t *const state = XXH64_createState();
+        XXH64_reset(state, 0);
+
+        const std::int32_t mode_value = static_cast<std::int32_t>(mode_);
+
+        XXH64_update(state, &source_hash_, sizeof(source_hash_));
+        XXH64_update(state, &index_, sizeof(index_));
+        XXH64_update(state, &size_.x, sizeof(size_.x));
+        XXH64_update(state, &size_.y, sizeof(size_.y));
+        XXH64_update(state, &mode_value, sizeof(mode_value));
+
+        const std::uint64_t result = XXH64_digest(state);
+        XXH64_freeState(state);
+
+        return result;
+    }
+
+    apa_icon_cache::apa_icon_cache(const std::string &root)
+        : root_(root)
+        , hits_(0)
+        , disk_hits_(0)
+        , misses_(0)
+        , stores_(0) {
+    }
+
+    std::uint64_t apa_icon_cache::hash_source(common::ro_stream *stream) {
+        XXH64_state_t *const state = XXH64_createState();
+        XXH64_reset(state, 0);
+
+        std::vector<std::uint8_t> chunk(APA_ICON_HASH_CHUNK_SIZE);
+        stream->seek(0, common::seek_where::beg);
+
+        while (true) {
+            const std::uint64_t read_count = stream->read(chunk.data(), chunk.size());
+
+            if ((read_count == 0) || (read_count > chunk.size())) {
+                break;
+            }
+
+            XXH64_update(state, chunk.data(), static_cast<std::size_t>(read_count));
+        }
+
+        stream->seek(0, common::seek_where::beg);
+
+        const std::uint64_t result = XXH64_digest(state);
+        XXH64_freeState(state);
+
+        return result;
+    }
+
+    std::uint64_t apa_icon_cache::hash_source(const std::uint8_t *data, const std::size_t size) {
+        return XXH64(data, size, 0);
+    }
+
+    std::string apa_icon_cache::get_entry_path(const apa_icon_cache_key &key) const {
+        return eka2l1::add_path(root_, fmt::format("{:016X}.bin", key.digest()));
+    }
+
+    static bool absorb_entry(common::chunkyseri &seri, apa_icon_cache_key &key, apa_rendered_icon &icon) {
+        seri.absorb(key.source_hash_);
+        seri.absorb(key.index_);
+        seri.absorb(key.size_.x);
+        seri.absorb(key.size_.y);
+        seri.absorb(key.mode_);
+
+        seri.absorb(icon.size_.x);
+        seri.absorb(icon.size_.y);
+        seri.absorb(icon.stride_);
+
+        std::uint32_t pixels_size = static_cast<std::uint32_t>(icon.pixels_.size());
+        seri.absorb(pixels_size);
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            if (pixels_size > seri.left()) {
+                return false;
+            }
+
+            icon.pixels_.resize(pixels_size);
+        }
+
+        seri.absorb_impl(icon.pixels_.data(), pixels_size);
+        return true;
+    }
+
+    std::shared_ptr<const apa_rendered_icon> apa_icon_cache::load_entry(const apa_icon_cache_key &key) {
+        if (root_.empty()) {
+            return nullptr;
+        }
+
+        const std::string path = get_entry_path(key);
+        common::ro_std_file_stream stream(path, true);
+
+        if (!stream.valid()) {
+            return nullptr;
+        }
+
+        std::vector<std::uint8_t> buf(stream.size());
+
+        if (buf.empty() || (stream.read(buf.data(), buf.size()) != buf.size())) {
+            return nullptr;
+        }
+
+        common::chunkyseri seri(buf.data(), buf.size(), common::SERI_MODE_READ);
+
+        std::uint32_t magic = 0;
+        seri.absorb(magic);
+
+        if (magic != APA_ICON_CACHE_MAGIC) {
+            return nullptr;
+        }
+
+        auto sec = seri.section("AppIconCache", APA_ICON_CACHE_VERSION);
+
+        if (!sec) {
+            return nullptr;
+        }
+
+        apa_icon_cache_key stored_key;
+        auto icon = std::make_shared<apa_rendered_icon>();
+
+        // Entries are named by key digest, make sure this is not a collision or a truncated file
+        if (!absorb_entry(seri, stored_key, *icon) || !(stored_key == key) || (icon->pixels_.size() < static_cast<std::size_t>(icon->stride_) * icon->size_.y)) {
+            LOG_WARN(SERVICE_APPLIST, "Icon cache entry {} does not match its key, ignored", path);
+            return nullptr;
+        }
+
+        return icon;
+    }
+
+    bool apa_icon_cache::save_entry(const apa_icon_cache_key &key, const apa_rendered_icon &icon) {
+        if (root_.empty()) {
+            return false;
+        }
+
+        std::uint32_t magic = APA_ICON_CACHE_MAGIC;
+
+        apa_icon_cache_key key_copy = key;
+        apa_rendered_icon &icon_ref = const_cast<apa_rendered_icon &>(icon);
+
+        common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+        seri.absorb(magic);
+        seri.section("AppIconCache", APA_ICON_CACHE_VERSION);
+        absorb_entry(seri, key_copy, icon_ref);
+
+        std::vector<std::uint8_t> buf(seri.size());
+
+        seri = common::chunkyseri(buf.data(), buf.size(), common::SERI_MODE_WRITE);
+        seri.absorb(magic);
+        seri.section("AppIconCache", APA_ICON_CACHE_VERSION);
+        absorb_entry(seri, key_copy, icon_ref);
+
+        common::create_directories(root_);
+
+        const std::string path = get_entry_path(key);
+        common::wo_std_file_stream stream(path, true);
+
+        if (!stream.valid() || (stream.write(buf.data(), buf.size()) != buf.size())) {
+            LOG_ERROR(SERVICE_APPLIST, "Unable to write icon cache entry to {}", path);
+            return false;
+        }
+
+        return true;
+    }
+
+    std::shared_ptr<const apa_rendered_icon> apa_icon_cache::get(const apa_icon_cache_key &key) {
+        const std::uint64_t digest = key.digest();
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            auto result = entries_.find(digest);
+
+            if (result != entries_.end()) {
+                hits_++;
+                return result->second;
+            }
+        }
+
+        std::shared_ptr<const apa_rendered_icon> loaded = load_entry(key);
+
+        if (!loaded) {
+            misses_++;
+            return nullptr;
+        }
+
+        hits_++;
+        disk_hits_++;
+
+        const std::lock_guard<std::mutex> guard(lock_);
+        entries_[digest] = loaded;
+
+        return loaded;
+    }
+
+    std::shared_ptr<const apa_rendered_icon> apa_icon_cache::put(const apa_icon_cache_key &key, apa_rendered_icon &&icon) {
+        auto stored = std::make_shared<const apa_rendered_icon>(std::move(icon));
+        save_entry(key, *stored);
+
+        stores_++;
+
+        const std::lock_guard<std::mutex> guard(lock_);
+        entries_[key.digest()] = stored;
+
+        return stored;
+    }
+
+    apa_icon_cache_stats apa_icon_cache::get_stats() {
+        apa_icon_cache_stats stats;
+
+        stats.hits_ = hits_.load();
+        stats.disk_hits_ = disk_hits_.load();
+        stats.misses_ = misses_.load();
+        stats.stores_ = stores_.load();
+
+        const std::lock_guard<std::mutex> guard(lock_);
+        stats.entry_count_ = static_cast<std::uint32_t>(entries_.size());
+
+        return stats;
+    }
+}
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/applist/snapshot.h>
+
+#include <common/algorithm.h>
+#include <common/buffer.h>
+#include <common/chunkyseri.h>
+#include <common/fileutils.h>
+#include <common/log.h>
+#include <common/path.h>
+
+#include <vfs/vfs.h>
+
+namespace eka2l1 {
+    static constexpr std::uint32_t APA_SNAPSHOT_MAGIC = 0x53504141; // AAPS
+    static constexpr std::int16_t APA_SNAPSHOT_VERSION = 1;
+
+    apa_file_stamp get_apa_file_stamp(io_system *io, const std::u16string &path) {
+        apa_file_stamp stamp;
+
+        if (path.empty()) {
+            return stamp;
+        }
+
+        std::optional<entry_info> info = io->get_entry_info(path);
+
+        if (info) {
+            stamp.size_ = info->size;
+            stamp.last_modified_ = info->last_write;
+        }
+
+        return stamp;
+    }
+
+    bool apa_registry_snapshot_entry::up_to_date(io_system *io, const apa_file_stamp &current_rsc_stamp) const {
+        if (rsc_stamp_ != current_rsc_stamp) {
+            return false;
+        }
+
+        return get_apa_file_stamp(io, localised_path_) == localised_stamp_;
+    }
+
+    static constexpr std::size_t APA_SNAPSHOT_STAMP_SIZE = sizeof(std::uint64_t) * 2;
+
+    // Key, localisable path, two stamps and the registry UID. The rest of a registry is not counted,
+    // this only has to be small enough to never reject a valid snapshot.
+    static constexpr std::size_t APA_SNAPSHOT_MIN_ENTRY_SIZE = sizeof(std::uint32_t) * 3 + APA_SNAPSHOT_STAMP_SIZE * 2;
+
+    /**
+     * @brief Check that a count read from the stream can be backed by the bytes left in it.
+     */
+    static bool snapshot_count_fits(common::chunkyseri &seri, const std::uint32_t count, const std::size_t min_elem_size) {
+        if (seri.get_seri_mode() != common::SERI_MODE_READ) {
+            return true;
+        }
+
+        return count <= seri.left() / min_elem_size;
+    }
+
+    template <typename T>
+    static bool absorb_string(common::chunkyseri &seri, std::basic_string<T> &str) {
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            std::uint32_t length = 0;
+
+            if (seri.left() < sizeof(length)) {
+                return false;
+            }
+
+            seri.absorb(length);
+
+            if (!snapshot_count_fits(seri, length, sizeof(T))) {
+                return false;
+            }
+
+            seri.backwards(sizeof(length));
+        }
+
+        seri.absorb(str);
+        return true;
+    }
+
+    template <typename T, typename F>
+    static bool absorb_bounded_container(common::chunkyseri &seri, std::vector<T> &c, const std::size_t min_elem_size, F func) {
+        std::uint32_t count = static_cast<std::uint32_t>(c.size());
+        seri.absorb(count);
+
+        if (!snapshot_count_fits(seri, count, min_elem_size)) {
+            return false;
+        }
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            c.resize(count);
+        }
+
+        for (auto &member : c) {
+            if (!func(seri, member)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static void absorb_stamp(common::chunkyseri &seri, apa_file_stamp &stamp) {
+        seri.absorb(stamp.size_);
+        seri.absorb(stamp.last_modified_);
+    }
+
+    template <typename T, unsigned int MAX_ELEM>
+    static bool absorb_buf_static(common::chunkyseri &seri, epoc::buf_static<T, MAX_ELEM> &buf) {
+        std::basic_string<T> content;
+
+        if (seri.get_seri_mode() != common::SERI_MODE_READ) {
+            content = buf.to_std_string(nullptr);
+        }
+
+        if (!absorb_string(seri, content)) {
+            return false;
+        }
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            if (content.length() > MAX_ELEM) {
+                return false;
+            }
+
+            buf.assign(nullptr, content);
+        }
+
+        return true;
+    }
+
+    static bool absorb_registry(common::chunkyseri &seri, apa_app_registry &reg) {
+        seri.absorb(reg.mandatory_info.uid);
+
+        if (!absorb_buf_static(seri, reg.mandatory_info.app_path) || !absorb_buf_static(seri, reg.mandatory_info.short_caption)
+            || !absorb_buf_static(seri, reg.mandatory_info.long_caption)) {
+            return false;
+        }
+
+        seri.absorb(reg.caps.ability);
+        seri.absorb(reg.caps.support_being_asked_to_create_new_file);
+        seri.absorb(reg.caps.is_hidden);
+        seri.absorb(reg.caps.launch_in_background);
+
+        if (!absorb_buf_static(seri, reg.caps.group_name)) {
+            return false;
+        }
+
+        seri.absorb(reg.caps.flags);
+
+        if (!absorb_string(seri, reg.rsc_path)) {
+            return false;
+        }
+
+        seri.absorb(reg.last_rsc_modified);
+
+        if (!absorb_string(seri, reg.localised_info_rsc_path)) {
+            return false;
+        }
+
+        seri.absorb(reg.localised_info_rsc_id);
+        seri.absorb(reg.default_screen_number);
+        seri.absorb(reg.icon_count);
+
+        if (!absorb_string(seri, reg.icon_file_path)) {
+            return false;
+        }
+
+        seri.absorb(reg.land_drive);
+
+        const bool containers_ok = absorb_bounded_container(seri, reg.data_types, sizeof(std::uint32_t) * 2,
+                                       [](common::chunkyseri &seri, data_type &type) {
+                                           seri.absorb(type.priority_);
+                                           return absorb_string(seri, type.type_);
+                                       })
+            && absorb_bounded_container(seri, reg.view_datas, sizeof(std::uint32_t) * 4,
+                [](common::chunkyseri &seri, view_data &view) {
+                    seri.absorb(view.uid_);
+                    seri.absorb(view.screen_mode_);
+                    seri.absorb(view.icon_count_);
+                    return absorb_string(seri, view.caption_);
+                })
+            && absorb_bounded_container(seri, reg.ownership_list, sizeof(std::uint32_t),
+                [](common::chunkyseri &seri, std::u16string &path) {
+                    return absorb_string(seri, path);
+                });
+
+        return containers_ok;
+    }
+
+    bool apa_registry_snapshot::do_state(common::chunkyseri &seri) {
+        std::uint32_t count = static_cast<std::uint32_t>(entries_.size());
+        seri.absorb(count);
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            entries_.clear();
+
+            if (!snapshot_count_fits(seri, count, APA_SNAPSHOT_MIN_ENTRY_SIZE)) {
+                LOG_WARN(SERVICE_APPLIST, "App registry snapshot claims {} entries, more than it can hold", count);
+                return false;
+            }
+
+            for (std::uint32_t i = 0; i < count; i++) {
+                std::u16string key;
+                apa_registry_snapshot_entry entry;
+
+                if (seri.left() < APA_SNAPSHOT_MIN_ENTRY_SIZE) {
+                    entries_.clear();
+                    return false;
+                }
+
+                bool ok = absorb_string(seri, key);
+
+                if (ok) {
+                    absorb_stamp(seri, entry.rsc_stamp_);
+                    ok = absorb_string(seri, entry.localised_path_);
+                }
+
+                if (ok) {
+                    absorb_stamp(seri, entry.localised_stamp_);
+                    ok = absorb_registry(seri, entry.reg_);
+                }
+
+                if (!ok) {
+                    // Truncated or corrupted snapshot, do not trust anything
+                    entries_.clear();
+                    return false;
+                }
+
+                entries_.emplace(std::move(key), std::move(entry));
+            }
+
+            return true;
+        }
+
+        for (auto &[key, entry] : entries_) {
+            std::u16string key_copy = key;
+
+            seri.absorb(key_copy);
+            absorb_stamp(seri, entry.rsc_stamp_);
+            seri.absorb(entry.localised_path_);
+            absorb_stamp(seri, entry.localised_stamp_);
+            absorb_registry(seri, entry.reg_);
+        }
+
+        return true;
+    }
+
+    apa_registry_snapshot_entry *apa_registry_snapshot::get(const std::u16string &rsc_path) {
+        auto result = entries_.find(common::lowercase_ucs2_string(rsc_path));
+
+        if (result == entries_.end()) {
+            return nullptr;
+        }
+
+        return &result->second;
+    }
+
+    void apa_registry_snapshot::set(const std::u16string &rsc_path, apa_registry_snapshot_entry &&entry) {
+        entries_[common::lowercase_ucs2_string(rsc_path)] = std::move(entry);
+        dirty_ = true;
+    }
+
+    bool apa_registry_snapshot::remove(const std::u16string &rsc_path) {
+        if (entries_.erase(common::lowercase_ucs2_string(rsc_path)) == 0) {
+            return false;
+        }
+
+        dirty_ = true;
+        return true;
+    }
+
+    bool apa_registry_snapshot::load(const std::string &host_path) {
+        common::ro_std_file_stream stream(host_path, true);
+
+        if (!stream.valid()) {
+            return false;
+        }
+
+        std::vector<std::uint8_t> buf(stream.size());
+
+        if (buf.empty() || (stream.read(buf.data(), buf.size()) != buf.size())) {
+            return false;
+        }
+
+        common::chunkyseri seri(buf.data(), buf.size(), common::SERI_MODE_READ);
+
+        std::uint32_t magic = 0;
+        seri.absorb(magic);
+
+        if (magic != APA_SNAPSHOT_MAGIC) {
+            LOG_WARN(SERVICE_APPLIST, "App registry snapshot {} has invalid magic, ignored", host_path);
+            return false;
+        }
+
+        auto sec = seri.section("AppRegistrySnapshot", APA_SNAPSHOT_VERSION);
+
+        if (!sec) {
+            return false;
+        }
+
+        if (!do_state(seri)) {
+            LOG_WARN(SERVICE_APPLIST, "App registry snapshot {} is corrupted, ignored", host_path);
+            return false;
+        }
+
+        dirty_ = false;
+        return true;
+    }
+
+    bool apa_registry_snapshot::save(const std::string &host_path) {
+        std::uint32_t magic = APA_SNAPSHOT_MAGIC;
+
+        common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+        seri.absorb(magic);
+        seri.section("AppRegistrySnapshot", APA_SNAPSHOT_VERSION);
+        do_state(seri);
+
+        std::vector<std::uint8_t> buf(seri.size());
+
+        seri = common::chunkyseri(buf.data(), buf.size(), common::SERI_MODE_WRITE);
+        seri.absorb(magic);
+        seri.section("AppRegistrySnapshot", APA_SNAPSHOT_VERSION);
+        do_state(seri);
+
+        common::create_directories(eka2l1::file_directory(host_path));
+        common::wo_std_file_stream stream(host_path, true);
+
+        if (!stream.valid() || (stream.write(buf.data(), buf.size()) != buf.size())) {
+            LOG_ERROR(SERVICE_APPLIST, "Unable to write app registry snapshot to {}", host_path);
+            return false;
+        }
+
+        dirty_ = false;
+        return true;
+    }
+}
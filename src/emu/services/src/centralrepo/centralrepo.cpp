@@ -227,6 +227,9 @@ namespace eka2l1 {
     central_repo_server::central_repo_server(eka2l1::system *sys)
         : service::server(sys->get_kernel_system(), sys, nullptr, CENTRAL_REPO_SERVER_NAME, true)
         , id_counter(0) {
+        // Every entry point takes the server lock, so messages can be processed on a worker
+        thread_safe_ = true;
+
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_init, "CenRep::Init");
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_create_int, "CenRep::CreateInt");
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_create_real, "CenRep::CreateReal");
@@ -303,6 +306,8 @@ namespace eka2l1 {
     }
 
     void central_repo_server::callback_on_drive_change(eka2l1::io_system *io, const drive_number drv, int act) {
+        const std::lock_guard<std::recursive_mutex> guard(serv_lock);
+
         // Eject
         if (act == 0) {
             if (rom_drv == drv) {
@@ -330,6 +335,8 @@ namespace eka2l1 {
     }
 
     void central_repo_server::redirect_msg_to_session(service::ipc_context &ctx) {
+        const std::lock_guard<std::recursive_mutex> guard(serv_lock);
+
         const kernel::uid session_uid = ctx.msg->msg_session->unique_id();
         auto session_ite = client_sessions.find(session_uid);
 
@@ -465,6 +472,8 @@ namespace eka2l1 {
     }
 
     eka2l1::central_repo *central_repo_server::load_repo_with_lookup(eka2l1::io_system *io, device_manager *mngr, const std::uint32_t key) {
+        const std::lock_guard<std::recursive_mutex> guard(serv_lock);
+
         auto result = repos.find(key);
 
         if (result != repos.end()) {
@@ -477,6 +486,8 @@ namespace eka2l1 {
 
     eka2l1::central_repo *central_repo_server::get_initial_repo(eka2l1::io_system *io,
         device_manager *mngr, const std::uint32_t key) {
+        const std::lock_guard<std::recursive_mutex> guard(serv_lock);
+
         // Load from cache first
         eka2l1::central_repo *repo = backup_cacher.get_cached_repo(key);
 
@@ -675,6 +686,8 @@ namespace eka2l1 {
     // If a session disconnect, we should at least save all changes it did
     // At least, if the session connected still exist
     void central_repo_server::disconnect(service::ipc_context &ctx) {
+        const std::lock_guard<std::recursive_mutex> guard(serv_lock);
+
         // Close all repos that are currently being opened.
         const kernel::uid ss_id = ctx.msg->msg_session->unique_id();
         auto ss_ite = client_sessions.find(ss_id);
@@ -698,6 +711,8 @@ namespace eka2l1 {
     }
 
     void central_repo_server::connect(service::ipc_context &ctx) {
+        const std::lock_guard<std::recursive_mutex> guard(serv_lock);
+
         central_repo_client_session session;
         session.server = this;
 
@@ -27,6 +27,7 @@
 #include <utils/des.h>
 #include <utils/sec.h>
 
+#include <common/metrics.h>
 #include <config/config.h>
 
 namespace eka2l1 {
@@ -35,8 +36,15 @@ namespace eka2l1 {
         }
 
         ipc_context::~ipc_context() {
-            if (auto_deref)
-                msg->unref();
+            if (auto_deref) {
+                if (svr && (server::current_worker() == svr)) {
+                    // Message release touches the session and kernel pools
+                    ipc_msg_ptr to_release = msg;
+                    svr->post_to_kernel([to_release]() { to_release->unref(); });
+                } else {
+                    msg->unref();
+                }
+            }
         }
 
         template <typename T>
@@ -141,6 +149,36 @@ namespace eka2l1 {
         void ipc_context::complete(int res) {
             if (msg->request_sts) {
                 kernel_system *kern = sys->get_kernel_system();
+
+                if (svr && (server::current_worker() == svr)) {
+                    // Kernel state is only touched on the kernel side. The client thread may be gone by then.
+                    ipc_msg_ptr to_complete = msg;
+                    const kernel::uid requester_uid = msg->own_thr->unique_id();
+                    const bool should_signal = !signaled;
+
+                    signaled = true;
+
+                    svr->post_to_kernel([kern, to_complete, requester_uid, res, should_signal]() {
+                        kernel::thread *requester = kern->get_by_id<kernel::thread>(requester_uid);
+
+                        if (!requester || (requester->unique_id() != requester_uid)) {
+                            return;
+                        }
+
+                        epoc::request_status *sts = to_complete->request_sts.get(requester->owning_process());
+
+                        if (sts) {
+                            sts->set(res, kern->is_eka1());
+                        }
+
+                        if (should_signal) {
+                            requester->signal_request();
+                        }
+                    });
+
+                    return;
+                }
+
                 (msg->request_sts.get(msg->own_thr->owning_process()))->set(res, kern->is_eka1());
 
                 // Avoid signal twice to cause undefined behavior
@@ -330,6 +368,17 @@ namespace eka2l1 {
             ctx.complete(0);
         }
 
+        common::metric_counter *server::hle_time_metric() {
+            common::metric_counter *metric = hle_time_metric_.load(std::memory_order_relaxed);
+
+            if (!metric) {
+                metric = sys->get_metrics()->counter("hle.server_time_us");
+                hle_time_metric_.store(metric, std::memory_order_relaxed);
+            }
+
+            return metric;
+        }
+
         // Processed asynchronously, use for HLE service where accepted function
         // is fetched imm
         void server::process_accepted_msg() {
@@ -340,6 +389,8 @@ namespace eka2l1 {
                 return;
             }
 
+            common::scoped_metric_timer timer(hle_time_metric());
+
             int func = process_msg->function;
 
             auto func_ite = ipc_funcs.find(func);
@@ -351,6 +402,7 @@ namespace eka2l1 {
 
                     context.sys = sys;
                     context.msg = process_msg;
+                    context.svr = this;
 
                     on_unhandled_opcode(context);
 
@@ -365,6 +417,7 @@ namespace eka2l1 {
             ipc_context context;
             context.sys = sys;
             context.msg = process_msg;
+            context.svr = this;
 
             if (conf->log_ipc) {
                 LOG_INFO(SERVICE_TRACK, "Calling IPC: {}, id: {}", ipf.name, func);
@@ -42,6 +42,9 @@
 #include <config/config.h>
 
 namespace eka2l1 {
+    // Host memory budget for decoded bitmaps of ROM MBM files
+    static constexpr std::size_t FBS_MBM_DECODE_CACHE_SIZE = common::MB(8);
+
     namespace epoc {
         bool does_client_use_pointer_instead_of_offset(fbscli *cli) {
             const epocver current_sys_ver = cli->server<fbs_server>()->get_system()->get_symbian_version_use();
@@ -299,6 +302,7 @@ namespace eka2l1 {
         , large_chunk(nullptr)
         , fntstr_seg(nullptr)
         , bmp_font_vtab(0)
+        , decode_cache(FBS_MBM_DECODE_CACHE_SIZE)
         , session_cache_list(nullptr) {
     }
 
@@ -473,7 +477,16 @@ namespace eka2l1 {
             return nullptr;
         }
 
-        return large_chunk_allocator->allocate(s);
+        void *result = large_chunk_allocator->allocate(s);
+
+        if (!result) {
+            const common::block_allocator_stats stats = large_chunk_allocator->get_stats();
+
+            LOG_ERROR(SERVICE_FBS, "Unable to allocate {} bytes of large data (free {} bytes, largest free block {} bytes, "
+                "fragmentation {:.2f})", s, stats.free_size_, stats.largest_free_block_, stats.fragmentation());
+        }
+
+        return result;
     }
 
     bool fbs_server::free_large_data(const void *ptr) {
@@ -485,6 +498,17 @@ namespace eka2l1 {
         return large_chunk_allocator->freep(ptr);
     }
 
+    bool fbs_server::get_chunk_allocator_stats(common::block_allocator_stats &shared_stats, common::block_allocator_stats &large_stats) {
+        if (!shared_chunk_allocator || !large_chunk_allocator) {
+            return false;
+        }
+
+        shared_stats = shared_chunk_allocator->get_stats();
+        large_stats = large_chunk_allocator->get_stats();
+
+        return true;
+    }
+
     fbs_server::~fbs_server() {
         if (compressor) {
             compressor->abort();
@@ -40,6 +40,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 
 namespace eka2l1 {
     static epoc::bitmap_color get_bitmap_color_type_from_display_mode(const epoc::display_mode bpp) {
@@ -407,7 +408,8 @@ namespace eka2l1 {
         return start;
     }
 
-    void *fbs_server::load_data_to_rom(loader::mbm_file &mbmf_, const std::size_t idx_, std::size_t &size_decomp, int *err_code) {
+    void *fbs_server::load_data_to_rom(loader::mbm_file &mbmf_, const std::size_t idx_, std::size_t &size_decomp, int *err_code,
+        const std::u16string &decode_cache_path) {
         *err_code = fbs_load_data_err_none;
         size_decomp = 0;
 
@@ -416,20 +418,33 @@ namespace eka2l1 {
             return nullptr;
         }
 
-        std::size_t size_when_compressed = epoc::get_byte_width(mbmf_.sbm_headers[idx_].size_pixels.x,
-                                               mbmf_.sbm_headers[idx_].bit_per_pixels)
-            * mbmf_.sbm_headers[idx_].size_pixels.y;
+        const loader::sbm_header &header = mbmf_.sbm_headers[idx_];
+        std::size_t expected_size = 0;
 
-        if (!mbmf_.read_single_bitmap(idx_, nullptr, size_when_compressed)) {
-            *err_code = fbs_load_data_err_read_decomp_fail;
-            return nullptr;
+        if (header.compression == 0) {
+            // Only retrieve the raw size, nothing is read
+            if (!mbmf_.read_single_bitmap(idx_, nullptr, expected_size)) {
+                *err_code = fbs_load_data_err_read_decomp_fail;
+                return nullptr;
+            }
         } else {
-            size_decomp = size_when_compressed;
+            // The header already tells the decompressed size, no need to decompress twice
+            expected_size = epoc::get_byte_width(header.size_pixels.x, header.bit_per_pixels) * header.size_pixels.y;
+        }
+
+        const std::vector<std::uint8_t> *decoded = nullptr;
+
+        if (!decode_cache_path.empty()) {
+            decoded = decode_cache.get(decode_cache_path, mbmf_.stream, idx_);
+
+            if (decoded) {
+                expected_size = decoded->size();
+            }
         }
 
         // Allocates from the large chunk
         // Align them with 4 bytes
-        std::size_t avail_dest_size = common::align(size_when_compressed, 4);
+        std::size_t avail_dest_size = common::align(expected_size, 4);
         void *data = nullptr;
 
         if (is_large_bitmap(static_cast<std::uint32_t>(avail_dest_size))) {
@@ -445,15 +460,22 @@ namespace eka2l1 {
             return nullptr;
         }
 
-        // Yay, we manage to alloc memory to load the data in
-        // So let's get to work
-        bool result_read = mbmf_.read_single_bitmap(idx_, reinterpret_cast<std::uint8_t *>(data), avail_dest_size);
+        if (decoded) {
+            std::memcpy(data, decoded->data(), decoded->size());
+            size_decomp = decoded->size();
+
+            return data;
+        }
+
+        // Read and decompress straight into the allocated memory
+        std::size_t written_size = avail_dest_size;
 
-        if (!result_read) {
+        if (!mbmf_.read_single_bitmap(idx_, reinterpret_cast<std::uint8_t *>(data), written_size)) {
             *err_code = fbs_load_data_err_read_decomp_fail;
             return nullptr;
         }
 
+        size_decomp = written_size;
         return data;
     }
 
@@ -633,7 +655,17 @@ namespace eka2l1 {
             int err_code = fbs_load_data_err_none;
             std::size_t size_when_decomp = 0;
 
-            auto bmp_data = fbss->load_data_to_rom(mbmf_, load_options->bitmap_id, size_when_decomp, &err_code);
+            // Read-only MBMs (mostly ROM icons and skins) are loaded bitmap by bitmap many times, so decode them
+            // entirely once and keep the result
+            std::u16string decode_cache_path;
+            const std::u16string source_path = source->file_name();
+
+            if (source->is_in_rom() || (!source_path.empty() && ((source_path[0] == u'z') || (source_path[0] == u'Z')))) {
+                decode_cache_path = common::lowercase_ucs2_string(source_path);
+            }
+
+            auto bmp_data = fbss->load_data_to_rom(mbmf_, load_options->bitmap_id, size_when_decomp, &err_code,
+                decode_cache_path);
             std::uint8_t *bmp_data_base = fbss->get_large_chunk_base();
 
             switch (err_code) {
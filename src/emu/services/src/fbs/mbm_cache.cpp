@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/fbs/mbm_cache.h>
+#include <services/window/common.h>
+
+#include <common/buffer.h>
+#include <common/log.h>
+#include <common/threadpool.h>
+
+#include <loader/mbm.h>
+
+#include <algorithm>
+
+namespace eka2l1 {
+    mbm_decode_cache::mbm_decode_cache(const std::size_t max_size)
+        : max_size_(max_size)
+        , use_counter_(0)
+        , stats_{} {
+    }
+
+    mbm_decode_cache::~mbm_decode_cache() {
+    }
+
+    static std::size_t get_decoded_bitmap_size(const loader::sbm_header &header) {
+        if (header.compression == 0) {
+            return header.bitmap_size - header.header_len;
+        }
+
+        return static_cast<std::size_t>(epoc::get_byte_width(header.size_pixels.x, static_cast<std::uint8_t>(header.bit_per_pixels)))
+            * header.size_pixels.y;
+    }
+
+    bool mbm_decode_cache::decode_file(common::ro_stream *stream, decoded_file &file) {
+        // The caller may only have read the header of the bitmap it wants, so read them all on our own
+        stream->seek(0, common::seek_where::beg);
+        loader::mbm_file mbmf(stream);
+
+        if (!mbmf.do_read_headers()) {
+            return false;
+        }
+
+        const std::size_t count = mbmf.trailer.count;
+
+        if (count < 2) {
+            // Nothing to gain from decoding ahead
+            return false;
+        }
+
+        std::vector<std::size_t> sizes(count);
+        std::size_t total_size = 0;
+
+        for (std::size_t i = 0; i < count; i++) {
+            sizes[i] = get_decoded_bitmap_size(mbmf.sbm_headers[i]);
+            total_size += sizes[i];
+        }
+
+        if (total_size > max_size_ / 2) {
+            return false;
+        }
+
+        // The stream is not thread-safe, read all the data first
+        std::vector<std::vector<std::uint8_t>> sources(count);
+
+        for (std::size_t i = 0; i < count; i++) {
+            std::size_t raw_size = 0;
+
+            if (!mbmf.read_single_bitmap_raw(i, nullptr, raw_size)) {
+                continue;
+            }
+
+            sources[i].resize(raw_size);
+
+            if (!mbmf.read_single_bitmap_raw(i, sources[i].data(), raw_size)) {
+                sources[i].clear();
+            }
+        }
+
+        if (!pool_) {
+            pool_ = std::make_unique<common::thread_pool>("FBS bitmap decoder");
+        }
+
+        file.bitmaps_.resize(count);
+
+        common::parallel_for(*pool_, count, [&](const std::size_t i) {
+            const loader::sbm_header &header = mbmf.sbm_headers[i];
+            std::vector<std::uint8_t> &dest = file.bitmaps_[i];
+
+            if (header.compression == 0) {
+                dest = std::move(sources[i]);
+                return;
+            }
+
+            if (sources[i].empty()) {
+                return;
+            }
+
+            std::size_t decoded_size = sizes[i];
+            dest.resize(decoded_size);
+
+            if (!loader::decompress_bitmap_data(header, sources[i].data(), sources[i].size(), dest.data(), decoded_size)) {
+                dest.clear();
+                return;
+            }
+
+            dest.resize(decoded_size);
+        });
+
+        file.total_size_ = 0;
+
+        for (const std::vector<std::uint8_t> &bitmap : file.bitmaps_) {
+            file.total_size_ += bitmap.size();
+        }
+
+        stats_.files_decoded_++;
+        stats_.bitmaps_decoded_ += count;
+
+        return true;
+    }
+
+    void mbm_decode_cache::evict_until_fit(const std::size_t new_size) {
+        while (stats_.total_size_ + new_size > max_size_) {
+            auto oldest = files_.end();
+
+            for (auto ite = files_.begin(); ite != files_.end(); ite++) {
+                if (ite->second.cacheable_ && ((oldest == files_.end()) || (ite->second.last_use_ < oldest->second.last_use_))) {
+                    oldest = ite;
+                }
+            }
+
+            if (oldest == files_.end()) {
+                break;
+            }
+
+            stats_.total_size_ -= oldest->second.total_size_;
+            files_.erase(oldest);
+        }
+    }
+
+    const std::vector<std::uint8_t> *mbm_decode_cache::get(const std::u16string &path, common::ro_stream *stream, const std::size_t index) {
+        auto ite = files_.find(path);
+
+        if (ite == files_.end()) {
+            decoded_file file;
+            file.cacheable_ = decode_file(stream, file);
+
+            if (file.cacheable_) {
+                evict_until_fit(file.total_size_);
+                stats_.total_size_ += file.total_size_;
+            } else {
+                // Remember the verdict, so the file is not parsed again on each load
+                file.bitmaps_.clear();
+            }
+
+            ite = files_.emplace(path, std::move(file)).first;
+        }
+
+        decoded_file &file = ite->second;
+
+        if (!file.cacheable_ || (index >= file.bitmaps_.size()) || file.bitmaps_[index].empty()) {
+            return nullptr;
+        }
+
+        file.last_use_ = ++use_counter_;
+        stats_.hits_++;
+
+        return &file.bitmaps_[index];
+    }
+}
@@ -18,6 +18,7 @@
  */
 
 #include <common/log.h>
+#include <common/metrics.h>
 #include <system/epoc.h>
 
 #include <services/framework.h>
@@ -87,9 +88,12 @@ namespace eka2l1::service {
             return;
         }
 
+        common::scoped_metric_timer timer(hle_time_metric());
+
         ipc_context context;
         context.sys = sys;
         context.msg = process_msg;
+        context.svr = this;
 
         auto func = ipc_funcs.find(process_msg->function);
 
@@ -166,12 +166,9 @@ namespace eka2l1 {
         // Create property references to system drive
         // TODO (pent0): Not hardcode the drive. Maybe dangerous, who knows.
         default_sys_path = u"C:\\";
-        system_drive_prop = &(*sys->get_kernel_system()->create<service::property>());
+        system_drive_prop = sys->get_kernel_system()->create_prop(static_cast<int>(FS_UID), static_cast<int>(SYSTEM_DRIVE_KEY));
         system_drive_prop->define(service::property_type::int_data, 0);
         system_drive_prop->set_int(drive_c);
-
-        system_drive_prop->first = static_cast<int>(FS_UID);
-        system_drive_prop->second = static_cast<int>(SYSTEM_DRIVE_KEY);
     }
 
     void fs_server_client::fetch(service::ipc_context *ctx) {
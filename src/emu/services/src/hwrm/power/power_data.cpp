@@ -29,25 +29,15 @@ namespace eka2l1::epoc::hwrm::power {
         , battery_level_prop_(nullptr)
         , battery_status_prop_(nullptr) {
         // Create and define the property. Remember to destroy later.
-        charging_status_prop_ = kern->create<service::property>();
-        battery_level_prop_ = kern->create<service::property>();
-        battery_status_prop_ = kern->create<service::property>();
+        charging_status_prop_ = kern->create_prop(STATE_UID, CHARGING_STATUS_KEY);
+        battery_level_prop_ = kern->create_prop(STATE_UID, BATTERY_LEVEL_KEY);
+        battery_status_prop_ = kern->create_prop(STATE_UID, BATTERY_STATUS_KEY);
 
         if (!charging_status_prop_ || !battery_level_prop_ || !battery_status_prop_) {
             LOG_ERROR(SERVICE_HWRM, "Failed to create power service's properties! Abort.");
             return;
         }
 
-        // Set the category and key, then define
-        charging_status_prop_->first = STATE_UID;
-        charging_status_prop_->second = CHARGING_STATUS_KEY;
-
-        battery_level_prop_->first = STATE_UID;
-        battery_level_prop_->second = BATTERY_LEVEL_KEY;
-
-        battery_status_prop_->first = STATE_UID;
-        battery_status_prop_->second = BATTERY_STATUS_KEY;
-
         // Define and allocate the size that fit our maximum need.
         charging_status_prop_->define(service::property_type::int_data, sizeof(std::uint32_t));
         battery_level_prop_->define(service::property_type::int_data, sizeof(std::uint32_t));
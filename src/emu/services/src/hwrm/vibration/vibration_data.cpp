@@ -44,17 +44,13 @@ namespace eka2l1::epoc::hwrm::vibration {
 
     bool resource_data::initialise_components(kernel_system *kern, io_system *io, device_manager *mngr) {
         // Create and define the property. Remember to destroy later.
-        status_prop_ = kern->create<service::property>();
+        status_prop_ = kern->create_prop(eka2l1::epoc::hwrm::SERVICE_UID, eka2l1::epoc::hwrm::vibration::VIBRATION_STATUS_KEY);
 
         if (!status_prop_) {
             LOG_ERROR(SERVICE_HWRM, "Failed to create light service's status property! Abort.");
             return false;
         }
 
-        // Set the category and key, then define
-        status_prop_->first = eka2l1::epoc::hwrm::SERVICE_UID;
-        status_prop_->second = eka2l1::epoc::hwrm::vibration::VIBRATION_STATUS_KEY;
-
         // Define and allocate the size that fit our maximum need.
         status_prop_->define(service::property_type::int_data, sizeof(std::uint32_t));
         status_prop_->set_int(static_cast<int>(status_stopped));
@@ -83,32 +83,24 @@
     temp = std::make_unique<svr>(sys, ##__VA_ARGS__); \
     sys->get_kernel_system()->add_custom_server(temp)
 
-#define DEFINE_INT_PROP_D(sys, category, key, data)                            \
-    property_ptr prop = sys->get_kernel_system()->create<service::property>(); \
-    prop->first = category;                                                    \
-    prop->second = key;                                                        \
-    prop->define(service::property_type::int_data, 0);                         \
+#define DEFINE_INT_PROP_D(sys, category, key, data)                           \
+    property_ptr prop = sys->get_kernel_system()->create_prop(category, key); \
+    prop->define(service::property_type::int_data, 0);                        \
     prop->set_int(data);
 
-#define DEFINE_INT_PROP(sys, category, key, data)                 \
-    prop = sys->get_kernel_system()->create<service::property>(); \
-    prop->first = category;                                       \
-    prop->second = key;                                           \
-    prop->define(service::property_type::int_data, 0);            \
+#define DEFINE_INT_PROP(sys, category, key, data)                \
+    prop = sys->get_kernel_system()->create_prop(category, key); \
+    prop->define(service::property_type::int_data, 0);           \
     prop->set_int(data);
 
-#define DEFINE_BIN_PROP_D(sys, category, key, size, data)                      \
-    property_ptr prop = sys->get_kernel_system()->create<service::property>(); \
-    prop->first = category;                                                    \
-    prop->second = key;                                                        \
-    prop->define(service::property_type::bin_data, size);                      \
+#define DEFINE_BIN_PROP_D(sys, category, key, size, data)                     \
+    property_ptr prop = sys->get_kernel_system()->create_prop(category, key); \
+    prop->define(service::property_type::bin_data, size);                     \
     prop->set(data);
 
-#define DEFINE_BIN_PROP(sys, category, key, size, data)           \
-    prop = sys->get_kernel_system()->create<service::property>(); \
-    prop->first = category;                                       \
-    prop->second = key;                                           \
-    prop->define(service::property_type::bin_data, size);         \
+#define DEFINE_BIN_PROP(sys, category, key, size, data)          \
+    prop = sys->get_kernel_system()->create_prop(category, key); \
+    prop->define(service::property_type::bin_data, size);        \
     prop->set(data);
 
 namespace eka2l1::epoc {
@@ -253,10 +253,7 @@ namespace eka2l1 {
         property_ptr prop = kern->get_prop(SYSTEM_AGENT_PROPERTY_CATEGORY, uid.value());
 
         if (!prop) {
-            prop = kern->create<service::property>();
-            prop->first = SYSTEM_AGENT_PROPERTY_CATEGORY;
-            prop->second = uid.value();
-
+            prop = kern->create_prop(SYSTEM_AGENT_PROPERTY_CATEGORY, uid.value());
             prop->define(service::property_type::int_data, 4);
         }
 
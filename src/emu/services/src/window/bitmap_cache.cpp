@@ -304,30 +304,56 @@ namespace eka2l1::epoc {
             char *data_pointer = reinterpret_cast<char *>(bmp->data_pointer(fbss_));
             std::uint32_t raw_size = 0;
 
+            std::uint32_t bpp = bmp->header_.bit_per_pixels;
+            std::size_t pixels_per_line = 0;
+
+            if ((bmp->header_.bit_per_pixels % 8) == 0) {
+                pixels_per_line = bmp->byte_width_ / (bmp->header_.bit_per_pixels >> 3);
+            }
+
+            epoc::display_mode dsp = bmp->settings_.current_display_mode();
+            if (dsp == epoc::display_mode::none) {
+                dsp = bmp->settings_.initial_display_mode();
+            }
+
+            // GPU don't support them. Convert them on CPU. The converted buffer is the one uploaded, so the
+            // decompressed data is only needed temporarily and can live in the scratch buffer.
+            const bool needs_conversion = is_palette_bitmap(bmp) || (dsp == epoc::display_mode::gray16) || (bpp == 1);
             const bitmap_file_compression comp = bmp->compression_type();
 
             if (comp != bitmap_file_no_compression) {
                 raw_size = bmp->byte_width_ * bmp->header_.size_pixels.y;
-                char *new_data_allocated = new char[raw_size];
+                char *decompress_dest = nullptr;
+
+                if (needs_conversion) {
+                    if (decode_scratch_.size() < raw_size) {
+                        decode_scratch_.resize(raw_size);
+                    }
+
+                    decompress_dest = reinterpret_cast<char *>(decode_scratch_.data());
+                } else {
+                    // The driver takes ownership of the uploaded buffer
+                    decompress_dest = new char[raw_size];
+                }
 
                 const std::uint32_t compressed_size = bmp->header_.bitmap_size - bmp->header_.header_len;
                 std::size_t final_size = raw_size;
 
                 switch (comp) {
                 case bitmap_file_byte_rle_compression:
-                    eka2l1::decompress_rle_fast_route<8>(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size, reinterpret_cast<std::uint8_t*>(new_data_allocated), final_size);
+                    eka2l1::decompress_rle_fast_route<8>(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size, reinterpret_cast<std::uint8_t*>(decompress_dest), final_size);
                     break;
 
                 case bitmap_file_twelve_bit_rle_compression:
-                    eka2l1::decompress_rle_fast_route<12>(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size, reinterpret_cast<std::uint8_t*>(new_data_allocated), final_size);
+                    eka2l1::decompress_rle_fast_route<12>(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size, reinterpret_cast<std::uint8_t*>(decompress_dest), final_size);
                     break;
 
                 case bitmap_file_sixteen_bit_rle_compression:
-                    eka2l1::decompress_rle_fast_route<16>(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size, reinterpret_cast<std::uint8_t*>(new_data_allocated), final_size);
+                    eka2l1::decompress_rle_fast_route<16>(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size, reinterpret_cast<std::uint8_t*>(decompress_dest), final_size);
                     break;
 
                 case bitmap_file_twenty_four_bit_rle_compression:
-                    eka2l1::decompress_rle_fast_route<24>(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size, reinterpret_cast<std::uint8_t*>(new_data_allocated), final_size);
+                    eka2l1::decompress_rle_fast_route<24>(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size, reinterpret_cast<std::uint8_t*>(decompress_dest), final_size);
                     break;
 
                 default:
@@ -335,71 +361,39 @@ namespace eka2l1::epoc {
                     break;
                 }
 
-                data_pointer = new_data_allocated;
+                data_pointer = decompress_dest;
             } else {
                 raw_size = bmp->header_.bitmap_size - bmp->header_.header_len;
 
-                char *new_data_pointer = new char[raw_size];
-                std::memcpy(new_data_pointer, data_pointer, raw_size);
+                // Conversion reads straight from the bitmap data, no need to copy it first
+                if (!needs_conversion) {
+                    char *new_data_pointer = new char[raw_size];
+                    std::memcpy(new_data_pointer, data_pointer, raw_size);
 
-                data_pointer = new_data_pointer;
-            }
-
-            std::uint32_t bpp = bmp->header_.bit_per_pixels;
-            std::size_t pixels_per_line = 0;
-
-            if ((bmp->header_.bit_per_pixels % 8) == 0) {
-                pixels_per_line = bmp->byte_width_ / (bmp->header_.bit_per_pixels >> 3);
+                    data_pointer = new_data_pointer;
+                }
             }
 
-            std::size_t raw_size_big = 0;
-            
-            epoc::display_mode dsp = bmp->settings_.current_display_mode();
-            if (dsp == epoc::display_mode::none) {
-                dsp = bmp->settings_.initial_display_mode();
-            }
+            if (needs_conversion) {
+                std::size_t raw_size_big = 0;
 
-            // GPU don't support them. Convert them on CPU
-            if (is_palette_bitmap(bmp) || (dsp == epoc::display_mode::gray16)) {
-                char *new_pointer = nullptr;
                 if (dsp == epoc::display_mode::gray16) {
-                    new_pointer = converted_gray_four_bpp_to_twenty_four_bpp_bitmap(bmp, reinterpret_cast<const std::uint8_t *>(data_pointer), raw_size_big);
-                } else {
-                    new_pointer = converted_palette_bitmap_to_twenty_four_bitmap(bmp, reinterpret_cast<const std::uint8_t *>(data_pointer),
+                    data_pointer = converted_gray_four_bpp_to_twenty_four_bpp_bitmap(bmp, reinterpret_cast<const std::uint8_t *>(data_pointer), raw_size_big);
+                } else if (is_palette_bitmap(bmp)) {
+                    data_pointer = converted_palette_bitmap_to_twenty_four_bitmap(bmp, reinterpret_cast<const std::uint8_t *>(data_pointer),
                         epoc::get_suitable_palette_256(kern->get_epoc_version()), epoc::color_16_palette, raw_size_big);
+                } else {
+                    data_pointer = converted_one_bpp_to_twenty_four_bpp_bitmap(bmp, reinterpret_cast<const std::uint32_t *>(data_pointer),
+                        raw_size_big);
                 }
 
                 bpp = 24;
                 raw_size = static_cast<std::uint32_t>(raw_size_big);
 
-                delete[] data_pointer;
-                data_pointer = new_pointer;
-
                 // Use default
                 pixels_per_line = 0;
             }
 
-            char *newly_pointer = nullptr;
-
-            switch (bpp) {
-            case 1:
-                newly_pointer = converted_one_bpp_to_twenty_four_bpp_bitmap(bmp, reinterpret_cast<const std::uint32_t *>(data_pointer),
-                    raw_size_big);
-                bpp = 24;
-                raw_size = static_cast<std::uint32_t>(raw_size_big);
-                pixels_per_line = 0;
-
-                break;
-
-            default:
-                break;
-            }
-
-            if (newly_pointer) {
-                delete[] data_pointer;
-                data_pointer = newly_pointer;
-            }
-
             if (builder) {
                 builder->update_bitmap(driver_textures[idx], data_pointer, raw_size, { 0, 0 }, bmp->header_.size_pixels, pixels_per_line, false);
             }
@@ -26,10 +26,12 @@
 #include <services/window/window.h>
 #include <utils/sec.h>
 
+#include <common/algorithm.h>
 #include <common/cvt.h>
 #include <common/log.h>
 
 #include <config/app_settings.h>
+#include <config/config.h>
 #include <kernel/kernel.h>
 
 #include <utils/err.h>
@@ -43,6 +45,21 @@ namespace eka2l1::epoc {
 
     void window_group::gain_focus() {
         queue_event(epoc::event{ client_handle, epoc::event_code::focus_gained });
+        apply_code_cache_setting();
+    }
+
+    void window_group::apply_code_cache_setting() {
+        kernel_system *kern = client->get_ws().get_kernel_system();
+        int code_cache_size_mb = kern->get_config()->jit_code_cache_size_mb;
+
+        if (saved_setting.jit_code_cache_size_mb) {
+            code_cache_size_mb = static_cast<int>(saved_setting.jit_code_cache_size_mb);
+        }
+
+        // The code cache is shared by every process. Only the foreground app decides its size, so that helper
+        // processes and servers loading in the background do not resize and flush it. Setting the size the
+        // cache already has is free.
+        kern->get_cpu()->set_code_cache_size(common::MB(common::max(code_cache_size_mb, 0)));
     }
 
     void window_group::receive_focus(service::ipc_context &context, ws_cmd &cmd) {
@@ -74,6 +91,7 @@ namespace eka2l1::epoc {
 
         if (this == scr->focus) {
             scr->restore_from_config(client->get_ws().get_graphics_driver(), saved_setting);
+            apply_code_cache_setting();
         }
     }
 
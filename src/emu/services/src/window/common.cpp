@@ -25,6 +25,7 @@
 #include <common/log.h>
 #include <common/time.h>
 
+#include <drivers/itc.h>
 #include <services/window/common.h>
 
 namespace eka2l1::epoc {
@@ -173,6 +174,21 @@ namespace eka2l1::epoc {
         return word_width * 4;
     }
 
+    void upload_screen_rect(drivers::graphics_command_builder &builder, const drivers::handle h, const std::uint8_t *buffer,
+        const eka2l1::vec2 &screen_size, const int bpp, const eka2l1::rect &area) {
+        const std::size_t bytes_per_pixel = (bpp + 7) / 8;
+        const std::size_t line_pitch = get_byte_width(screen_size.x, static_cast<std::uint8_t>(bpp));
+
+        // Rows keep the pitch of the whole screen, only upload from the first pixel to the last
+        const std::size_t start_offset = static_cast<std::size_t>(area.top.y) * line_pitch + area.top.x * bytes_per_pixel;
+        const std::size_t upload_size = static_cast<std::size_t>(area.size.y - 1) * line_pitch + area.size.x * bytes_per_pixel;
+
+        // The pitch is padded past the screen width, a whole number of pixels for 24bpp's 12 bytes. Drivers are given
+        // the pitch in pixels, since they only align rows to 4 bytes.
+        builder.update_bitmap(h, reinterpret_cast<const char *>(buffer + start_offset), upload_size, area.top, area.size,
+            line_pitch / bytes_per_pixel);
+    }
+
     epoc::display_mode string_to_display_mode(const std::string &disp_str) {
         const std::string disp_str_lower = common::lowercase_string(disp_str);
         if (disp_str_lower == "color16map")
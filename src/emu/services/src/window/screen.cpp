@@ -24,6 +24,7 @@
 #include <services/window/screen.h>
 #include <services/window/window.h>
 
+#include <common/metrics.h>
 #include <common/rgb.h>
 #include <common/time.h>
 #include <config/app_settings.h>
@@ -37,6 +38,7 @@ namespace eka2l1::epoc {
     struct window_drawer_walker : public window_tree_walker {
         drivers::graphics_command_builder &builder_;
         std::uint32_t total_redrawed_;
+        common::region drawn_region_;
 
         explicit window_drawer_walker(drivers::graphics_command_builder &builder)
             : builder_(builder)
@@ -50,8 +52,10 @@ namespace eka2l1::epoc {
 
             epoc::canvas_base *cv = reinterpret_cast<epoc::canvas_base*>(win);
 
-            if (cv->draw(builder_))
+            if (cv->draw(builder_)) {
                 total_redrawed_++;
+                drawn_region_.add_rect(cv->abs_rect);
+            }
 
             return false;
         }
@@ -154,20 +158,58 @@ namespace eka2l1::epoc {
         delete pitcher;
     }
 
-    void screen::sync_screen_buffer_data(drivers::graphics_driver *driver) {
+    void screen::sync_screen_buffer_data(drivers::graphics_driver *driver, const common::region *dirty) {
         std::uint8_t *buffer_ptr = screen_buffer_ptr();
         const config::screen_mode &crrmode = current_mode();
 
-        drivers::read_bitmap(driver, screen_texture, eka2l1::point(0, 0), eka2l1::object_size(crrmode.size),
-            get_bpp_from_display_mode(disp_mode), buffer_ptr);
+        const std::uint32_t bpp = get_bpp_from_display_mode(disp_mode);
+        const bool flipped = (crrmode.rotation == 90) || (crrmode.rotation == 180);
+
+        // The driver only reads back in the buffer layout for these depths, and the texture must not be upscaled
+        if (!dirty || ((bpp != 16) && (bpp != 32)) || (display_scale_factor != 1.0f)) {
+            drivers::read_bitmap(driver, screen_texture, eka2l1::point(0, 0), eka2l1::object_size(crrmode.size),
+                bpp, buffer_ptr);
+
+            if (flipped) {
+                const std::uint32_t current_pitch = epoc::get_byte_width(crrmode.size.x, bpp);
+                flip_screen_image(buffer_ptr, current_pitch, crrmode.size.y);
+            }
 
-        if ((crrmode.rotation == 90) || (crrmode.rotation == 180)) {
-            const std::uint32_t current_pitch = epoc::get_byte_width(crrmode.size.x, epoc::get_bpp_from_display_mode(disp_mode));
-            flip_screen_image(buffer_ptr, current_pitch, crrmode.size.y);
+            return;
+        }
+
+        const eka2l1::rect screen_rect(eka2l1::vec2(0, 0), crrmode.size);
+        const std::uint32_t line_pitch = epoc::get_byte_width(crrmode.size.x, bpp);
+        const std::uint32_t bytes_per_pixel = bpp / 8;
+
+        for (const eka2l1::rect &dirty_rect : dirty->rects_) {
+            const eka2l1::rect to_read = dirty_rect.intersect(screen_rect);
+
+            if (to_read.empty()) {
+                continue;
+            }
+
+            const std::uint32_t read_pitch = ((to_read.size.x * bytes_per_pixel) + 3) & ~3;
+            readback_buffer_.resize(read_pitch * to_read.size.y);
+
+            // The texture is upside down when the screen is flipped
+            const int texture_y = flipped ? (crrmode.size.y - to_read.top.y - to_read.size.y) : to_read.top.y;
+
+            if (!drivers::read_bitmap(driver, screen_texture, eka2l1::point(to_read.top.x, texture_y),
+                    eka2l1::object_size(to_read.size), bpp, readback_buffer_.data())) {
+                continue;
+            }
+
+            for (int y = 0; y < to_read.size.y; y++) {
+                const int source_row = flipped ? (to_read.size.y - y - 1) : y;
+
+                std::memcpy(buffer_ptr + (to_read.top.y + y) * line_pitch + to_read.top.x * bytes_per_pixel,
+                    readback_buffer_.data() + source_row * read_pitch, to_read.size.x * bytes_per_pixel);
+            }
         }
     }
 
-    bool screen::redraw(drivers::graphics_command_builder &builder, const bool need_bind) {
+    bool screen::redraw(drivers::graphics_command_builder &builder, const bool need_bind, common::region *drawn_region) {
         if (need_update_visible_regions()) {
             recalculate_visible_regions();
         }
@@ -193,6 +235,11 @@ namespace eka2l1::epoc {
         window_drawer_walker adrawwalker(builder);
         root->walk_tree(&adrawwalker, window_tree_walk_style::bonjour_children);
 
+        if (drawn_region) {
+            // Only the color buffer of windows that drew is touched, the rest of the screen keeps its content
+            *drawn_region = std::move(adrawwalker.drawn_region_);
+        }
+
         // Done! Unbind and submit this to the driver
         builder.bind_bitmap(0);
 
@@ -209,13 +256,15 @@ namespace eka2l1::epoc {
 
         // Make command list first, and bind our screen bitmap
         drivers::graphics_command_builder builder;
-        const bool performed = redraw(builder, true);
+        common::region drawn_region;
+
+        const bool performed = redraw(builder, true, &drawn_region);
     
         eka2l1::drivers::command_list retrieved = builder.retrieve_command_list();
         driver->submit_command_list(retrieved);
 
         if (performed && sync_screen_buffer && (display_scale_factor == 1.0f)) {
-            sync_screen_buffer_data(driver);
+            sync_screen_buffer_data(driver, &drawn_region);
         }
 
         fire_screen_redraw_callbacks(false);
@@ -402,6 +451,11 @@ namespace eka2l1::epoc {
     }
 
     void screen::fire_screen_redraw_callbacks(const bool is_dsa) {
+        if (metrics_ && (number == 0)) {
+            // End the frame before the callbacks, so that they can show its statistics
+            metrics_->end_frame();
+        }
+
         for (auto &callback : screen_redraw_callbacks) {
             if (callback.second)
                 callback.second(callback.first, this, is_dsa);
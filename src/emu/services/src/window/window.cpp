@@ -1802,6 +1802,10 @@ namespace eka2l1 {
         // Set default focus screen to be the first
         focus_screen_ = screens;
 
+        for (crr = screens; crr; crr = crr->next) {
+            crr->metrics_ = sys->get_metrics();
+        }
+
         config::state *config = kern->get_config();
 
         if (config) {
@@ -27,6 +27,7 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
 #include <tuple>
 
 namespace eka2l1 {
@@ -40,8 +41,31 @@ namespace eka2l1 {
 
     namespace common {
         class chunkyseri;
+        class metrics_registry;
     }
 
+    enum snapshot_result {
+        snapshot_result_ok = 0,
+        snapshot_result_io_error = 1,
+        snapshot_result_invalid_file = 2,
+        snapshot_result_device_mismatch = 3,
+        snapshot_result_state_mismatch = 4,
+        snapshot_result_not_running = 5,
+        snapshot_result_session_mismatch = 6
+    };
+
+    /**
+     * @brief Header of a system snapshot file. Readable without decompressing the state.
+     */
+    struct snapshot_info {
+        std::uint32_t version_ = 0;
+        std::uint64_t session_id_ = 0; ///< Identifies the boot the snapshot was taken in.
+        std::string firmware_code_;
+        arm_emulator_type cpu_type_ = arm_emulator_type::dynarmic;
+        std::uint64_t guest_time_us_ = 0;
+        std::uint64_t state_size_ = 0;
+    };
+
     namespace epoc {
         struct hal;
     }
@@ -136,7 +160,28 @@ namespace eka2l1 {
 
         int loop();
 
-        void do_state(common::chunkyseri &seri);
+        bool do_state(common::chunkyseri &seri);
+
+        /**
+         * @brief Save the timing, chunk memory and thread contexts of the running system to a compressed file.
+         *
+         * This is a rewind point for the current boot, not a boot image. Kernel objects, handle tables and HLE
+         * servers are not saved, so the snapshot can't bring up a system after a restart of the emulator.
+         */
+        snapshot_result save_snapshot(const std::string &path);
+
+        /**
+         * @brief Rewind the running system to a snapshot saved during the current boot.
+         *
+         * Only guest memory, thread contexts and timing are restored. Kernel objects, their handles and HLE
+         * server state are left as they are, so a snapshot from an earlier boot would pair the saved memory
+         * with unrelated host-side state. Such a snapshot is rejected with snapshot_result_session_mismatch.
+         * The snapshot is also rejected, with nothing changed, if the set of live chunks and threads differs
+         * from the saved one.
+         */
+        snapshot_result load_snapshot(const std::string &path);
+
+        static std::optional<snapshot_info> read_snapshot_info(const std::string &path);
 
         device_manager *get_device_manager();
         manager::packages *get_packages();
@@ -155,6 +200,13 @@ namespace eka2l1 {
         config::state *get_config();
         dispatch::dispatcher *get_dispatcher();
 
+        /**
+         * @brief Get the registry that subsystems publish their performance metrics into.
+         *
+         * A frame snapshot is taken each time the first screen is presented.
+         */
+        common::metrics_registry *get_metrics();
+
         void set_config(config::state *conf);
 
         void mount(drive_number drv, const drive_media media, std::string path, const std::uint32_t attrib = io_attrib_none);
@@ -31,10 +31,16 @@
 namespace eka2l1 {
     using device_firmware_choose_variant_callback = std::function<int(const std::vector<std::string> &)>;
 
+    /**
+     * @brief Called after each firmware extraction stage, with the stage description and the host time it took
+     *        in microseconds.
+     */
+    using firmware_stage_timing_callback = std::function<void(const std::string &, const std::uint64_t)>;
+
     class device_manager;
 
     device_installation_error install_firmware(device_manager *dvc, const std::string &vpl_path,
         const std::string &drives_c_path, const std::string &drives_e_path, const std::string &drives_z_path,
         const std::string &rom_resident_path, device_firmware_choose_variant_callback choose_callback, progress_changed_callback progress_callback,
-        cancel_requested_callback cancel_cb);
+        cancel_requested_callback cancel_cb, firmware_stage_timing_callback stage_timing_cb = nullptr);
 }
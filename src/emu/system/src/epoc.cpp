@@ -21,11 +21,13 @@
 #include <common/configure.h>
 
 #include <common/algorithm.h>
+#include <common/buffer.h>
 #include <common/chunkyseri.h>
 #include <common/container.h>
 #include <common/cvt.h>
 #include <common/fileutils.h>
 #include <common/log.h>
+#include <common/metrics.h>
 #include <common/path.h>
 #include <common/platform.h>
 #include <common/random.h>
@@ -47,6 +49,9 @@
 #include <string>
 
 #include <disasm/disasm.h>
+#include <drivers/audio/audio.h>
+#include <drivers/audio/mixer.h>
+#include <drivers/graphics/graphics.h>
 #include <drivers/itc.h>
 #include <gdbstub/gdbstub.h>
 
@@ -95,6 +100,11 @@ namespace eka2l1 {
     class system_impl {
         std::mutex mut;
 
+        // Created first, so that it outlives every subsystem that publishes into it
+        std::unique_ptr<common::metrics_registry> metrics_;
+        common::metric_counter *cpu_time_metric_;
+        common::metric_counter *cpu_instructions_metric_;
+
         arm::core_instance cpu;
         arm::exclusive_monitor_instance exmonitor;
 
@@ -132,6 +142,10 @@ namespace eka2l1 {
 
         bool startup_inited = false;
 
+        // Regenerated on every boot. Snapshots don't hold the kernel objects and HLE servers, and can only
+        // rewind the boot they were taken in.
+        std::uint64_t session_id_ = 0;
+
         std::optional<filesystem_id> rom_fs_id_;
         std::optional<filesystem_id> physical_fs_id_;
 
@@ -145,6 +159,8 @@ namespace eka2l1 {
     public:
         explicit system_impl(system *parent, system_create_components &param);
 
+        void init_metrics();
+
         ~system_impl() {
             // Reset dispatchers...
             if (dispatcher_)
@@ -519,11 +535,18 @@ namespace eka2l1 {
             return dispatcher_.get();
         }
 
+        common::metrics_registry *get_metrics() {
+            return metrics_.get();
+        }
+
         void mount(drive_number drv, const drive_media media, std::string path, const std::uint32_t attrib = io_attrib_none);
         zip_mount_error mount_game_zip(drive_number drv, const drive_media media, const std::string &zip_path, const std::uint32_t attrib = io_attrib_none, progress_changed_callback progress_cb = nullptr, cancel_requested_callback cancel_cb = nullptr);
 
         bool reset(const bool lock_sys, const std::int32_t new_index = -1);
-        void do_state(common::chunkyseri &seri);
+        bool do_state(common::chunkyseri &seri);
+
+        snapshot_result save_snapshot(const std::string &path);
+        snapshot_result load_snapshot(const std::string &path);
 
         package::installation_result install_package(std::u16string path, drive_number drv);
         bool load_rom(const std::string &path);
@@ -539,7 +562,176 @@ namespace eka2l1 {
         void initialize_user_parties();
     };
 
-    void system_impl::do_state(common::chunkyseri &seri) {
+    static constexpr std::uint32_t SNAPSHOT_MAGIC = 0x50414E53; // SNAP
+    static constexpr std::uint32_t SNAPSHOT_VERSION = 2;
+
+    bool system_impl::do_state(common::chunkyseri &seri) {
+        auto s = seri.section("System", 1);
+
+        if (!s || !timing_ || !kern_) {
+            return false;
+        }
+
+        timing_->do_state(seri);
+        return kern_->do_state(seri);
+    }
+
+    static bool absorb_snapshot_header(common::chunkyseri &seri, snapshot_info &info) {
+        std::uint32_t magic = SNAPSHOT_MAGIC;
+        seri.absorb(magic);
+
+        if (magic != SNAPSHOT_MAGIC) {
+            return false;
+        }
+
+        std::uint32_t cpu_type = static_cast<std::uint32_t>(info.cpu_type_);
+
+        seri.absorb(info.version_);
+        seri.absorb(info.session_id_);
+        seri.absorb(info.firmware_code_);
+        seri.absorb(cpu_type);
+        seri.absorb(info.guest_time_us_);
+        seri.absorb(info.state_size_);
+
+        info.cpu_type_ = static_cast<arm_emulator_type>(cpu_type);
+        return !seri.eos();
+    }
+
+    snapshot_result system_impl::save_snapshot(const std::string &path) {
+        device *dvc = dvcmngr_->get_current();
+
+        if (!kern_ || !dvc) {
+            return snapshot_result_not_running;
+        }
+
+        start_access();
+
+        common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+        do_state(seri);
+
+        std::vector<std::uint8_t> state(seri.size());
+
+        seri = common::chunkyseri(state.data(), state.size(), common::SERI_MODE_WRITE);
+        const bool written = do_state(seri);
+
+        snapshot_info info;
+        info.version_ = SNAPSHOT_VERSION;
+        info.session_id_ = session_id_;
+        info.firmware_code_ = dvc->firmware_code;
+        info.cpu_type_ = cpu_type;
+        info.guest_time_us_ = timing_->microseconds();
+        info.state_size_ = state.size();
+
+        end_access();
+
+        if (!written) {
+            return snapshot_result_not_running;
+        }
+
+        // Guest memory is mostly zero-filled or repeated, compress it before touching the disk
+        mz_ulong compressed_size = mz_compressBound(static_cast<mz_ulong>(state.size()));
+        std::vector<std::uint8_t> compressed(compressed_size);
+
+        if (mz_compress2(compressed.data(), &compressed_size, state.data(), static_cast<mz_ulong>(state.size()), MZ_BEST_SPEED) != MZ_OK) {
+            LOG_ERROR(SYSTEM, "Unable to compress system snapshot");
+            return snapshot_result_io_error;
+        }
+
+        seri = common::chunkyseri(nullptr, 0, common::SERI_MODE_MEASURE);
+        absorb_snapshot_header(seri, info);
+
+        std::vector<std::uint8_t> header(seri.size());
+        seri = common::chunkyseri(header.data(), header.size(), common::SERI_MODE_WRITE);
+        absorb_snapshot_header(seri, info);
+
+        common::create_directories(eka2l1::file_directory(path));
+        common::wo_std_file_stream stream(path, true);
+
+        if (!stream.valid() || (stream.write(header.data(), header.size()) != header.size())
+            || (stream.write(compressed.data(), compressed_size) != compressed_size)) {
+            LOG_ERROR(SYSTEM, "Unable to write system snapshot to {}", path);
+            return snapshot_result_io_error;
+        }
+
+        LOG_INFO(SYSTEM, "Saved system snapshot to {} ({} bytes, {} bytes compressed)", path, state.size(), compressed_size);
+        return snapshot_result_ok;
+    }
+
+    static snapshot_result read_snapshot_file(const std::string &path, snapshot_info &info, std::vector<std::uint8_t> *state) {
+        common::ro_std_file_stream stream(path, true);
+
+        if (!stream.valid()) {
+            return snapshot_result_io_error;
+        }
+
+        std::vector<std::uint8_t> buf(stream.size());
+
+        if (buf.empty() || (stream.read(buf.data(), buf.size()) != buf.size())) {
+            return snapshot_result_io_error;
+        }
+
+        common::chunkyseri seri(buf.data(), buf.size(), common::SERI_MODE_READ);
+
+        if (!absorb_snapshot_header(seri, info) || (info.version_ != SNAPSHOT_VERSION)) {
+            return snapshot_result_invalid_file;
+        }
+
+        if (!state) {
+            return snapshot_result_ok;
+        }
+
+        state->resize(info.state_size_);
+
+        mz_ulong state_size = static_cast<mz_ulong>(info.state_size_);
+        const std::size_t header_size = seri.size();
+
+        if ((mz_uncompress(state->data(), &state_size, buf.data() + header_size, static_cast<mz_ulong>(buf.size() - header_size)) != MZ_OK)
+            || (state_size != info.state_size_)) {
+            return snapshot_result_invalid_file;
+        }
+
+        return snapshot_result_ok;
+    }
+
+    snapshot_result system_impl::load_snapshot(const std::string &path) {
+        device *dvc = dvcmngr_->get_current();
+
+        if (!kern_ || !dvc) {
+            return snapshot_result_not_running;
+        }
+
+        snapshot_info info;
+        std::vector<std::uint8_t> state;
+
+        const snapshot_result result = read_snapshot_file(path, info, &state);
+
+        if (result != snapshot_result_ok) {
+            LOG_ERROR(SYSTEM, "Unable to read system snapshot {}", path);
+            return result;
+        }
+
+        if ((info.firmware_code_ != dvc->firmware_code) || (info.cpu_type_ != cpu_type)) {
+            LOG_ERROR(SYSTEM, "System snapshot {} was taken on firmware {}, current firmware is {}", path, info.firmware_code_,
+                dvc->firmware_code);
+            return snapshot_result_device_mismatch;
+        }
+
+        start_access();
+
+        if (info.session_id_ != session_id_) {
+            end_access();
+
+            LOG_ERROR(SYSTEM, "System snapshot {} was taken in an earlier boot, ignored. Snapshots only rewind the "
+                "boot they were taken in", path);
+            return snapshot_result_session_mismatch;
+        }
+
+        common::chunkyseri seri(state.data(), state.size(), common::SERI_MODE_READ);
+        const bool restored = do_state(seri);
+
+        end_access();
+
+        return restored ? snapshot_result_ok : snapshot_result_state_mismatch;
     }
 
     static constexpr std::uint32_t DEFAULT_CPU_HZ = 484000000;
@@ -557,6 +749,10 @@ namespace eka2l1 {
         exmonitor = arm::create_exclusive_monitor(cpu_type, 1);
         cpu = arm::create_core(exmonitor.get(), cpu_type);
 
+        if (conf_->jit_code_cache_size_mb > 0) {
+            cpu->set_code_cache_size(common::MB(conf_->jit_code_cache_size_mb));
+        }
+
         kern_ = std::make_unique<kernel_system>(parent_, timing_.get(), io_.get(), conf_, app_settings_, &romf_, cpu.get(),
             disassembler_.get());
 
@@ -582,6 +778,57 @@ namespace eka2l1 {
         io_ = std::make_unique<io_system>();
         stub_ = std::make_unique<gdbstub>();
         packages_ = std::make_unique<manager::packages>(io_.get(), conf_);
+
+        init_metrics();
+    }
+
+    void system_impl::init_metrics() {
+        metrics_ = std::make_unique<common::metrics_registry>();
+
+        cpu_time_metric_ = metrics_->counter("cpu.run_time_us");
+        cpu_instructions_metric_ = metrics_->counter("cpu.instructions");
+
+        // Subsystems below already keep their own statistics, mirror them at the end of each frame
+        common::metric_counter *jit_compiled_blocks = metrics_->counter("jit.compiled_blocks");
+        common::metric_counter *jit_compile_time = metrics_->counter("jit.compile_time_us");
+        common::metric_gauge *jit_cache_used = metrics_->gauge("jit.cache_used_kb");
+
+        common::metric_counter *gpu_busy_time = metrics_->counter("gpu.busy_time_us");
+        common::metric_counter *gpu_lists = metrics_->counter("gpu.submitted_lists");
+        common::metric_counter *gpu_stall_time = metrics_->counter("gpu.producer_stall_us");
+
+        common::metric_counter *audio_mix_time = metrics_->counter("audio.mix_time_us");
+        common::metric_counter *audio_underruns = metrics_->counter("audio.underruns");
+        common::metric_gauge *audio_active_streams = metrics_->gauge("audio.active_streams");
+
+        metrics_->add_collector([this, jit_compiled_blocks, jit_compile_time, jit_cache_used, gpu_busy_time, gpu_lists,
+                                    gpu_stall_time, audio_mix_time, audio_underruns, audio_active_streams]() {
+            if (cpu) {
+                const arm::code_cache_stats stats = cpu->get_code_cache_stats();
+
+                jit_compiled_blocks->set(stats.compiled_block_count_);
+                jit_compile_time->set(stats.compile_time_us_);
+                jit_cache_used->set(static_cast<double>(stats.used_bytes_) / 1024.0);
+            }
+
+            if (gdriver) {
+                const drivers::command_queue_stats stats = gdriver->get_command_queue_stats();
+
+                gpu_busy_time->set(stats.consumer_busy_us_);
+                gpu_lists->set(stats.submitted_lists_);
+                gpu_stall_time->set(stats.producer_stall_us_);
+            }
+
+            drivers::audio_mixer *mixer = adriver ? adriver->get_mixer() : nullptr;
+
+            if (mixer) {
+                const drivers::audio_mixer_stats stats = mixer->get_stats();
+
+                audio_mix_time->set(stats.mix_time_us_);
+                audio_underruns->set(stats.underruns_);
+                audio_active_streams->set(static_cast<double>(stats.active_stream_count_));
+            }
+        });
     }
 
     void system_impl::set_graphics_driver(drivers::graphics_driver *graphics_driver) {
@@ -681,6 +928,7 @@ namespace eka2l1 {
 
         if (to_run != nullptr) {
             if (!should_step) {
+                common::scoped_metric_timer timer(cpu_time_metric_);
                 cpu->run(to_run->get_remaining_screenticks());
             } else {
                 cpu->step();
@@ -692,6 +940,7 @@ namespace eka2l1 {
             }
 
             to_run->add_ticks(cpu->get_num_instruction_executed());
+            cpu_instructions_metric_->add(cpu->get_num_instruction_executed());
         }
 
         if (!kern_->should_terminate()) {
@@ -960,6 +1209,8 @@ namespace eka2l1 {
         scripting_ = std::make_unique<manager::scripts>(parent_);
 #endif
 
+        session_id_ = (static_cast<std::uint64_t>(random()) << 32) | random();
+
         // Setup outsiders
         setup_outsider();
         invoke_system_reset_callbacks();
@@ -1119,6 +1370,10 @@ namespace eka2l1 {
         return impl->get_dispatcher();
     }
 
+    common::metrics_registry *system::get_metrics() {
+        return impl->get_metrics();
+    }
+
     void system::mount(drive_number drv, const drive_media media, std::string path,
         const std::uint32_t attrib) {
         return impl->mount(drv, media, path, attrib);
@@ -1152,10 +1407,28 @@ namespace eka2l1 {
         return impl->get_hal(category);
     }
 
-    void system::do_state(common::chunkyseri &seri) {
+    bool system::do_state(common::chunkyseri &seri) {
         return impl->do_state(seri);
     }
 
+    snapshot_result system::save_snapshot(const std::string &path) {
+        return impl->save_snapshot(path);
+    }
+
+    snapshot_result system::load_snapshot(const std::string &path) {
+        return impl->load_snapshot(path);
+    }
+
+    std::optional<snapshot_info> system::read_snapshot_info(const std::string &path) {
+        snapshot_info info;
+
+        if (read_snapshot_file(path, info, nullptr) != snapshot_result_ok) {
+            return std::nullopt;
+        }
+
+        return info;
+    }
+
     const language system::get_system_language() const {
         return impl->get_system_language();
     }
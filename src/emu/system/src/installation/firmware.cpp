@@ -27,49 +27,78 @@
 #include <common/fileutils.h>
 #include <common/log.h>
 #include <common/path.h>
+#include <common/threadpool.h>
 
 #include <loader/fpsx.h>
 #include <loader/rofs.h>
 #include <loader/rom.h>
 
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <mutex>
 #include <pugixml.hpp>
 
 #include <fat/fat.h>
 
 namespace eka2l1 {
-    static void extract_file(Fat::Image &img, Fat::Entry &entry, const std::string &path) {
-        const std::u16string filename_16 = entry.get_filename();
-        std::string filename = eka2l1::add_path(path, common::ucs2_to_utf8(filename_16));
+    static constexpr std::uint32_t FAT_EXTRACT_CHUNK_SIZE = 0x100000;
 
-        if (common::is_platform_case_sensitive()) {
-            filename = common::lowercase_string(filename);
-        }
+    struct fat_extract_file {
+        Fat::Entry entry_;
+        std::string dest_path_;
+    };
 
-        common::wo_std_file_stream f(filename, true);
+    static std::uint32_t fat_image_read(void *userdata, void *buffer, std::uint32_t size) {
+        common::ro_std_file_stream *stream = reinterpret_cast<common::ro_std_file_stream *>(userdata);
+        return static_cast<std::uint32_t>(stream->read(buffer, size));
+    }
 
-        static constexpr std::uint32_t CHUNK_SIZE = 0x10000;
+    static std::uint32_t fat_image_seek(void *userdata, std::uint32_t offset, int mode) {
+        common::ro_std_file_stream *stream = reinterpret_cast<common::ro_std_file_stream *>(userdata);
+        stream->seek(offset, (mode == Fat::IMAGE_SEEK_MODE_BEG ? common::seek_where::beg : (mode == Fat::IMAGE_SEEK_MODE_CUR ? common::seek_where::cur : common::seek_where::end)));
 
-        std::vector<std::uint8_t> temp_buf;
-        temp_buf.resize(CHUNK_SIZE);
+        return static_cast<std::uint32_t>(stream->tell());
+    }
+
+    static void report_stage_timing(firmware_stage_timing_callback &stage_timing_cb, const std::string &stage,
+        std::chrono::steady_clock::time_point &stage_start) {
+        const auto now = std::chrono::steady_clock::now();
+        const std::uint64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(now - stage_start).count();
+
+        LOG_INFO(SYSTEM, "Firmware installation stage \"{}\" took {} ms", stage, elapsed_us / 1000);
+
+        if (stage_timing_cb) {
+            stage_timing_cb(stage, elapsed_us);
+        }
 
-        std::uint32_t size_left = entry.entry.file_size;
+        stage_start = now;
+    }
+
+    static bool extract_file(Fat::Image &img, fat_extract_file &file, std::vector<std::uint8_t> &temp_buf,
+        const std::function<void(const std::uint32_t)> &written_cb) {
+        common::wo_std_file_stream f(file.dest_path_, true);
+
+        std::uint32_t size_left = file.entry_.entry.file_size;
         std::uint32_t offset = 0;
 
         while (size_left != 0) {
-            std::uint32_t size_to_take = std::min<std::uint32_t>(CHUNK_SIZE, size_left);
-            if (img.read_from_cluster(&temp_buf[0], offset, entry.entry.starting_cluster, size_to_take) != size_to_take) {
-                break;
+            std::uint32_t size_to_take = std::min<std::uint32_t>(FAT_EXTRACT_CHUNK_SIZE, size_left);
+            if (img.read_from_cluster(&temp_buf[0], offset, file.entry_.entry.starting_cluster, size_to_take) != size_to_take) {
+                return false;
             }
 
             size_left -= size_to_take;
             offset += size_to_take;
 
             f.write(reinterpret_cast<const char *>(&temp_buf[0]), size_to_take);
+            written_cb(size_to_take);
         }
+
+        return true;
     }
 
-    static void extract_directory(Fat::Image &img, Fat::Entry mee, std::string dir_path) {
+    static void index_directory(Fat::Image &img, Fat::Entry mee, std::string dir_path, std::vector<fat_extract_file> &files) {
         common::create_directories(dir_path);
 
         while (img.get_next_entry(mee)) {
@@ -87,19 +116,102 @@ namespace eka2l1 {
                         dir_name = common::lowercase_ucs2_string(dir_name);
                     }
 
-                    extract_directory(img, baby, dir_path + common::ucs2_to_utf8(dir_name) + "\\");
+                    index_directory(img, baby, dir_path + common::ucs2_to_utf8(dir_name) + "\\", files);
                 }
             }
 
             if ((mee.entry.file_attributes & (int)Fat::EntryAttribute::ARCHIVE) || (!(mee.entry.file_attributes & (int)Fat::EntryAttribute::DIRECTORY) && (mee.entry.file_size != 0))) {
-                extract_file(img, mee, dir_path);
+                std::string filename = eka2l1::add_path(dir_path, common::ucs2_to_utf8(mee.get_filename()));
+
+                if (common::is_platform_case_sensitive()) {
+                    filename = common::lowercase_string(filename);
+                }
+
+                files.push_back({ mee, filename });
+            }
+        }
+    }
+
+    static bool extract_fat_image(const std::string &image_path, const std::string &dest_path, progress_changed_callback &progress_cb,
+        cancel_requested_callback &cancel_cb, firmware_stage_timing_callback &stage_timing_cb, const std::string &stage_prefix) {
+        auto stage_start = std::chrono::steady_clock::now();
+        std::vector<fat_extract_file> files;
+
+        {
+            // I was using ifstream, but not sure why it fucked up
+            common::ro_std_file_stream fat_image_file(image_path, true);
+            Fat::Image fat_img(&fat_image_file, fat_image_read, fat_image_seek);
+
+            Fat::Entry bootstrap_entry;
+            index_directory(fat_img, bootstrap_entry, dest_path, files);
+        }
+
+        report_stage_timing(stage_timing_cb, stage_prefix + "FAT index", stage_start);
+
+        std::uint64_t total_size = 0;
+        for (const fat_extract_file &file : files) {
+            total_size += file.entry_.entry.file_size;
+        }
+
+        std::atomic<std::size_t> next_file(0);
+        std::atomic<bool> canceled(false);
+
+        std::mutex progress_lock;
+        std::uint64_t written_size = 0;
+
+        const std::function<void(const std::uint32_t)> written_cb = [&](const std::uint32_t size) {
+            if (progress_cb) {
+                const std::lock_guard<std::mutex> guard(progress_lock);
+
+                written_size += size;
+                progress_cb(static_cast<std::size_t>(written_size), static_cast<std::size_t>(std::max<std::uint64_t>(total_size, 1)));
+            }
+        };
+
+        {
+            common::thread_pool pool("FAT extract", std::min<std::size_t>(files.size(), std::thread::hardware_concurrency()));
+            std::vector<std::future<void>> waits;
+
+            for (std::size_t i = 0; i < pool.worker_count(); i++) {
+                waits.push_back(pool.submit([&]() {
+                    // Each worker owns an image, the cluster chain walk seeks the stream
+                    common::ro_std_file_stream fat_image_file(image_path, true);
+                    Fat::Image fat_img(&fat_image_file, fat_image_read, fat_image_seek);
+
+                    std::vector<std::uint8_t> temp_buf(FAT_EXTRACT_CHUNK_SIZE);
+
+                    while (!canceled) {
+                        const std::size_t index = next_file++;
+
+                        if (index >= files.size()) {
+                            break;
+                        }
+
+                        if (cancel_cb && cancel_cb()) {
+                            canceled = true;
+                            break;
+                        }
+
+                        if (!extract_file(fat_img, files[index], temp_buf, written_cb)) {
+                            LOG_ERROR(SYSTEM, "Fail to extract file {} from FAT image", files[index].dest_path_);
+                        }
+                    }
+                }));
+            }
+
+            for (auto &wait : waits) {
+                wait.get();
             }
         }
+
+        report_stage_timing(stage_timing_cb, stage_prefix + "FAT extract (" + std::to_string(files.size()) + " files)", stage_start);
+        return !canceled;
     }
 
     static device_installation_error dump_data_from_fpsx(loader::firmware::fpsx_header &header, common::ro_stream &stream, const std::string &drives_c_path,
         const std::string &drives_e_path, const std::string &drives_z_path, const std::string &rom_resident_path,
-        progress_changed_callback progress_cb, cancel_requested_callback cancel_cb) {
+        progress_changed_callback progress_cb, cancel_requested_callback cancel_cb, firmware_stage_timing_callback &stage_timing_cb,
+        const std::string &stage_prefix) {
         if (header.type_ == loader::firmware::FPSX_TYPE_INVALID) {
             if (progress_cb)
                 progress_cb(1, 1);
@@ -111,6 +223,7 @@ namespace eka2l1 {
         }
 
         std::vector<char> buf;
+        auto stage_start = std::chrono::steady_clock::now();
 
         if (header.type_ == loader::firmware::FPSX_TYPE_CORE) {
             const std::string rom_path = eka2l1::add_path(rom_resident_path, "SYM_TEMP.ROM");
@@ -167,6 +280,7 @@ namespace eka2l1 {
                 }
             }
 
+            report_stage_timing(stage_timing_cb, stage_prefix + "core ROM assembly", stage_start);
             int defrag_result = 0;
 
             {
@@ -189,6 +303,7 @@ namespace eka2l1 {
                 }
             }
 
+            report_stage_timing(stage_timing_cb, stage_prefix + "core ROM defrag", stage_start);
             common::ro_std_file_stream rom_read_stream(rom_final_path, true);
 
             if (!loader::dump_rom_files(reinterpret_cast<common::ro_stream *>(&rom_read_stream),
@@ -196,6 +311,8 @@ namespace eka2l1 {
                 common::remove(rom_final_path);
                 return device_installation_rom_file_corrupt;
             }
+
+            report_stage_timing(stage_timing_cb, stage_prefix + "core ROM dump", stage_start);
         }
 
         std::string image_path = eka2l1::add_path(rom_resident_path, "TEMP.IMG");
@@ -243,43 +360,33 @@ namespace eka2l1 {
             }
         }
 
+        report_stage_timing(stage_timing_cb, stage_prefix + "image assembly", stage_start);
+
         // What to do with it now?
         if (header.type_ == loader::firmware::FPSX_TYPE_UDA) {
             // Extract the FAT image, with some twists
-            // I was using ifstream, but not sure why it fucked up
-            common::ro_std_file_stream fat_image_file(image_path, true);
-            Fat::Image fat_img(
-                &fat_image_file,
-                // Read hook
-                [](void *userdata, void *buffer, std::uint32_t size) -> std::uint32_t {
-                    common::ro_std_file_stream *stream = reinterpret_cast<common::ro_std_file_stream *>(userdata);
-                    return static_cast<std::uint32_t>(stream->read(buffer, size));
-                },
-                // Seek hook
-                [](void *userdata, std::uint32_t offset, int mode) -> std::uint32_t {
-                    common::ro_std_file_stream *stream = reinterpret_cast<common::ro_std_file_stream *>(userdata);
-                    stream->seek(offset, (mode == Fat::IMAGE_SEEK_MODE_BEG ? common::seek_where::beg : (mode == Fat::IMAGE_SEEK_MODE_CUR ? common::seek_where::cur : common::seek_where::end)));
-
-                    return static_cast<std::uint32_t>(stream->tell());
-                });
-
-            std::string fat_dump_base;
-            fat_dump_base = drives_c_path;
-
-            Fat::Entry bootstrap_entry;
-            extract_directory(fat_img, bootstrap_entry, fat_dump_base);
+            if (!extract_fat_image(image_path, drives_c_path, progress_cb, cancel_cb, stage_timing_cb, stage_prefix)) {
+                return device_installation_general_failure;
+            }
 
             if (progress_cb)
                 progress_cb(1, 1);
         } else {
-            // Extract the ROFS image
-            common::ro_std_file_stream rofs_img_stream(image_path, true);
-
             // Dump quality ROFS content!!!!!
-            if (!loader::dump_rofs_system(rofs_img_stream, drives_z_path, progress_cb, cancel_cb)) {
+            loader::rofs_dump_stats rofs_stats;
+
+            if (!loader::dump_rofs_system(image_path, drives_z_path, progress_cb, cancel_cb, &rofs_stats)) {
                 LOG_ERROR(SYSTEM, "Error while dumping ROFS!");
                 return device_installation_rofs_corrupt;
             }
+
+            if (stage_timing_cb) {
+                stage_timing_cb(stage_prefix + "ROFS index", rofs_stats.index_time_us_);
+                stage_timing_cb(stage_prefix + "ROFS extract (" + std::to_string(rofs_stats.file_count_) + " files)", rofs_stats.extract_time_us_);
+            }
+
+            LOG_INFO(SYSTEM, "Extracted {} ROFS files ({} bytes), index took {} ms, extraction took {} ms", rofs_stats.file_count_,
+                rofs_stats.total_size_, rofs_stats.index_time_us_ / 1000, rofs_stats.extract_time_us_ / 1000);
         }
 
         // Remove the image, no need it no more :((
@@ -290,7 +397,7 @@ namespace eka2l1 {
     device_installation_error install_firmware(device_manager *dvcmngr, const std::string &vpl_path,
         const std::string &drives_c_path, const std::string &drives_e_path, const std::string &drives_z_path,
         const std::string &rom_resident_path, device_firmware_choose_variant_callback choose_callback,
-        progress_changed_callback progress_callback, cancel_requested_callback cancel_callback) {
+        progress_changed_callback progress_callback, cancel_requested_callback cancel_callback, firmware_stage_timing_callback stage_timing_cb) {
         std::string cur_dir;
         if (!common::get_current_directory(cur_dir)) {
             LOG_ERROR(SYSTEM, "Can't get current directory!");
@@ -440,7 +547,7 @@ namespace eka2l1 {
             }
 
             const auto result = dump_data_from_fpsx(fpsx_head.value(), fpsx_file_stream, drives_c_path, drives_e_path, drives_z_temp_path,
-                rom_resident_path, wrapped_progress, cancel_callback);
+                rom_resident_path, wrapped_progress, cancel_callback, stage_timing_cb, eka2l1::filename(fpsx_filename) + ": ");
 
             if (result != device_installation_none) {
                 common::delete_folder(drives_z_temp_path);
@@ -451,6 +558,7 @@ namespace eka2l1 {
         }
 
         // Start analyze and put it into device list
+        auto stage_start = std::chrono::steady_clock::now();
         const epocver ver = loader::determine_rpkg_symbian_version(drives_z_temp_path);
 
         std::string manufacturer;
@@ -464,6 +572,7 @@ namespace eka2l1 {
             return device_installation_determine_product_failure;
         }
 
+        report_stage_timing(stage_timing_cb, "product analysis", stage_start);
         const std::string current_temp_rom = eka2l1::add_path(rom_resident_path, "SYM.ROM");
 
         if (dvcmngr->get(firmcode)) {
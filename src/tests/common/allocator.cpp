@@ -22,6 +22,8 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <utility>
+#include <vector>
 
 using namespace eka2l1;
 
@@ -128,4 +130,155 @@ TEST_CASE("bitmap_count_unaligned_start_end", "bitmap_allocator") {
     // First bitmap has 4 valid bits on (from offset 2), plus with bitmap 2 and 3 (4 bits before offset 70),
     // we got 4 + 12 + 4 = 20 bits
     REQUIRE(alloc.allocated_count(2, 70) == 20);
-}
\ No newline at end of file
+}
+
+TEST_CASE("block_alloc_coalesce_neighbors", "block_allocator") {
+    std::vector<std::uint8_t> space(4096);
+    common::block_allocator alloc(space.data(), space.size());
+
+    void *a = alloc.allocate(100);
+    void *b = alloc.allocate(200);
+    void *c = alloc.allocate(300);
+
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    REQUIRE(c != nullptr);
+
+    REQUIRE(alloc.freep(a));
+    REQUIRE(alloc.freep(c));
+
+    // Free space is split by b
+    REQUIRE(alloc.get_stats().free_block_count_ == 2);
+
+    REQUIRE(alloc.freep(b));
+    REQUIRE_FALSE(alloc.freep(b));
+
+    const common::block_allocator_stats stats = alloc.get_stats();
+
+    REQUIRE(stats.free_block_count_ == 1);
+    REQUIRE(stats.active_block_count_ == 0);
+    REQUIRE(stats.largest_free_block_ == 4096);
+    REQUIRE(stats.fragmentation() == 0.0);
+
+    // Whole space must be allocatable again
+    REQUIRE(alloc.allocate(4096) == space.data());
+}
+
+TEST_CASE("block_alloc_reuse_freed_hole", "block_allocator") {
+    std::vector<std::uint8_t> space(1024);
+    common::block_allocator alloc(space.data(), space.size());
+
+    void *a = alloc.allocate(256);
+    void *b = alloc.allocate(256);
+    void *c = alloc.allocate(256);
+    void *d = alloc.allocate(256);
+
+    REQUIRE(d != nullptr);
+    REQUIRE(alloc.allocate(16) == nullptr);
+    REQUIRE(alloc.get_stats().failed_allocation_count_ == 1);
+
+    REQUIRE(alloc.freep(b));
+    REQUIRE(alloc.allocate(250) == b);
+
+    REQUIRE(alloc.freep(a));
+    REQUIRE(alloc.freep(c));
+
+    const common::block_allocator_stats stats = alloc.get_stats();
+
+    REQUIRE(stats.free_size_ == 512);
+    REQUIRE(stats.largest_free_block_ == 256);
+    REQUIRE(stats.fragmentation() == 0.5);
+}
+
+TEST_CASE("block_alloc_random_churn_no_overlap", "block_allocator") {
+    static constexpr std::size_t SPACE_SIZE = 1 << 20;
+
+    std::vector<std::uint8_t> space(SPACE_SIZE);
+    common::block_allocator alloc(space.data(), space.size());
+
+    std::vector<std::pair<std::uint8_t *, std::size_t>> actives;
+    std::uint32_t seed = 0x1234567;
+
+    for (int i = 0; i < 20000; i++) {
+        seed = seed * 1103515245 + 12345;
+
+        if (actives.empty() || ((seed >> 16) % 3 != 0)) {
+            const std::size_t size = 1 + (seed >> 8) % 3000;
+            std::uint8_t *data = reinterpret_cast<std::uint8_t *>(alloc.allocate(size));
+
+            if (data) {
+                REQUIRE((data - space.data()) % common::block_allocator::ALIGNMENT == 0);
+                REQUIRE(data + size <= space.data() + SPACE_SIZE);
+
+                for (auto &[other, other_size] : actives) {
+                    REQUIRE(((data + size <= other) || (other + other_size <= data)));
+                }
+
+                actives.emplace_back(data, size);
+            }
+        } else {
+            const std::size_t index = (seed >> 4) % actives.size();
+
+            REQUIRE(alloc.freep(actives[index].first));
+            actives.erase(actives.begin() + index);
+        }
+
+        if (actives.size() > 300) {
+            REQUIRE(alloc.freep(actives.front().first));
+            actives.erase(actives.begin());
+        }
+    }
+
+    for (auto &[data, size] : actives) {
+        REQUIRE(alloc.freep(data));
+    }
+
+    const common::block_allocator_stats stats = alloc.get_stats();
+
+    REQUIRE(stats.used_size_ == 0);
+    REQUIRE(stats.free_block_count_ == 1);
+    REQUIRE(stats.largest_free_block_ == SPACE_SIZE);
+}
+
+namespace {
+    // Space that can be expanded up to a limit, like a chunk up to its max size
+    class capped_block_allocator : public common::block_allocator {
+        std::size_t limit_;
+
+    public:
+        explicit capped_block_allocator(std::uint8_t *sptr, const std::size_t initial_size, const std::size_t limit)
+            : common::block_allocator(sptr, initial_size)
+            , limit_(limit) {
+        }
+
+        bool expand(std::size_t target) override {
+            return target <= limit_;
+        }
+    };
+}
+
+TEST_CASE("block_alloc_expand_stops_at_limit", "block_allocator") {
+    static constexpr std::size_t LIMIT = 4096;
+
+    std::vector<std::uint8_t> space(LIMIT);
+    capped_block_allocator alloc(space.data(), 1024, LIMIT);
+
+    std::uint8_t *a = reinterpret_cast<std::uint8_t *>(alloc.allocate(1000));
+    std::uint8_t *b = reinterpret_cast<std::uint8_t *>(alloc.allocate(2000));
+
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    REQUIRE(alloc.get_max_size() <= LIMIT);
+
+    // Doubling is over the limit, and so is the exact size needed
+    REQUIRE(alloc.allocate(1500) == nullptr);
+    REQUIRE(alloc.get_max_size() <= LIMIT);
+
+    // Doubling is over the limit, but the exact size needed still fits
+    std::uint8_t *c = reinterpret_cast<std::uint8_t *>(alloc.allocate(900));
+
+    REQUIRE(c != nullptr);
+    REQUIRE(c + 900 <= space.data() + LIMIT);
+    REQUIRE(alloc.get_max_size() <= LIMIT);
+    REQUIRE(alloc.allocate(LIMIT) == nullptr);
+}
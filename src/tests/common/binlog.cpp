@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/binlog.h>
+#include <common/log.h>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+TEST_CASE("binlog_round_trip", "binlog") {
+    const std::string path = "binlog_round_trip.binlog";
+
+    REQUIRE(log::start_binary_log(path));
+
+    log::write_binary(SYSTEM, spdlog::level::info, __FILE__, 10, "Hello {} {:X} {} {}", 42, 0xCAFEu, std::string("there"), true);
+    log::write_binary(KERNEL, spdlog::level::warn, __FILE__, 20, "Float {:.2f} char {}", 1.5, 'c');
+
+    std::thread other([]() {
+        for (int i = 0; i < 100; i++) {
+            log::write_binary(SYSTEM, spdlog::level::trace, __FILE__, 30, "Other thread {}", i);
+        }
+    });
+
+    other.join();
+    log::stop_binary_log();
+
+    std::vector<log::binlog_entry> entries;
+    std::uint64_t dropped = 0;
+
+    REQUIRE(log::decode_binary_log(path, [&](const log::binlog_entry &entry) {
+        entries.push_back(entry);
+    }, &dropped));
+
+    REQUIRE(dropped == 0);
+    REQUIRE(entries.size() == 102);
+
+    std::size_t other_count = 0;
+    bool found_hello = false;
+    bool found_float = false;
+
+    for (const log::binlog_entry &entry : entries) {
+        if (entry.line_ == 10) {
+            REQUIRE(entry.message_ == "Hello 42 CAFE there true");
+            REQUIRE(entry.level_ == spdlog::level::info);
+            found_hello = true;
+        } else if (entry.line_ == 20) {
+            REQUIRE(entry.message_ == "Float 1.50 char c");
+            REQUIRE(entry.class_name_ == log_class_to_string(KERNEL));
+            found_float = true;
+        } else {
+            REQUIRE(entry.message_ == "Other thread " + std::to_string(other_count++));
+        }
+    }
+
+    REQUIRE(found_hello);
+    REQUIRE(found_float);
+    REQUIRE(other_count == 100);
+
+    std::remove(path.c_str());
+}
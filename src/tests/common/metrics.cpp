@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/metrics.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+using namespace eka2l1;
+
+TEST_CASE("metrics_frame_deltas", "metrics") {
+    common::metrics_registry registry;
+
+    common::metric_counter *calls = registry.counter("test.calls");
+    common::metric_gauge *memory = registry.gauge("test.memory");
+    common::metric_histogram *latency = registry.histogram("test.latency");
+
+    REQUIRE(calls);
+    REQUIRE(memory);
+    REQUIRE(latency);
+
+    // Same name gives the same metric, another type is rejected
+    REQUIRE(registry.counter("test.calls") == calls);
+    REQUIRE(registry.gauge("test.calls") == nullptr);
+
+    calls->add(5);
+    memory->set(12.5);
+
+    for (std::uint64_t i = 1; i <= 100; i++) {
+        latency->record(i);
+    }
+
+    registry.end_frame();
+    common::metrics_frame frame = registry.last_frame();
+
+    REQUIRE(frame.index_ == 0);
+    REQUIRE(frame.samples_.size() == 3);
+
+    const common::metric_sample *calls_sample = frame.find("test.calls");
+    REQUIRE(calls_sample);
+    REQUIRE(calls_sample->value_ == 5.0);
+    REQUIRE(calls_sample->total_ == 5);
+
+    REQUIRE(frame.find("test.memory")->value_ == 12.5);
+
+    const common::metric_sample *latency_sample = frame.find("test.latency");
+    REQUIRE(latency_sample->total_ == 100);
+    REQUIRE(latency_sample->value_ == Approx(50.5));
+    REQUIRE(latency_sample->max_ == 100);
+    REQUIRE(latency_sample->p50_ >= 32.0);
+    REQUIRE(latency_sample->p50_ <= 63.0);
+    REQUIRE(latency_sample->p95_ >= 64.0);
+    REQUIRE(latency_sample->p95_ <= 100.0);
+
+    // Next frame only reports what happened since
+    calls->add(2);
+    latency->record(7);
+
+    registry.end_frame();
+    frame = registry.last_frame();
+
+    REQUIRE(frame.index_ == 1);
+    REQUIRE(frame.find("test.calls")->value_ == 2.0);
+    REQUIRE(frame.find("test.calls")->total_ == 7);
+    REQUIRE(frame.find("test.latency")->total_ == 1);
+    REQUIRE(frame.find("test.latency")->value_ == 7.0);
+    REQUIRE(frame.find("test.latency")->max_ == 7);
+    REQUIRE(frame.find("test.memory")->value_ == 12.5);
+
+    registry.end_frame();
+    frame = registry.last_frame();
+
+    REQUIRE(frame.find("test.calls")->value_ == 0.0);
+    REQUIRE(frame.find("test.latency")->total_ == 0);
+    REQUIRE(frame.find("test.latency")->max_ == 0);
+}
+
+TEST_CASE("metrics_collectors_and_callbacks", "metrics") {
+    common::metrics_registry registry;
+    common::metric_counter *mirrored = registry.counter("test.mirrored");
+
+    std::uint64_t source_total = 0;
+    const std::size_t collector = registry.add_collector([&]() {
+        mirrored->set(source_total);
+    });
+
+    std::uint64_t last_seen = 0;
+    std::size_t callback_count = 0;
+
+    const std::size_t callback = registry.add_frame_callback([&](const common::metrics_frame &frame) {
+        last_seen = static_cast<std::uint64_t>(frame.find("test.mirrored")->value_);
+        callback_count++;
+    });
+
+    source_total = 40;
+    registry.end_frame();
+
+    REQUIRE(callback_count == 1);
+    REQUIRE(last_seen == 40);
+
+    source_total = 45;
+    registry.end_frame();
+
+    REQUIRE(last_seen == 5);
+
+    REQUIRE(registry.remove_collector(collector));
+    REQUIRE(registry.remove_frame_callback(callback));
+
+    source_total = 100;
+    registry.end_frame();
+
+    REQUIRE(callback_count == 2);
+    REQUIRE(registry.last_frame().find("test.mirrored")->value_ == 0.0);
+}
+
+TEST_CASE("metrics_concurrent_updates", "metrics") {
+    common::metrics_registry registry;
+
+    common::metric_counter *calls = registry.counter("test.calls");
+    common::metric_histogram *latency = registry.histogram("test.latency");
+
+    std::vector<std::thread> workers;
+
+    for (int i = 0; i < 4; i++) {
+        workers.emplace_back([&]() {
+            for (int j = 0; j < 10000; j++) {
+                calls->add();
+                latency->record(static_cast<std::uint64_t>(j));
+            }
+        });
+    }
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    registry.end_frame();
+    const common::metrics_frame frame = registry.last_frame();
+
+    REQUIRE(frame.find("test.calls")->value_ == 40000.0);
+    REQUIRE(frame.find("test.latency")->total_ == 40000);
+    REQUIRE(frame.find("test.latency")->max_ == 9999);
+}
+
+TEST_CASE("metrics_csv_output", "metrics") {
+    const std::string path = "metrics_csv_output.csv";
+
+    {
+        common::metrics_registry registry;
+        common::metrics_csv_writer writer(path);
+
+        REQUIRE(writer.valid());
+
+        registry.counter("a")->add(3);
+        registry.end_frame();
+        writer.write(registry.last_frame());
+
+        registry.histogram("b")->record(4);
+        registry.end_frame();
+        writer.write(registry.last_frame());
+    }
+
+    std::ifstream stream(path);
+    std::string line;
+    std::vector<std::string> lines;
+
+    while (std::getline(stream, line)) {
+        lines.push_back(line);
+    }
+
+    stream.close();
+    std::remove(path.c_str());
+
+    // A new metric appeared on the second frame, so the header is repeated
+    REQUIRE(lines.size() == 4);
+    REQUIRE(lines[0] == "frame,timestamp_us,frame_time_us,a");
+    REQUIRE(lines[1].rfind("0,", 0) == 0);
+    REQUIRE(lines[1].substr(lines[1].size() - 2) == ",3");
+    REQUIRE(lines[2] == "frame,timestamp_us,frame_time_us,a,b.count,b.mean,b.p50,b.p95,b.max");
+
+    const std::string expected_tail = ",0,1,4.00,4.00,4.00,4";
+    REQUIRE(lines[3].substr(lines[3].size() - expected_tail.size()) == expected_tail);
+}
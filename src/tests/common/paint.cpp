@@ -56,3 +56,84 @@ TEST_CASE("simple_line", "painter") {
 
     plotter.save_to_bmp(reinterpret_cast<common::wo_stream *>(&std_fstream_paint));
 }
+
+namespace {
+    // Plotter that only implements the per-pixel interface, so the span functions use the default fallbacks
+    class per_pixel_plotter : public common::pixel_plotter {
+        common::buffer_32bmp_pixel_plotter backing_;
+
+    public:
+        void resize(const eka2l1::vec2 &size) override {
+            backing_.resize(size);
+        }
+
+        void plot_pixel(const eka2l1::vec2 &pos, const eka2l1::vecx<int, 4> &color) override {
+            backing_.plot_pixel(pos, color);
+        }
+
+        eka2l1::vecx<int, 4> get_pixel(const eka2l1::vec2 &pos) override {
+            return backing_.get_pixel(pos);
+        }
+
+        eka2l1::vec2 &get_size() override {
+            return backing_.get_size();
+        }
+    };
+
+    void draw_spans(common::pixel_plotter &plotter) {
+        plotter.resize({ 77, 9 });
+
+        for (int y = 0; y < 9; y++) {
+            plotter.fill_span({ 0, y }, 77, { 255, 255, 255, 255 });
+        }
+
+        plotter.fill_span({ -10, 0 }, 50, { 12, 34, 56, 255 });
+        plotter.fill_span({ 70, 1 }, 50, { 78, 90, 12, 255 });
+        plotter.fill_span({ 5, -1 }, 50, { 1, 2, 3, 255 });
+
+        plotter.blend_span({ 3, 2 }, 70, { 200, 100, 0, 100 });
+        plotter.blend_span({ -4, 3 }, 90, { 0, 50, 250, 1 });
+        plotter.blend_span({ 0, 4 }, 77, { 9, 9, 9, 0 });
+
+        std::uint32_t row[64];
+
+        for (int i = 0; i < 64; i++) {
+            row[i] = 0xFF000000 | (i * 3) << 16 | (i * 2) << 8 | i;
+        }
+
+        plotter.copy_row({ -6, 5 }, row, 64);
+        plotter.copy_row({ 40, 6 }, row, 64);
+    }
+}
+
+TEST_CASE("span_matches_per_pixel", "painter") {
+    per_pixel_plotter reference;
+    common::buffer_24bmp_pixel_plotter plotter24;
+    common::buffer_32bmp_pixel_plotter plotter32;
+
+    draw_spans(reference);
+    draw_spans(plotter24);
+    draw_spans(plotter32);
+
+    for (int y = 0; y < 9; y++) {
+        for (int x = 0; x < 77; x++) {
+            auto expected = reference.get_pixel({ x, y });
+            auto result24 = plotter24.get_pixel({ x, y });
+            auto result32 = plotter32.get_pixel({ x, y });
+
+            for (int c = 0; c < 4; c++) {
+                if (c < 3) {
+                    REQUIRE(result24[c] == expected[c]);
+                }
+
+                REQUIRE(result32[c] == expected[c]);
+            }
+        }
+    }
+
+    // Half-transparent blend over white
+    auto blended = plotter32.get_pixel({ 10, 2 });
+    REQUIRE(blended[0] == 233);
+    REQUIRE(blended[1] == 194);
+    REQUIRE(blended[2] == 155);
+}
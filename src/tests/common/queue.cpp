@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/queue.h>
+#include <common/sync.h>
+
+#include <cstdint>
+#include <thread>
+
+using namespace eka2l1;
+
+TEST_CASE("spsc_ring_capacity_rounded_and_bounded", "spsc_ring") {
+    spsc_ring<int> ring(5);
+    REQUIRE(ring.capacity() == 8);
+
+    for (int i = 0; i < 8; i++) {
+        REQUIRE(ring.try_push(i));
+    }
+
+    REQUIRE_FALSE(ring.try_push(8));
+    REQUIRE(ring.size() == 8);
+
+    int value = -1;
+    REQUIRE(ring.try_pop(value));
+    REQUIRE(value == 0);
+    REQUIRE(ring.try_push(8));
+}
+
+TEST_CASE("spsc_ring_two_threads_keep_order", "spsc_ring") {
+    static constexpr std::uint32_t TOTAL = 100000;
+
+    spsc_ring<std::uint32_t> ring(16);
+    std::thread producer([&]() {
+        for (std::uint32_t i = 0; i < TOTAL; i++) {
+            while (!ring.try_push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::uint32_t expected = 0;
+    std::uint32_t value = 0;
+
+    while (expected < TOTAL) {
+        if (!ring.try_pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        REQUIRE(value == expected);
+        expected++;
+    }
+
+    producer.join();
+    REQUIRE(ring.empty());
+}
+
+TEST_CASE("futex_wake_releases_waiter", "futex") {
+    std::atomic<std::uint32_t> word(0);
+
+    std::thread waiter([&]() {
+        while (word.load() == 0) {
+            common::futex_wait(word, 0);
+        }
+    });
+
+    word = 1;
+    common::futex_wake(word, true);
+
+    waiter.join();
+    REQUIRE(word.load() == 1);
+}
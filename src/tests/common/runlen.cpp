@@ -22,6 +22,7 @@
 #include <common/runlen.h>
 
 #include <array>
+#include <random>
 
 using namespace eka2l1;
 
@@ -178,4 +179,73 @@ TEST_CASE("sixteen_bits_compression_small", "rle_compression") {
 
     REQUIRE(compressed_size == expected.size());
     REQUIRE(std::equal(expected.begin(), expected.end(), dest_buf.begin()));
-}
\ No newline at end of file
+}
+
+template <std::size_t BIT>
+static void check_fast_route_matches_stream(std::mt19937 &rng) {
+    static constexpr std::size_t PIXEL_SIZE = (BIT == 12) ? 2 : (BIT / 8);
+
+    std::vector<std::uint8_t> source;
+    std::size_t total_size = 0;
+
+    for (int run = 0; run < 300; run++) {
+        if (BIT == 12) {
+            const std::uint16_t word = static_cast<std::uint16_t>(rng());
+
+            source.push_back(static_cast<std::uint8_t>(word));
+            source.push_back(static_cast<std::uint8_t>(word >> 8));
+
+            total_size += ((word >> 12) + 1) * 2;
+            continue;
+        }
+
+        const std::int8_t count = static_cast<std::int8_t>(rng());
+        source.push_back(static_cast<std::uint8_t>(count));
+
+        const std::size_t value_size = (count >= 0) ? PIXEL_SIZE : (-count * PIXEL_SIZE);
+
+        for (std::size_t i = 0; i < value_size; i++) {
+            source.push_back(static_cast<std::uint8_t>(rng()));
+        }
+
+        total_size += (count >= 0) ? ((count + 1) * PIXEL_SIZE) : value_size;
+    }
+
+    std::vector<std::uint8_t> expected(total_size);
+    common::ro_buf_stream source_stream(source.data(), source.size());
+    common::wo_buf_stream expected_stream(expected.data(), expected.size());
+
+    decompress_rle<BIT>(&source_stream, &expected_stream);
+
+    std::size_t count_size = 0;
+    decompress_rle_fast_route<BIT>(source.data(), source.size(), nullptr, count_size);
+
+    REQUIRE(count_size == total_size);
+
+    // Guard bytes after the destination must be left untouched
+    static constexpr std::uint8_t GUARD = 0xCD;
+
+    for (const std::size_t dest_size : { total_size, total_size / 3 + 1 }) {
+        std::vector<std::uint8_t> result(dest_size + 64, GUARD);
+        std::size_t result_size = dest_size;
+
+        decompress_rle_fast_route<BIT>(source.data(), source.size(), result.data(), result_size);
+
+        REQUIRE(result_size <= dest_size);
+        REQUIRE(result_size + PIXEL_SIZE > dest_size);
+        REQUIRE(std::equal(result.begin(), result.begin() + result_size, expected.begin()));
+        REQUIRE(std::all_of(result.begin() + dest_size, result.end(), [](const std::uint8_t b) { return b == GUARD; }));
+    }
+}
+
+TEST_CASE("decompress_fast_route_matches_stream", "rle_compression") {
+    std::mt19937 rng(0x52454C45);
+
+    for (int i = 0; i < 20; i++) {
+        check_fast_route_matches_stream<8>(rng);
+        check_fast_route_matches_stream<12>(rng);
+        check_fast_route_matches_stream<16>(rng);
+        check_fast_route_matches_stream<24>(rng);
+        check_fast_route_matches_stream<32>(rng);
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <common/virtualmem.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace eka2l1;
+
+static std::vector<std::uint8_t> make_cow_test_image(const std::size_t size) {
+    std::vector<std::uint8_t> image(size);
+
+    for (std::size_t i = 0; i < size; i++) {
+        image[i] = static_cast<std::uint8_t>(i * 7);
+    }
+
+    return image;
+}
+
+TEST_CASE("cow_template_write_isolation", "[virtualmem]") {
+    const std::size_t page_size = static_cast<std::size_t>(common::get_host_page_size());
+    const std::size_t size = page_size * 4;
+
+    const std::vector<std::uint8_t> image = make_cow_test_image(size);
+    const std::intptr_t tmpl = common::create_cow_template(image.data(), size);
+
+    if (tmpl == -1) {
+        WARN("Copy-on-write images are not supported on this host");
+        return;
+    }
+
+    std::uint8_t *first = reinterpret_cast<std::uint8_t *>(common::map_memory(size));
+    std::uint8_t *second = reinterpret_cast<std::uint8_t *>(common::map_memory(size));
+
+    REQUIRE(common::map_cow_template(tmpl, first, size, prot_read_write));
+    REQUIRE(common::map_cow_template(tmpl, second, size, prot_read_write));
+
+    // Mappings stay valid without the handle
+    common::destroy_cow_template(tmpl);
+
+    REQUIRE(std::memcmp(first, image.data(), size) == 0);
+    REQUIRE(std::memcmp(second, image.data(), size) == 0);
+
+    first[page_size + 3] = 0xAB;
+    second[page_size * 2] = 0xCD;
+
+    REQUIRE(first[page_size + 3] == 0xAB);
+    REQUIRE(second[page_size + 3] == image[page_size + 3]);
+    REQUIRE(second[page_size * 2] == 0xCD);
+    REQUIRE(first[page_size * 2] == image[page_size * 2]);
+
+    REQUIRE(common::unmap_cow_template(first, size));
+    REQUIRE(common::unmap_cow_template(second, size));
+
+    common::unmap_memory(first, size);
+    common::unmap_memory(second, size);
+}
+
+TEST_CASE("cow_template_private_size", "[virtualmem]") {
+    const std::size_t page_size = static_cast<std::size_t>(common::get_host_page_size());
+    const std::size_t size = page_size * 4;
+
+    const std::vector<std::uint8_t> image = make_cow_test_image(size);
+    const std::intptr_t tmpl = common::create_cow_template(image.data(), size);
+
+    if (tmpl == -1) {
+        WARN("Copy-on-write images are not supported on this host");
+        return;
+    }
+
+    std::uint8_t *mapped = reinterpret_cast<std::uint8_t *>(common::map_memory(size));
+    REQUIRE(common::map_cow_template(tmpl, mapped, size, prot_read_write));
+
+    common::destroy_cow_template(tmpl);
+
+    // Reading keeps every page shared with the image
+    volatile std::uint32_t sum = 0;
+
+    for (std::size_t i = 0; i < size; i += page_size) {
+        sum += mapped[i];
+    }
+
+    REQUIRE(common::get_cow_private_size(mapped, size) == 0);
+
+    mapped[0] = 1;
+    mapped[page_size * 2 + 100] = 2;
+
+    REQUIRE(common::get_cow_private_size(mapped, size) == page_size * 2);
+
+    REQUIRE(common::unmap_cow_template(mapped, size));
+    common::unmap_memory(mapped, size);
+}
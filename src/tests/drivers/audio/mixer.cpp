@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <drivers/audio/audio.h>
+#include <drivers/audio/mixer.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace eka2l1;
+
+namespace {
+    constexpr std::uint32_t TEST_HOST_SAMPLE_RATE = 48000;
+    constexpr std::size_t TEST_HOST_FRAMES = 256;
+
+    struct test_host_stream : public drivers::audio_output_stream {
+        explicit test_host_stream(drivers::audio_driver *driver, const std::uint32_t sample_rate, const std::uint8_t channels)
+            : drivers::audio_output_stream(driver, sample_rate, channels) {
+        }
+
+        bool start() override {
+            return true;
+        }
+
+        bool stop() override {
+            return true;
+        }
+
+        void pause() override {
+        }
+
+        bool is_playing() override {
+            return true;
+        }
+
+        bool is_pausing() override {
+            return false;
+        }
+
+        bool set_volume(const float volume) override {
+            return true;
+        }
+
+        float get_volume() const override {
+            return 1.0f;
+        }
+
+        bool current_frame_position(std::uint64_t *pos) override {
+            return false;
+        }
+    };
+
+    // Host streams are pulled by the test instead of a backend thread
+    class test_audio_driver : public drivers::audio_driver {
+        drivers::data_callback host_callback_;
+
+    protected:
+        std::unique_ptr<drivers::audio_output_stream> new_host_output_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, drivers::data_callback callback) override {
+            host_callback_ = callback;
+            return std::make_unique<test_host_stream>(this, sample_rate, channels);
+        }
+
+    public:
+        ~test_audio_driver() override {
+            destroy_mixer();
+        }
+
+        std::uint32_t native_sample_rate() override {
+            return TEST_HOST_SAMPLE_RATE;
+        }
+
+        std::vector<std::int16_t> pull(const std::size_t frames) {
+            std::vector<std::int16_t> output(frames * 2);
+            REQUIRE(host_callback_(output.data(), frames) == frames);
+
+            return output;
+        }
+    };
+
+    drivers::data_callback make_constant_callback(const std::uint8_t channels, const std::int16_t value) {
+        return [channels, value](std::int16_t *buffer, const std::size_t frames) {
+            std::fill(buffer, buffer + frames * channels, value);
+            return frames;
+        };
+    }
+}
+
+TEST_CASE("mixer_sums_and_clamps_streams", "mixer") {
+    test_audio_driver driver;
+
+    auto mono = driver.new_output_stream(TEST_HOST_SAMPLE_RATE, 1, make_constant_callback(1, 20000));
+    auto stereo = driver.new_output_stream(TEST_HOST_SAMPLE_RATE, 2, make_constant_callback(2, 1000));
+
+    REQUIRE(mono);
+    REQUIRE(stereo);
+    REQUIRE(driver.get_mixer());
+
+    mono->start();
+    stereo->start();
+
+    std::vector<std::int16_t> output = driver.pull(TEST_HOST_FRAMES);
+    REQUIRE(std::all_of(output.begin(), output.end(), [](const std::int16_t sample) { return sample == 21000; }));
+
+    // The sum goes out of the 16-bit range, it must be clamped rather than wrapped
+    REQUIRE(mono->set_volume(1.6f));
+
+    output = driver.pull(TEST_HOST_FRAMES);
+    REQUIRE(std::all_of(output.begin(), output.end(), [](const std::int16_t sample) { return sample == 32767; }));
+
+    auto negative = driver.new_output_stream(TEST_HOST_SAMPLE_RATE, 1, make_constant_callback(1, -30000));
+    negative->start();
+
+    REQUIRE(mono->set_volume(0.0f));
+    REQUIRE(stereo->set_volume(0.0f));
+    REQUIRE(negative->set_volume(1.5f));
+
+    output = driver.pull(TEST_HOST_FRAMES);
+    REQUIRE(std::all_of(output.begin(), output.end(), [](const std::int16_t sample) { return sample == -32768; }));
+
+    const drivers::audio_mixer_stats stats = driver.get_mixer()->get_stats();
+
+    REQUIRE(stats.stream_count_ == 3);
+    REQUIRE(stats.active_stream_count_ == 3);
+    REQUIRE(stats.mix_calls_ == 3);
+    REQUIRE(stats.mixed_frames_ == TEST_HOST_FRAMES * 3);
+    REQUIRE(stats.underruns_ == 0);
+}
+
+TEST_CASE("mixer_drained_and_stopped_streams", "mixer") {
+    test_audio_driver driver;
+
+    std::size_t frames_left = 100;
+    std::size_t callback_count = 0;
+
+    auto stream = driver.new_output_stream(TEST_HOST_SAMPLE_RATE, 2, [&](std::int16_t *buffer, const std::size_t frames) {
+        const std::size_t given = std::min(frames, frames_left);
+
+        std::fill(buffer, buffer + given * 2, 5000);
+        frames_left -= given;
+        callback_count++;
+
+        return given;
+    });
+
+    REQUIRE(stream);
+    REQUIRE(!stream->is_playing());
+
+    stream->start();
+    REQUIRE(stream->is_playing());
+
+    // The callback runs dry in the middle of the pass, the rest is silence
+    std::vector<std::int16_t> output = driver.pull(TEST_HOST_FRAMES);
+
+    REQUIRE(output[0] == 5000);
+    REQUIRE(output[TEST_HOST_FRAMES * 2 - 1] == 0);
+
+    REQUIRE(!stream->is_playing());
+    REQUIRE(driver.get_mixer()->get_stats().underruns_ == 1);
+    REQUIRE(driver.get_mixer()->get_stats().active_stream_count_ == 0);
+
+    std::uint64_t position = 0;
+    REQUIRE(stream->current_frame_position(&position));
+    REQUIRE(position == 100);
+
+    // A drained stream is not pulled anymore
+    const std::size_t drained_callback_count = callback_count;
+    driver.pull(TEST_HOST_FRAMES);
+
+    REQUIRE(callback_count == drained_callback_count);
+
+    // Starting again resumes pulling
+    frames_left = TEST_HOST_FRAMES * 4;
+    stream->start();
+
+    REQUIRE(stream->is_playing());
+
+    output = driver.pull(TEST_HOST_FRAMES);
+    REQUIRE(std::all_of(output.begin(), output.end(), [](const std::int16_t sample) { return sample == 5000; }));
+
+    // A stopped stream is neither playing nor pulled
+    stream->stop();
+    REQUIRE(!stream->is_playing());
+
+    const std::size_t stopped_callback_count = callback_count;
+    output = driver.pull(TEST_HOST_FRAMES);
+
+    REQUIRE(callback_count == stopped_callback_count);
+    REQUIRE(std::all_of(output.begin(), output.end(), [](const std::int16_t sample) { return sample == 0; }));
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <drivers/audio/audio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace eka2l1;
+
+TEST_CASE("null_audio_pulls_streams_and_shuts_down", "null_audio") {
+    drivers::null_audio_options options;
+    options.sample_rate_ = 48000;
+    options.period_frames_ = 480;
+
+    drivers::audio_driver_instance driver = drivers::make_audio_driver(drivers::audio_driver_backend::null, 100,
+        drivers::player_type_tsf, options);
+
+    REQUIRE(driver);
+
+    std::atomic<std::size_t> frames_pulled{ 0 };
+
+    auto stream = driver->new_output_stream(48000, 2, [&](std::int16_t *buffer, const std::size_t frames) {
+        std::fill(buffer, buffer + frames * 2, 1000);
+        frames_pulled += frames;
+
+        return frames;
+    });
+
+    REQUIRE(stream);
+    REQUIRE(stream->start());
+
+    // The device clock pulls 10 ms per period, wait for a few of them
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+    while ((frames_pulled < options.period_frames_ * 4) && (std::chrono::steady_clock::now() < deadline)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    REQUIRE(frames_pulled >= options.period_frames_ * 4);
+
+    // The mixer's host stream keeps ticking after the guest stream is gone. Destroying the driver must stop
+    // the clock before the mixer is freed.
+    stream.reset();
+    driver.reset();
+}
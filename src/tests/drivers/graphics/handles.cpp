@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <drivers/graphics/backend/software/graphics_software.h>
+#include <drivers/itc.h>
+
+#include <memory>
+#include <thread>
+
+using namespace eka2l1;
+
+TEST_CASE("handle_allocator_keeps_numbers_until_released", "graphics_handles") {
+    drivers::graphics_handle_allocator allocator;
+
+    const std::uint32_t first = allocator.reserve();
+    const std::uint32_t second = allocator.reserve();
+
+    REQUIRE(first != 0);
+    REQUIRE(second != first);
+
+    REQUIRE(allocator.release(first));
+
+    // A number that is not reserved anymore can't be given back twice
+    REQUIRE_FALSE(allocator.release(first));
+    REQUIRE_FALSE(allocator.release(0));
+    REQUIRE_FALSE(allocator.release(1000));
+
+    const std::uint32_t third = allocator.reserve();
+    const std::uint32_t fourth = allocator.reserve();
+
+    REQUIRE(third == first);
+    REQUIRE(fourth != first);
+    REQUIRE(fourth != second);
+}
+
+namespace {
+    struct software_driver_runner {
+        drivers::window_system_info info_;
+        std::unique_ptr<drivers::software_graphics_driver> driver_;
+        std::thread thread_;
+
+        explicit software_driver_runner()
+            : driver_(std::make_unique<drivers::software_graphics_driver>(info_)) {
+            thread_ = std::thread([this]() { driver_->run(); });
+        }
+
+        ~software_driver_runner() {
+            driver_->abort();
+            thread_.join();
+        }
+
+        void submit_and_wait(drivers::graphics_command_builder &builder) {
+            drivers::command_fence fence;
+            builder.present(&fence);
+
+            drivers::command_list list = builder.retrieve_command_list();
+            driver_->submit_command_list(list);
+            driver_->wait_for(&fence);
+        }
+    };
+}
+
+TEST_CASE("failed_creation_keeps_handle_until_destroyed", "graphics_handles") {
+    software_driver_runner runner;
+    drivers::graphics_driver *driver = runner.driver_.get();
+
+    // Textures are not supported by the software driver, so the creation fails on the driver thread
+    drivers::command_fence status;
+    const std::uint8_t pixels[4 * 4 * 4] = {};
+
+    const drivers::handle texture = drivers::create_texture(driver, 2, 0, drivers::texture_format::rgba,
+        drivers::texture_format::rgba, drivers::texture_data_type::ubyte, pixels, sizeof(pixels), eka2l1::vec3(4, 4, 0),
+        0, 4, &status);
+
+    REQUIRE(texture != 0);
+
+    driver->wait_for(&status);
+    REQUIRE(status.result_ != 0);
+
+    // The client still holds the handle, it must not be given to another object
+    const drivers::handle other = driver->new_object_handle();
+    REQUIRE(other != texture);
+
+    // Destroying the handle gives it back, even if there is no object behind it. A second destroy is ignored.
+    drivers::graphics_command_builder builder;
+    builder.destroy(texture);
+    builder.destroy(texture);
+    runner.submit_and_wait(builder);
+
+    const drivers::handle reused = driver->new_object_handle();
+    const drivers::handle fresh = driver->new_object_handle();
+
+    REQUIRE(reused == texture);
+    REQUIRE(fresh != texture);
+    REQUIRE(fresh != other);
+}
+
+TEST_CASE("destroyed_bitmap_handle_is_reused_once", "graphics_handles") {
+    software_driver_runner runner;
+    drivers::graphics_driver *driver = runner.driver_.get();
+
+    drivers::command_fence status;
+    const drivers::handle bitmap = drivers::create_bitmap(driver, eka2l1::vec2(4, 4), 32, &status);
+
+    driver->wait_for(&status);
+    REQUIRE(status.result_ == 0);
+
+    drivers::graphics_command_builder builder;
+    builder.destroy_bitmap(bitmap);
+    builder.destroy_bitmap(bitmap);
+    runner.submit_and_wait(builder);
+
+    const drivers::handle reused = driver->new_bitmap_handle();
+    const drivers::handle fresh = driver->new_bitmap_handle();
+
+    REQUIRE(reused == bitmap);
+    REQUIRE(fresh != bitmap);
+}
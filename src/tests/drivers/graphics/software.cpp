@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <common/region.h>
+#include <drivers/graphics/backend/software/graphics_software.h>
+#include <drivers/itc.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+// Golden frames are written as rows of characters, each character is one pixel of the palette below.
+// Pixels are RGBA8888, R in the lowest byte.
+static const std::map<char, std::uint32_t> golden_palette = {
+    { '.', 0xFF000000 },
+    { 'R', 0xFF0000FF },
+    { 'G', 0xFF00FF00 },
+    { 'B', 0xFFFF0000 },
+    { 'W', 0xFFFFFFFF },
+    { 'Y', 0xFF00FFFF },
+    { 'P', 0xFF7F0080 }     // Half transparent red over blue
+};
+
+namespace {
+    struct software_frame_runner {
+        drivers::window_system_info info_;
+        std::unique_ptr<drivers::software_graphics_driver> driver_;
+        std::thread thread_;
+
+        explicit software_frame_runner()
+            : driver_(std::make_unique<drivers::software_graphics_driver>(info_)) {
+            thread_ = std::thread([this]() { driver_->run(); });
+        }
+
+        ~software_frame_runner() {
+            driver_->abort();
+            thread_.join();
+        }
+
+        /**
+         * @brief Present the commands in the builder and return the frame, as golden rows.
+         */
+        std::vector<std::string> present(drivers::graphics_command_builder &builder) {
+            drivers::command_fence fence;
+            builder.present(&fence);
+
+            drivers::command_list list = builder.retrieve_command_list();
+            driver_->submit_command_list(list);
+            driver_->wait_for(&fence);
+
+            std::vector<std::uint32_t> pixels;
+            eka2l1::vec2 size;
+
+            driver_->get_presented_frame(pixels, size);
+
+            std::vector<std::string> rows(size.y, std::string(size.x, '?'));
+
+            for (int y = 0; y < size.y; y++) {
+                for (int x = 0; x < size.x; x++) {
+                    for (const auto &[symbol, color] : golden_palette) {
+                        if (pixels[y * size.x + x] == color) {
+                            rows[y][x] = symbol;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            return rows;
+        }
+
+        /**
+         * @brief Create a 32bpp bitmap from golden rows.
+         */
+        drivers::handle create_bitmap(const std::vector<std::string> &rows) {
+            const eka2l1::vec2 size(static_cast<int>(rows[0].size()), static_cast<int>(rows.size()));
+            std::vector<std::uint8_t> data;
+
+            // The guest layout is BGRA
+            for (const std::string &row : rows) {
+                for (const char symbol : row) {
+                    const std::uint32_t color = golden_palette.at(symbol);
+
+                    data.push_back(static_cast<std::uint8_t>(color >> 16));
+                    data.push_back(static_cast<std::uint8_t>(color >> 8));
+                    data.push_back(static_cast<std::uint8_t>(color));
+                    data.push_back(static_cast<std::uint8_t>(color >> 24));
+                }
+            }
+
+            const drivers::handle h = drivers::create_bitmap(driver_.get(), size, 32);
+
+            drivers::graphics_command_builder builder;
+            builder.update_bitmap(h, reinterpret_cast<const char *>(data.data()), data.size(), { 0, 0 }, size);
+
+            drivers::command_list list = builder.retrieve_command_list();
+            driver_->submit_command_list(list);
+
+            return h;
+        }
+    };
+}
+
+static void begin_frame(drivers::graphics_command_builder &builder, const eka2l1::vec2 &size) {
+    builder.set_swapchain_size(size);
+    builder.bind_bitmap(0);
+    builder.clear({ 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f }, drivers::draw_buffer_bit_color_buffer);
+}
+
+TEST_CASE("software_clear_and_fill", "software_graphics") {
+    software_frame_runner runner;
+    drivers::graphics_command_builder builder;
+
+    begin_frame(builder, { 8, 6 });
+
+    builder.set_brush_color({ 255, 0, 0 });
+    builder.draw_rectangle(eka2l1::rect({ 1, 1 }, { 3, 2 }));
+
+    // Partly outside the surface
+    builder.set_brush_color({ 0, 255, 0 });
+    builder.draw_rectangle(eka2l1::rect({ 6, 4 }, { 4, 4 }));
+
+    // Scissor only applies while clipping is enabled
+    builder.set_brush_color({ 0, 0, 255 });
+    builder.clip_rect(eka2l1::rect({ 0, 4 }, { 2, 2 }));
+    builder.set_feature(drivers::graphics_feature::clipping, true);
+    builder.draw_rectangle(eka2l1::rect({ 0, 3 }, { 5, 3 }));
+    builder.set_feature(drivers::graphics_feature::clipping, false);
+
+    const std::vector<std::string> expected = {
+        "........",
+        ".RRR....",
+        ".RRR....",
+        "........",
+        "BB....GG",
+        "BB....GG"
+    };
+
+    REQUIRE(runner.present(builder) == expected);
+}
+
+TEST_CASE("software_fill_clip_region", "software_graphics") {
+    software_frame_runner runner;
+    drivers::graphics_command_builder builder;
+
+    begin_frame(builder, { 8, 4 });
+
+    common::region region;
+    region.add_rect(eka2l1::rect({ 0, 0 }, { 2, 2 }));
+    region.add_rect(eka2l1::rect({ 5, 2 }, { 3, 2 }));
+
+    builder.clip_bitmap_region(region);
+    builder.set_brush_color({ 255, 255, 255 });
+    builder.draw_rectangle(eka2l1::rect({ 1, 1 }, { 6, 3 }));
+
+    // Like a stencil, the region does not restrict clears
+    builder.clear({ 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f }, drivers::draw_buffer_bit_color_buffer);
+    builder.set_feature(drivers::graphics_feature::stencil_test, false);
+
+    const std::vector<std::string> first_expected = {
+        "YYYYYYYY",
+        "YYYYYYYY",
+        "YYYYYYYY",
+        "YYYYYYYY"
+    };
+
+    REQUIRE(runner.present(builder) == first_expected);
+
+    drivers::graphics_command_builder second;
+    begin_frame(second, { 8, 4 });
+
+    second.clip_bitmap_region(region);
+    second.set_brush_color({ 255, 255, 255 });
+    second.draw_rectangle(eka2l1::rect({ 1, 1 }, { 6, 3 }));
+
+    const std::vector<std::string> second_expected = {
+        "........",
+        ".W......",
+        ".....WW.",
+        ".....WW."
+    };
+
+    REQUIRE(runner.present(second) == second_expected);
+}
+
+TEST_CASE("software_fill_blend", "software_graphics") {
+    software_frame_runner runner;
+    drivers::graphics_command_builder builder;
+
+    begin_frame(builder, { 4, 2 });
+
+    builder.set_brush_color({ 0, 0, 255 });
+    builder.draw_rectangle(eka2l1::rect({ 0, 0 }, { 4, 2 }));
+
+    builder.set_feature(drivers::graphics_feature::blend, true);
+    builder.blend_formula(drivers::blend_equation::add, drivers::blend_equation::add, drivers::blend_factor::frag_out_alpha,
+        drivers::blend_factor::one_minus_frag_out_alpha, drivers::blend_factor::one, drivers::blend_factor::one);
+
+    builder.set_brush_color_detail({ 255, 0, 0, 128 });
+    builder.draw_rectangle(eka2l1::rect({ 1, 0 }, { 2, 1 }));
+
+    // Saved state is restored with blending on and the red brush
+    builder.backup_state();
+    builder.set_feature(drivers::graphics_feature::blend, false);
+    builder.set_brush_color({ 0, 255, 0 });
+    builder.load_backup_state();
+    builder.draw_rectangle(eka2l1::rect({ 0, 1 }, { 1, 1 }));
+
+    const std::vector<std::string> expected = {
+        "BPPB",
+        "PBBB"
+    };
+
+    REQUIRE(runner.present(builder) == expected);
+}
+
+TEST_CASE("software_draw_lines", "software_graphics") {
+    software_frame_runner runner;
+    drivers::graphics_command_builder builder;
+
+    begin_frame(builder, { 16, 8 });
+
+    builder.set_brush_color({ 255, 255, 255 });
+    builder.set_pen_style(drivers::pen_style_solid);
+    builder.draw_line({ 0, 0 }, { 4, 4 });
+
+    // Dotted pattern, starting from the first pixel of the line
+    builder.set_pen_style(drivers::pen_style_dotted);
+    builder.draw_line({ 0, 7 }, { 15, 7 });
+
+    builder.set_pen_style(drivers::pen_style_none);
+    builder.draw_line({ 0, 6 }, { 15, 6 });
+
+    // Wide pen is centered on the line
+    builder.set_pen_style(drivers::pen_style_solid);
+    builder.set_point_size(3);
+    builder.set_brush_color({ 255, 0, 0 });
+    builder.draw_line({ 10, 2 }, { 13, 2 });
+
+    const std::vector<std::string> expected = {
+        "W...............",
+        ".W.......RRRRRR.",
+        "..W......RRRRRR.",
+        "...W.....RRRRRR.",
+        "....W...........",
+        "................",
+        "................",
+        ".WW..WW..WW..WW."
+    };
+
+    REQUIRE(runner.present(builder) == expected);
+}
+
+TEST_CASE("software_draw_polygon", "software_graphics") {
+    software_frame_runner runner;
+    drivers::graphics_command_builder builder;
+
+    begin_frame(builder, { 6, 5 });
+
+    // The outline is not closed, same as the GPU backends' line strip
+    const eka2l1::point points[] = { { 0, 0 }, { 4, 0 }, { 4, 4 }, { 0, 4 } };
+
+    builder.set_brush_color({ 0, 255, 0 });
+    builder.set_pen_style(drivers::pen_style_solid);
+    builder.draw_polygons(points, 4);
+
+    const std::vector<std::string> expected = {
+        "GGGGG.",
+        "....G.",
+        "....G.",
+        "....G.",
+        "GGGGG."
+    };
+
+    REQUIRE(runner.present(builder) == expected);
+}
+
+TEST_CASE("software_blit_bitmap", "software_graphics") {
+    software_frame_runner runner;
+
+    const drivers::handle source = runner.create_bitmap({
+        "RG",
+        "BW"
+    });
+
+    drivers::graphics_command_builder builder;
+    begin_frame(builder, { 12, 4 });
+
+    // Straight copy, then a 2x nearest scale, then a single source pixel
+    builder.draw_bitmap(source, 0, eka2l1::rect({ 0, 0 }, { 0, 0 }), eka2l1::rect({ 0, 0 }, { 0, 0 }));
+    builder.draw_bitmap(source, 0, eka2l1::rect({ 2, 0 }, { 4, 4 }), eka2l1::rect({ 0, 0 }, { 0, 0 }));
+    builder.draw_bitmap(source, 0, eka2l1::rect({ 0, 3 }, { 2, 1 }), eka2l1::rect({ 1, 1 }, { 1, 1 }));
+
+    // Flipped vertically, then rotated half a turn around its center
+    builder.draw_bitmap(source, 0, eka2l1::rect({ 7, 0 }, { 2, 2 }), eka2l1::rect({ 0, 0 }, { 0, 0 }), { 0, 0 }, 0.0f,
+        drivers::bitmap_draw_flag_flip);
+    builder.draw_bitmap(source, 0, eka2l1::rect({ 10, 0 }, { 2, 2 }), eka2l1::rect({ 0, 0 }, { 0, 0 }), { 1, 1 }, 180.0f);
+
+    // Modulated by the brush
+    builder.set_brush_color({ 255, 0, 0 });
+    builder.draw_bitmap(source, 0, eka2l1::rect({ 7, 2 }, { 2, 2 }), eka2l1::rect({ 0, 0 }, { 0, 0 }), { 0, 0 }, 0.0f,
+        drivers::bitmap_draw_flag_use_brush);
+
+    const std::vector<std::string> expected = {
+        "RGRRGG.BW.WB",
+        "BWRRGG.RG.GR",
+        "..BBWW.R....",
+        "WWBBWW..R..."
+    };
+
+    REQUIRE(runner.present(builder) == expected);
+}
+
+TEST_CASE("software_blit_masked", "software_graphics") {
+    software_frame_runner runner;
+
+    const drivers::handle source = runner.create_bitmap({
+        "RRRR"
+    });
+
+    // Only the red channel of the mask is used
+    const drivers::handle mask = runner.create_bitmap({
+        "W.W."
+    });
+
+    drivers::graphics_command_builder builder;
+    begin_frame(builder, { 4, 3 });
+
+    builder.set_brush_color({ 0, 0, 255 });
+    builder.draw_rectangle(eka2l1::rect({ 0, 0 }, { 4, 3 }));
+
+    builder.set_feature(drivers::graphics_feature::blend, true);
+    builder.blend_formula(drivers::blend_equation::add, drivers::blend_equation::add, drivers::blend_factor::frag_out_alpha,
+        drivers::blend_factor::one_minus_frag_out_alpha, drivers::blend_factor::one, drivers::blend_factor::one);
+
+    builder.draw_bitmap(source, mask, eka2l1::rect({ 0, 0 }, { 0, 0 }), eka2l1::rect({ 0, 0 }, { 0, 0 }));
+    builder.draw_bitmap(source, mask, eka2l1::rect({ 0, 1 }, { 0, 0 }), eka2l1::rect({ 0, 0 }, { 0, 0 }), { 0, 0 }, 0.0f,
+        drivers::bitmap_draw_flag_invert_mask);
+
+    const std::vector<std::string> expected = {
+        "RBRB",
+        "BRBR",
+        "BBBB"
+    };
+
+    REQUIRE(runner.present(builder) == expected);
+}
+
+TEST_CASE("software_draw_to_bitmap", "software_graphics") {
+    software_frame_runner runner;
+
+    const drivers::handle target = runner.create_bitmap({
+        "....",
+        "...."
+    });
+
+    drivers::graphics_command_builder builder;
+    begin_frame(builder, { 4, 2 });
+
+    builder.bind_bitmap(target);
+    builder.set_brush_color({ 0, 255, 0 });
+    builder.draw_rectangle(eka2l1::rect({ 1, 0 }, { 2, 1 }));
+
+    // Stretched to the new size with its content
+    builder.resize_bitmap(target, { 8, 2 });
+
+    builder.bind_bitmap(0);
+    builder.draw_bitmap(target, 0, eka2l1::rect({ 0, 0 }, { 4, 2 }), eka2l1::rect({ 2, 0 }, { 4, 2 }));
+
+    const std::vector<std::string> expected = {
+        "GGGG",
+        "...."
+    };
+
+    REQUIRE(runner.present(builder) == expected);
+
+    // Bitmaps are read back in RGBA, the same as GPU backends
+    std::uint32_t row[8] = {};
+    REQUIRE(drivers::read_bitmap(runner.driver_.get(), target, { 0, 0 }, { 8, 1 }, 32, reinterpret_cast<std::uint8_t *>(row)));
+
+    const std::uint32_t green = golden_palette.at('G');
+    const std::uint32_t black = golden_palette.at('.');
+
+    REQUIRE(std::vector<std::uint32_t>(row, row + 8) == std::vector<std::uint32_t>{ black, black, green, green, green, green, black, black });
+}
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <common/chunkyseri.h>
+#include <config/config.h>
+#include <cpu/arm_factory.h>
+#include <kernel/chunk.h>
+#include <kernel/kernel.h>
+#include <kernel/property.h>
+#include <kernel/sema.h>
+#include <kernel/server.h>
+#include <kernel/timing.h>
+#include <mem/mem.h>
+#include <vfs/vfs.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+// A kernel with no system or memory behind it, enough for objects that don't touch guest memory
+struct kernel_test_env {
+    arm::exclusive_monitor_instance monitor;
+    arm::core_instance cpu;
+    ntimer timing;
+    io_system io;
+    config::state conf;
+
+    // Only for tests that need guest memory. Declared before the kernel, so that it outlives the chunks.
+    std::unique_ptr<memory_system> mem;
+
+    kernel_system kern;
+
+    explicit kernel_test_env()
+        : monitor(arm::create_exclusive_monitor(arm_emulator_type::dyncom, 1))
+        , cpu(arm::create_core(monitor.get(), arm_emulator_type::dyncom))
+        , timing(484000000)
+        , kern(nullptr, &timing, &io, &conf, nullptr, nullptr, cpu.get(), nullptr) {
+        // Start the timing thread, so that scheduled events run
+        timing.reset();
+    }
+};
+
+TEST_CASE("kernel_obj_state_round_trip_keeps_access_count", "[kernel]") {
+    kernel_test_env env;
+
+    kernel::semaphore *sema = env.kern.create<kernel::semaphore>(nullptr, "TestSema", 0, kernel::access_type::global_access);
+    REQUIRE(sema);
+
+    sema->increase_access_count();
+
+    common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+    sema->kernel_obj::do_state(seri);
+
+    std::vector<std::uint8_t> state(seri.size());
+    seri = common::chunkyseri(state.data(), state.size(), common::SERI_MODE_WRITE);
+    sema->kernel_obj::do_state(seri);
+
+    // Opened again after the state was saved. Restoring must not take this reference away.
+    sema->increase_access_count();
+
+    seri = common::chunkyseri(state.data(), state.size(), common::SERI_MODE_READ);
+    sema->kernel_obj::do_state(seri);
+
+    REQUIRE(seri.size() == state.size());
+    REQUIRE(sema->get_access_count() == 2);
+    REQUIRE(sema->name() == "TestSema");
+}
+
+// Same layout as the system state of a snapshot: timing, then the kernel
+static bool absorb_snapshot_state(kernel_test_env &env, common::chunkyseri &seri) {
+    auto s = seri.section("System", 1);
+
+    if (!s) {
+        return false;
+    }
+
+    env.timing.do_state(seri);
+    return env.kern.do_state(seri);
+}
+
+static std::vector<std::uint8_t> save_snapshot_state(kernel_test_env &env) {
+    common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+    absorb_snapshot_state(env, seri);
+
+    std::vector<std::uint8_t> state(seri.size());
+
+    seri = common::chunkyseri(state.data(), state.size(), common::SERI_MODE_WRITE);
+    REQUIRE(absorb_snapshot_state(env, seri));
+
+    return state;
+}
+
+TEST_CASE("snapshot_state_round_trip_rewinds_chunk_memory", "[kernel]") {
+    kernel_test_env env;
+
+    env.mem = std::make_unique<memory_system>(env.monitor.get(), &env.conf, mem::mem_model_type::multiple, false);
+    env.kern.install_memory(env.mem.get());
+
+    static constexpr std::uint32_t CHUNK_SIZE = 0x3000;
+
+    kernel::chunk *chunk = env.kern.create<kernel::chunk>(env.mem.get(), nullptr, "SnapshotTestChunk", 0, CHUNK_SIZE, CHUNK_SIZE,
+        prot_read_write, kernel::chunk_type::normal, kernel::chunk_access::rom, kernel::chunk_attrib::none, 0x00);
+
+    REQUIRE(chunk);
+
+    std::uint8_t *data = reinterpret_cast<std::uint8_t *>(chunk->host_base());
+
+    for (std::uint32_t i = 0; i < CHUNK_SIZE; i++) {
+        data[i] = static_cast<std::uint8_t>(i * 7 + 3);
+    }
+
+    const std::vector<std::uint8_t> expected(data, data + CHUNK_SIZE);
+    const std::vector<std::uint8_t> state = save_snapshot_state(env);
+
+    std::memset(data, 0xCD, CHUNK_SIZE);
+
+    common::chunkyseri seri(const_cast<std::uint8_t *>(state.data()), state.size(), common::SERI_MODE_READ);
+
+    REQUIRE(absorb_snapshot_state(env, seri));
+    REQUIRE(seri.size() == state.size());
+    REQUIRE(std::memcmp(data, expected.data(), CHUNK_SIZE) == 0);
+
+    // A chunk created since the save can't be matched with the snapshot. Nothing must be restored.
+    REQUIRE(env.kern.create<kernel::chunk>(env.mem.get(), nullptr, "SnapshotLateChunk", 0, 0x1000, 0x1000, prot_read_write,
+        kernel::chunk_type::normal, kernel::chunk_access::rom, kernel::chunk_attrib::none, 0x00));
+
+    std::memset(data, 0xCD, CHUNK_SIZE);
+
+    seri = common::chunkyseri(const_cast<std::uint8_t *>(state.data()), state.size(), common::SERI_MODE_READ);
+
+    REQUIRE(!absorb_snapshot_state(env, seri));
+    REQUIRE(data[0] == 0xCD);
+    REQUIRE(data[CHUNK_SIZE - 1] == 0xCD);
+}
+
+TEST_CASE("prop_define_delete_redefine", "[kernel]") {
+    kernel_test_env env;
+
+    static constexpr int TEST_CATEGORY = 0x10205F5D;
+    static constexpr int TEST_KEY = 5;
+
+    property_ptr prop = env.kern.create_prop(TEST_CATEGORY, TEST_KEY);
+    REQUIRE(prop);
+
+    prop->define(service::property_type::int_data, 0);
+    REQUIRE(prop->set_int(42));
+
+    // Closing the last reference destroys the property, and must take the lookup entry with it
+    prop->increase_access_count();
+    prop->decrease_access_count();
+
+    REQUIRE(!env.kern.get_prop(TEST_CATEGORY, TEST_KEY));
+
+    property_ptr redefined = env.kern.create_prop(TEST_CATEGORY, TEST_KEY);
+    REQUIRE(redefined);
+
+    redefined->define(service::property_type::int_data, 0);
+    REQUIRE(redefined->set_int(7));
+
+    REQUIRE(env.kern.get_prop(TEST_CATEGORY, TEST_KEY) == redefined);
+    REQUIRE(redefined->get_int() == 7);
+
+    REQUIRE(env.kern.delete_prop(TEST_CATEGORY, TEST_KEY));
+    REQUIRE(!env.kern.get_prop(TEST_CATEGORY, TEST_KEY));
+
+    REQUIRE(env.kern.create_prop(TEST_CATEGORY, TEST_KEY));
+}
+
+struct worker_test_server : public service::server {
+    std::atomic<int> completed{ 0 };
+    std::thread::id worker_id;
+    std::thread::id completion_id;
+
+    explicit worker_test_server(kernel_system *kern)
+        : service::server(kern, nullptr, nullptr, "WorkerTestServer", true) {
+        thread_safe_ = true;
+    }
+
+    void process_accepted_msg() override {
+        worker_id = std::this_thread::get_id();
+
+        post_to_kernel([this]() {
+            completion_id = std::this_thread::get_id();
+            completed++;
+        });
+    }
+};
+
+TEST_CASE("hle_worker_completes_on_kernel_side", "[kernel]") {
+    kernel_test_env env;
+    env.conf.hle_server_threads = true;
+
+    worker_test_server *svr = env.kern.create<worker_test_server>();
+    REQUIRE(svr);
+
+    // The send and close SVCs run with the kernel lock held. The worker must not need it to finish.
+    env.kern.lock();
+
+    svr->dispatch_accepted_msg();
+    REQUIRE(svr->has_worker());
+
+    svr->flush_worker();
+    env.kern.unlock();
+
+    REQUIRE(svr->completed == 1);
+    REQUIRE(svr->worker_id != std::this_thread::get_id());
+    REQUIRE(svr->completion_id == std::this_thread::get_id());
+
+    // Without a flush, the timing thread runs the completion under the kernel lock
+    svr->dispatch_accepted_msg();
+
+    const auto give_up_time = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+    while ((svr->completed != 2) && (std::chrono::steady_clock::now() < give_up_time)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    REQUIRE(svr->completed == 2);
+    REQUIRE(svr->completion_id != svr->worker_id);
+    REQUIRE(svr->completion_id != std::this_thread::get_id());
+}
+
+TEST_CASE("ipc_msg_handle_not_reused_by_next_holder", "[kernel]") {
+    kernel_test_env env;
+
+    ipc_msg_ptr first = env.kern.create_msg(kernel::owner_type::kernel);
+    ipc_msg_ptr second = env.kern.create_msg(kernel::owner_type::kernel);
+
+    REQUIRE(first);
+    REQUIRE(second);
+    REQUIRE(first->id != second->id);
+
+    const int first_handle = static_cast<int>(first->id);
+
+    REQUIRE(env.kern.get_msg(first_handle) == first);
+    REQUIRE(env.kern.get_msg(static_cast<int>(second->id)) == second);
+
+    // Last unref gives the message back to the pool
+    first->ref();
+    first->unref();
+
+    REQUIRE(env.kern.get_msg(first_handle) == nullptr);
+    REQUIRE(env.kern.get_msg_pool_stats().in_use_ == 1);
+
+    // The slot is handed out again, under a different handle
+    ipc_msg_ptr third = env.kern.create_msg(kernel::owner_type::kernel);
+
+    REQUIRE(third == first);
+    REQUIRE(static_cast<int>(third->id) != first_handle);
+    REQUIRE((third->id & ipc_msg_handle_slot_mask) == (first_handle & ipc_msg_handle_slot_mask));
+
+    REQUIRE(env.kern.get_msg(first_handle) == nullptr);
+    REQUIRE(env.kern.get_msg(static_cast<int>(third->id)) == third);
+    REQUIRE(env.kern.get_msg(static_cast<int>(second->id)) == second);
+
+    const ipc_msg_pool_stats stats = env.kern.get_msg_pool_stats();
+
+    REQUIRE(stats.allocated_ == 2);
+    REQUIRE(stats.in_use_ == 2);
+    REQUIRE(stats.high_water_mark_ == 2);
+    REQUIRE(stats.total_allocs_ == 3);
+    REQUIRE(stats.failed_allocs_ == 0);
+}
+
+TEST_CASE("ipc_msg_handle_stays_positive_across_generations", "[kernel]") {
+    kernel_test_env env;
+
+    ipc_msg_ptr msg = env.kern.create_msg(kernel::owner_type::kernel);
+    REQUIRE(msg);
+
+    const std::uint32_t slot = msg->id & ipc_msg_handle_slot_mask;
+    std::uint32_t previous_id = msg->id;
+
+    // Go through every generation and wrap around once
+    for (std::uint32_t i = 0; i <= ipc_msg_handle_generation_mask + 1; i++) {
+        env.kern.free_msg(msg);
+        REQUIRE(env.kern.get_msg(static_cast<int>(previous_id)) == nullptr);
+
+        msg = env.kern.create_msg(kernel::owner_type::kernel);
+
+        REQUIRE(static_cast<int>(msg->id) > 0);
+        REQUIRE((msg->id & ipc_msg_handle_slot_mask) == slot);
+        REQUIRE(msg->id != previous_id);
+        REQUIRE(env.kern.get_msg(static_cast<int>(msg->id)) == msg);
+
+        previous_id = msg->id;
+    }
+
+    REQUIRE(env.kern.get_msg_pool_stats().allocated_ == 1);
+}
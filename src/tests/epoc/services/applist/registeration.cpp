@@ -19,12 +19,16 @@
 
 #include <loader/rsc.h>
 #include <services/applist/applist.h>
+#include <services/applist/iconcache.h>
+#include <services/applist/snapshot.h>
 #include <vfs/vfs.h>
 
 #include <common/algorithm.h>
 #include <common/buffer.h>
+#include <common/fileutils.h>
 
 #include <catch2/catch.hpp>
+#include <cstring>
 
 using namespace eka2l1;
 
@@ -85,3 +89,124 @@ TEST_CASE("mandatory_check_localise", "applist_registeration") {
     REQUIRE(reg.mandatory_info.short_caption.to_std_string(nullptr) == u"ITried");
     REQUIRE(reg.mandatory_info.long_caption.to_std_string(nullptr) == u"ITried");
 }
+
+TEST_CASE("snapshot_roundtrip", "applist_registeration") {
+    std::vector<std::uint8_t> dat;
+    REQUIRE(read_resource_from_file("applistassets//sample_reg.rsc", 1, dat));
+
+    common::ro_buf_stream app_info_resource_stream(&dat[0], dat.size());
+    apa_registry_snapshot_entry entry;
+
+    REQUIRE(read_registeration_info(reinterpret_cast<common::ro_stream *>(&app_info_resource_stream),
+        entry.reg_, drive_c));
+
+    entry.reg_.rsc_path = u"C:\\Private\\10003a3f\\import\\apps\\sample_reg.rsc";
+    entry.reg_.mandatory_info.short_caption.assign(nullptr, u"ITried");
+    entry.rsc_stamp_.size_ = dat.size();
+    entry.rsc_stamp_.last_modified_ = 0x1234;
+    entry.localised_path_ = u"C:\\resource\\apps\\sample.r01";
+
+    apa_registry_snapshot snapshot;
+    snapshot.set(entry.reg_.rsc_path, std::move(entry));
+
+    REQUIRE(snapshot.dirty());
+    REQUIRE(snapshot.save("applist_snapshot_test.bin"));
+
+    apa_registry_snapshot loaded;
+    REQUIRE(loaded.load("applist_snapshot_test.bin"));
+
+    // Lookup is case insensitive
+    apa_registry_snapshot_entry *result = loaded.get(u"c:\\private\\10003A3F\\import\\apps\\SAMPLE_REG.RSC");
+    REQUIRE(result);
+    REQUIRE(result->rsc_stamp_.last_modified_ == 0x1234);
+    REQUIRE(result->localised_path_ == u"C:\\resource\\apps\\sample.r01");
+    REQUIRE(result->reg_.mandatory_info.short_caption.to_std_string(nullptr) == u"ITried");
+    REQUIRE(common::compare_ignore_case(result->reg_.mandatory_info.app_path.to_std_string(nullptr),
+                u"C:\\System\\Programs\\ITried_0xed3e09d5.exe")
+        == 0);
+}
+
+TEST_CASE("icon_cache_persist", "applist_registeration") {
+    const std::uint8_t source[] = { 'M', 'I', 'F', 1, 2, 3 };
+
+    apa_icon_cache_key key;
+    key.source_hash_ = apa_icon_cache::hash_source(source, sizeof(source));
+    key.size_ = eka2l1::vec2(2, 2);
+
+    // Start from an empty cache, entries from a previous run are persisted
+    common::delete_folder("applist_icon_cache_test");
+
+    {
+        apa_icon_cache cache("applist_icon_cache_test");
+        REQUIRE(!cache.get(key));
+
+        apa_rendered_icon icon;
+        icon.size_ = eka2l1::vec2(2, 2);
+        icon.stride_ = 8;
+        icon.pixels_ = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+
+        cache.put(key, std::move(icon));
+
+        const apa_icon_cache_stats stats = cache.get_stats();
+        REQUIRE(stats.misses_ == 1);
+        REQUIRE(stats.stores_ == 1);
+    }
+
+    apa_icon_cache loaded("applist_icon_cache_test");
+    std::shared_ptr<const apa_rendered_icon> result = loaded.get(key);
+
+    REQUIRE(result);
+    REQUIRE(result->stride_ == 8);
+    REQUIRE(result->pixels_.size() == 16);
+    REQUIRE(result->pixels_[15] == 16);
+
+    // The same source rendered at another size is a different entry
+    apa_icon_cache_key other_size = key;
+    other_size.size_ = eka2l1::vec2(4, 4);
+
+    REQUIRE(!loaded.get(other_size));
+
+    // Second lookup is served from memory
+    REQUIRE(loaded.get(key));
+
+    const apa_icon_cache_stats stats = loaded.get_stats();
+    REQUIRE(stats.hits_ == 2);
+    REQUIRE(stats.disk_hits_ == 1);
+    REQUIRE(stats.misses_ == 1);
+}
+
+TEST_CASE("snapshot_reject_oversized_count", "applist_registeration") {
+    apa_registry_snapshot_entry entry;
+    entry.reg_.rsc_path = u"C:\\Private\\10003a3f\\import\\apps\\sample_reg.rsc";
+
+    apa_registry_snapshot snapshot;
+    snapshot.set(entry.reg_.rsc_path, std::move(entry));
+
+    REQUIRE(snapshot.save("applist_snapshot_corrupt_test.bin"));
+
+    std::vector<std::uint8_t> buf;
+
+    {
+        common::ro_std_file_stream stream("applist_snapshot_corrupt_test.bin", true);
+        REQUIRE(stream.valid());
+
+        buf.resize(stream.size());
+        REQUIRE(stream.read(buf.data(), buf.size()) == buf.size());
+    }
+
+    // Entry count follows the magic and the section header. Claim far more entries than the file holds.
+    const std::size_t count_offset = sizeof(std::uint32_t) + std::string("AppRegistrySnapshot").length() + sizeof(std::int16_t);
+    const std::uint32_t bogus_count = 0x10000000;
+
+    REQUIRE(buf.size() > count_offset + sizeof(bogus_count));
+    std::memcpy(buf.data() + count_offset, &bogus_count, sizeof(bogus_count));
+
+    {
+        common::wo_std_file_stream stream("applist_snapshot_corrupt_test.bin", true);
+        REQUIRE(stream.write(buf.data(), buf.size()) == buf.size());
+    }
+
+    apa_registry_snapshot loaded;
+    REQUIRE_FALSE(loaded.load("applist_snapshot_corrupt_test.bin"));
+    REQUIRE(loaded.size() == 0);
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <drivers/graphics/backend/software/graphics_software.h>
+#include <drivers/itc.h>
+#include <services/window/common.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+static std::uint8_t screen_test_channel(const int x, const int y, const int c) {
+    return static_cast<std::uint8_t>(y * 40 + x * 4 + c + 1);
+}
+
+TEST_CASE("upload_screen_rect_odd_width_24bpp", "window_screen") {
+    // 3 * 5 = 15 bytes per row, padded to 24 by the guest
+    const eka2l1::vec2 screen_size(5, 4);
+    const int line_pitch = epoc::get_byte_width(screen_size.x, 24);
+
+    REQUIRE(line_pitch == 24);
+
+    std::vector<std::uint8_t> buffer(line_pitch * screen_size.y, 0xEE);
+
+    for (int y = 0; y < screen_size.y; y++) {
+        for (int x = 0; x < screen_size.x; x++) {
+            for (int c = 0; c < 3; c++) {
+                buffer[y * line_pitch + x * 3 + c] = screen_test_channel(x, y, c);
+            }
+        }
+    }
+
+    drivers::window_system_info info;
+    auto driver = std::make_unique<drivers::software_graphics_driver>(info);
+    std::thread driver_thread([&]() { driver->run(); });
+
+    const drivers::handle bitmap = drivers::create_bitmap(driver.get(), screen_size, 24);
+
+    // A dirty rectangle away from the first column and row, then the rest of the screen
+    drivers::graphics_command_builder builder;
+    epoc::upload_screen_rect(builder, bitmap, buffer.data(), screen_size, 24, eka2l1::rect({ 1, 1 }, { 3, 2 }));
+
+    drivers::command_list list = builder.retrieve_command_list();
+    driver->submit_command_list(list);
+
+    std::vector<std::uint32_t> pixels(screen_size.x * screen_size.y);
+    REQUIRE(drivers::read_bitmap(driver.get(), bitmap, { 0, 0 }, screen_size, 24, reinterpret_cast<std::uint8_t *>(pixels.data())));
+
+    auto expected_pixel = [](const int x, const int y) -> std::uint32_t {
+        // The guest stores BGR, read back as RGBA
+        return screen_test_channel(x, y, 2) | (screen_test_channel(x, y, 1) << 8) | (screen_test_channel(x, y, 0) << 16) | 0xFF000000;
+    };
+
+    for (int y = 0; y < screen_size.y; y++) {
+        for (int x = 0; x < screen_size.x; x++) {
+            const bool in_rect = (x >= 1) && (x < 4) && (y >= 1) && (y < 3);
+            REQUIRE(pixels[y * screen_size.x + x] == (in_rect ? expected_pixel(x, y) : 0));
+        }
+    }
+
+    epoc::upload_screen_rect(builder, bitmap, buffer.data(), screen_size, 24, eka2l1::rect({ 0, 0 }, screen_size));
+
+    list = builder.retrieve_command_list();
+    driver->submit_command_list(list);
+
+    REQUIRE(drivers::read_bitmap(driver.get(), bitmap, { 0, 0 }, screen_size, 24, reinterpret_cast<std::uint8_t *>(pixels.data())));
+
+    for (int y = 0; y < screen_size.y; y++) {
+        for (int x = 0; x < screen_size.x; x++) {
+            REQUIRE(pixels[y * screen_size.x + x] == expected_pixel(x, y));
+        }
+    }
+
+    driver->abort();
+    driver_thread.join();
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/binlog.h>
+
+#include <cstdio>
+#include <iostream>
+
+static const char *level_to_string(const std::uint8_t level) {
+    static const char *LEVEL_NAMES[] = { "trace", "debug", "info", "warning", "error", "critical" };
+
+    if (level >= sizeof(LEVEL_NAMES) / sizeof(const char *)) {
+        return "unknown";
+    }
+
+    return LEVEL_NAMES[level];
+}
+
+int main(int argc, char **argv) {
+    if (argc <= 1) {
+        std::cout << "Usage: binlogdump [filename]" << std::endl;
+        return -1;
+    }
+
+    std::uint64_t dropped = 0;
+    std::uint64_t first_time = 0;
+    bool first = true;
+
+    const bool result = eka2l1::log::decode_binary_log(argv[1], [&](const eka2l1::log::binlog_entry &entry) {
+        if (first) {
+            first_time = entry.time_us_;
+            first = false;
+        }
+
+        const std::uint64_t delta = entry.time_us_ - first_time;
+
+        std::printf("+%llu.%06llu [T%u] [%s] %s:%u [%s]: %s\n", static_cast<unsigned long long>(delta / 1000000),
+            static_cast<unsigned long long>(delta % 1000000), entry.thread_, level_to_string(entry.level_),
+            entry.file_.c_str(), entry.line_, entry.class_name_.c_str(), entry.message_.c_str());
+    }, &dropped);
+
+    if (!result) {
+        std::cerr << "Unable to decode binary log " << argv[1] << ", the file is invalid" << std::endl;
+        return -2;
+    }
+
+    if (dropped != 0) {
+        std::cerr << dropped << " records were dropped because the log ring was full" << std::endl;
+    }
+
+    return 0;
+}
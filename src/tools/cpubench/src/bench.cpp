@@ -0,0 +1,480 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bench.h"
+#include "kernels.h"
+
+#include <common/atomic.h>
+#include <common/log.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace eka2l1::cpubench {
+    static constexpr std::uint32_t CPSR_USER_MODE = 0x10;
+    static constexpr std::uint32_t CPSR_THUMB_BIT = 0x20;
+
+    // NZCVQ, GE and T. Mode and mask bits are not emulated the same way by every backend
+    static constexpr std::uint32_t CPSR_COMPARE_MASK = 0xF80F0020;
+    static constexpr std::uint32_t FPSCR_COMPARE_MASK = 0xF0000000;
+
+    static constexpr std::size_t VFP_COMPARE_REG_COUNT = 32;
+    static constexpr std::size_t VFP_REG_COUNT = 64;
+
+    static constexpr std::uint32_t RUN_SLICE = 1000000;
+
+    // Odd and small so that core switches land between LDREX and STREX often
+    static constexpr std::uint32_t CONTENTION_SLICE = 97;
+
+    static constexpr std::uint64_t MAX_DIFF_STEPS = 50000000;
+
+    bench_env::bench_env(const arm_emulator_type type, const std::size_t core_count)
+        : type_(type)
+        , memory_(MEMORY_SIZE, 0) {
+        monitor_ = arm::create_exclusive_monitor(type, core_count);
+
+        if (!monitor_) {
+            return;
+        }
+
+        monitor_->read_8bit = [this](arm::core *cc, const arm::address addr, std::uint8_t *data) {
+            return read<std::uint8_t>(cc, addr, data);
+        };
+
+        monitor_->read_16bit = [this](arm::core *cc, const arm::address addr, std::uint16_t *data) {
+            return read<std::uint16_t>(cc, addr, data);
+        };
+
+        monitor_->read_32bit = [this](arm::core *cc, const arm::address addr, std::uint32_t *data) {
+            return read<std::uint32_t>(cc, addr, data);
+        };
+
+        monitor_->read_64bit = [this](arm::core *cc, const arm::address addr, std::uint64_t *data) {
+            return read<std::uint64_t>(cc, addr, data);
+        };
+
+        monitor_->write_8bit = [this](arm::core *cc, const arm::address addr, std::uint8_t value, std::uint8_t expected) {
+            return write_exclusive<std::uint8_t>(addr, value, expected);
+        };
+
+        monitor_->write_16bit = [this](arm::core *cc, const arm::address addr, std::uint16_t value, std::uint16_t expected) {
+            return write_exclusive<std::uint16_t>(addr, value, expected);
+        };
+
+        monitor_->write_32bit = [this](arm::core *cc, const arm::address addr, std::uint32_t value, std::uint32_t expected) {
+            return write_exclusive<std::uint32_t>(addr, value, expected);
+        };
+
+        monitor_->write_64bit = [this](arm::core *cc, const arm::address addr, std::uint64_t value, std::uint64_t expected) {
+            return write_exclusive<std::uint64_t>(addr, value, expected);
+        };
+
+        cores_.resize(core_count);
+
+        for (std::size_t i = 0; i < core_count; i++) {
+            cores_[i].core_ = arm::create_core(monitor_.get(), type);
+
+            if (!cores_[i].core_) {
+                cores_.clear();
+                return;
+            }
+
+            cores_[i].core_->set_core_number(i);
+            hook_core(cores_[i]);
+        }
+    }
+
+    std::uint8_t *bench_env::pointer(const arm::address addr, const std::size_t size) {
+        if ((static_cast<std::size_t>(addr) + size) > memory_.size()) {
+            return nullptr;
+        }
+
+        return memory_.data() + addr;
+    }
+
+    template <typename T>
+    bool bench_env::read(arm::core *cc, const arm::address addr, T *data) {
+        std::uint8_t *ptr = pointer(addr, sizeof(T));
+
+        if (!ptr) {
+            return false;
+        }
+
+        std::memcpy(data, ptr, sizeof(T));
+
+        const arm::address page_addr = addr & ~(PAGE_SIZE - 1);
+        cc->set_tlb_page(page_addr, memory_.data() + page_addr, prot_read_write);
+
+        return true;
+    }
+
+    template <typename T>
+    bool bench_env::write(arm::core *cc, const arm::address addr, T *data) {
+        std::uint8_t *ptr = pointer(addr, sizeof(T));
+
+        if (!ptr) {
+            return false;
+        }
+
+        std::memcpy(ptr, data, sizeof(T));
+
+        const arm::address page_addr = addr & ~(PAGE_SIZE - 1);
+        cc->set_tlb_page(page_addr, memory_.data() + page_addr, prot_read_write);
+
+        return true;
+    }
+
+    template <typename T>
+    std::int32_t bench_env::write_exclusive(const arm::address addr, T value, T expected) {
+        std::uint8_t *ptr = pointer(addr, sizeof(T));
+
+        if (!ptr) {
+            return -1;
+        }
+
+        return static_cast<std::int32_t>(common::atomic_compare_and_swap<T>(reinterpret_cast<volatile T *>(ptr),
+            value, expected));
+    }
+
+    void bench_env::hook_core(bench_core &bcore) {
+        arm::core *cc = bcore.core_.get();
+
+        cc->read_8bit = [this, cc](const arm::address addr, std::uint8_t *data) { return read(cc, addr, data); };
+        cc->read_16bit = [this, cc](const arm::address addr, std::uint16_t *data) { return read(cc, addr, data); };
+        cc->read_32bit = [this, cc](const arm::address addr, std::uint32_t *data) { return read(cc, addr, data); };
+        cc->read_64bit = [this, cc](const arm::address addr, std::uint64_t *data) { return read(cc, addr, data); };
+        cc->read_code = [this, cc](const arm::address addr, std::uint32_t *data) { return read(cc, addr, data); };
+
+        cc->write_8bit = [this, cc](const arm::address addr, std::uint8_t *data) { return write(cc, addr, data); };
+        cc->write_16bit = [this, cc](const arm::address addr, std::uint16_t *data) { return write(cc, addr, data); };
+        cc->write_32bit = [this, cc](const arm::address addr, std::uint32_t *data) { return write(cc, addr, data); };
+        cc->write_64bit = [this, cc](const arm::address addr, std::uint64_t *data) { return write(cc, addr, data); };
+
+        cc->exclusive_write_8bit = [this](const arm::address addr, std::uint8_t value, std::uint8_t expected) {
+            return write_exclusive<std::uint8_t>(addr, value, expected);
+        };
+
+        cc->exclusive_write_16bit = [this](const arm::address addr, std::uint16_t value, std::uint16_t expected) {
+            return write_exclusive<std::uint16_t>(addr, value, expected);
+        };
+
+        cc->exclusive_write_32bit = [this](const arm::address addr, std::uint32_t value, std::uint32_t expected) {
+            return write_exclusive<std::uint32_t>(addr, value, expected);
+        };
+
+        cc->exclusive_write_64bit = [this](const arm::address addr, std::uint64_t value, std::uint64_t expected) {
+            return write_exclusive<std::uint64_t>(addr, value, expected);
+        };
+
+        // Every kernel ends with a SVC
+        cc->system_call_handler = [&bcore](const std::uint32_t svc) {
+            bcore.finished_ = true;
+            bcore.core_->stop();
+        };
+
+        cc->exception_handler = [&bcore](arm::exception_type type, const std::uint32_t data) {
+            LOG_ERROR(eka2l1::SYSTEM, "Core {} raised exception {} (data 0x{:X}, PC 0x{:X})", bcore.core_->core_number(),
+                static_cast<int>(type), data, bcore.core_->get_pc());
+
+            bcore.faulted_ = true;
+            bcore.core_->stop();
+
+            return false;
+        };
+    }
+
+    void bench_env::load_code(const kernel &kern) {
+        std::fill(memory_.begin(), memory_.end(), 0);
+        std::memcpy(pointer(CODE_BASE, kern.code_.size()), kern.code_.data(), kern.code_.size());
+
+        for (bench_core &bcore : cores_) {
+            bcore.core_->clear_instruction_cache();
+        }
+    }
+
+    void bench_env::reset_core(const std::size_t index, const bool thumb) {
+        bench_core &bcore = cores_[index];
+        arm::core *cc = bcore.core_.get();
+
+        bcore.finished_ = false;
+        bcore.faulted_ = false;
+        bcore.instructions_ = 0;
+
+        // Not load_context: some backends throw away their translated code on context switch
+        for (std::size_t i = 0; i < 15; i++) {
+            cc->set_reg(i, 0);
+        }
+
+        for (std::size_t i = 0; i < VFP_REG_COUNT; i++) {
+            cc->set_vfp(i, 0);
+        }
+
+        cc->set_pc(CODE_BASE);
+        cc->set_cpsr(CPSR_USER_MODE | (thumb ? CPSR_THUMB_BIT : 0));
+        cc->set_fpscr(0);
+
+        monitor_->clear_exclusive();
+    }
+
+    bool bench_env::run_all(const std::uint32_t slice) {
+        bool any_running = true;
+
+        while (any_running) {
+            any_running = false;
+
+            for (bench_core &bcore : cores_) {
+                if (bcore.finished_ || bcore.faulted_) {
+                    continue;
+                }
+
+                bcore.core_->run(slice);
+                bcore.instructions_ += bcore.core_->get_num_instruction_executed();
+
+                if (bcore.faulted_) {
+                    return false;
+                }
+
+                any_running = any_running || !bcore.finished_;
+            }
+        }
+
+        return true;
+    }
+
+    static void setup_kernel(bench_env &env, const kernel &kern, const std::uint32_t iterations) {
+        for (std::size_t i = 0; i < env.core_count(); i++) {
+            env.reset_core(i, kern.thumb_);
+            kern.setup_(env, i, iterations);
+        }
+    }
+
+    static bool timed_run(bench_env &env, const kernel &kern, const std::uint32_t iterations, double &ms, std::uint64_t &instructions) {
+        setup_kernel(env, kern, iterations);
+
+        const auto start = std::chrono::steady_clock::now();
+        const bool ok = env.run_all((kern.core_count_ > 1) ? CONTENTION_SLICE : RUN_SLICE);
+        const auto end = std::chrono::steady_clock::now();
+
+        ms = std::chrono::duration<double, std::milli>(end - start).count();
+        instructions = 0;
+
+        for (std::size_t i = 0; i < env.core_count(); i++) {
+            instructions += env.instructions(i);
+        }
+
+        return ok;
+    }
+
+    bench_result run_benchmark(const kernel &kern, const arm_emulator_type type, const double scale) {
+        bench_result result;
+        bench_env env(type, kern.core_count_);
+
+        if (!env.valid()) {
+            result.error_ = "Backend is not available on this host";
+            return result;
+        }
+
+        env.load_code(kern);
+
+        if (!timed_run(env, kern, 1, result.first_run_ms_, result.first_run_instructions_)) {
+            result.error_ = "Guest faulted on the first run";
+            return result;
+        }
+
+        const std::uint32_t iterations = std::max<std::uint32_t>(1, static_cast<std::uint32_t>(kern.iterations_ * scale));
+
+        if (!timed_run(env, kern, iterations, result.steady_run_ms_, result.steady_instructions_)) {
+            result.error_ = "Guest faulted on the steady run";
+            return result;
+        }
+
+        if (kern.verify_) {
+            result.error_ = kern.verify_(env, iterations);
+
+            if (!result.error_.empty()) {
+                return result;
+            }
+        }
+
+        for (std::size_t i = 0; i < env.core_count(); i++) {
+            const arm::code_cache_stats stats = env.core(i)->get_code_cache_stats();
+
+            result.cache_stats_.capacity_bytes_ += stats.capacity_bytes_;
+            result.cache_stats_.committed_bytes_ += stats.committed_bytes_;
+            result.cache_stats_.used_bytes_ += stats.used_bytes_;
+            result.cache_stats_.block_count_ += stats.block_count_;
+            result.cache_stats_.evicted_block_count_ += stats.evicted_block_count_;
+            result.cache_stats_.reclaim_count_ += stats.reclaim_count_;
+            result.cache_stats_.flush_count_ += stats.flush_count_;
+            result.cache_stats_.compiled_block_count_ += stats.compiled_block_count_;
+            result.cache_stats_.recompiled_block_count_ += stats.recompiled_block_count_;
+            result.cache_stats_.flush_time_us_ += stats.flush_time_us_;
+            result.cache_stats_.recompile_time_us_ += stats.recompile_time_us_;
+        }
+
+        result.ok_ = true;
+        return result;
+    }
+
+    static std::string compare_cores(arm::core *test, arm::core *ref) {
+        std::string diff;
+
+        for (std::size_t i = 0; i < 16; i++) {
+            if (test->get_reg(i) != ref->get_reg(i)) {
+                diff += fmt::format("  r{}: 0x{:08X} (reference 0x{:08X})\n", i, test->get_reg(i), ref->get_reg(i));
+            }
+        }
+
+        if ((test->get_cpsr() & CPSR_COMPARE_MASK) != (ref->get_cpsr() & CPSR_COMPARE_MASK)) {
+            diff += fmt::format("  cpsr: 0x{:08X} (reference 0x{:08X})\n", test->get_cpsr(), ref->get_cpsr());
+        }
+
+        for (std::size_t i = 0; i < VFP_COMPARE_REG_COUNT; i++) {
+            if (test->get_vfp(i) != ref->get_vfp(i)) {
+                diff += fmt::format("  s{}: 0x{:08X} (reference 0x{:08X})\n", i, test->get_vfp(i), ref->get_vfp(i));
+            }
+        }
+
+        if ((test->get_fpscr() & FPSCR_COMPARE_MASK) != (ref->get_fpscr() & FPSCR_COMPARE_MASK)) {
+            diff += fmt::format("  fpscr: 0x{:08X} (reference 0x{:08X})\n", test->get_fpscr(), ref->get_fpscr());
+        }
+
+        return diff;
+    }
+
+    static std::string compare_memory(bench_env &test, bench_env &ref) {
+        if (std::memcmp(test.memory(), ref.memory(), bench_env::MEMORY_SIZE) == 0) {
+            return "";
+        }
+
+        for (arm::address addr = 0; addr < bench_env::MEMORY_SIZE; addr += 4) {
+            const std::uint32_t test_word = test.read_value<std::uint32_t>(addr);
+            const std::uint32_t ref_word = ref.read_value<std::uint32_t>(addr);
+
+            if (test_word != ref_word) {
+                return fmt::format("  [0x{:08X}]: 0x{:08X} (reference 0x{:08X})\n", addr, test_word, ref_word);
+            }
+        }
+
+        return "";
+    }
+
+    diff_result run_differential(const kernel &kern, const arm_emulator_type test_type, const arm_emulator_type reference_type,
+        const std::uint32_t mem_compare_interval) {
+        diff_result result;
+
+        bench_env test(test_type, kern.core_count_);
+        bench_env ref(reference_type, kern.core_count_);
+
+        if (!test.valid() || !ref.valid()) {
+            result.report_ = "Backend is not available on this host";
+            return result;
+        }
+
+        test.load_code(kern);
+        ref.load_code(kern);
+
+        setup_kernel(test, kern, kern.diff_iterations_);
+        setup_kernel(ref, kern, kern.diff_iterations_);
+
+        std::uint64_t last_mem_compare = 0;
+
+        while (result.steps_ < MAX_DIFF_STEPS) {
+            bool any_running = false;
+
+            for (std::size_t i = 0; i < kern.core_count_; i++) {
+                if (test.finished(i) && ref.finished(i)) {
+                    continue;
+                }
+
+                arm::core *test_core = test.core(i);
+                arm::core *ref_core = ref.core(i);
+
+                const std::uint32_t pc = ref_core->get_pc();
+                const bool thumb = ref_core->is_thumb_mode();
+
+                const std::uint32_t inst = thumb ? ref.read_value<std::uint16_t>(pc) : ref.read_value<std::uint32_t>(pc);
+                const std::string where = fmt::format("core {}, step {}, PC 0x{:08X} ({} 0x{:0{}X})", i, result.steps_,
+                    pc, thumb ? "thumb" : "arm", inst, thumb ? 4 : 8);
+
+                if (test.finished(i) != ref.finished(i)) {
+                    result.report_ = fmt::format("Divergence at {}: only {} reached the final SVC\n", where,
+                        test.finished(i) ? "the tested backend" : "the reference backend");
+
+                    return result;
+                }
+
+                test_core->step();
+                ref_core->step();
+
+                result.steps_++;
+
+                if (test.faulted(i) || ref.faulted(i)) {
+                    result.report_ = fmt::format("Fault at {}: tested backend {}, reference backend {}\n", where,
+                        test.faulted(i) ? "faulted" : "ok", ref.faulted(i) ? "faulted" : "ok");
+
+                    return result;
+                }
+
+                const std::string diff = compare_cores(test_core, ref_core);
+
+                if (!diff.empty()) {
+                    result.report_ = fmt::format("Register divergence after {}:\n{}", where, diff);
+                    return result;
+                }
+
+                any_running = true;
+            }
+
+            if (!any_running) {
+                break;
+            }
+
+            if (result.steps_ - last_mem_compare >= mem_compare_interval) {
+                const std::string diff = compare_memory(test, ref);
+
+                if (!diff.empty()) {
+                    result.report_ = fmt::format("Memory divergence between step {} and {}:\n{}", last_mem_compare,
+                        result.steps_, diff);
+
+                    return result;
+                }
+
+                last_mem_compare = result.steps_;
+            }
+        }
+
+        if (result.steps_ >= MAX_DIFF_STEPS) {
+            result.report_ = fmt::format("Kernel did not finish in {} steps\n", MAX_DIFF_STEPS);
+            return result;
+        }
+
+        const std::string diff = compare_memory(test, ref);
+
+        if (!diff.empty()) {
+            result.report_ = fmt::format("Memory divergence between step {} and the end:\n{}", last_mem_compare, diff);
+            return result;
+        }
+
+        result.ok_ = true;
+        return result;
+    }
+}
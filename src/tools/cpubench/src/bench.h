@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cpu/arm_factory.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace eka2l1::cpubench {
+    struct kernel;
+
+    /**
+     * @brief A flat guest address space, with a set of cores and their exclusive monitor.
+     *
+     * Memory is handed to the cores through the TLB on first access, the same way the MMU does.
+     */
+    class bench_env {
+    public:
+        enum : std::uint32_t {
+            PAGE_BITS = 12,
+            PAGE_SIZE = 1 << PAGE_BITS,
+            CODE_BASE = 0x10000,
+            DATA_BASE = 0x100000,
+            MEMORY_SIZE = 0x400000
+        };
+
+    private:
+        struct bench_core {
+            arm::core_instance core_;
+            bool finished_ = false;
+            bool faulted_ = false;
+            std::uint64_t instructions_ = 0;
+        };
+
+        arm_emulator_type type_;
+        std::vector<std::uint8_t> memory_;
+        arm::exclusive_monitor_instance monitor_;
+        std::vector<bench_core> cores_;
+
+        template <typename T>
+        bool read(arm::core *cc, const arm::address addr, T *data);
+
+        template <typename T>
+        bool write(arm::core *cc, const arm::address addr, T *data);
+
+        template <typename T>
+        std::int32_t write_exclusive(const arm::address addr, T value, T expected);
+
+        void hook_core(bench_core &bcore);
+
+    public:
+        explicit bench_env(const arm_emulator_type type, const std::size_t core_count);
+
+        bool valid() const {
+            return !cores_.empty();
+        }
+
+        arm_emulator_type type() const {
+            return type_;
+        }
+
+        std::size_t core_count() const {
+            return cores_.size();
+        }
+
+        arm::core *core(const std::size_t index) {
+            return cores_[index].core_.get();
+        }
+
+        bool finished(const std::size_t index) const {
+            return cores_[index].finished_;
+        }
+
+        bool faulted(const std::size_t index) const {
+            return cores_[index].faulted_;
+        }
+
+        std::uint64_t instructions(const std::size_t index) const {
+            return cores_[index].instructions_;
+        }
+
+        const std::uint8_t *memory() const {
+            return memory_.data();
+        }
+
+        /**
+         * @brief Get the host pointer of a guest address range.
+         *
+         * @returns Null if the range is outside of the guest memory.
+         */
+        std::uint8_t *pointer(const arm::address addr, const std::size_t size = 1);
+
+        template <typename T>
+        T read_value(const arm::address addr) {
+            T value{};
+            std::memcpy(&value, pointer(addr, sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        template <typename T>
+        void write_value(const arm::address addr, const T value) {
+            std::memcpy(pointer(addr, sizeof(T)), &value, sizeof(T));
+        }
+
+        void load_code(const kernel &kern);
+
+        /**
+         * @brief Zero every register of a core and point it to the start of the kernel.
+         *
+         * The translated code of the core is kept, so that a second run measures the steady state.
+         */
+        void reset_core(const std::size_t index, const bool thumb);
+
+        /**
+         * @brief Run all cores until they reach the final SVC or fault.
+         *
+         * @param slice     Maximum number of instructions a core runs before switching to the next one.
+         * @returns False if any core faulted.
+         */
+        bool run_all(const std::uint32_t slice);
+    };
+
+    struct bench_result {
+        bool ok_ = false;
+        std::string error_;
+
+        std::uint64_t first_run_instructions_ = 0;
+        double first_run_ms_ = 0.0;
+
+        std::uint64_t steady_instructions_ = 0;
+        double steady_run_ms_ = 0.0;
+
+        arm::code_cache_stats cache_stats_;
+    };
+
+    /**
+     * @brief Run a kernel once with a single iteration to populate the code cache, then at full length.
+     *
+     * @param scale     Multiplier of the kernel's iteration count.
+     */
+    bench_result run_benchmark(const kernel &kern, const arm_emulator_type type, const double scale);
+
+    struct diff_result {
+        bool ok_ = false;
+        std::uint64_t steps_ = 0;
+        std::string report_;
+    };
+
+    /**
+     * @brief Step two backends one instruction at a time over the same kernel, and compare their states.
+     *
+     * Registers and flags are compared after every step, and guest memory every @p mem_compare_interval steps
+     * and at the end.
+     */
+    diff_result run_differential(const kernel &kern, const arm_emulator_type test_type, const arm_emulator_type reference_type,
+        const std::uint32_t mem_compare_interval);
+}
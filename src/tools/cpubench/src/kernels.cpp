@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kernels.h"
+#include "bench.h"
+
+#include <fmt/format.h>
+
+#include <cstring>
+#include <initializer_list>
+
+namespace eka2l1::cpubench {
+    static constexpr std::uint32_t MEMCPY_SIZE = 0x10000;
+    static constexpr std::uint32_t DSP_SAMPLE_COUNT = 1024;
+
+    template <typename T>
+    static std::vector<std::uint8_t> make_code(std::initializer_list<T> insts) {
+        std::vector<std::uint8_t> code(insts.size() * sizeof(T));
+        std::memcpy(code.data(), insts.begin(), code.size());
+
+        return code;
+    }
+
+    static std::uint32_t rotate_right(const std::uint32_t value, const std::uint32_t amount) {
+        return (value >> amount) | (value << (32 - amount));
+    }
+
+    // Deterministic pseudo-random fill, so that every backend sees the same input
+    static std::uint32_t next_random(std::uint32_t &seed) {
+        seed = seed * 1664525 + 1013904223;
+        return seed;
+    }
+
+    static void setup_int_alu(bench_env &env, const std::size_t core_index, const std::uint32_t iterations) {
+        env.core(core_index)->set_reg(0, iterations);
+    }
+
+    static std::string verify_int_alu(bench_env &env, const std::uint32_t iterations) {
+        std::uint32_t r1 = 0;
+        std::uint32_t r2 = 1;
+        std::uint32_t r3 = 0;
+
+        for (std::uint32_t i = 0; i < iterations; i++) {
+            r1 += r2;
+            r2 ^= r1 << 3;
+            r3 = r1 | rotate_right(r2, 7);
+            r2 = r3 & ~0xF0U;
+        }
+
+        arm::core *cc = env.core(0);
+
+        if ((cc->get_reg(1) != r1) || (cc->get_reg(2) != r2) || (cc->get_reg(3) != r3)) {
+            return fmt::format("Expected r1-r3 = 0x{:X} 0x{:X} 0x{:X}, got 0x{:X} 0x{:X} 0x{:X}", r1, r2, r3,
+                cc->get_reg(1), cc->get_reg(2), cc->get_reg(3));
+        }
+
+        return "";
+    }
+
+    static void setup_thumb_alu(bench_env &env, const std::size_t core_index, const std::uint32_t iterations) {
+        env.core(core_index)->set_reg(0, iterations);
+        env.core(core_index)->set_reg(2, 1);
+    }
+
+    static std::string verify_thumb_alu(bench_env &env, const std::uint32_t iterations) {
+        std::uint32_t r1 = 0;
+        std::uint32_t r2 = 1;
+
+        for (std::uint32_t i = 0; i < iterations; i++) {
+            r1 += r2;
+            r2 ^= r1 << 3;
+            r1 |= r2 >> 5;
+        }
+
+        arm::core *cc = env.core(0);
+
+        if ((cc->get_reg(1) != r1) || (cc->get_reg(2) != r2)) {
+            return fmt::format("Expected r1-r2 = 0x{:X} 0x{:X}, got 0x{:X} 0x{:X}", r1, r2, cc->get_reg(1),
+                cc->get_reg(2));
+        }
+
+        return "";
+    }
+
+    static void setup_memcpy(bench_env &env, const std::size_t core_index, const std::uint32_t iterations) {
+        std::uint32_t seed = 0x1234;
+
+        for (std::uint32_t offset = 0; offset < MEMCPY_SIZE; offset += 4) {
+            env.write_value<std::uint32_t>(bench_env::DATA_BASE + offset, next_random(seed));
+            env.write_value<std::uint32_t>(bench_env::DATA_BASE + MEMCPY_SIZE + offset, 0);
+        }
+
+        arm::core *cc = env.core(core_index);
+
+        cc->set_reg(0, iterations);
+        cc->set_reg(1, bench_env::DATA_BASE);
+        cc->set_reg(2, bench_env::DATA_BASE + MEMCPY_SIZE);
+        cc->set_reg(3, MEMCPY_SIZE);
+    }
+
+    static std::string verify_memcpy(bench_env &env, const std::uint32_t iterations) {
+        if (std::memcmp(env.pointer(bench_env::DATA_BASE, MEMCPY_SIZE), env.pointer(bench_env::DATA_BASE + MEMCPY_SIZE, MEMCPY_SIZE),
+                MEMCPY_SIZE)
+            != 0) {
+            return "Destination buffer does not match the source";
+        }
+
+        return "";
+    }
+
+    static void setup_dsp(bench_env &env, const std::size_t core_index, const std::uint32_t iterations) {
+        std::uint32_t seed = 0x5678;
+
+        for (std::uint32_t i = 0; i < DSP_SAMPLE_COUNT * 2; i++) {
+            env.write_value<std::uint16_t>(bench_env::DATA_BASE + i * 2, static_cast<std::uint16_t>(next_random(seed) >> 16));
+        }
+
+        arm::core *cc = env.core(core_index);
+
+        cc->set_reg(0, iterations);
+        cc->set_reg(1, bench_env::DATA_BASE);
+        cc->set_reg(2, bench_env::DATA_BASE + DSP_SAMPLE_COUNT * 2);
+        cc->set_reg(3, DSP_SAMPLE_COUNT);
+    }
+
+    static std::string verify_dsp(bench_env &env, const std::uint32_t iterations) {
+        std::uint32_t r8 = 0;
+        std::uint32_t r9 = 0;
+        std::uint32_t r12 = 0;
+
+        for (std::uint32_t pass = 0; pass < iterations; pass++) {
+            r8 = 0;
+            r9 = 0;
+
+            for (std::uint32_t i = 0; i < DSP_SAMPLE_COUNT; i++) {
+                const std::int32_t a = env.read_value<std::int16_t>(bench_env::DATA_BASE + i * 2);
+                const std::int32_t b = env.read_value<std::int16_t>(bench_env::DATA_BASE + (DSP_SAMPLE_COUNT + i) * 2);
+                const std::uint32_t product = static_cast<std::uint32_t>(a * b);
+
+                // SMLABB, then SMLAL on the same accumulator, then MLA
+                r8 += product;
+
+                const std::uint64_t acc = ((static_cast<std::uint64_t>(r9) << 32) | r8) + static_cast<std::uint64_t>(static_cast<std::int64_t>(a) * b);
+
+                r8 = static_cast<std::uint32_t>(acc);
+                r9 = static_cast<std::uint32_t>(acc >> 32);
+                r12 += product;
+            }
+        }
+
+        arm::core *cc = env.core(0);
+
+        if ((cc->get_reg(0) != r8) || (cc->get_reg(1) != r9) || (cc->get_reg(12) != r12)) {
+            return fmt::format("Expected r0, r1, r12 = 0x{:X} 0x{:X} 0x{:X}, got 0x{:X} 0x{:X} 0x{:X}", r8, r9, r12,
+                cc->get_reg(0), cc->get_reg(1), cc->get_reg(12));
+        }
+
+        return "";
+    }
+
+    static void setup_vfp(bench_env &env, const std::size_t core_index, const std::uint32_t iterations) {
+        arm::core *cc = env.core(core_index);
+
+        cc->set_reg(0, iterations);
+
+        // d0 = 1.0, d1 = 0.5, s8 = 1.0, s9 = 0.25. There is no VFPv2 immediate move to do it in the kernel
+        cc->set_vfp(1, 0x3FF00000);
+        cc->set_vfp(3, 0x3FE00000);
+        cc->set_vfp(8, 0x3F800000);
+        cc->set_vfp(9, 0x3E800000);
+    }
+
+    static void setup_exclusive(bench_env &env, const std::size_t core_index, const std::uint32_t iterations) {
+        if (core_index == 0) {
+            env.write_value<std::uint32_t>(bench_env::DATA_BASE, 0);
+        }
+
+        env.core(core_index)->set_reg(0, iterations);
+        env.core(core_index)->set_reg(1, bench_env::DATA_BASE);
+    }
+
+    static std::string verify_exclusive(bench_env &env, const std::uint32_t iterations) {
+        const std::uint32_t expected = iterations * static_cast<std::uint32_t>(env.core_count());
+        const std::uint32_t counter = env.read_value<std::uint32_t>(bench_env::DATA_BASE);
+
+        if (counter != expected) {
+            return fmt::format("Expected the shared counter to be {}, got {}", expected, counter);
+        }
+
+        return "";
+    }
+
+    const std::vector<kernel> &get_kernels() {
+        static const std::vector<kernel> kernels = {
+            { "int_alu", "ARM integer loop with shifted operands",
+                make_code<std::uint32_t>({
+                    0xE3A01000, // mov r1, #0
+                    0xE3A02001, // mov r2, #1
+                    0xE0811002, // 1: add r1, r1, r2
+                    0xE0222181, // eor r2, r2, r1, lsl #3
+                    0xE18133E2, // orr r3, r1, r2, ror #7
+                    0xE3C320F0, // bic r2, r3, #0xF0
+                    0xE2500001, // subs r0, r0, #1
+                    0x1AFFFFF9, // bne 1b
+                    0xEF000000 // svc #0
+                }),
+                false, 1, 10000000, 2000, setup_int_alu, verify_int_alu },
+            { "thumb_alu", "Thumb integer loop",
+                make_code<std::uint16_t>({
+                    0x1889, // 1: adds r1, r1, r2
+                    0x00CB, // lsls r3, r1, #3
+                    0x405A, // eors r2, r3
+                    0x0953, // lsrs r3, r2, #5
+                    0x4319, // orrs r1, r3
+                    0x1E40, // subs r0, r0, #1
+                    0xD1F8, // bne 1b
+                    0xDF00 // svc #0
+                }),
+                true, 1, 8000000, 2000, setup_thumb_alu, verify_thumb_alu },
+            { "memcpy", "64 KB block copy with LDM/STM",
+                make_code<std::uint32_t>({
+                    0xE1A04001, // 1: mov r4, r1
+                    0xE1A05002, // mov r5, r2
+                    0xE1A06003, // mov r6, r3
+                    0xE8B45F80, // 2: ldmia r4!, {r7-r12, lr}
+                    0xE8A55F80, // stmia r5!, {r7-r12, lr}
+                    0xE8B40080, // ldmia r4!, {r7}
+                    0xE8A50080, // stmia r5!, {r7}
+                    0xE2566020, // subs r6, r6, #32
+                    0x1AFFFFF9, // bne 2b
+                    0xE2500001, // subs r0, r0, #1
+                    0x1AFFFFF4, // bne 1b
+                    0xEF000000 // svc #0
+                }),
+                false, 1, 4000, 1, setup_memcpy, verify_memcpy },
+            { "dsp", "Fixed-point multiply-accumulate over 16-bit samples",
+                make_code<std::uint32_t>({
+                    0xE1A04001, // 1: mov r4, r1
+                    0xE1A05002, // mov r5, r2
+                    0xE1A06003, // mov r6, r3
+                    0xE3A08000, // mov r8, #0
+                    0xE3A09000, // mov r9, #0
+                    0xE0D4A0F2, // 2: ldrsh r10, [r4], #2
+                    0xE0D5B0F2, // ldrsh r11, [r5], #2
+                    0xE1088B8A, // smlabb r8, r10, r11, r8
+                    0xE0E98B9A, // smlal r8, r9, r10, r11
+                    0xE02CCB9A, // mla r12, r10, r11, r12
+                    0xE2566001, // subs r6, r6, #1
+                    0x1AFFFFF8, // bne 2b
+                    0xE2500001, // subs r0, r0, #1
+                    0x1AFFFFF1, // bne 1b
+                    0xE1A00008, // mov r0, r8
+                    0xE1A01009, // mov r1, r9
+                    0xEF000000 // svc #0
+                }),
+                false, 1, 7000, 2, setup_dsp, verify_dsp },
+            { "vfp", "VFPv2 single and double precision arithmetic",
+                make_code<std::uint32_t>({
+                    0xEE010B01, // 1: vmla.f64 d0, d1, d1
+                    0xEE202B01, // vmul.f64 d2, d0, d1
+                    0xEE321B01, // vadd.f64 d1, d2, d1
+                    0xEE811B00, // vdiv.f64 d1, d1, d0
+                    0xEE244A24, // vmul.f32 s8, s8, s9
+                    0xEE744A84, // vadd.f32 s9, s9, s8
+                    0xEEB15AE4, // vsqrt.f32 s10, s9
+                    0xE2500001, // subs r0, r0, #1
+                    0x1AFFFFF6, // bne 1b
+                    0xEF000000 // svc #0
+                }),
+                false, 1, 5000000, 1000, setup_vfp, nullptr },
+            { "exclusive", "LDREX/STREX counter increment contended by two cores",
+                make_code<std::uint32_t>({
+                    0xE1912F9F, // 1: ldrex r2, [r1]
+                    0xE2822001, // add r2, r2, #1
+                    0xE1813F92, // strex r3, r2, [r1]
+                    0xE3530000, // cmp r3, #0
+                    0x1AFFFFFA, // bne 1b
+                    0xE2500001, // subs r0, r0, #1
+                    0x1AFFFFF8, // bne 1b
+                    0xEF000000 // svc #0
+                }),
+                false, 2, 2000000, 500, setup_exclusive, verify_exclusive }
+        };
+
+        return kernels;
+    }
+}
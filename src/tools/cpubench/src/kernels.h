@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace eka2l1::cpubench {
+    class bench_env;
+
+    /**
+     * @brief A small guest program of the benchmark corpus.
+     *
+     * Every kernel starts at bench_env::CODE_BASE, with its parameters in r0-r3, and ends with an SVC.
+     * Kernels that need more than one core are run round-robin on the host thread, all cores executing the same code.
+     */
+    struct kernel {
+        const char *name_;
+        const char *description_;
+
+        std::vector<std::uint8_t> code_;
+        bool thumb_;
+        std::size_t core_count_;
+
+        std::uint32_t iterations_; ///< Iteration count of a benchmark run.
+        std::uint32_t diff_iterations_; ///< Iteration count of a lockstep differential run.
+
+        /**
+         * @brief Fill guest memory and the registers of a core for a run.
+         */
+        void (*setup_)(bench_env &env, const std::size_t core_index, const std::uint32_t iterations);
+
+        /**
+         * @brief Check the guest result against the host model of the kernel.
+         *
+         * @returns Empty string on success, else a description of the mismatch.
+         */
+        std::string (*verify_)(bench_env &env, const std::uint32_t iterations);
+    };
+
+    const std::vector<kernel> &get_kernels();
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bench.h"
+#include "kernels.h"
+
+#include <common/log.h>
+#include <common/platform.h>
+#include <cpu/arm_utils.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static constexpr std::uint32_t DIFF_MEMORY_COMPARE_INTERVAL = 4096;
+
+static void print_usage() {
+    LOG_INFO(eka2l1::SYSTEM, "Usage: cpubench [--backend name] [--kernel name] [--scale factor] [--diff] [--list]");
+    LOG_INFO(eka2l1::SYSTEM, "  --backend   dynarmic, r12l1 or dyncom. Default to the recompiler of this host.");
+    LOG_INFO(eka2l1::SYSTEM, "  --kernel    Only run the given kernel. Can be repeated.");
+    LOG_INFO(eka2l1::SYSTEM, "  --scale     Multiply the iteration count of every kernel.");
+    LOG_INFO(eka2l1::SYSTEM, "  --diff      Step the backend and dyncom in lockstep, and report the first divergence.");
+    LOG_INFO(eka2l1::SYSTEM, "  --list      List the kernels of the corpus.");
+}
+
+static bool should_run(const eka2l1::cpubench::kernel &kern, const std::vector<std::string> &filters) {
+    if (filters.empty()) {
+        return true;
+    }
+
+    return std::find(filters.begin(), filters.end(), kern.name_) != filters.end();
+}
+
+int main(int argc, char **argv) {
+    eka2l1::log::setup_log(nullptr);
+    eka2l1::log::toggle_console();
+
+    // Backends trace in their hot paths, which would be measured too
+    eka2l1::log::filterings->parse_filter_string("*:info");
+
+#if EKA2L1_ARCH(ARM)
+    arm_emulator_type backend = arm_emulator_type::r12l1;
+#else
+    arm_emulator_type backend = arm_emulator_type::dynarmic;
+#endif
+
+    std::vector<std::string> filters;
+    double scale = 1.0;
+    bool diff_mode = false;
+
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = (i + 1 < argc);
+
+        if ((std::strcmp(argv[i], "--backend") == 0) && has_value) {
+            backend = eka2l1::arm::string_to_arm_emulator_type(argv[++i]);
+        } else if ((std::strcmp(argv[i], "--kernel") == 0) && has_value) {
+            filters.push_back(argv[++i]);
+        } else if ((std::strcmp(argv[i], "--scale") == 0) && has_value) {
+            scale = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--diff") == 0) {
+            diff_mode = true;
+        } else if (std::strcmp(argv[i], "--list") == 0) {
+            for (const eka2l1::cpubench::kernel &kern : eka2l1::cpubench::get_kernels()) {
+                LOG_INFO(eka2l1::SYSTEM, "{:<12} {}", kern.name_, kern.description_);
+            }
+
+            return 0;
+        } else {
+            print_usage();
+            return -1;
+        }
+    }
+
+    if (scale <= 0.0) {
+        LOG_ERROR(eka2l1::SYSTEM, "Scale must be positive!");
+        return -1;
+    }
+
+    const char *backend_name = eka2l1::arm::arm_emulator_type_to_string(backend);
+    int failed_count = 0;
+
+    if (diff_mode) {
+        if (backend == arm_emulator_type::dyncom) {
+            LOG_ERROR(eka2l1::SYSTEM, "Dyncom is the reference backend, choose another backend to compare against it!");
+            return -1;
+        }
+
+        LOG_INFO(eka2l1::SYSTEM, "Comparing {} against Dyncom in lockstep", backend_name);
+
+        for (const eka2l1::cpubench::kernel &kern : eka2l1::cpubench::get_kernels()) {
+            if (!should_run(kern, filters)) {
+                continue;
+            }
+
+            const eka2l1::cpubench::diff_result result = eka2l1::cpubench::run_differential(kern, backend,
+                arm_emulator_type::dyncom, DIFF_MEMORY_COMPARE_INTERVAL);
+
+            if (result.ok_) {
+                LOG_INFO(eka2l1::SYSTEM, "{:<12} OK, {} steps", kern.name_, result.steps_);
+            } else {
+                LOG_ERROR(eka2l1::SYSTEM, "{:<12} FAILED\n{}", kern.name_, result.report_);
+                failed_count++;
+            }
+        }
+
+        return failed_count ? -2 : 0;
+    }
+
+    LOG_INFO(eka2l1::SYSTEM, "Benchmarking {}", backend_name);
+
+    for (const eka2l1::cpubench::kernel &kern : eka2l1::cpubench::get_kernels()) {
+        if (!should_run(kern, filters)) {
+            continue;
+        }
+
+        const eka2l1::cpubench::bench_result result = eka2l1::cpubench::run_benchmark(kern, backend, scale);
+
+        if (!result.ok_) {
+            LOG_ERROR(eka2l1::SYSTEM, "{:<12} FAILED: {}", kern.name_, result.error_);
+            failed_count++;
+
+            continue;
+        }
+
+        const double mips = (result.steady_run_ms_ > 0.0) ? (result.steady_instructions_ / (result.steady_run_ms_ * 1000.0)) : 0.0;
+
+        // The first run executes a single iteration, so nearly all of its time is spent translating
+        double translate_ms = result.first_run_ms_;
+
+        if (mips > 0.0) {
+            translate_ms = std::max(0.0, translate_ms - result.first_run_instructions_ / (mips * 1000.0));
+        }
+
+        LOG_INFO(eka2l1::SYSTEM, "{:<12} {:>12} insts {:>10.2f} ms {:>9.2f} MIPS | first run {:.3f} ms, translate ~{:.3f} ms",
+            kern.name_, result.steady_instructions_, result.steady_run_ms_, mips, result.first_run_ms_, translate_ms);
+
+        const eka2l1::arm::code_cache_stats &cache = result.cache_stats_;
+
+        if (cache.committed_bytes_ || cache.block_count_) {
+            LOG_INFO(eka2l1::SYSTEM, "{:<12} cache: {} blocks, {} KB used, {} KB committed of {} KB, {} evicted, {} reclaims", "",
+                cache.block_count_, cache.used_bytes_ / 1024, cache.committed_bytes_ / 1024, cache.capacity_bytes_ / 1024,
+                cache.evicted_block_count_, cache.reclaim_count_);
+        }
+
+        if (cache.compiled_block_count_ || cache.flush_count_) {
+            LOG_INFO(eka2l1::SYSTEM, "{:<12} cache: {} compiled, {} recompiled ({} us), {} full flushes, {} us flushing", "",
+                cache.compiled_block_count_, cache.recompiled_block_count_, cache.recompile_time_us_, cache.flush_count_,
+                cache.flush_time_us_);
+        }
+    }
+
+    return failed_count ? -2 : 0;
+}
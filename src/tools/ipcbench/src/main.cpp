@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <common/log.h>
+#include <config/config.h>
+#include <cpu/arm_factory.h>
+#include <kernel/ipc.h>
+#include <kernel/kernel.h>
+#include <kernel/timing.h>
+#include <vfs/vfs.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+using namespace eka2l1;
+
+static void print_usage() {
+    LOG_INFO(eka2l1::SYSTEM, "Usage: ipcbench [--messages count] [--inflight count] [--seed number]");
+    LOG_INFO(eka2l1::SYSTEM, "  --messages  Number of messages sent in each pattern. Default to 1000000.");
+    LOG_INFO(eka2l1::SYSTEM, "  --inflight  Number of messages held at once before the oldest is completed. Default to 64.");
+    LOG_INFO(eka2l1::SYSTEM, "  --seed      Seed of the out-of-order completion pattern.");
+}
+
+struct storm_result {
+    bool ok_ = true;
+    double ms_ = 0.0;
+    std::uint64_t stale_hits_ = 0; ///< Handles of completed messages that still resolved to a message.
+};
+
+// Keep the handle of a completed message, and make sure it no longer resolves once the slot is reused
+static void complete_msg(ipc_msg_ptr msg, std::vector<int> &stale_handles) {
+    stale_handles.push_back(static_cast<int>(msg->id));
+    msg->unref();
+}
+
+static std::uint64_t check_stale_handles(kernel_system &kern, std::vector<int> &stale_handles) {
+    std::uint64_t hits = 0;
+
+    for (const int handle : stale_handles) {
+        if (kern.get_msg(handle)) {
+            hits++;
+        }
+    }
+
+    stale_handles.clear();
+    return hits;
+}
+
+// Send messages like a client keeping a number of requests in flight, and complete them like a server.
+// When out of order, a random in-flight message is completed each time, instead of the oldest.
+static storm_result run_storm(kernel_system &kern, const std::uint64_t count, const std::uint32_t inflight,
+    const bool out_of_order, const std::uint32_t seed) {
+    storm_result result;
+
+    std::deque<ipc_msg_ptr> pending;
+    std::vector<int> stale_handles;
+    std::mt19937 rng(seed);
+
+    stale_handles.reserve(inflight);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::uint64_t i = 0; i < count; i++) {
+        ipc_msg_ptr msg = kern.create_msg(kernel::owner_type::process);
+
+        if (!msg) {
+            result.ok_ = false;
+            break;
+        }
+
+        msg->function = static_cast<int>(i & 0xFF);
+        msg->ref();
+
+        // The server side gets the message back from its handle
+        if (kern.get_msg(static_cast<int>(msg->id)) != msg) {
+            result.ok_ = false;
+            break;
+        }
+
+        pending.push_back(msg);
+
+        if (pending.size() < inflight) {
+            continue;
+        }
+
+        std::size_t victim = 0;
+
+        if (out_of_order) {
+            victim = rng() % pending.size();
+            std::swap(pending[victim], pending.front());
+        }
+
+        complete_msg(pending.front(), stale_handles);
+        pending.pop_front();
+
+        // Checking is not free, only do it once per window so that it does not dominate the timing
+        if (stale_handles.size() >= inflight) {
+            result.stale_hits_ += check_stale_handles(kern, stale_handles);
+        }
+    }
+
+    while (!pending.empty()) {
+        complete_msg(pending.front(), stale_handles);
+        pending.pop_front();
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    result.ms_ = std::chrono::duration<double, std::milli>(end - start).count();
+    result.stale_hits_ += check_stale_handles(kern, stale_handles);
+
+    return result;
+}
+
+int main(int argc, char **argv) {
+    eka2l1::log::setup_log(nullptr);
+    eka2l1::log::toggle_console();
+
+    eka2l1::log::filterings->parse_filter_string("*:info");
+
+    std::uint64_t message_count = 1000000;
+    std::uint32_t inflight = 64;
+    std::uint32_t seed = 0x45504F43;
+
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = (i + 1 < argc);
+
+        if ((std::strcmp(argv[i], "--messages") == 0) && has_value) {
+            message_count = std::strtoull(argv[++i], nullptr, 10);
+        } else if ((std::strcmp(argv[i], "--inflight") == 0) && has_value) {
+            inflight = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if ((std::strcmp(argv[i], "--seed") == 0) && has_value) {
+            seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            print_usage();
+            return -1;
+        }
+    }
+
+    // A kernel with no system behind it, the message pool does not need guest memory
+    arm::exclusive_monitor_instance monitor = arm::create_exclusive_monitor(arm_emulator_type::dyncom, 1);
+    arm::core_instance cpu = arm::create_core(monitor.get(), arm_emulator_type::dyncom);
+
+    ntimer timing(484000000);
+    io_system io;
+    config::state conf;
+
+    kernel_system kern(nullptr, &timing, &io, &conf, nullptr, nullptr, cpu.get(), nullptr);
+
+    const std::uint32_t capacity = kern.get_msg_pool_stats().capacity_;
+
+    if ((inflight == 0) || (inflight > capacity)) {
+        LOG_ERROR(eka2l1::SYSTEM, "In-flight count must be between 1 and {}!", capacity);
+        return -1;
+    }
+
+    LOG_INFO(eka2l1::SYSTEM, "Sending {} messages per pattern, {} in flight", message_count, inflight);
+
+    int failed_count = 0;
+
+    for (const bool out_of_order : { false, true }) {
+        const char *pattern_name = out_of_order ? "out-of-order" : "in-order";
+        const storm_result result = run_storm(kern, message_count, inflight, out_of_order, seed);
+
+        if (!result.ok_) {
+            LOG_ERROR(eka2l1::SYSTEM, "{:<14} FAILED: message allocation or lookup failed", pattern_name);
+            failed_count++;
+
+            continue;
+        }
+
+        const double ns_per_msg = (message_count > 0) ? (result.ms_ * 1000000.0 / message_count) : 0.0;
+        LOG_INFO(eka2l1::SYSTEM, "{:<14} {:>10.2f} ms, {:>8.2f} ns/msg", pattern_name, result.ms_, ns_per_msg);
+
+        if (result.stale_hits_ != 0) {
+            LOG_ERROR(eka2l1::SYSTEM, "{:<14} FAILED: {} handles of completed messages still resolved", pattern_name,
+                result.stale_hits_);
+            failed_count++;
+        }
+    }
+
+    const ipc_msg_pool_stats stats = kern.get_msg_pool_stats();
+
+    LOG_INFO(eka2l1::SYSTEM, "Pool: {} slots constructed of {}, high water mark {}, {} in use, {} allocations, {} failed",
+        stats.allocated_, stats.capacity_, stats.high_water_mark_, stats.in_use_, stats.total_allocs_, stats.failed_allocs_);
+
+    return failed_count ? -2 : 0;
+}